@@ -256,6 +256,14 @@ typedef void * lv_group_user_data_t;
     #define LV_USE_GPU_STM32_DMA2D  0
 #endif
 
+/* 1: Fill and blend with the kernels of lv_gpu_esp32_blend.c (IRAM, 32 bit
+ * accesses). They exist for swapped RGB565 only. */
+#if defined CONFIG_LVGL_FEATURE_USE_GPU_ESP32_BLEND && LV_COLOR_DEPTH == 16 && LV_COLOR_16_SWAP && !LV_COLOR_SCREEN_TRANSP
+    #define LV_USE_GPU_ESP32_BLEND  1
+#else
+    #define LV_USE_GPU_ESP32_BLEND  0
+#endif
+
 /* 1: Enable file system (might be required for images */
 #if defined CONFIG_LVGL_FEATURE_USE_FILESYSTEM
     #define LV_USE_FILESYSTEM       1
@@ -340,7 +348,9 @@ typedef void * lv_img_decoder_user_data_t;
 #define LV_ATTRIBUTE_LARGE_CONST
 
 /* Prefix performance critical functions to place them into a faster memory (e.g RAM)
- * Uses 15-20 kB extra memory */
+ * Uses 15-20 kB extra memory.
+ * Left empty: lvgl_iram.lf places the functions a profile of this UI found
+ * hot instead (CONFIG_LVGL_CODE_PLACEMENT_IRAM, tools/lvgl_iram_place.py) */
 #define LV_ATTRIBUTE_FAST_MEM
 
 /* Export integer constant to binding.
@@ -357,10 +367,12 @@ typedef void * lv_img_decoder_user_data_t;
 
 /* 1: use a custom tick source.
  * It removes the need to manually update the tick with `lv_tick_inc`) */
-#define LV_TICK_CUSTOM     0
+/* The tick is read from esp_timer, so no periodic timer has to wake the
+ * CPU just to advance it while the GUI task sleeps */
+#define LV_TICK_CUSTOM     1
 #if LV_TICK_CUSTOM == 1
-#define LV_TICK_CUSTOM_INCLUDE  "something.h"       /*Header for the sys time function*/
-#define LV_TICK_CUSTOM_SYS_TIME_EXPR (millis())     /*Expression evaluating to current systime in ms*/
+#define LV_TICK_CUSTOM_INCLUDE  "esp_timer.h"       /*Header for the sys time function*/
+#define LV_TICK_CUSTOM_SYS_TIME_EXPR ((uint32_t)(esp_timer_get_time() / 1000))     /*Expression evaluating to current systime in ms*/
 #endif   /*LV_TICK_CUSTOM*/
 
 typedef void * lv_disp_drv_user_data_t;             /*Type of user data in the display driver*/
@@ -13,12 +13,17 @@
 #include "../lv_core/lv_refr.h"
 
 #include "../lv_gpu/lv_gpu_stm32_dma2d.h"
+#include "../lv_gpu/lv_gpu_esp32_blend.h"
 
 /*********************
  *      DEFINES
  *********************/
 #define GPU_SIZE_LIMIT      240
 
+#if LV_USE_GPU_ESP32_BLEND && (LV_COLOR_MIX_ROUND_OFS != 128 || LV_OPA_MAX != LV_GPU_ESP32_BLEND_OPA_MAX)
+    #error "The ESP32 blend kernels mix with LV_COLOR_MIX_ROUND_OFS 128 and LV_OPA_MAX 250"
+#endif
+
 /**********************
  *      TYPEDEFS
  **********************/
@@ -328,6 +333,13 @@ LV_ATTRIBUTE_FAST_MEM static void fill_normal(const lv_area_t * disp_area, lv_co
                 return;
             }
 #endif
+
+#if LV_USE_GPU_ESP32_BLEND
+            if(lv_gpu_esp32_blend_is_enabled()) {
+                lv_gpu_esp32_blend_fill(&disp_buf_first->full, disp_w, color.full, draw_area_w, draw_area_h);
+                return;
+            }
+#endif
             /*Software rendering*/
             for(y = 0; y < draw_area_h; y++) {
                 lv_color_fill(disp_buf_first, color, draw_area_w);
@@ -368,6 +380,13 @@ LV_ATTRIBUTE_FAST_MEM static void fill_normal(const lv_area_t * disp_area, lv_co
                 return;
             }
 #endif
+
+#if LV_USE_GPU_ESP32_BLEND
+            if(lv_gpu_esp32_blend_is_enabled()) {
+                lv_gpu_esp32_blend_fill_opa(&disp_buf_first->full, disp_w, color.full, opa, draw_area_w, draw_area_h);
+                return;
+            }
+#endif
             lv_color_t last_dest_color = LV_COLOR_BLACK;
             lv_color_t last_res_color = lv_color_mix(color, last_dest_color, opa);
 
@@ -407,6 +426,13 @@ LV_ATTRIBUTE_FAST_MEM static void fill_normal(const lv_area_t * disp_area, lv_co
         }
 #endif
 
+#if LV_USE_GPU_ESP32_BLEND
+        if(lv_gpu_esp32_blend_is_enabled()) {
+            lv_gpu_esp32_blend_fill_mask(&disp_buf_first->full, disp_w, color.full, opa > LV_OPA_MAX ? LV_OPA_COVER : opa,
+                                         mask, draw_area_w, draw_area_h);
+            return;
+        }
+#endif
 
         /*Buffer the result color to avoid recalculating the same color*/
         lv_color_t last_dest_color;
@@ -719,6 +745,13 @@ LV_ATTRIBUTE_FAST_MEM static void map_normal(const lv_area_t * disp_area, lv_col
             }
 #endif
 
+#if LV_USE_GPU_ESP32_BLEND
+            if(lv_gpu_esp32_blend_is_enabled()) {
+                lv_gpu_esp32_blend_copy(&disp_buf_first->full, disp_w, &map_buf_first->full, map_w, draw_area_w, draw_area_h);
+                return;
+            }
+#endif
+
             /*Software rendering*/
             for(y = 0; y < draw_area_h; y++) {
                 _lv_memcpy(disp_buf_first, map_buf_first, draw_area_w * sizeof(lv_color_t));
@@ -734,6 +767,14 @@ LV_ATTRIBUTE_FAST_MEM static void map_normal(const lv_area_t * disp_area, lv_col
             }
 #endif
 
+#if LV_USE_GPU_ESP32_BLEND
+            if(lv_gpu_esp32_blend_is_enabled()) {
+                lv_gpu_esp32_blend_map_opa(&disp_buf_first->full, disp_w, &map_buf_first->full, map_w, opa,
+                                           draw_area_w, draw_area_h);
+                return;
+            }
+#endif
+
             /*Software rendering*/
 
             for(y = 0; y < draw_area_h; y++) {
@@ -756,6 +797,14 @@ LV_ATTRIBUTE_FAST_MEM static void map_normal(const lv_area_t * disp_area, lv_col
     }
     /*Masked*/
     else {
+#if LV_USE_GPU_ESP32_BLEND
+        if(lv_gpu_esp32_blend_is_enabled()) {
+            lv_gpu_esp32_blend_map_mask(&disp_buf_first->full, disp_w, &map_buf_first->full, map_w,
+                                        opa > LV_OPA_MAX ? LV_OPA_COVER : opa, mask, draw_area_w, draw_area_h);
+            return;
+        }
+#endif
+
         /*Only the mask matters*/
         if(opa > LV_OPA_MAX) {
             /*Go to the first pixel of the row */
@@ -1,4 +1,5 @@
 CSRCS += lv_gpu_stm32_dma2d.c
+CSRCS += lv_gpu_esp32_blend.c
 
 DEPPATH += --dep-path $(LVGL_DIR)/$(LVGL_DIR_NAME)/src/lv_gpu
 VPATH += :$(LVGL_DIR)/$(LVGL_DIR_NAME)/src/lv_gpu
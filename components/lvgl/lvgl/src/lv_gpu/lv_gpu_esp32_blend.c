@@ -0,0 +1,371 @@
+/**
+ * @file lv_gpu_esp32_blend.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_gpu_esp32_blend.h"
+
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
+#if !defined(ESP_PLATFORM) || defined(CONFIG_LVGL_FEATURE_USE_GPU_ESP32_BLEND)
+
+/*********************
+ *      DEFINES
+ *********************/
+#define LANES_ROUND 0x00800080U     /*LV_COLOR_MIX_ROUND_OFS in both lanes*/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static volatile bool enabled = true;
+
+/**********************
+ *      MACROS
+ **********************/
+/*Inlined even at -Og: a helper left out of line would run from flash*/
+#define KERNEL_INLINE static inline __attribute__((always_inline))
+
+/*Two pixels as one word, the first in the low half. A swapped RGB565 pixel
+ *as a little endian uint16_t is GGGBBBBB RRRRRGGG: red in bits 3..7, blue in
+ *8..12, green split over 0..2 (high bits) and 13..15 (low bits).
+ *A channel of both pixels goes to the two 16 bit lanes of a word.*/
+#define PAIR_R(p)   (((p) >> 3) & 0x001F001FU)
+#define PAIR_B(p)   (((p) >> 8) & 0x001F001FU)
+#define PAIR_G(p)   ((((p) & 0x00070007U) << 3) | (((p) >> 13) & 0x00070007U))
+
+#define PAIR(p0, p1) ((uint32_t)(p0) | ((uint32_t)(p1) << 16))
+
+KERNEL_INLINE uint32_t pair_pack(uint32_t r, uint32_t g, uint32_t b)
+{
+    return (r << 3) | (b << 8) | ((g >> 3) & 0x00070007U) | ((g & 0x00070007U) << 13);
+}
+
+/*floor(x / 255) in both lanes, for lane values below 65535: the same as
+ *LV_MATH_UDIV255 there. Mixed channels stay below 2^14, so nothing carries
+ *from one lane to the other.*/
+KERNEL_INLINE uint32_t lanes_div255(uint32_t x)
+{
+    return ((x + 0x00010001U + ((x >> 8) & 0x00FF00FFU)) >> 8) & 0x00FF00FFU;
+}
+
+/*`lv_color_mix` of a channel in both lanes as bg * 255 + (fg - bg) * mix.
+ *A lane of fg - bg may be negative and borrow from the next one, but the sum
+ *is exact again: no lane of it is negative or above 2^16.*/
+KERNEL_INLINE uint32_t lanes_mix(uint32_t fg, uint32_t bg, uint32_t mix)
+{
+    return lanes_div255((bg << 8) - bg + (fg - bg) * mix + LANES_ROUND);
+}
+
+/*The same with mix0 in the low and mix0 + mix_diff in the high lane*/
+KERNEL_INLINE uint32_t lanes_mix2(uint32_t fg, uint32_t bg, uint32_t mix0, int32_t mix_diff)
+{
+    uint32_t diff = fg - bg;
+    int32_t diff0 = (int16_t)diff;
+    int32_t diff1 = ((int32_t)diff - diff0) >> 16;
+    return lanes_div255((bg << 8) - bg + diff * mix0 + ((uint32_t)(diff1 * mix_diff) << 16) + LANES_ROUND);
+}
+
+/*`lv_color_mix_premult`: fg already holds fg * mix + LV_COLOR_MIX_ROUND_OFS*/
+KERNEL_INLINE uint32_t lanes_mix_premult(uint32_t fg, uint32_t bg, uint32_t mix_inv)
+{
+    return lanes_div255(fg + bg * mix_inv);
+}
+
+/*`lv_color_mix` of two pixel pairs*/
+KERNEL_INLINE uint32_t pair_mix(uint32_t fg, uint32_t bg, uint32_t mix)
+{
+    return pair_pack(lanes_mix(PAIR_R(fg), PAIR_R(bg), mix),
+                     lanes_mix(PAIR_G(fg), PAIR_G(bg), mix),
+                     lanes_mix(PAIR_B(fg), PAIR_B(bg), mix));
+}
+
+/*`lv_color_mix` of two pixel pairs with a ratio for each pixel*/
+KERNEL_INLINE uint32_t pair_mix2(uint32_t fg, uint32_t bg, uint32_t mix0, uint32_t mix1)
+{
+    if(mix0 == mix1) return pair_mix(fg, bg, mix0);
+
+    int32_t mix_diff = (int32_t)mix1 - (int32_t)mix0;
+    return pair_pack(lanes_mix2(PAIR_R(fg), PAIR_R(bg), mix0, mix_diff),
+                     lanes_mix2(PAIR_G(fg), PAIR_G(bg), mix0, mix_diff),
+                     lanes_mix2(PAIR_B(fg), PAIR_B(bg), mix0, mix_diff));
+}
+
+/*The ratio `fill_normal` mixes the color with under a mask value (opa 255:
+ *the mask alone). Mixing with 0 leaves the pixel and with 255 gives the
+ *color, just like the shortcuts of the C code.*/
+KERNEL_INLINE uint32_t fill_mix(uint32_t m, uint32_t opa)
+{
+    if(opa == 255) return m;
+    return m == 255 ? opa : (m * opa) >> 8;
+}
+
+/*The ratio `map_normal` mixes a map pixel with under a mask value*/
+KERNEL_INLINE uint32_t map_mix(uint32_t m, uint32_t opa)
+{
+    if(opa == 255) return m;
+    return m >= LV_GPU_ESP32_BLEND_OPA_MAX ? opa : (opa * m) >> 8;
+}
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void lv_gpu_esp32_blend_set_enabled(bool en)
+{
+    enabled = en;
+}
+
+LV_GPU_ESP32_BLEND_ATTR bool lv_gpu_esp32_blend_is_enabled(void)
+{
+    return enabled;
+}
+
+LV_GPU_ESP32_BLEND_ATTR void lv_gpu_esp32_blend_fill(uint16_t * buf, int32_t buf_w, uint16_t color,
+                                                     int32_t fill_w, int32_t fill_h)
+{
+    uint32_t color2 = PAIR(color, color);
+
+    for(int32_t y = 0; y < fill_h; y++) {
+        uint16_t * d = buf;
+        int32_t n = fill_w;
+
+        /*Align to a word: the 32 bit accesses below must not straddle one*/
+        if(((uintptr_t)d & 0x2) && n > 0) {
+            *d++ = color;
+            n--;
+        }
+
+        uint32_t * d32 = (uint32_t *)d;
+        for(; n >= 8; n -= 8) {
+            d32[0] = color2;
+            d32[1] = color2;
+            d32[2] = color2;
+            d32[3] = color2;
+            d32 += 4;
+        }
+        for(; n >= 2; n -= 2) {
+            *d32++ = color2;
+        }
+        if(n > 0) *(uint16_t *)d32 = color;
+
+        buf += buf_w;
+    }
+}
+
+LV_GPU_ESP32_BLEND_ATTR void lv_gpu_esp32_blend_fill_opa(uint16_t * buf, int32_t buf_w, uint16_t color, uint8_t opa,
+                                                         int32_t fill_w, int32_t fill_h)
+{
+    uint32_t color2 = PAIR(color, color);
+    uint32_t opa_inv = 255 - opa;
+    uint32_t fg_r = PAIR_R(color2) * opa + LANES_ROUND;
+    uint32_t fg_g = PAIR_G(color2) * opa + LANES_ROUND;
+    uint32_t fg_b = PAIR_B(color2) * opa + LANES_ROUND;
+
+#define FILL_OPA_PAIR(bg) pair_pack(lanes_mix_premult(fg_r, PAIR_R(bg), opa_inv),   \
+                                    lanes_mix_premult(fg_g, PAIR_G(bg), opa_inv),   \
+                                    lanes_mix_premult(fg_b, PAIR_B(bg), opa_inv))
+
+    /*Backgrounds are mostly plain: keep the last pair and its result*/
+    uint32_t last_bg = 0;
+    uint32_t last_res = FILL_OPA_PAIR(last_bg);
+
+    for(int32_t y = 0; y < fill_h; y++) {
+        uint16_t * d = buf;
+        int32_t n = fill_w;
+
+        if(((uintptr_t)d & 0x2) && n > 0) {
+            *d = FILL_OPA_PAIR((uint32_t)*d);
+            d++;
+            n--;
+        }
+
+        uint32_t * d32 = (uint32_t *)d;
+        for(; n >= 2; n -= 2) {
+            uint32_t bg = *d32;
+            if(bg != last_bg) {
+                last_bg = bg;
+                last_res = FILL_OPA_PAIR(bg);
+            }
+            *d32++ = last_res;
+        }
+        if(n > 0) {
+            d = (uint16_t *)d32;
+            *d = FILL_OPA_PAIR((uint32_t)*d);
+        }
+
+        buf += buf_w;
+    }
+
+#undef FILL_OPA_PAIR
+}
+
+LV_GPU_ESP32_BLEND_ATTR void lv_gpu_esp32_blend_fill_mask(uint16_t * buf, int32_t buf_w, uint16_t color, uint8_t opa,
+                                                          const uint8_t * mask, int32_t fill_w, int32_t fill_h)
+{
+    uint32_t color2 = PAIR(color, color);
+
+    for(int32_t y = 0; y < fill_h; y++) {
+        uint16_t * d = buf;
+        const uint8_t * m = mask;
+        int32_t n = fill_w;
+
+        if(((uintptr_t)d & 0x2) && n > 0) {
+            if(*m) *d = pair_mix(color, *d, fill_mix(*m, opa));
+            d++;
+            m++;
+            n--;
+        }
+
+        /*Masks are mostly runs of 0 (outside) and 255 (inside): decide those
+         *for a whole pair. The mask is read by bytes; it need not be aligned.*/
+        uint32_t * d32 = (uint32_t *)d;
+        for(; n >= 2; n -= 2, m += 2, d32++) {
+            uint32_t m0 = m[0];
+            uint32_t m1 = m[1];
+            if((m0 | m1) == 0) continue;
+            if((m0 & m1) == 255 && opa == 255) {
+                *d32 = color2;
+                continue;
+            }
+            *d32 = pair_mix2(color2, *d32, fill_mix(m0, opa), fill_mix(m1, opa));
+        }
+        if(n > 0 && *m) {
+            d = (uint16_t *)d32;
+            *d = pair_mix(color, *d, fill_mix(*m, opa));
+        }
+
+        buf += buf_w;
+        mask += fill_w;
+    }
+}
+
+LV_GPU_ESP32_BLEND_ATTR void lv_gpu_esp32_blend_copy(uint16_t * buf, int32_t buf_w, const uint16_t * map, int32_t map_w,
+                                                     int32_t copy_w, int32_t copy_h)
+{
+    for(int32_t y = 0; y < copy_h; y++) {
+        uint16_t * d = buf;
+        const uint16_t * s = map;
+        int32_t n = copy_w;
+
+        if(((uintptr_t)d & 0x2) && n > 0) {
+            *d++ = *s++;
+            n--;
+        }
+
+        uint32_t * d32 = (uint32_t *)d;
+        if(((uintptr_t)s & 0x2) == 0) {
+            const uint32_t * s32 = (const uint32_t *)s;
+            for(; n >= 8; n -= 8) {
+                d32[0] = s32[0];
+                d32[1] = s32[1];
+                d32[2] = s32[2];
+                d32[3] = s32[3];
+                d32 += 4;
+                s32 += 4;
+            }
+            for(; n >= 2; n -= 2) {
+                *d32++ = *s32++;
+            }
+            s = (const uint16_t *)s32;
+        }
+        else {
+            /*The map is off by a halfword: two loads, one store*/
+            for(; n >= 2; n -= 2, s += 2) {
+                *d32++ = PAIR(s[0], s[1]);
+            }
+        }
+        if(n > 0) *(uint16_t *)d32 = *s;
+
+        buf += buf_w;
+        map += map_w;
+    }
+}
+
+LV_GPU_ESP32_BLEND_ATTR void lv_gpu_esp32_blend_map_opa(uint16_t * buf, int32_t buf_w, const uint16_t * map, int32_t map_w,
+                                                        uint8_t opa, int32_t copy_w, int32_t copy_h)
+{
+    for(int32_t y = 0; y < copy_h; y++) {
+        uint16_t * d = buf;
+        const uint16_t * s = map;
+        int32_t n = copy_w;
+
+        if(((uintptr_t)d & 0x2) && n > 0) {
+            *d = pair_mix(*s, *d, opa);
+            d++;
+            s++;
+            n--;
+        }
+
+        /*The map is read by halfwords: its alignment need not match*/
+        uint32_t * d32 = (uint32_t *)d;
+        for(; n >= 2; n -= 2, s += 2, d32++) {
+            *d32 = pair_mix(PAIR(s[0], s[1]), *d32, opa);
+        }
+        if(n > 0) {
+            d = (uint16_t *)d32;
+            *d = pair_mix(*s, *d, opa);
+        }
+
+        buf += buf_w;
+        map += map_w;
+    }
+}
+
+LV_GPU_ESP32_BLEND_ATTR void lv_gpu_esp32_blend_map_mask(uint16_t * buf, int32_t buf_w, const uint16_t * map, int32_t map_w,
+                                                         uint8_t opa, const uint8_t * mask, int32_t copy_w, int32_t copy_h)
+{
+    for(int32_t y = 0; y < copy_h; y++) {
+        uint16_t * d = buf;
+        const uint16_t * s = map;
+        const uint8_t * m = mask;
+        int32_t n = copy_w;
+
+        if(((uintptr_t)d & 0x2) && n > 0) {
+            if(*m) *d = pair_mix(*s, *d, map_mix(*m, opa));
+            d++;
+            s++;
+            m++;
+            n--;
+        }
+
+        uint32_t * d32 = (uint32_t *)d;
+        for(; n >= 2; n -= 2, s += 2, m += 2, d32++) {
+            uint32_t m0 = m[0];
+            uint32_t m1 = m[1];
+            if((m0 | m1) == 0) continue;
+            uint32_t fg = PAIR(s[0], s[1]);
+            if((m0 & m1) == 255 && opa == 255) {
+                *d32 = fg;
+                continue;
+            }
+            *d32 = pair_mix2(fg, *d32, map_mix(m0, opa), map_mix(m1, opa));
+        }
+        if(n > 0 && *m) {
+            d = (uint16_t *)d32;
+            *d = pair_mix(*s, *d, map_mix(*m, opa));
+        }
+
+        buf += buf_w;
+        map += map_w;
+        mask += copy_w;
+    }
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+#endif /*!ESP_PLATFORM || CONFIG_LVGL_FEATURE_USE_GPU_ESP32_BLEND*/
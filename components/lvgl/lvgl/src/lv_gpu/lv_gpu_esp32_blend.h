@@ -0,0 +1,155 @@
+/**
+ * @file lv_gpu_esp32_blend.h
+ *
+ * Software blend kernels for the ESP32 and a 16 bit, byte swapped
+ * (LV_COLOR_16_SWAP) display buffer. `fill_normal` and `map_normal` in
+ * lv_draw_blend.c hand whole areas to them when LV_USE_GPU_ESP32_BLEND is
+ * set and they are enabled (the default); their per-pixel C code stays the
+ * reference the kernels must match bit for bit, and draws while they are
+ * disabled.
+ *
+ * - They run from IRAM, so a cache miss on the draw path does not stall them
+ * - Two pixels are loaded and stored as one 32 bit word; the opaque fill is
+ *   unrolled to 8 pixels per loop
+ * - Mixing keeps red and blue in the two 16 bit halves of one word, so one
+ *   multiply scales both, and divides by 255 with shifts and adds. The
+ *   result equals `lv_color_mix` (LV_MATH_UDIV255, LV_COLOR_MIX_ROUND_OFS 128).
+ *
+ * Pixels are plain uint16_t (`lv_color_t.full`) and there are no LVGL or
+ * ESP-IDF dependencies, so the kernels also build on a host
+ * (tools/blend_kernel_check.c).
+ */
+
+#ifndef LV_GPU_ESP32_BLEND_H
+#define LV_GPU_ESP32_BLEND_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+#ifdef ESP_PLATFORM
+#include "esp_attr.h"
+#define LV_GPU_ESP32_BLEND_ATTR IRAM_ATTR
+#else
+#define LV_GPU_ESP32_BLEND_ATTR
+#endif
+
+/*Same as LV_OPA_MAX: a mask value from which `map_normal` uses `opa` as it is*/
+#define LV_GPU_ESP32_BLEND_OPA_MAX  250
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/**
+ * Let `fill_normal` and `map_normal` use the kernels, or their own C code
+ * (to compare the two)
+ * @param en true: kernels (default), false: C code
+ */
+void lv_gpu_esp32_blend_set_enabled(bool en);
+
+/**
+ * @return true: `fill_normal` and `map_normal` use the kernels
+ */
+bool lv_gpu_esp32_blend_is_enabled(void);
+
+/**
+ * Fill an area of the buffer with a color
+ * @param buf first pixel to fill
+ * @param buf_w width of the buffer in pixels
+ * @param color fill color
+ * @param fill_w width to fill in pixels (<= buf_w)
+ * @param fill_h height to fill in pixels
+ */
+void lv_gpu_esp32_blend_fill(uint16_t * buf, int32_t buf_w, uint16_t color, int32_t fill_w, int32_t fill_h);
+
+/**
+ * Mix a color into an area of the buffer
+ * @param buf first pixel to fill
+ * @param buf_w width of the buffer in pixels
+ * @param color fill color
+ * @param opa opacity of `color`, below 255
+ * @param fill_w width to fill in pixels (<= buf_w)
+ * @param fill_h height to fill in pixels
+ */
+void lv_gpu_esp32_blend_fill_opa(uint16_t * buf, int32_t buf_w, uint16_t color, uint8_t opa,
+                                 int32_t fill_w, int32_t fill_h);
+
+/**
+ * Mix a color into an area of the buffer through a mask
+ * @param buf first pixel to fill
+ * @param buf_w width of the buffer in pixels
+ * @param color fill color
+ * @param opa 255: the mask is the opacity. Below: 255 in the mask means `opa`,
+ *            other values `mask * opa >> 8`
+ * @param mask opacity of each pixel, `fill_w` values per line
+ * @param fill_w width to fill in pixels (<= buf_w)
+ * @param fill_h height to fill in pixels
+ */
+void lv_gpu_esp32_blend_fill_mask(uint16_t * buf, int32_t buf_w, uint16_t color, uint8_t opa,
+                                  const uint8_t * mask, int32_t fill_w, int32_t fill_h);
+
+/**
+ * Copy a map (e.g. an RGB image) to an area of the buffer
+ * @param buf first pixel to copy to
+ * @param buf_w width of the buffer in pixels
+ * @param map first pixel of the map to copy
+ * @param map_w width of the map in pixels
+ * @param copy_w width to copy in pixels (<= buf_w, map_w)
+ * @param copy_h height to copy in pixels
+ * @note unlike `_lv_memcpy` it copies words also when only one of `buf` and
+ *       `map` is word aligned
+ */
+void lv_gpu_esp32_blend_copy(uint16_t * buf, int32_t buf_w, const uint16_t * map, int32_t map_w,
+                             int32_t copy_w, int32_t copy_h);
+
+/**
+ * Mix a map into an area of the buffer
+ * @param buf first pixel to blend into
+ * @param buf_w width of the buffer in pixels
+ * @param map first pixel of the map to blend
+ * @param map_w width of the map in pixels
+ * @param opa opacity of the map, below 255
+ * @param copy_w width to blend in pixels (<= buf_w, map_w)
+ * @param copy_h height to blend in pixels
+ */
+void lv_gpu_esp32_blend_map_opa(uint16_t * buf, int32_t buf_w, const uint16_t * map, int32_t map_w,
+                                uint8_t opa, int32_t copy_w, int32_t copy_h);
+
+/**
+ * Mix a map into an area of the buffer through a mask
+ * @param buf first pixel to blend into
+ * @param buf_w width of the buffer in pixels
+ * @param map first pixel of the map to blend
+ * @param map_w width of the map in pixels
+ * @param opa 255: the mask is the opacity. Below: mask values from
+ *            LV_GPU_ESP32_BLEND_OPA_MAX mean `opa`, others `opa * mask >> 8`
+ * @param mask opacity of each pixel, `copy_w` values per line
+ * @param copy_w width to blend in pixels (<= buf_w, map_w)
+ * @param copy_h height to blend in pixels
+ */
+void lv_gpu_esp32_blend_map_mask(uint16_t * buf, int32_t buf_w, const uint16_t * map, int32_t map_w,
+                                 uint8_t opa, const uint8_t * mask, int32_t copy_w, int32_t copy_h);
+
+/**********************
+ *      MACROS
+ **********************/
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /*LV_GPU_ESP32_BLEND_H*/
@@ -10,7 +10,9 @@
 #if LV_USE_GAUGE != 0
 
 #include "../lv_core/lv_debug.h"
+#include "../lv_core/lv_refr.h"
 #include "../lv_draw/lv_draw.h"
+#include "../lv_draw/lv_img_cache.h"
 #include "../lv_themes/lv_theme.h"
 #include "../lv_misc/lv_txt.h"
 #include "../lv_misc/lv_math.h"
@@ -41,6 +43,8 @@ static lv_res_t lv_gauge_signal(lv_obj_t * gauge, lv_signal_t sign, void * param
 static lv_style_list_t * lv_gauge_get_style(lv_obj_t * gauge, uint8_t part);
 static void lv_gauge_draw_labels(lv_obj_t * gauge, const lv_area_t * mask);
 static void lv_gauge_draw_needle(lv_obj_t * gauge, const lv_area_t * clip_area);
+static void lv_gauge_draw_face(lv_obj_t * gauge, const lv_area_t * clip_area);
+static bool lv_gauge_face_usable(lv_obj_t * gauge);
 
 /**********************
  *  STATIC VARIABLES
@@ -89,6 +93,7 @@ lv_obj_t * lv_gauge_create(lv_obj_t * par, const lv_obj_t * copy)
     ext->needle_img = 0;
     ext->needle_img_pivot.x = 0;
     ext->needle_img_pivot.y = 0;
+    ext->face_img = NULL;
     if(ancestor_signal == NULL) ancestor_signal = lv_obj_get_signal_cb(gauge);
     if(ancestor_design == NULL) ancestor_design = lv_obj_get_design_cb(gauge);
 
@@ -291,6 +296,73 @@ void lv_gauge_set_needle_img(lv_obj_t * gauge, const void * img, lv_coord_t pivo
     lv_obj_invalidate(gauge);
 }
 
+/**
+ * Draw the background, the scale and the labels from an image and only the needles on it.
+ * Moving a needle then redraws the image under it instead of the scale and the background.
+ * The image is used only while it is as large as the gauge.
+ * @param gauge pointer to a gauge object
+ * @param img a true color image filled by `lv_gauge_render_face()`, NULL to draw everything again
+ */
+void lv_gauge_set_face_img(lv_obj_t * gauge, const lv_img_dsc_t * img)
+{
+    LV_ASSERT_OBJ(gauge, LV_OBJX_NAME);
+
+    lv_gauge_ext_t * ext = lv_obj_get_ext_attr(gauge);
+    if(ext->face_img == img) return;
+
+    ext->face_img = img;
+    lv_obj_invalidate(gauge);
+}
+
+/**
+ * Render the background, the scale and the labels of a gauge into an image.
+ * Render it again after the styles of the gauge change (e.g. a new theme).
+ * @param gauge pointer to a gauge object
+ * @param img a true color image as large as the gauge
+ * @param bg_color color of the corners outside the gauge's background (e.g. the parent's background)
+ */
+void lv_gauge_render_face(lv_obj_t * gauge, lv_img_dsc_t * img, lv_color_t bg_color)
+{
+    LV_ASSERT_OBJ(gauge, LV_OBJX_NAME);
+
+    lv_coord_t w = lv_obj_get_width(gauge);
+    lv_coord_t h = lv_obj_get_height(gauge);
+    if(img->header.cf != LV_IMG_CF_TRUE_COLOR || img->header.w != w || img->header.h != h) {
+        LV_LOG_WARN("lv_gauge_render_face: the image must be a true color image as large as the gauge");
+        return;
+    }
+
+    lv_color_t * px = (lv_color_t *)img->data;
+    uint32_t i;
+    for(i = 0; i < (uint32_t)w * h; i++) px[i] = bg_color;
+
+    /* Create a dummy display whose buffer is the image at the gauge's position
+     * (like `lv_canvas` does) so the gauge draws its face with its own functions */
+    lv_disp_t disp;
+    _lv_memset_00(&disp, sizeof(lv_disp_t));
+
+    lv_disp_buf_t disp_buf;
+    lv_disp_buf_init(&disp_buf, px, NULL, (uint32_t)w * h);
+    lv_area_copy(&disp_buf.area, &gauge->coords);
+
+    lv_disp_drv_init(&disp.driver);
+    disp.driver.buffer  = &disp_buf;
+    disp.driver.hor_res = gauge->coords.x2 + 1;
+    disp.driver.ver_res = gauge->coords.y2 + 1;
+
+    lv_disp_t * refr_ori = _lv_refr_get_disp_refreshing();
+    _lv_refr_set_disp_refreshing(&disp);
+
+    lv_gauge_draw_face(gauge, &gauge->coords);
+
+    _lv_refr_set_disp_refreshing(refr_ori);
+
+    lv_img_cache_invalidate_src(img);
+
+    lv_gauge_ext_t * ext = lv_obj_get_ext_attr(gauge);
+    if(ext->face_img == img) lv_obj_invalidate(gauge);
+}
+
 /**
  * Assign a function to format gauge values
  * @param gauge pointer to a gauge object
@@ -396,6 +468,20 @@ lv_coord_t lv_gauge_get_needle_img_pivot_y(lv_obj_t * gauge)
     return ext->needle_img_pivot.y;
 }
 
+/**
+ * Get the image the background, the scale and the labels are drawn from
+ * @param gauge pointer to a gauge object
+ * @return the image set by `lv_gauge_set_face_img()`, `NULL` if not used.
+ */
+const lv_img_dsc_t * lv_gauge_get_face_img(lv_obj_t * gauge)
+{
+    LV_ASSERT_OBJ(gauge, LV_OBJX_NAME);
+
+    lv_gauge_ext_t * ext = lv_obj_get_ext_attr(gauge);
+
+    return ext->face_img;
+}
+
 
 /**********************
  *   STATIC FUNCTIONS
@@ -415,20 +501,25 @@ static lv_design_res_t lv_gauge_design(lv_obj_t * gauge, const lv_area_t * clip_
 {
     /*Return false if the object is not covers the mask_p area*/
     if(mode == LV_DESIGN_COVER_CHK) {
-        return LV_DESIGN_RES_NOT_COVER;
+        /*The face image is opaque, corners included*/
+        if(lv_gauge_face_usable(gauge) == false) return LV_DESIGN_RES_NOT_COVER;
+        if(lv_obj_get_style_opa_scale(gauge, LV_GAUGE_PART_MAIN) < LV_OPA_MAX) return LV_DESIGN_RES_NOT_COVER;
+        if(_lv_area_is_in(clip_area, &gauge->coords, 0) == false) return LV_DESIGN_RES_NOT_COVER;
+
+        return LV_DESIGN_RES_COVER;
     }
     /*Draw the object*/
     else if(mode == LV_DESIGN_DRAW_MAIN) {
-        ancestor_design(gauge, clip_area, mode);
-
-        lv_gauge_ext_t * ext           = lv_obj_get_ext_attr(gauge);
-        lv_gauge_draw_labels(gauge, clip_area);
-
-        /*Add the strong lines*/
-        uint16_t line_cnt_tmp = ext->lmeter.line_cnt;
-        ext->lmeter.line_cnt         = ext->label_count;                 /*Only to labels*/
-        lv_linemeter_draw_scale(gauge, clip_area, LV_GAUGE_PART_MAJOR);
-        ext->lmeter.line_cnt = line_cnt_tmp; /*Restore the parameters*/
+        if(lv_gauge_face_usable(gauge)) {
+            lv_gauge_ext_t * ext = lv_obj_get_ext_attr(gauge);
+            lv_draw_img_dsc_t img_dsc;
+            lv_draw_img_dsc_init(&img_dsc);
+            img_dsc.opa = lv_obj_get_style_opa_scale(gauge, LV_GAUGE_PART_MAIN);
+            lv_draw_img(&gauge->coords, clip_area, ext->face_img, &img_dsc);
+        }
+        else {
+            lv_gauge_draw_face(gauge, clip_area);
+        }
 
         lv_gauge_draw_needle(gauge, clip_area);
     }
@@ -501,6 +592,39 @@ static lv_style_list_t * lv_gauge_get_style(lv_obj_t * gauge, uint8_t part)
 
     return style_dsc_p;
 }
+/**
+ * Draw the background, the scale and the labels of a gauge
+ * @param gauge pointer to gauge object
+ * @param clip_area the object will be drawn only in this area
+ */
+static void lv_gauge_draw_face(lv_obj_t * gauge, const lv_area_t * clip_area)
+{
+    ancestor_design(gauge, clip_area, LV_DESIGN_DRAW_MAIN);
+
+    lv_gauge_ext_t * ext           = lv_obj_get_ext_attr(gauge);
+    lv_gauge_draw_labels(gauge, clip_area);
+
+    /*Add the strong lines*/
+    uint16_t line_cnt_tmp = ext->lmeter.line_cnt;
+    ext->lmeter.line_cnt         = ext->label_count;                 /*Only to labels*/
+    lv_linemeter_draw_scale(gauge, clip_area, LV_GAUGE_PART_MAJOR);
+    ext->lmeter.line_cnt = line_cnt_tmp; /*Restore the parameters*/
+}
+
+/**
+ * Tell whether the face image can be drawn instead of the face
+ * @param gauge pointer to gauge object
+ * @return true: the gauge has a face image as large as itself
+ */
+static bool lv_gauge_face_usable(lv_obj_t * gauge)
+{
+    lv_gauge_ext_t * ext = lv_obj_get_ext_attr(gauge);
+    if(ext->face_img == NULL) return false;
+
+    return ext->face_img->header.w == lv_obj_get_width(gauge) &&
+           ext->face_img->header.h == lv_obj_get_height(gauge);
+}
+
 /**
  * Draw the scale on a gauge
  * @param gauge pointer to gauge object
@@ -50,6 +50,7 @@ typedef struct {
     uint8_t needle_count;             /*Number of needles*/
     uint8_t label_count;              /*Number of labels on the scale*/
     lv_gauge_format_cb_t format_cb;
+    const lv_img_dsc_t * face_img;    /*Pre-rendered background, scale and labels (NULL: draw them)*/
 } lv_gauge_ext_t;
 
 /*Styles*/
@@ -154,6 +155,24 @@ void lv_gauge_set_needle_img(lv_obj_t * gauge, const void * img, lv_coord_t pivo
  */
 void lv_gauge_set_formatter_cb(lv_obj_t * gauge, lv_gauge_format_cb_t format_cb);
 
+/**
+ * Draw the background, the scale and the labels from an image and only the needles on it.
+ * Moving a needle then redraws the image under it instead of the scale and the background.
+ * The image is used only while it is as large as the gauge.
+ * @param gauge pointer to a gauge object
+ * @param img a true color image filled by `lv_gauge_render_face()`, NULL to draw everything again
+ */
+void lv_gauge_set_face_img(lv_obj_t * gauge, const lv_img_dsc_t * img);
+
+/**
+ * Render the background, the scale and the labels of a gauge into an image.
+ * Render it again after the styles of the gauge change (e.g. a new theme).
+ * @param gauge pointer to a gauge object
+ * @param img a true color image as large as the gauge
+ * @param bg_color color of the corners outside the gauge's background (e.g. the parent's background)
+ */
+void lv_gauge_render_face(lv_obj_t * gauge, lv_img_dsc_t * img, lv_color_t bg_color);
+
 /*=====================
  * Getter functions
  *====================*/
@@ -262,6 +281,13 @@ lv_coord_t lv_gauge_get_needle_img_pivot_x(lv_obj_t * gauge);
  */
 lv_coord_t lv_gauge_get_needle_img_pivot_y(lv_obj_t * gauge);
 
+/**
+ * Get the image the background, the scale and the labels are drawn from
+ * @param gauge pointer to a gauge object
+ * @return the image set by `lv_gauge_set_face_img()`, `NULL` if not used.
+ */
+const lv_img_dsc_t * lv_gauge_get_face_img(lv_obj_t * gauge);
+
 /**********************
  *      MACROS
  **********************/
@@ -0,0 +1,194 @@
+/**
+ * @file lvgl_profile.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "sdkconfig.h"
+
+#if CONFIG_LVGL_CODE_PLACEMENT_PROFILE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lvgl_profile.h"
+#include "esp_attr.h"
+#include "esp_cpu.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define TAG "lvgl_profile"
+
+#define PROFILE_SLOTS_LOG2  10      /* LVGL has ~1500 functions, a session calls fewer */
+#define PROFILE_SLOTS       (1 << PROFILE_SLOTS_LOG2)
+#define PROFILE_DEPTH       64      /* LVGL call depth followed; deeper calls count in their caller */
+
+/* The hooks must not call themselves */
+#define PROFILE_HOOK        IRAM_ATTR __attribute__((no_instrument_function))
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct {
+    uint32_t fn;                /* Entry address, 0: free */
+    uint32_t calls;
+    uint64_t cycles;            /* Self cycles */
+} profile_slot_t;
+
+/* An LVGL function the profiled task is in */
+typedef struct {
+    uint32_t fn;
+    uint32_t start;             /* CCOUNT on entry */
+    uint32_t child;             /* Cycles in the LVGL functions it called */
+} profile_frame_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+void __cyg_profile_func_enter(void *fn, void *call_site) PROFILE_HOOK;
+void __cyg_profile_func_exit(void *fn, void *call_site) PROFILE_HOOK;
+static int slot_cmp(const void *a, const void *b);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static profile_slot_t *slots;
+static profile_frame_t stack[PROFILE_DEPTH];
+static int depth;
+static uint32_t dropped;
+static volatile TaskHandle_t profiled_task;     /* NULL: not profiling */
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+bool lvgl_profile_start(void)
+{
+    if (slots == NULL) {
+        slots = heap_caps_malloc(PROFILE_SLOTS * sizeof(profile_slot_t), MALLOC_CAP_INTERNAL);
+        if (slots == NULL) {
+            ESP_LOGE(TAG, "No memory for %d counters", PROFILE_SLOTS);
+            return false;
+        }
+    }
+    memset(slots, 0, PROFILE_SLOTS * sizeof(profile_slot_t));
+    depth = 0;
+    dropped = 0;
+    profiled_task = xTaskGetCurrentTaskHandle();
+    return true;
+}
+
+void lvgl_profile_stop(void)
+{
+    profiled_task = NULL;
+}
+
+void lvgl_profile_get_stats(lvgl_profile_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    stats->dropped = dropped;
+    if (slots == NULL) {
+        return;
+    }
+    for (int i = 0; i < PROFILE_SLOTS; i++) {
+        if (slots[i].fn) {
+            stats->functions++;
+            stats->cycles += slots[i].cycles;
+        }
+    }
+}
+
+void lvgl_profile_print(void)
+{
+    if (slots == NULL || profiled_task != NULL) {
+        return;
+    }
+    /* Sorting moves the slots off their hash positions; start() clears them */
+    qsort(slots, PROFILE_SLOTS, sizeof(profile_slot_t), slot_cmp);
+    for (int i = 0; i < PROFILE_SLOTS && slots[i].fn; i++) {
+        printf("P 0x%08lx %lu %llu\n", (unsigned long)slots[i].fn, (unsigned long)slots[i].calls,
+               (unsigned long long)slots[i].cycles);
+    }
+}
+
+/* Called by the instrumented LVGL code on entry to every function */
+void __cyg_profile_func_enter(void *fn, void *call_site)
+{
+    (void)call_site;
+    if (profiled_task == NULL || xPortInIsrContext() || xTaskGetCurrentTaskHandle() != profiled_task) {
+        return;
+    }
+    if (depth < PROFILE_DEPTH) {
+        profile_frame_t *f = &stack[depth];
+        f->fn = (uint32_t)(uintptr_t)fn;
+        f->child = 0;
+        f->start = esp_cpu_get_cycle_count();
+    }
+    depth++;
+}
+
+/* ... and on every return */
+void __cyg_profile_func_exit(void *fn, void *call_site)
+{
+    uint32_t now = esp_cpu_get_cycle_count();
+    (void)fn;
+    (void)call_site;
+
+    if (profiled_task == NULL || xPortInIsrContext() || xTaskGetCurrentTaskHandle() != profiled_task ||
+        depth == 0) {
+        return;
+    }
+    depth--;
+    if (depth >= PROFILE_DEPTH) {
+        dropped++;
+        return;
+    }
+
+    profile_frame_t *f = &stack[depth];
+    uint32_t total = now - f->start;
+    if (depth > 0) {
+        stack[depth - 1].child += total;
+    }
+
+    /* Fibonacci hash of the word address, then linear probing */
+    uint32_t i = ((f->fn >> 2) * 2654435761u) >> (32 - PROFILE_SLOTS_LOG2);
+    for (int n = 0; n < PROFILE_SLOTS; n++, i = (i + 1) & (PROFILE_SLOTS - 1)) {
+        profile_slot_t *s = &slots[i];
+        if (s->fn == f->fn || s->fn == 0) {
+            s->fn = f->fn;
+            s->calls++;
+            s->cycles += total - f->child;
+            return;
+        }
+    }
+    dropped++;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+static int slot_cmp(const void *a, const void *b)
+{
+    const profile_slot_t *sa = a;
+    const profile_slot_t *sb = b;
+    if ((sa->fn == 0) != (sb->fn == 0)) {
+        return sa->fn == 0 ? 1 : -1;    /* Free slots last */
+    }
+    if (sa->cycles != sb->cycles) {
+        return sa->cycles < sb->cycles ? 1 : -1;
+    }
+    return sa->fn < sb->fn ? -1 : sa->fn > sb->fn;
+}
+
+#endif /*CONFIG_LVGL_CODE_PLACEMENT_PROFILE*/
@@ -0,0 +1,64 @@
+/**
+ * @file lvgl_profile.h
+ *
+ * Cycles per LVGL function, for placing the hot ones in IRAM. With
+ * CONFIG_LVGL_CODE_PLACEMENT_PROFILE the lvgl component is built with
+ * -finstrument-functions, so every LVGL function calls a hook on entry and
+ * exit. While profiling, the hooks count calls and self cycles (the time in
+ * a function minus the time in the LVGL functions it called) of the task
+ * that started the profile. tools/lvgl_iram_place.py turns the printed
+ * counters into lvgl_iram.lf.
+ */
+
+#ifndef LVGL_PROFILE_H
+#define LVGL_PROFILE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdbool.h>
+#include <stdint.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct {
+    uint32_t functions;         /* Functions with at least one call */
+    uint64_t cycles;            /* Self cycles of all of them */
+    uint32_t dropped;           /* Calls not counted: table full or too deep */
+} lvgl_profile_stats_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+/* Clear the counters and count the LVGL calls of the calling task, which
+ * must not be inside an LVGL function. Returns false when the counter table
+ * cannot be allocated. */
+bool lvgl_profile_start(void);
+
+/* Stop counting; the counters stay until the next start */
+void lvgl_profile_stop(void);
+
+void lvgl_profile_get_stats(lvgl_profile_stats_t *stats);
+
+/* Print one "P <address> <calls> <self cycles>" line per function, most
+ * cycles first */
+void lvgl_profile_print(void);
+
+/**********************
+ *      MACROS
+ **********************/
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /*LVGL_PROFILE_H*/
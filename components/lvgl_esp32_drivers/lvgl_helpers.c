@@ -28,10 +28,14 @@ void lvgl_driver_init(void)
     disp_spi_add_device(TFT_SPI_HOST);
     disp_driver_init();
 
-    // 电阻触摸屏初始化 使用GPIO模拟SPI
+    // 电阻触摸屏初始化
+#if CONFIG_LVGL_TOUCH_XPT2046_GPIO_SPI
+    printf("%s->Touch SPI bit-banged on GPIOs\n",TAG);
+#else
     printf("%s->Initializing SPI master for touch\n",TAG);
-    //lvgl_spi_driver_init(TOUCH_SPI_HOST,TP_SPI_MISO, TP_SPI_MOSI, TP_SPI_CLK,0 /* Defaults to 4094 */, 2,-1, -1);
-    //tp_spi_add_device(TOUCH_SPI_HOST);
+    // One burst per read fits the FIFO, no DMA needed
+    lvgl_spi_driver_init(TOUCH_SPI_HOST,TP_SPI_MISO, TP_SPI_MOSI, TP_SPI_CLK,0 /* Defaults to 64 without DMA */, SPI_DMA_DISABLED,-1, -1);
+#endif
     touch_driver_init();
 }
 
@@ -21,31 +21,25 @@ extern "C" {
 /*********************
  *      DEFINES
  *********************/
-#if defined (CONFIG_LVGL_TFT_DISPLAY_CONTROLLER_ST7789)
-#define DISP_BUF_SIZE  (LV_HOR_RES_MAX * 40)
-#elif defined CONFIG_LVGL_TFT_DISPLAY_CONTROLLER_ST7735S
-#define DISP_BUF_SIZE  (LV_HOR_RES_MAX * 40)
-#elif defined CONFIG_LVGL_TFT_DISPLAY_CONTROLLER_HX8357
-#define DISP_BUF_SIZE  (LV_HOR_RES_MAX * 40)
-#elif defined CONFIG_LVGL_TFT_DISPLAY_CONTROLLER_SH1107
+/* Stripe controllers render CONFIG_LVGL_DISP_BUF_LINES lines per buffer,
+ * monochrome ones need the whole frame */
+#if defined CONFIG_LVGL_TFT_DISPLAY_CONTROLLER_SH1107
 #define DISP_BUF_SIZE  (CONFIG_LVGL_DISPLAY_WIDTH*CONFIG_LVGL_DISPLAY_HEIGHT)
-#elif defined CONFIG_LVGL_TFT_DISPLAY_CONTROLLER_ILI9481
-#define DISP_BUF_SIZE  (LV_HOR_RES_MAX * 40)
-#elif defined CONFIG_LVGL_TFT_DISPLAY_CONTROLLER_ILI9486
-#define DISP_BUF_SIZE  (LV_HOR_RES_MAX * 40)
-#elif defined CONFIG_LVGL_TFT_DISPLAY_CONTROLLER_ILI9488
-#define DISP_BUF_SIZE  (LV_HOR_RES_MAX * 40)
-#elif defined CONFIG_LVGL_TFT_DISPLAY_CONTROLLER_ILI9341
-#define DISP_BUF_SIZE  (LV_HOR_RES_MAX * 64)
 #elif defined CONFIG_LVGL_TFT_DISPLAY_CONTROLLER_SSD1306
 #define DISP_BUF_SIZE  (CONFIG_LVGL_DISPLAY_WIDTH*CONFIG_LVGL_DISPLAY_HEIGHT)
-#elif defined (CONFIG_LVGL_TFT_DISPLAY_CONTROLLER_FT81X)
-#define DISP_BUF_LINES  40
-#define DISP_BUF_SIZE  (LV_HOR_RES_MAX * DISP_BUF_LINES)
 #elif defined (CONFIG_LVGL_TFT_DISPLAY_CONTROLLER_IL3820)
 #define DISP_BUF_SIZE (CONFIG_LVGL_DISPLAY_HEIGHT * IL3820_COLUMNS)
-#elif defined CONFIG_LVGL_TFT_DISPLAY_CONTROLLER_RA8875
-#define DISP_BUF_SIZE  (LV_HOR_RES_MAX * 40)
+#elif defined (CONFIG_LVGL_TFT_DISPLAY_CONTROLLER_ST7789)  || \
+      defined (CONFIG_LVGL_TFT_DISPLAY_CONTROLLER_ST7735S) || \
+      defined (CONFIG_LVGL_TFT_DISPLAY_CONTROLLER_HX8357)  || \
+      defined (CONFIG_LVGL_TFT_DISPLAY_CONTROLLER_ILI9481) || \
+      defined (CONFIG_LVGL_TFT_DISPLAY_CONTROLLER_ILI9486) || \
+      defined (CONFIG_LVGL_TFT_DISPLAY_CONTROLLER_ILI9488) || \
+      defined (CONFIG_LVGL_TFT_DISPLAY_CONTROLLER_ILI9341) || \
+      defined (CONFIG_LVGL_TFT_DISPLAY_CONTROLLER_FT81X)   || \
+      defined (CONFIG_LVGL_TFT_DISPLAY_CONTROLLER_RA8875)
+#define DISP_BUF_LINES  CONFIG_LVGL_DISP_BUF_LINES
+#define DISP_BUF_SIZE  (LV_HOR_RES_MAX * DISP_BUF_LINES)
 #else
 #error "No display controller selected"
 #endif
@@ -27,11 +27,21 @@ extern "C" {
     #define DISP_SPI_INPUT_DELAY_NS (0)
 #endif
 #define DISP_SPI_CLK CONFIG_LVGL_DISP_SPI_CLK
+#if defined (CONFIG_LVGL_DISP_SPI_TRANS_QUEUE_DEPTH)
+    #define DISP_SPI_TRANS_QUEUE_DEPTH CONFIG_LVGL_DISP_SPI_TRANS_QUEUE_DEPTH
+#else
+    #define DISP_SPI_TRANS_QUEUE_DEPTH (8)
+#endif
 #if defined (CONFIG_LVGL_DISPLAY_USE_SPI_CS)
     #define DISP_SPI_CS CONFIG_LVGL_DISP_SPI_CS
 #else
     #define DISP_SPI_CS (-1)
 #endif
+#if defined (CONFIG_LVGL_DISPLAY_USE_DC)
+    #define DISP_SPI_DC CONFIG_LVGL_DISP_PIN_DC
+#else
+    #define DISP_SPI_DC (-1)
+#endif
 
 /* Define TOUCHPAD PINS when selecting a touch controller */
 #if !defined (CONFIG_LVGL_TOUCH_CONTROLLER_NONE)
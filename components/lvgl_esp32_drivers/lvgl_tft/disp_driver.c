@@ -30,6 +30,59 @@ void disp_driver_flush(lv_disp_drv_t * drv, const lv_area_t * area, lv_color_t *
 
 }
 
+void disp_driver_set_brightness(uint8_t percent)
+{
+#if defined CONFIG_LVGL_TFT_DISPLAY_CONTROLLER_ILI9341
+    ili9341_set_brightness(percent);
+#else
+    (void) percent;
+#endif
+}
+
+void disp_driver_sleep(bool sleep)
+{
+#if defined CONFIG_LVGL_TFT_DISPLAY_CONTROLLER_ILI9341
+    if (sleep) {
+        ili9341_sleep_in();
+    } else {
+        ili9341_sleep_out();
+    }
+#else
+    (void) sleep;
+#endif
+}
+
+void disp_driver_wait_cb(lv_disp_drv_t * drv)
+{
+    (void) drv;
+#if defined CONFIG_LVGL_TFT_DISPLAY_PROTOCOL_SPI
+    disp_spi_wait_flush();
+#endif
+}
+
+#if defined CONFIG_LVGL_DISP_SPI_CLOCK_TUNE
+bool disp_driver_tune_clock(disp_panel_clock_t * clock)
+{
+    return ili9341_tune_clock(clock);
+}
+
+bool disp_driver_check_clock(const disp_panel_clock_t * clock, uint16_t rows)
+{
+    if (!clock->verified) {
+        return true;
+    }
+
+    /* Test the fastest clock that passed, not the one in use: a shrinking
+     * margin shows up before the running clock corrupts pixels */
+    int bad = ili9341_test_clock(clock->passed_hz, rows);
+
+    disp_spi_change_device_speed(clock->clock_hz);
+
+    /* No RAM for the test (-1) tells nothing, keep the clock */
+    return bad <= 0;
+}
+#endif
+
 void disp_driver_rounder(lv_disp_drv_t * disp_drv, lv_area_t * area)
 {
 #if defined CONFIG_LVGL_TFT_DISPLAY_CONTROLLER_SSD1306
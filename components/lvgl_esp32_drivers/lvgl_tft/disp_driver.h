@@ -13,6 +13,7 @@ extern "C" {
  *      INCLUDES
  *********************/
 #include "lvgl/lvgl.h"
+#include "disp_panel.h"
 
 #if defined CONFIG_LVGL_TFT_DISPLAY_CONTROLLER_ILI9341
 #include "ili9341.h"
@@ -58,6 +59,27 @@ void disp_driver_init(void);
 /* Display flush callback */
 void disp_driver_flush(lv_disp_drv_t * drv, const lv_area_t * area, lv_color_t * color_map);
 
+/* Backlight at 0-100 % (CONFIG_LVGL_BACKLIGHT_PWM), otherwise on/off */
+void disp_driver_set_brightness(uint8_t percent);
+
+/* Panel sleep in/out after the queued SPI transfers (drain a flush worker
+ * first). Blocks up to 120 ms. */
+void disp_driver_sleep(bool sleep);
+
+/* Display wait callback: sleeps while LVGL waits for a flush to finish */
+void disp_driver_wait_cb(lv_disp_drv_t * drv);
+
+#if defined CONFIG_LVGL_DISP_SPI_CLOCK_TUNE
+/* Pick the SPI clock by writing and reading back test patterns (disp_panel.h).
+ * Returns false if nothing could be read back; the configured clock stays.
+ * The top DISP_PANEL_TUNE_ROWS rows must be redrawn afterwards. */
+bool disp_driver_tune_clock(disp_panel_clock_t * clock);
+
+/* Test clock->passed_hz again on the given number of rows and go back to
+ * clock->clock_hz. Returns false if the pattern came back damaged. */
+bool disp_driver_check_clock(const disp_panel_clock_t * clock, uint16_t rows);
+#endif
+
 /* Display rounder callback, used with monochrome dispays */
 void disp_driver_rounder(lv_disp_drv_t * disp_drv, lv_area_t * area);
 
@@ -0,0 +1,541 @@
+/**
+ * @file disp_panel.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <assert.h>
+
+#include "disp_panel.h"
+#include "disp_spi.h"
+#include "driver/gpio.h"
+#if CONFIG_LVGL_BACKLIGHT_PWM
+#include "driver/ledc.h"
+#endif
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "../lvgl_helpers.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define TAG "disp_panel"
+
+#define PANEL_DC    CONFIG_LVGL_DISP_PIN_DC
+#define PANEL_RST   CONFIG_LVGL_DISP_PIN_RST
+
+#if CONFIG_LVGL_ENABLE_BACKLIGHT_CONTROL
+#define PANEL_BCKL  CONFIG_LVGL_DISP_PIN_BCKL
+#endif
+
+#if CONFIG_LVGL_BACKLIGHT_ACTIVE_LVL
+#define PANEL_BCKL_ACTIVE_LVL 1
+#else
+#define PANEL_BCKL_ACTIVE_LVL 0
+#endif
+
+#if CONFIG_LVGL_BACKLIGHT_PWM
+#define BCKL_LEDC_MODE      LEDC_LOW_SPEED_MODE
+#define BCKL_LEDC_TIMER     LEDC_TIMER_0
+#define BCKL_LEDC_CHANNEL   LEDC_CHANNEL_0
+#define BCKL_LEDC_BITS      LEDC_TIMER_10_BIT
+#define BCKL_LEDC_HZ        5000    /* Above flicker, below the LED driver's slew limit */
+#endif
+
+/* After SLPIN/SLPOUT the panel takes 5 ms before the next command, and
+ * 120 ms must pass between SLPOUT and SLPIN (either way round) */
+#define SLEEP_CMD_MS        5
+#define SLEEP_TOGGLE_MS     120
+
+/* The SPI clock is 80 MHz / n. RAMRD runs at 80 / 12 = 6.7 MHz, inside the
+ * ILI9341's 150 ns serial read cycle, so only the write clock is tested. */
+#define APB_CLOCK_HZ        (80 * 1000 * 1000)
+#define READ_CLOCK_HZ       (APB_CLOCK_HZ / 12)
+#define TUNE_SLOWEST_DIV    8
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static void queue_cmd(uint8_t cmd);
+static void queue_window_data(uint8_t *buf, uint16_t start, uint16_t end);
+static size_t widen(const uint8_t *src, uint8_t *dst, size_t length);
+static void send_window(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2);
+static void fill_pattern(uint8_t *px, uint16_t rows);
+static uint32_t compare_pattern(const uint8_t *px, const uint8_t *rgb666, uint32_t count);
+#if CONFIG_LVGL_BACKLIGHT_PWM
+static void backlight_pwm_init(void);
+#endif
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static const disp_panel_t *panel;
+static uint8_t panel_orientation;
+
+/* Pixels converted for 3 byte per pixel panels, kept until the next flush */
+static uint8_t *convert_buf;
+
+/* Window parameters of a 16-bit bus panel do not fit the 4 inline bytes of a
+ * transaction; they stay valid because LVGL only flushes again after the
+ * pixels of this flush (queued behind them) have been sent. */
+static uint8_t window_buf[2][8];
+
+/* Seed of the random pattern rows, different for every test */
+static uint32_t pattern_seed = 0x1234567;
+
+/* Sleep state; the init stream ends with SLPOUT */
+static bool panel_asleep;
+static int64_t sleep_toggled_us;
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+void disp_panel_init(const disp_panel_t *p, uint8_t orientation)
+{
+    panel = p;
+
+#if defined(PANEL_BCKL) && PANEL_BCKL == 15
+    gpio_config_t io_conf = {
+        .intr_type = GPIO_INTR_DISABLE,
+        .mode = GPIO_MODE_OUTPUT,
+        .pin_bit_mask = GPIO_SEL_15,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+    };
+    gpio_config(&io_conf);
+#endif
+
+    //Initialize non-SPI GPIOs
+    gpio_set_direction(PANEL_DC, GPIO_MODE_OUTPUT);
+    gpio_set_direction(PANEL_RST, GPIO_MODE_OUTPUT);
+#if CONFIG_LVGL_BACKLIGHT_PWM
+    backlight_pwm_init();
+#elif defined(PANEL_BCKL)
+    gpio_set_direction(PANEL_BCKL, GPIO_MODE_OUTPUT);
+#endif
+
+    if (panel->convert && convert_buf == NULL) {
+        /* One LVGL buffer worth of 3 byte pixels */
+        convert_buf = heap_caps_malloc(DISP_BUF_SIZE * 3, MALLOC_CAP_DMA);
+        assert(convert_buf != NULL);
+    }
+
+    //Reset the display
+    gpio_set_level(PANEL_RST, 0);
+    vTaskDelay(pdMS_TO_TICKS(panel->reset_low_ms));
+    gpio_set_level(PANEL_RST, 1);
+    vTaskDelay(pdMS_TO_TICKS(panel->reset_high_ms));
+
+    ESP_LOGI(TAG, "%s initialization.", panel->name);
+
+    disp_panel_run_stream(panel->init);
+    panel_asleep = false;
+    sleep_toggled_us = esp_timer_get_time();
+
+    disp_panel_enable_backlight(true);
+    disp_panel_set_orientation(orientation);
+
+    if (panel->invert != DISP_PANEL_INVERT_IN_INIT) {
+        disp_panel_set_inversion(panel->invert);
+    }
+}
+
+void disp_panel_flush(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map)
+{
+    const int16_t *offset = panel->offset[panel_orientation];
+    uint16_t x1 = area->x1 + offset[0];
+    uint16_t x2 = area->x2 + offset[0];
+    uint16_t y1 = area->y1 + offset[1];
+    uint16_t y2 = area->y2 + offset[1];
+
+    /* Command bytes and parameters need different DC levels, so they cannot
+     * share a transfer. Each of them is at most 4 bytes and travels inline in
+     * its descriptor (no DMA buffer); only the pixels use DMA. */
+    queue_cmd(DISP_PANEL_CMD_CASET);
+    queue_window_data(window_buf[0], x1, x2);
+    queue_cmd(DISP_PANEL_CMD_RASET);
+    queue_window_data(window_buf[1], y1, y2);
+    queue_cmd(DISP_PANEL_CMD_RAMWR);
+
+    uint32_t size = lv_area_get_width(area) * lv_area_get_height(area);
+    const uint8_t *pixels = (const uint8_t *) color_map;
+    size_t length = size * 2;
+
+    if (panel->convert) {
+        /* LVGL never flushes more than one buffer (DISP_BUF_SIZE pixels) */
+        panel->convert(color_map, convert_buf, size);
+        pixels = convert_buf;
+        length = size * 3;
+    }
+
+    disp_spi_transaction(pixels, length,
+        DISP_SPI_SEND_QUEUED | DISP_SPI_SIGNAL_FLUSH | DISP_SPI_DC_DATA, NULL, 0);
+}
+
+int disp_panel_test_clock(int clock_hz, uint16_t rows)
+{
+    const int16_t *offset = panel->offset[panel_orientation];
+    uint32_t count = (uint32_t) LV_HOR_RES_MAX * rows;
+    /* RAMRD answers with a dummy byte, then 3 bytes per pixel */
+    size_t read_length = 1 + count * 3;
+    uint8_t *px = heap_caps_malloc(count * 2, MALLOC_CAP_DMA);
+    uint8_t *read_buf = heap_caps_malloc((read_length + 3) & ~3u, MALLOC_CAP_DMA);
+    int bad = -1;
+
+    if (px != NULL && read_buf != NULL) {
+        uint16_t x1 = offset[0];
+        uint16_t y1 = offset[1];
+        uint16_t x2 = x1 + LV_HOR_RES_MAX - 1;
+        uint16_t y2 = y1 + rows - 1;
+
+        fill_pattern(px, rows);
+
+        disp_spi_change_device_speed(clock_hz);
+        send_window(x1, y1, x2, y2);
+        disp_panel_send_cmd(DISP_PANEL_CMD_RAMWR);
+        disp_panel_send_data(px, count * 2);
+
+        disp_spi_change_device_speed(READ_CLOCK_HZ);
+        send_window(x1, y1, x2, y2);
+        disp_spi_read_cmd(DISP_PANEL_CMD_RAMRD, read_buf, read_length);
+
+        bad = compare_pattern(px, read_buf + 1, count);
+        disp_spi_change_device_speed(clock_hz);
+    }
+
+    heap_caps_free(px);
+    heap_caps_free(read_buf);
+    return bad;
+}
+
+bool disp_panel_tune_clock(int max_hz, uint8_t margin_steps, int fallback_hz, disp_panel_clock_t *clock)
+{
+    int steps[TUNE_SLOWEST_DIV];
+    int num_steps = 0;
+
+    for (int div = TUNE_SLOWEST_DIV; div >= 1; div--) {
+        if (APB_CLOCK_HZ / div <= max_hz) {
+            steps[num_steps++] = APB_CLOCK_HZ / div;
+        }
+    }
+
+    /* At the read clock the pattern must come back, or there is no MISO */
+    clock->verified = disp_panel_test_clock(READ_CLOCK_HZ, DISP_PANEL_TUNE_ROWS) == 0;
+    if (!clock->verified) {
+        ESP_LOGW(TAG, "No read back from the panel, keeping %d Hz", fallback_hz);
+        disp_spi_change_device_speed(fallback_hz);
+        clock->clock_hz = fallback_hz;
+        clock->passed_hz = 0;
+        clock->margin_pct = 0;
+        return false;
+    }
+
+    int passed = -1;
+    for (int i = 0; i < num_steps; i++) {
+        int bad = disp_panel_test_clock(steps[i], DISP_PANEL_TUNE_ROWS);
+        if (bad != 0) {
+            ESP_LOGI(TAG, "%d Hz: %d of %d pixels wrong", steps[i], bad,
+                     LV_HOR_RES_MAX * DISP_PANEL_TUNE_ROWS);
+            break;
+        }
+        passed = i;
+    }
+
+    int chosen = passed - margin_steps;
+    clock->passed_hz = passed >= 0 ? steps[passed] : READ_CLOCK_HZ;
+    clock->clock_hz = chosen >= 0 ? steps[chosen] : READ_CLOCK_HZ;
+    clock->margin_pct = 100 - (uint8_t) ((int64_t) clock->clock_hz * 100 / clock->passed_hz);
+    disp_spi_change_device_speed(clock->clock_hz);
+
+    ESP_LOGI(TAG, "SPI clock %d Hz, %d Hz passed (%u%% margin)",
+             clock->clock_hz, clock->passed_hz, clock->margin_pct);
+    return true;
+}
+
+void disp_panel_run_stream(const uint8_t *stream)
+{
+    while (stream[1] != 0xFF) {
+        uint8_t cmd = *stream++;
+        uint8_t n = *stream++;
+        uint8_t length = n & DISP_PANEL_LEN_MASK;
+
+        if (!(n & DISP_PANEL_NO_CMD)) {
+            disp_panel_send_cmd(cmd);
+            disp_panel_send_data(stream, length);
+        }
+        stream += length;
+
+        if (n & DISP_PANEL_DELAY) {
+            vTaskDelay(pdMS_TO_TICKS(*stream++ * 5));
+        }
+    }
+}
+
+void disp_panel_set_orientation(uint8_t orientation)
+{
+    const char *orientation_str[] = {
+        "PORTRAIT", "PORTRAIT_INVERTED", "LANDSCAPE", "LANDSCAPE_INVERTED"
+    };
+
+    orientation &= 3;
+    panel_orientation = orientation;
+
+    ESP_LOGI(TAG, "Display orientation: %s", orientation_str[orientation]);
+    ESP_LOGI(TAG, "0x36 command value: 0x%02X", panel->madctl[orientation]);
+
+    disp_panel_send_cmd(DISP_PANEL_CMD_MADCTL);
+    disp_panel_send_data(&panel->madctl[orientation], 1);
+}
+
+void disp_panel_set_inversion(bool invert)
+{
+    disp_panel_send_cmd(invert ? DISP_PANEL_CMD_INVON : DISP_PANEL_CMD_INVOFF);
+}
+
+void disp_panel_enable_backlight(bool backlight)
+{
+#ifdef PANEL_BCKL
+    ESP_LOGI(TAG, "%s backlight.", backlight ? "Enabling" : "Disabling");
+    disp_panel_set_brightness(backlight ? 100 : 0);
+#endif
+}
+
+void disp_panel_set_brightness(uint8_t percent)
+{
+#if CONFIG_LVGL_BACKLIGHT_PWM
+    if (percent > 100) {
+        percent = 100;
+    }
+    if (percent == 0) {
+        /* Idle level before the output inversion: off for either polarity */
+        ledc_stop(BCKL_LEDC_MODE, BCKL_LEDC_CHANNEL, 0);
+        return;
+    }
+
+    /* The eye sees roughly the square root of the light: square the duty */
+    uint32_t max = (1u << BCKL_LEDC_BITS) - 1;
+    uint32_t duty = (max * percent * percent + 5000) / 10000;
+    if (duty == 0) {
+        duty = 1;
+    }
+    ledc_set_duty(BCKL_LEDC_MODE, BCKL_LEDC_CHANNEL, duty);
+    ledc_update_duty(BCKL_LEDC_MODE, BCKL_LEDC_CHANNEL);
+#elif defined(PANEL_BCKL)
+    gpio_set_level(PANEL_BCKL, percent ? PANEL_BCKL_ACTIVE_LVL : !PANEL_BCKL_ACTIVE_LVL);
+#else
+    (void) percent;
+#endif
+}
+
+void disp_panel_sleep(bool sleep)
+{
+    if (sleep == panel_asleep) {
+        return;
+    }
+
+    int64_t since_ms = (esp_timer_get_time() - sleep_toggled_us) / 1000;
+    if (since_ms < SLEEP_TOGGLE_MS) {
+        vTaskDelay(pdMS_TO_TICKS(SLEEP_TOGGLE_MS - since_ms) + 1);
+    }
+
+    /* Sent polling: queued pixels go out first */
+    disp_panel_send_cmd(sleep ? DISP_PANEL_CMD_SLPIN : DISP_PANEL_CMD_SLPOUT);
+    sleep_toggled_us = esp_timer_get_time();
+    panel_asleep = sleep;
+    vTaskDelay(pdMS_TO_TICKS(SLEEP_CMD_MS) + 1);
+}
+
+bool disp_panel_is_asleep(void)
+{
+    return panel_asleep;
+}
+
+void disp_panel_send_cmd(uint8_t cmd)
+{
+    uint8_t word[] = {0x00, cmd};
+
+    if (panel->flags & DISP_PANEL_16BIT_BUS) {
+        disp_spi_transaction(word, sizeof word, DISP_SPI_SEND_POLLING | DISP_SPI_DC_CMD, NULL, 0);
+    } else {
+        disp_spi_transaction(&cmd, 1, DISP_SPI_SEND_POLLING | DISP_SPI_DC_CMD, NULL, 0);
+    }
+}
+
+void disp_panel_send_data(const void *data, size_t length)
+{
+    const uint8_t *bytes = data;
+
+    if (!(panel->flags & DISP_PANEL_16BIT_BUS)) {
+        disp_spi_transaction(bytes, length, DISP_SPI_SEND_POLLING | DISP_SPI_DC_DATA, NULL, 0);
+        return;
+    }
+
+    uint8_t words[32];
+    while (length > 0) {
+        size_t chunk = length < sizeof words / 2 ? length : sizeof words / 2;
+        disp_spi_transaction(words, widen(bytes, words, chunk),
+            DISP_SPI_SEND_POLLING | DISP_SPI_DC_DATA, NULL, 0);
+        bytes += chunk;
+        length -= chunk;
+    }
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+#if CONFIG_LVGL_BACKLIGHT_PWM
+static void backlight_pwm_init(void)
+{
+    ledc_timer_config_t timer = {
+        .speed_mode = BCKL_LEDC_MODE,
+        .duty_resolution = BCKL_LEDC_BITS,
+        .timer_num = BCKL_LEDC_TIMER,
+        .freq_hz = BCKL_LEDC_HZ,
+        .clk_cfg = LEDC_AUTO_CLK,
+    };
+    esp_err_t ret = ledc_timer_config(&timer);
+    assert(ret == ESP_OK);
+
+    /* Starts dark; disp_panel_init turns it on after the init stream */
+    ledc_channel_config_t channel = {
+        .gpio_num = PANEL_BCKL,
+        .speed_mode = BCKL_LEDC_MODE,
+        .channel = BCKL_LEDC_CHANNEL,
+        .timer_sel = BCKL_LEDC_TIMER,
+        .duty = 0,
+        .flags.output_invert = !PANEL_BCKL_ACTIVE_LVL,
+    };
+    ret = ledc_channel_config(&channel);
+    assert(ret == ESP_OK);
+}
+#endif
+
+static void queue_cmd(uint8_t cmd)
+{
+    uint8_t word[] = {0x00, cmd};
+
+    if (panel->flags & DISP_PANEL_16BIT_BUS) {
+        disp_spi_transaction(word, sizeof word, DISP_SPI_SEND_QUEUED | DISP_SPI_DC_CMD, NULL, 0);
+    } else {
+        disp_spi_queue_cmd(cmd);
+    }
+}
+
+/* Start/end address pair of CASET/RASET */
+static void queue_window_data(uint8_t *buf, uint16_t start, uint16_t end)
+{
+    uint8_t data[4] = {
+        (start >> 8) & 0xFF, start & 0xFF,
+        (end >> 8) & 0xFF, end & 0xFF,
+    };
+
+    if (panel->flags & DISP_PANEL_16BIT_BUS) {
+        disp_spi_transaction(buf, widen(data, buf, sizeof data),
+            DISP_SPI_SEND_QUEUED | DISP_SPI_DC_DATA, NULL, 0);
+    } else {
+        disp_spi_queue_data(data, sizeof data);
+    }
+}
+
+/* 16-bit bus: every byte goes out as 0x00, byte */
+static size_t widen(const uint8_t *src, uint8_t *dst, size_t length)
+{
+    for (size_t i = 0; i < length; i++) {
+        dst[2 * i] = 0x00;
+        dst[2 * i + 1] = src[i];
+    }
+    return length * 2;
+}
+
+/* Synchronous CASET/RASET, for the clock test */
+static void send_window(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2)
+{
+    uint8_t data[4] = {x1 >> 8, x1 & 0xFF, x2 >> 8, x2 & 0xFF};
+
+    disp_panel_send_cmd(DISP_PANEL_CMD_CASET);
+    disp_panel_send_data(data, sizeof data);
+
+    data[0] = y1 >> 8;
+    data[1] = y1 & 0xFF;
+    data[2] = y2 >> 8;
+    data[3] = y2 & 0xFF;
+    disp_panel_send_cmd(DISP_PANEL_CMD_RASET);
+    disp_panel_send_data(data, sizeof data);
+}
+
+/* RGB565 as sent on the wire (big endian). The rows cycle through the
+ * patterns hardest on a long cable: the fastest toggling data line,
+ * walking ones and zeros (crosstalk), and random data. */
+static void fill_pattern(uint8_t *px, uint16_t rows)
+{
+    for (uint16_t y = 0; y < rows; y++) {
+        for (uint16_t x = 0; x < LV_HOR_RES_MAX; x++) {
+            uint16_t v;
+
+            switch (y % 3) {
+            case 0:
+                v = (x & 1) ? 0xAAAA : 0x5555;
+                break;
+            case 1:
+                v = 1u << (x % 16);
+                if (y & 1) {
+                    v = ~v;
+                }
+                break;
+            default:
+                /* xorshift32 */
+                pattern_seed ^= pattern_seed << 13;
+                pattern_seed ^= pattern_seed >> 17;
+                pattern_seed ^= pattern_seed << 5;
+                v = pattern_seed;
+                break;
+            }
+
+            *px++ = v >> 8;
+            *px++ = v & 0xFF;
+        }
+    }
+}
+
+/* RAMRD returns 6 bits per colour, left aligned; only the bits that were
+ * written are compared. With MADCTL.BGR set the panel may return red and
+ * blue swapped, the order with fewer errors counts. */
+static uint32_t compare_pattern(const uint8_t *px, const uint8_t *rgb666, uint32_t count)
+{
+    uint32_t bad_rgb = 0;
+    uint32_t bad_bgr = 0;
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint16_t v = (px[0] << 8) | px[1];
+        uint8_t r = v >> 11;
+        uint8_t g = (v >> 5) & 0x3F;
+        uint8_t b = v & 0x1F;
+
+        if ((rgb666[1] >> 2) != g) {
+            bad_rgb++;
+            bad_bgr++;
+        } else {
+            bad_rgb += (rgb666[0] >> 3) != r || (rgb666[2] >> 3) != b;
+            bad_bgr += (rgb666[0] >> 3) != b || (rgb666[2] >> 3) != r;
+        }
+
+        px += 2;
+        rgb666 += 3;
+    }
+
+    return bad_rgb < bad_bgr ? bad_rgb : bad_bgr;
+}
@@ -0,0 +1,134 @@
+/**
+ * @file disp_panel.h
+ *
+ * Shared command layer for MIPI-DBI style SPI panels (ILI9341, ILI9481,
+ * ILI9486, ILI9488, ST7789, ST7735S, HX8357). A controller is described by a
+ * const disp_panel_t: its init sequence as a packed command stream, the
+ * MADCTL value and window offset for each orientation, and its pixel format.
+ * Reset, init, orientation, inversion, backlight and the flush path are the
+ * same for all of them.
+ */
+
+#ifndef DISP_PANEL_H
+#define DISP_PANEL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "lvgl/lvgl.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+/* Init stream: entries of  cmd, n, data[n & DISP_PANEL_LEN_MASK] [, delay]
+ * and DISP_PANEL_END to finish. */
+#define DISP_PANEL_LEN_MASK     0x3F
+#define DISP_PANEL_DELAY        0x80    /* One delay byte (5 ms units) follows the data */
+#define DISP_PANEL_NO_CMD       0x40    /* Nothing is sent, the entry is only a delay */
+#define DISP_PANEL_END          0x00, 0xFF
+
+/* Standard DCS commands used by the layer */
+#define DISP_PANEL_CMD_SLPIN    0x10
+#define DISP_PANEL_CMD_SLPOUT   0x11
+#define DISP_PANEL_CMD_INVOFF   0x20
+#define DISP_PANEL_CMD_INVON    0x21
+#define DISP_PANEL_CMD_CASET    0x2A
+#define DISP_PANEL_CMD_RASET    0x2B
+#define DISP_PANEL_CMD_RAMWR    0x2C
+#define DISP_PANEL_CMD_RAMRD    0x2E
+#define DISP_PANEL_CMD_MADCTL   0x36
+
+/* disp_panel_t.flags */
+#define DISP_PANEL_16BIT_BUS    0x01    /* Commands and parameters are sent as 16-bit words (ILI9486) */
+
+/* disp_panel_t.invert */
+#define DISP_PANEL_INVERT_IN_INIT   (-1) /* Inversion is part of the init stream */
+
+/* Rows of test pattern written by the clock tuning and by the periodic check.
+ * They are overwritten at the top of the screen and must be redrawn. */
+#define DISP_PANEL_TUNE_ROWS    24
+#define DISP_PANEL_CHECK_ROWS   6
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+/* Converts LVGL RGB565 pixels to the panel's 3 byte per pixel format */
+typedef void (*disp_panel_convert_cb_t)(const lv_color_t *src, uint8_t *dst, uint32_t px);
+
+typedef struct {
+    const char *name;
+    const uint8_t *init;            /* Packed init stream */
+    uint8_t reset_low_ms;           /* RST pulse and wait after it */
+    uint8_t reset_high_ms;
+    uint8_t madctl[4];              /* Per orientation: portrait, portrait inverted, landscape, landscape inverted */
+    int16_t offset[4][2];           /* Per orientation: x, y added to the window (panels smaller than the controller RAM) */
+    int8_t invert;                  /* 0/1 sent after the orientation, or DISP_PANEL_INVERT_IN_INIT */
+    uint8_t flags;
+    disp_panel_convert_cb_t convert; /* NULL: RGB565 sent as rendered */
+} disp_panel_t;
+
+/* SPI clock picked by disp_panel_tune_clock() */
+typedef struct {
+    int clock_hz;                   /* Clock in use */
+    int passed_hz;                  /* Fastest clock whose patterns read back intact */
+    uint8_t margin_pct;             /* How much slower clock_hz is than passed_hz */
+    bool verified;                  /* false: nothing could be read back, clock_hz is the configured one */
+} disp_panel_clock_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+/* Reset the panel, run its init stream, set the orientation, inversion and
+ * turn the backlight on. Must be called before any other function. */
+void disp_panel_init(const disp_panel_t *panel, uint8_t orientation);
+
+/* Queue the address window, RAMWR and the pixels without waiting on the bus.
+ * Can be used as the LVGL flush callback directly. */
+void disp_panel_flush(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map);
+
+/* Write rows of test patterns to the top of the panel at clock_hz and read
+ * them back with RAMRD (RGB666) at a slow clock. Returns the number of wrong
+ * pixels, or -1 if there was no DMA RAM for the test. The device is left at
+ * clock_hz. */
+int disp_panel_test_clock(int clock_hz, uint16_t rows);
+
+/* Try the clocks 80 MHz / n from slow to fast, up to max_hz, and run at
+ * margin_steps below the fastest one that passes. If the pattern cannot be
+ * read back at all (no MISO), fallback_hz is kept and false returned. */
+bool disp_panel_tune_clock(int max_hz, uint8_t margin_steps, int fallback_hz, disp_panel_clock_t *clock);
+
+void disp_panel_run_stream(const uint8_t *stream);
+void disp_panel_set_orientation(uint8_t orientation);
+void disp_panel_set_inversion(bool invert);
+void disp_panel_enable_backlight(bool backlight);
+
+/* Backlight at 0-100 %, perceptually (duty = percent squared). Without
+ * CONFIG_LVGL_BACKLIGHT_PWM anything above 0 is fully on. */
+void disp_panel_set_brightness(uint8_t percent);
+
+/* SLPIN/SLPOUT after the queued pixels. Waits out the 120 ms the panel
+ * needs between the two, so it may block that long. */
+void disp_panel_sleep(bool sleep);
+bool disp_panel_is_asleep(void);
+
+/* Single command/parameters, sent synchronously (init, sleep, ...) */
+void disp_panel_send_cmd(uint8_t cmd);
+void disp_panel_send_data(const void *data, size_t length);
+
+/**********************
+ *      MACROS
+ **********************/
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /*DISP_PANEL_H*/
@@ -0,0 +1,182 @@
+/**
+ * @file disp_pipeline.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <assert.h>
+
+#include "disp_pipeline.h"
+#include "disp_driver.h"
+#include "disp_spi.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define TAG "disp_pipeline"
+
+#define FLUSH_TASK_STACK    3072
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+/* A rendered stripe waiting for the worker */
+typedef struct {
+    lv_disp_drv_t *drv;
+    lv_area_t area;
+    lv_color_t *buf;
+} flush_job_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static void flush_task(void *arg);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static QueueHandle_t job_queue;     /* Rendered stripes, in render order */
+static QueueHandle_t free_queue;    /* Buffers LVGL may render into next */
+static lv_color_t *bufs[DISP_PIPELINE_MAX_BUFS];
+static uint8_t buf_count;
+static disp_pipeline_stats_t stats;
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+uint8_t disp_pipeline_init(lv_disp_buf_t *disp_buf, uint8_t count, uint32_t size_in_px,
+                           BaseType_t core, UBaseType_t priority)
+{
+    if (count > DISP_PIPELINE_MAX_BUFS) {
+        count = DISP_PIPELINE_MAX_BUFS;
+    }
+
+    buf_count = 0;
+    while (buf_count < count) {
+        lv_color_t *buf = heap_caps_malloc(size_in_px * sizeof(lv_color_t), MALLOC_CAP_DMA);
+        if (buf == NULL) {
+            break;
+        }
+        bufs[buf_count++] = buf;
+    }
+
+    if (buf_count < 2) {
+        ESP_LOGE(TAG, "No DMA RAM for two %u px display buffers", (unsigned) size_in_px);
+        while (buf_count > 0) {
+            heap_caps_free(bufs[--buf_count]);
+        }
+        return 0;
+    }
+    if (buf_count < count) {
+        ESP_LOGW(TAG, "Only %u of %u display buffers fit in DMA RAM", buf_count, count);
+    }
+
+    job_queue = xQueueCreate(buf_count, sizeof(flush_job_t));
+    free_queue = xQueueCreate(buf_count, sizeof(lv_color_t *));
+    assert(job_queue != NULL && free_queue != NULL);
+
+    /* LVGL owns one buffer at a time and runs in single buffer mode; the
+     * others wait in the free queue */
+    for (uint8_t i = 1; i < buf_count; i++) {
+        xQueueSend(free_queue, &bufs[i], 0);
+    }
+    lv_disp_buf_init(disp_buf, bufs[0], NULL, size_in_px);
+
+    stats.buffers = buf_count;
+    stats.buf_px = size_in_px;
+
+    BaseType_t ret = xTaskCreatePinnedToCore(flush_task, "disp_flush", FLUSH_TASK_STACK,
+                                             NULL, priority, NULL, core);
+    assert(ret == pdPASS);
+
+    ESP_LOGI(TAG, "%u buffers of %u px (%u bytes each), flushing on core %d",
+             buf_count, (unsigned) size_in_px, (unsigned) (size_in_px * sizeof(lv_color_t)),
+             (int) core);
+
+    return buf_count;
+}
+
+void disp_pipeline_flush(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map)
+{
+    flush_job_t job = {
+        .drv = drv,
+        .area = *area,
+        .buf = color_map,
+    };
+
+    /* Never blocks: there are never more jobs than buffers */
+    xQueueSend(job_queue, &job, portMAX_DELAY);
+
+    uint8_t queued = buf_count - uxQueueMessagesWaiting(free_queue);
+    if (queued > stats.max_queued) {
+        stats.max_queued = queued;
+    }
+
+    lv_color_t *next;
+    if (xQueueReceive(free_queue, &next, 0) != pdTRUE) {
+        int64_t start = esp_timer_get_time();
+        stats.render_stalls++;
+        xQueueReceive(free_queue, &next, portMAX_DELAY);
+        stats.render_wait_us += esp_timer_get_time() - start;
+    }
+
+    /* The stripe is LVGL's to forget: render the next one into a free buffer */
+    drv->buffer->buf1 = next;
+    drv->buffer->buf_act = next;
+    lv_disp_flush_ready(drv);
+}
+
+void disp_pipeline_drain(void)
+{
+    /* Every buffer but the one LVGL holds is back once the queue is empty */
+    while (free_queue && uxQueueMessagesWaiting(free_queue) < buf_count - 1u) {
+        vTaskDelay(1);
+    }
+}
+
+void disp_pipeline_get_stats(disp_pipeline_stats_t *out)
+{
+    *out = stats;
+    out->queued = 0;
+    if (free_queue) {
+        UBaseType_t free_bufs = uxQueueMessagesWaiting(free_queue);
+        out->queued = free_bufs < buf_count ? buf_count - 1u - free_bufs : 0;
+    }
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+/* The only task that sends pixels while the pipeline runs. The SPI ISR
+ * still calls lv_disp_flush_ready() for every stripe; it can only clear a
+ * flag that disp_pipeline_flush() clears anyway, so that is harmless. */
+static void flush_task(void *arg)
+{
+    flush_job_t job;
+
+    (void) arg;
+
+    for (;;) {
+        xQueueReceive(job_queue, &job, portMAX_DELAY);
+
+        int64_t start = esp_timer_get_time();
+        disp_driver_flush(job.drv, &job.area, job.buf);
+        /* The buffer is free again once the DMA has read all of it */
+        disp_wait_for_pending_transactions();
+        stats.flush_us += esp_timer_get_time() - start;
+        stats.stripes++;
+
+        xQueueSend(free_queue, &job.buf, portMAX_DELAY);
+    }
+}
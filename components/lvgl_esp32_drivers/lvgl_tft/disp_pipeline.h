@@ -0,0 +1,72 @@
+/**
+ * @file disp_pipeline.h
+ *
+ * Render/flush pipeline for SPI displays. LVGL renders stripes into a ring
+ * of display buffers; every finished stripe is queued to a worker task
+ * (normally on the other core) that sends it with disp_driver_flush() and
+ * returns the buffer once its last byte is on the bus. LVGL only waits when
+ * every buffer is rendered and still queued.
+ */
+
+#ifndef DISP_PIPELINE_H
+#define DISP_PIPELINE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+#include "lvgl/lvgl.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define DISP_PIPELINE_MAX_BUFS  4
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct {
+    uint8_t buffers;            /* Buffers in the ring */
+    uint32_t buf_px;            /* Pixels per buffer */
+    uint32_t stripes;           /* Stripes flushed by the worker */
+    uint32_t render_stalls;     /* LVGL found no free buffer after a flush */
+    uint64_t render_wait_us;    /* Time LVGL waited for one there */
+    uint64_t flush_us;          /* Worker time from taking a stripe to its last byte */
+    uint8_t queued;             /* Stripes waiting for or in the worker */
+    uint8_t max_queued;
+} disp_pipeline_stats_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+/* Allocate up to count buffers of size_in_px pixels from DMA capable RAM,
+ * initialize disp_buf with the first one and start the worker on the given
+ * core. Returns the number of buffers in use (fewer when the heap is short)
+ * or 0 if not even two could be allocated. */
+uint8_t disp_pipeline_init(lv_disp_buf_t *disp_buf, uint8_t count, uint32_t size_in_px,
+                           BaseType_t core, UBaseType_t priority);
+
+/* LVGL flush callback: queue the stripe and hand LVGL a free buffer */
+void disp_pipeline_flush(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map);
+
+/* Wait until the worker has sent every queued stripe. Call it (from the
+ * task that runs LVGL) before sending anything else to the panel. */
+void disp_pipeline_drain(void);
+
+void disp_pipeline_get_stats(disp_pipeline_stats_t *stats);
+
+/**********************
+ *      MACROS
+ **********************/
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /*DISP_PIPELINE_H*/
@@ -10,6 +10,7 @@
 #include "driver/gpio.h"
 #include "driver/spi_master.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 #define TAG "disp_spi"
 
@@ -38,15 +39,40 @@
 /**********************
  *  STATIC PROTOTYPES
  **********************/
+static void IRAM_ATTR spi_pre (spi_transaction_t *trans);
 static void IRAM_ATTR spi_ready (spi_transaction_t *trans);
+static void add_device(spi_host_device_t host, int clock_speed_hz);
+static void trans_ring_drain(void);
+static spi_transaction_ext_t *trans_ring_acquire(void);
+static void trans_ring_reclaim(TickType_t ticks_to_wait);
 
 /**********************
  *  STATIC VARIABLES
  **********************/
 static spi_host_device_t spi_host;
 static spi_device_handle_t spi;
-static volatile uint8_t spi_pending_trans = 0;
+static int spi_clock_speed_hz;
+static transaction_cb_t chained_pre_cb;
 static transaction_cb_t chained_post_cb;
+static disp_spi_flush_done_cb_t flush_done_cb;
+
+/* Given from the post callback whenever a flush has been handed back to
+ * LVGL. A token left over from a flush nobody waited for only costs the next
+ * waiter one extra pass of LVGL's flushing loop. */
+static SemaphoreHandle_t flush_done_sem;
+
+/* Queued transactions live in a ring of descriptors that stay valid until
+ * the SPI driver returns them. Slots are queued and returned in order:
+ * trans_tail is the oldest slot still owned by the driver, trans_head the
+ * next free one. trans_done[] is set from the post callback (ISR). */
+static spi_transaction_ext_t trans_ring[DISP_SPI_TRANS_QUEUE_DEPTH];
+static volatile bool trans_done[DISP_SPI_TRANS_QUEUE_DEPTH];
+static uint8_t trans_head = 0;
+static uint8_t trans_tail = 0;
+static uint8_t trans_in_flight = 0;
+static disp_spi_queue_stats_t queue_stats;
+static uint64_t blocked_at_last_flush;
+static int64_t flush_started_us;    /* Set from the pre callback (ISR) */
 
 /**********************
  *      MACROS
@@ -58,8 +84,14 @@ static transaction_cb_t chained_post_cb;
 void disp_spi_add_device_config(spi_host_device_t host, spi_device_interface_config_t *devcfg)
 {
     spi_host=host;
+    chained_pre_cb=devcfg->pre_cb;
     chained_post_cb=devcfg->post_cb;
+    devcfg->pre_cb=spi_pre;
     devcfg->post_cb=spi_ready;
+    if (flush_done_sem == NULL) {
+        flush_done_sem = xSemaphoreCreateBinary();
+        assert(flush_done_sem != NULL);
+    }
     esp_err_t ret=spi_bus_add_device(host, devcfg, &spi);
     assert(ret==ESP_OK);
 }
@@ -73,17 +105,7 @@ void disp_spi_add_device_with_speed(spi_host_device_t host, int clock_speed_hz)
 {
 	printf("%s->Adding SPI device\n",TAG);
 	printf("%s->Clock speed: %dHz, mode: %d, CS pin: %d\n",TAG,clock_speed_hz, SPI_TFT_SPI_MODE, DISP_SPI_CS);
-	spi_device_interface_config_t devcfg={
-		.clock_speed_hz = clock_speed_hz,
-		.mode = SPI_TFT_SPI_MODE,
-		.spics_io_num=DISP_SPI_CS,              // CS pin
-		.input_delay_ns=DISP_SPI_INPUT_DELAY_NS,
-		.queue_size=1,
-		.pre_cb=NULL,
-		.post_cb=NULL,
-		.flags = SPI_DEVICE_NO_DUMMY | SPI_DEVICE_HALFDUPLEX,
-	};
-	disp_spi_add_device_config(host, &devcfg);
+	add_device(host, clock_speed_hz);
 }
 
 void disp_spi_change_device_speed(int clock_speed_hz)
@@ -91,9 +113,18 @@ void disp_spi_change_device_speed(int clock_speed_hz)
     if (clock_speed_hz <= 0) {
         clock_speed_hz = SPI_TFT_CLOCK_SPEED_HZ;
     }
-    printf("%s->Changing SPI device clock speed: %d\n",TAG, clock_speed_hz);
+    if (clock_speed_hz == spi_clock_speed_hz) {
+        return;
+    }
+    /* Quiet: the clock tuning switches back and forth many times */
+    ESP_LOGD(TAG, "Changing SPI device clock speed: %d", clock_speed_hz);
     disp_spi_remove_device();
-    disp_spi_add_device_with_speed(spi_host, clock_speed_hz);
+    add_device(spi_host, clock_speed_hz);
+}
+
+int disp_spi_get_clock_speed(void)
+{
+    return spi_clock_speed_hz;
 }
 
 void disp_spi_remove_device()
@@ -113,9 +144,6 @@ void disp_spi_transaction(const uint8_t *data, size_t length,
         return;
     }
 
-    /* Wait for previous pending transaction results */
-    disp_wait_for_pending_transactions();
-
     spi_transaction_ext_t t = {0};
 
     /* transaction length is in bits */
@@ -152,16 +180,42 @@ void disp_spi_transaction(const uint8_t *data, size_t length,
     t.base.user = (void *) flags;
 
     /* Poll/Complete/Queue transaction */
-    if (flags & DISP_SPI_SEND_POLLING) {
-        spi_device_polling_transmit(spi, (spi_transaction_t *) &t);
-    } else if (flags & DISP_SPI_SEND_SYNCHRONOUS) {
-        spi_device_transmit(spi, (spi_transaction_t *) &t);
+    if (flags & (DISP_SPI_SEND_POLLING | DISP_SPI_SEND_SYNCHRONOUS)) {
+        int64_t start = esp_timer_get_time();
+        /* Polling and synchronous transfers may not overtake queued ones */
+        trans_ring_drain();
+        if (flags & DISP_SPI_SEND_POLLING) {
+            spi_device_polling_transmit(spi, (spi_transaction_t *) &t);
+        } else {
+            spi_device_transmit(spi, (spi_transaction_t *) &t);
+        }
+        queue_stats.blocked_us += esp_timer_get_time() - start;
     } else {
-        static spi_transaction_ext_t queuedt;
-        memcpy(&queuedt, &t, sizeof t);
-        spi_pending_trans++;
-        if (spi_device_queue_trans(spi, (spi_transaction_t *) &queuedt, portMAX_DELAY) != ESP_OK) {
-            spi_pending_trans--; /* Clear wait state */
+        /* Queued: data of more than 4 bytes must stay valid until completion */
+        spi_transaction_ext_t *queuedt = trans_ring_acquire();
+        memcpy(queuedt, &t, sizeof t);
+        trans_done[queuedt - trans_ring] = false;
+        trans_head = (trans_head + 1) % DISP_SPI_TRANS_QUEUE_DEPTH;
+        trans_in_flight++;
+        if (spi_device_queue_trans(spi, (spi_transaction_t *) queuedt, portMAX_DELAY) != ESP_OK) {
+            /* Not queued: give the slot back */
+            trans_head = (trans_head + DISP_SPI_TRANS_QUEUE_DEPTH - 1) % DISP_SPI_TRANS_QUEUE_DEPTH;
+            trans_in_flight--;
+            return;
+        }
+        queue_stats.queued++;
+        if (trans_in_flight > queue_stats.max_in_flight) {
+            queue_stats.max_in_flight = trans_in_flight;
+        }
+    }
+
+    if (flags & DISP_SPI_SIGNAL_FLUSH) {
+        uint32_t blocked = queue_stats.blocked_us - blocked_at_last_flush;
+        blocked_at_last_flush = queue_stats.blocked_us;
+        queue_stats.flushes++;
+        queue_stats.last_flush_blocked_us = blocked;
+        if (blocked > queue_stats.max_flush_blocked_us) {
+            queue_stats.max_flush_blocked_us = blocked;
         }
     }
 }
@@ -169,15 +223,33 @@ void disp_spi_transaction(const uint8_t *data, size_t length,
 
 void disp_wait_for_pending_transactions(void)
 {
-    spi_transaction_t *presult;
-
-    while (spi_pending_trans) {
-        if (spi_device_get_trans_result(spi, &presult, portMAX_DELAY) == ESP_OK) {
-            spi_pending_trans--;
-        }
+    if (trans_in_flight) {
+        int64_t start = esp_timer_get_time();
+        trans_ring_drain();
+        queue_stats.blocked_us += esp_timer_get_time() - start;
     }
 }
 
+void disp_spi_get_queue_stats(disp_spi_queue_stats_t *stats)
+{
+    *stats = queue_stats;
+    stats->in_flight = trans_in_flight;
+    stats->depth = DISP_SPI_TRANS_QUEUE_DEPTH;
+}
+
+void disp_spi_set_flush_done_cb(disp_spi_flush_done_cb_t cb)
+{
+    flush_done_cb = cb;
+}
+
+void disp_spi_wait_flush(void)
+{
+    int64_t start = esp_timer_get_time();
+    xSemaphoreTake(flush_done_sem, 1);
+    queue_stats.flush_waits++;
+    queue_stats.flush_wait_us += esp_timer_get_time() - start;
+}
+
 void disp_spi_acquire(void)
 {
     esp_err_t ret = spi_device_acquire_bus(spi, portMAX_DELAY);
@@ -189,17 +261,131 @@ void disp_spi_release(void)
     spi_device_release_bus(spi);
 }
 
+void disp_spi_read_cmd(uint8_t cmd, uint8_t *data, size_t length)
+{
+    spi_transaction_t t = {
+        .flags = SPI_TRANS_USE_TXDATA | SPI_TRANS_CS_KEEP_ACTIVE,
+        .length = 8,
+        .tx_data = {cmd},
+        .user = (void *) DISP_SPI_DC_CMD,
+    };
+
+    int64_t start = esp_timer_get_time();
+    trans_ring_drain();
+
+    /* CS going high ends the read, so both phases run with the bus held */
+    disp_spi_acquire();
+    spi_device_polling_transmit(spi, &t);
+
+    t = (spi_transaction_t) {
+        .rxlength = length * 8,
+        .rx_buffer = data,
+        .user = (void *) DISP_SPI_DC_DATA,
+    };
+    spi_device_polling_transmit(spi, &t);
+    disp_spi_release();
+
+    queue_stats.blocked_us += esp_timer_get_time() - start;
+}
+
 /**********************
  *   STATIC FUNCTIONS
  **********************/
 
+static void add_device(spi_host_device_t host, int clock_speed_hz)
+{
+	spi_device_interface_config_t devcfg={
+		.clock_speed_hz = clock_speed_hz,
+		.mode = SPI_TFT_SPI_MODE,
+		.spics_io_num=DISP_SPI_CS,              // CS pin
+		.input_delay_ns=DISP_SPI_INPUT_DELAY_NS,
+		.queue_size=DISP_SPI_TRANS_QUEUE_DEPTH,
+		.pre_cb=NULL,
+		.post_cb=NULL,
+		.flags = SPI_DEVICE_NO_DUMMY | SPI_DEVICE_HALFDUPLEX,
+	};
+	disp_spi_add_device_config(host, &devcfg);
+	spi_clock_speed_hz = clock_speed_hz;
+}
+
+/* Free slot for the next queued transaction. Completed slots are returned
+ * without blocking; only a full ring waits for its oldest transaction. */
+static spi_transaction_ext_t *trans_ring_acquire(void)
+{
+    while (trans_in_flight && trans_done[trans_tail]) {
+        trans_ring_reclaim(0);
+    }
+    if (trans_in_flight == DISP_SPI_TRANS_QUEUE_DEPTH) {
+        int64_t start = esp_timer_get_time();
+        queue_stats.ring_full_waits++;
+        trans_ring_reclaim(portMAX_DELAY);
+        queue_stats.blocked_us += esp_timer_get_time() - start;
+    }
+    return &trans_ring[trans_head];
+}
+
+/* Wait until the driver has returned every queued transaction */
+static void trans_ring_drain(void)
+{
+    while (trans_in_flight) {
+        trans_ring_reclaim(portMAX_DELAY);
+    }
+}
+
+/* Collect the oldest result from the driver and release its slot */
+static void trans_ring_reclaim(TickType_t ticks_to_wait)
+{
+    spi_transaction_t *presult;
+
+    if (spi_device_get_trans_result(spi, &presult, ticks_to_wait) != ESP_OK) {
+        return;
+    }
+    /* The driver completes transactions in queue order */
+    assert(presult == (spi_transaction_t *) &trans_ring[trans_tail]);
+    trans_done[trans_tail] = false;
+    trans_tail = (trans_tail + 1) % DISP_SPI_TRANS_QUEUE_DEPTH;
+    trans_in_flight--;
+}
+
+/* Runs right before the driver starts a transfer, so the DC level always
+ * matches the transfer on the wire, however many are queued ahead of it */
+static void IRAM_ATTR spi_pre(spi_transaction_t *trans)
+{
+    disp_spi_send_flag_t flags = (disp_spi_send_flag_t) trans->user;
+
+#if DISP_SPI_DC >= 0
+    if (flags & DISP_SPI_DC_CMD) {
+        gpio_set_level(DISP_SPI_DC, 0);
+    } else if (flags & DISP_SPI_DC_DATA) {
+        gpio_set_level(DISP_SPI_DC, 1);
+    }
+#else
+    (void) flags;
+#endif
+
+    if (flags & DISP_SPI_SIGNAL_FLUSH) {
+        flush_started_us = esp_timer_get_time();
+    }
+
+    if (chained_pre_cb) {
+        chained_pre_cb(trans);
+    }
+}
+
 static void IRAM_ATTR spi_ready(spi_transaction_t *trans)
 {
     disp_spi_send_flag_t flags = (disp_spi_send_flag_t) trans->user;
+    spi_transaction_ext_t *ext = (spi_transaction_ext_t *) trans;
+
+    if (ext >= trans_ring && ext < trans_ring + DISP_SPI_TRANS_QUEUE_DEPTH) {
+        trans_done[ext - trans_ring] = true;
+    }
 
     if (flags & DISP_SPI_SIGNAL_FLUSH) {
         lv_disp_t * disp = NULL;
 
+        queue_stats.flush_bus_us += esp_timer_get_time() - flush_started_us;
+
 #if (LVGL_VERSION_MAJOR >= 7)
         disp = _lv_refr_get_disp_refreshing();
 #else /* Before v7 */
@@ -207,6 +393,17 @@ static void IRAM_ATTR spi_ready(spi_transaction_t *trans)
 #endif
 
         lv_disp_flush_ready(&disp->driver);
+
+        BaseType_t woken = pdFALSE;
+        xSemaphoreGiveFromISR(flush_done_sem, &woken);
+
+        if (flush_done_cb) {
+            flush_done_cb();
+        }
+
+        if (woken) {
+            portYIELD_FROM_ISR();
+        }
     }
 
     if (chained_post_cb) {
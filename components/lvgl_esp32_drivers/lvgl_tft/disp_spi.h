@@ -39,6 +39,8 @@ typedef enum _disp_spi_send_flag_t {
     DISP_SPI_MODE_DIO           = 0x00000400, /* Reserved */
     DISP_SPI_MODE_QIO           = 0x00000800, /* Reserved */
     DISP_SPI_MODE_DIOQIO_ADDR   = 0x00001000, /* Reserved */
+    DISP_SPI_DC_CMD             = 0x00002000, /* Drive DC low before the transfer */
+    DISP_SPI_DC_DATA            = 0x00004000, /* Drive DC high before the transfer */
 } disp_spi_send_flag_t;
 
 typedef struct _disp_spi_read_data {
@@ -50,6 +52,25 @@ typedef struct _disp_spi_read_data {
     } __attribute__((packed));
 } disp_spi_read_data __attribute__((aligned(4)));
 
+/* Occupancy of the queued transaction ring */
+typedef struct _disp_spi_queue_stats_t {
+    uint32_t queued;            /* Transactions queued since boot */
+    uint32_t ring_full_waits;   /* Sends that waited for a free slot */
+    uint32_t flushes;           /* Transactions queued with DISP_SPI_SIGNAL_FLUSH */
+    uint64_t blocked_us;        /* CPU time spent waiting on the SPI bus */
+    uint32_t last_flush_blocked_us; /* Blocked time since the previous flush, up to this one */
+    uint32_t max_flush_blocked_us;
+    uint32_t flush_waits;       /* disp_spi_wait_flush() calls */
+    uint64_t flush_wait_us;     /* Time slept there, free for other tasks */
+    uint64_t flush_bus_us;      /* Time on the wire of DISP_SPI_SIGNAL_FLUSH transfers */
+    uint8_t in_flight;          /* Queued and not yet returned by the driver */
+    uint8_t max_in_flight;      /* High-water mark of in_flight */
+    uint8_t depth;              /* DISP_SPI_TRANS_QUEUE_DEPTH */
+} disp_spi_queue_stats_t;
+
+/* Called from the SPI ISR once a flush has been handed back to LVGL */
+typedef void (*disp_spi_flush_done_cb_t)(void);
+
 /**********************
  * GLOBAL PROTOTYPES
  **********************/
@@ -57,12 +78,21 @@ void disp_spi_add_device(spi_host_device_t host);
 void disp_spi_add_device_config(spi_host_device_t host, spi_device_interface_config_t *devcfg);
 void disp_spi_add_device_with_speed(spi_host_device_t host, int clock_speed_hz);
 void disp_spi_change_device_speed(int clock_speed_hz);
+int disp_spi_get_clock_speed(void);
 void disp_spi_remove_device();
 void disp_spi_transaction(const uint8_t *data, size_t length,
     disp_spi_send_flag_t flags, disp_spi_read_data *out, uint64_t addr);
 void disp_wait_for_pending_transactions(void);
+void disp_spi_get_queue_stats(disp_spi_queue_stats_t *stats);
+void disp_spi_set_flush_done_cb(disp_spi_flush_done_cb_t cb);
+/* Sleep until a flush completes (LVGL wait_cb). Returns after at most one
+ * tick, LVGL checks its flushing flag again and calls it while needed. */
+void disp_spi_wait_flush(void);
 void disp_spi_acquire(void);
 void disp_spi_release(void);
+/* Send a command and read length bytes back over MISO with CS held low in
+ * between (RAMRD, RDDID, ...). Waits for queued transfers first. */
+void disp_spi_read_cmd(uint8_t cmd, uint8_t *data, size_t length);
 
 static inline void disp_spi_send_data(uint8_t *data, size_t length) {
     disp_spi_transaction(data, length, DISP_SPI_SEND_POLLING, NULL, 0);
@@ -74,6 +104,18 @@ static inline void disp_spi_send_colors(uint8_t *data, size_t length) {
         NULL, 0);
 }
 
+/* Queued command/parameter bytes. The DC level travels with the transaction
+ * and is applied in the pre-transfer callback, so nothing waits for earlier
+ * transfers. Up to 4 bytes are copied into the descriptor; longer data must
+ * stay valid until the transfer completes. */
+static inline void disp_spi_queue_cmd(uint8_t cmd) {
+    disp_spi_transaction(&cmd, 1, DISP_SPI_SEND_QUEUED | DISP_SPI_DC_CMD, NULL, 0);
+}
+
+static inline void disp_spi_queue_data(const uint8_t *data, size_t length) {
+    disp_spi_transaction(data, length, DISP_SPI_SEND_QUEUED | DISP_SPI_DC_DATA, NULL, 0);
+}
+
 /**********************
  *      MACROS
  **********************/
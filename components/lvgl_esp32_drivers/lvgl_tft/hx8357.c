@@ -16,11 +16,7 @@
  *      INCLUDES
  *********************/
 #include "hx8357.h"
-#include "disp_spi.h"
-#include "driver/gpio.h"
-#include <esp_log.h>
-#include "freertos/FreeRTOS.h"
-#include "freertos/task.h"
+#include "disp_panel.h"
 
 /*********************
  *      DEFINES
@@ -39,20 +35,9 @@
  *      TYPEDEFS
  **********************/
 
-/*The LCD needs a bunch of command/argument values to be initialized. They are stored in this struct. */
-typedef struct {
-    uint8_t cmd;
-    uint8_t data[16];
-    uint8_t databytes; //No of data in data; bit 7 = delay after set; 0xFF = end of cmds.
-} lcd_init_cmd_t;
-
 /**********************
  *  STATIC PROTOTYPES
  **********************/
-static void hx8357_send_cmd(uint8_t cmd);
-static void hx8357_send_data(void * data, uint16_t length);
-static void hx8357_send_color(void * data, uint16_t length);
-
 
 /**********************
  *  INITIALIZATION ARRAYS
@@ -88,14 +73,14 @@ static const uint8_t
       0x00, 0x00, 0x01, 0x3F,
     HX8357B_SETDISPMODE, 1,
       0x00,                      // CPU (DBI) and internal oscillation ??
-    HX8357_SLPOUT, 0x80 + 120/5, // Exit sleep, then delay 120 ms
-    HX8357_DISPON, 0x80 +  10/5, // Main screen turn on, delay 10 ms
-    0                            // END OF COMMAND LIST
+    HX8357_SLPOUT, DISP_PANEL_DELAY, 120/5, // Exit sleep, then delay 120 ms
+    HX8357_DISPON, DISP_PANEL_DELAY,  10/5, // Main screen turn on, delay 10 ms
+    DISP_PANEL_END
   }, initd[] = {
-    HX8357_SWRESET, 0x80 + 100/5, // Soft reset, then delay 10 ms
+    HX8357_SWRESET, DISP_PANEL_DELAY, 100/5, // Soft reset, then delay 100 ms
     HX8357D_SETC, 3,
       0xFF, 0x83, 0x57,
-    0xFF, 0x80 + 500/5,          // No command, just delay 300 ms
+    0xFF, DISP_PANEL_NO_CMD | DISP_PANEL_DELAY, 500/5, // No command, just delay 500 ms
     HX8357_SETRGB, 4,
       0x80, 0x00, 0x06, 0x06,    // 0x80 enables SDO pin (0x00 disables)
     HX8357D_SETCOM, 1,
@@ -139,14 +124,32 @@ static const uint8_t
       0x00,                      // TW off
     HX8357_TEARLINE, 2,
       0x00, 0x02,
-    HX8357_SLPOUT, 0x80 + 150/5, // Exit Sleep, then delay 150 ms
-    HX8357_DISPON, 0x80 +  50/5, // Main screen turn on, delay 50 ms
-    0,                           // END OF COMMAND LIST
+    HX8357_SLPOUT, DISP_PANEL_DELAY, 150/5, // Exit Sleep, then delay 150 ms
+    HX8357_DISPON, DISP_PANEL_DELAY,  50/5, // Main screen turn on, delay 50 ms
+    DISP_PANEL_END
   };
 
 /**********************
  *  STATIC VARIABLES
  **********************/
+static uint8_t displayType = HX8357D;
+
+static disp_panel_t hx8357_panel = {
+	.name = "HX8357",
+	.reset_low_ms = 10,
+	.reset_high_ms = 120,
+	.madctl = {
+		MADCTL_MX | MADCTL_MY | MADCTL_RGB,
+		MADCTL_MV | MADCTL_MY | MADCTL_RGB,
+		MADCTL_RGB,
+		MADCTL_MX | MADCTL_MV | MADCTL_RGB,
+	},
+#if HX8357_INVERT_DISPLAY
+	.invert = 1,
+#else
+	.invert = DISP_PANEL_INVERT_IN_INIT,
+#endif
+};
 
 /**********************
  *      MACROS
@@ -155,153 +158,26 @@ static const uint8_t
 /**********************
  *   GLOBAL FUNCTIONS
  **********************/
-static uint8_t displayType = HX8357D;
 
 void hx8357_init(void)
 {
-	//Initialize non-SPI GPIOs
-	gpio_set_direction(HX8357_DC, GPIO_MODE_OUTPUT);
-	gpio_set_direction(HX8357_RST, GPIO_MODE_OUTPUT);
-
-#if HX8357_ENABLE_BACKLIGHT_CONTROL
-	gpio_set_direction(HX8357_BCKL, GPIO_MODE_OUTPUT);
-#endif
-
-	//Reset the display
-	gpio_set_level(HX8357_RST, 0);
-	vTaskDelay(10 / portTICK_RATE_MS);
-	gpio_set_level(HX8357_RST, 1);
-	vTaskDelay(120 / portTICK_RATE_MS);
-
-	ESP_LOGI(TAG, "Initialization.");
-	
-	//Send all the commands
-	const uint8_t *addr = (displayType == HX8357B) ? initb : initd;
-	uint8_t        cmd, x, numArgs;
-	while((cmd = *addr++) > 0) { // '0' command ends list
-		x = *addr++;
-		numArgs = x & 0x7F;
-		if (cmd != 0xFF) { // '255' is ignored
-			if (x & 0x80) {  // If high bit set, numArgs is a delay time
-				hx8357_send_cmd(cmd);
-			} else {
-				hx8357_send_cmd(cmd);
-				hx8357_send_data((void *) addr, numArgs);
-				addr += numArgs;
-			}
-		}
-		if (x & 0x80) {       // If high bit set...
-			vTaskDelay(numArgs * 5 / portTICK_RATE_MS); // numArgs is actually a delay time (5ms units)
-		}
-	}
-
-	hx8357_set_rotation(1);
-	
-#if HX8357_INVERT_DISPLAY
-	hx8357_send_cmd(HX8357_INVON);;
-#endif
-
-	hx8357_enable_backlight(true);
+	hx8357_panel.init = (displayType == HX8357B) ? initb : initd;
+	disp_panel_init(&hx8357_panel, 1);
 }
 
 
 void hx8357_flush(lv_disp_drv_t * drv, const lv_area_t * area, lv_color_t * color_map)
 {
-	uint32_t size = lv_area_get_width(area) * lv_area_get_height(area);
-	
-	/* Column addresses  */
-	uint8_t xb[] = {
-	    (uint8_t) (area->x1 >> 8) & 0xFF,
-	    (uint8_t) (area->x1) & 0xFF,
-	    (uint8_t) (area->x2 >> 8) & 0xFF,
-	    (uint8_t) (area->x2) & 0xFF,
-	};
-	
-	/* Page addresses  */
-	uint8_t yb[] = {
-	    (uint8_t) (area->y1 >> 8) & 0xFF,
-	    (uint8_t) (area->y1) & 0xFF,
-	    (uint8_t) (area->y2 >> 8) & 0xFF,
-	    (uint8_t) (area->y2) & 0xFF,
-	};
-
-	/*Column addresses*/
-	hx8357_send_cmd(HX8357_CASET);
-	hx8357_send_data(xb, 4);
-
-	/*Page addresses*/
-	hx8357_send_cmd(HX8357_PASET);
-	hx8357_send_data(yb, 4);
-
-	/*Memory write*/
-	hx8357_send_cmd(HX8357_RAMWR);
-	hx8357_send_color((void*)color_map, size * 2);
+	disp_panel_flush(drv, area, color_map);
 }
 
 void hx8357_enable_backlight(bool backlight)
 {
-#if HX8357_ENABLE_BACKLIGHT_CONTROL
-    ESP_LOGD(TAG, "%s backlight.\n", backlight ? "Enabling" : "Disabling");
-    uint32_t tmp = 0;
-
-#if (HX8357_BCKL_ACTIVE_LVL==1)
-    tmp = backlight ? 1 : 0;
-#else
-    tmp = backlight ? 0 : 1;
-#endif
-
-    gpio_set_level(HX8357_BCKL, tmp);
-#endif
+	disp_panel_enable_backlight(backlight);
 }
 
 
 void hx8357_set_rotation(uint8_t r)
 {
-	r = r & 3; // can't be higher than 3
-	
-	switch(r) {
-		case 0:
-			r = MADCTL_MX | MADCTL_MY | MADCTL_RGB;
-			break;
-		case 1:
-			r = MADCTL_MV | MADCTL_MY | MADCTL_RGB;
-      		break;
-		case 2:
-			r = MADCTL_RGB;
-  			break;
-		case 3:
-			r = MADCTL_MX | MADCTL_MV | MADCTL_RGB;
-		break;
-	}
-	
-	hx8357_send_cmd(HX8357_MADCTL);
-	hx8357_send_data(&r, 1);
-}
-
-/**********************
- *   STATIC FUNCTIONS
- **********************/
-
-
-static void hx8357_send_cmd(uint8_t cmd)
-{
-	disp_wait_for_pending_transactions();
-	gpio_set_level(HX8357_DC, 0);	 /*Command mode*/
-	disp_spi_send_data(&cmd, 1);
-}
-
-
-static void hx8357_send_data(void * data, uint16_t length)
-{
-	disp_wait_for_pending_transactions();
-	gpio_set_level(HX8357_DC, 1);	 /*Data mode*/
-	disp_spi_send_data(data, length);
-}
-
-
-static void hx8357_send_color(void * data, uint16_t length)
-{
-	disp_wait_for_pending_transactions();
-	gpio_set_level(HX8357_DC, 1);   /*Data mode*/
-	disp_spi_send_colors(data, length);
+	disp_panel_set_orientation(r & 3); // can't be higher than 3
 }
@@ -17,6 +17,7 @@ extern "C" {
 
 #include "lvgl/lvgl.h"
 #include "../lvgl_helpers.h"
+#include "disp_panel.h"
 
 /*********************
  *      DEFINES
@@ -45,7 +46,12 @@ extern "C" {
 
 void ili9341_init(void);
 void ili9341_flush(lv_disp_drv_t * drv, const lv_area_t * area, lv_color_t * color_map);
+int ili9341_test_clock(int clock_hz, uint16_t rows);
+#if CONFIG_LVGL_DISP_SPI_CLOCK_TUNE
+bool ili9341_tune_clock(disp_panel_clock_t *clock);
+#endif
 void ili9341_enable_backlight(bool backlight);
+void ili9341_set_brightness(uint8_t percent);
 void ili9341_sleep_in(void);
 void ili9341_sleep_out(void);
 
@@ -6,13 +6,7 @@
  *      INCLUDES
  *********************/
 #include "ili9488.h"
-#include "disp_spi.h"
-#include "driver/gpio.h"
-#include "esp_log.h"
-#include "esp_heap_caps.h"
-
-#include "freertos/FreeRTOS.h"
-#include "freertos/task.h"
+#include "disp_panel.h"
 
 /*********************
  *      DEFINES
@@ -23,25 +17,47 @@
  *      TYPEDEFS
  **********************/
 
-/*The LCD needs a bunch of command/argument values to be initialized. They are stored in this struct. */
-typedef struct {
-    uint8_t cmd;
-    uint8_t data[16];
-    uint8_t databytes; //No of data in data; bit 7 = delay after set; 0xFF = end of cmds.
-} lcd_init_cmd_t;
-
 /**********************
  *  STATIC PROTOTYPES
  **********************/
-static void ili9488_set_orientation(uint8_t orientation);
-
-static void ili9488_send_cmd(uint8_t cmd);
-static void ili9488_send_data(void * data, uint16_t length);
-static void ili9488_send_color(void * data, uint16_t length);
+static void ili9488_convert(const lv_color_t *src, uint8_t *dst, uint32_t px);
 
 /**********************
  *  STATIC VARIABLES
  **********************/
+// From github.com/jeremyjh/ESP32_TFT_library
+// From github.com/mvturnho/ILI9488-lvgl-ESP32-WROVER-B
+static const uint8_t ili_init_cmds[] = {
+	0x01, DISP_PANEL_DELAY, 100 / 5,	/* Software reset */
+	ILI9488_CMD_SLEEP_OUT, DISP_PANEL_DELAY, 100 / 5,
+	ILI9488_CMD_POSITIVE_GAMMA_CORRECTION, 15, 0x00, 0x03, 0x09, 0x08, 0x16, 0x0A, 0x3F, 0x78, 0x4C, 0x09, 0x0A, 0x08, 0x16, 0x1A, 0x0F,
+	ILI9488_CMD_NEGATIVE_GAMMA_CORRECTION, 15, 0x00, 0x16, 0x19, 0x03, 0x0F, 0x05, 0x32, 0x45, 0x46, 0x04, 0x0E, 0x0D, 0x35, 0x37, 0x0F,
+	ILI9488_CMD_POWER_CONTROL_1, 2, 0x17, 0x15,
+	ILI9488_CMD_POWER_CONTROL_2, 1, 0x41,
+	ILI9488_CMD_VCOM_CONTROL_1, 3, 0x00, 0x12, 0x80,
+	ILI9488_CMD_MEMORY_ACCESS_CONTROL, 1, (0x20 | 0x08),
+	ILI9488_CMD_COLMOD_PIXEL_FORMAT_SET, 1, 0x66,
+	ILI9488_CMD_INTERFACE_MODE_CONTROL, 1, 0x00,
+	ILI9488_CMD_FRAME_RATE_CONTROL_NORMAL, 1, 0xA0,
+	ILI9488_CMD_DISPLAY_INVERSION_CONTROL, 1, 0x02,
+	ILI9488_CMD_DISPLAY_FUNCTION_CONTROL, 2, 0x02, 0x02,
+	ILI9488_CMD_SET_IMAGE_FUNCTION, 1, 0x00,
+	ILI9488_CMD_WRITE_CTRL_DISPLAY, 1, 0x28,
+	ILI9488_CMD_WRITE_DISPLAY_BRIGHTNESS, 1, 0x7F,
+	ILI9488_CMD_ADJUST_CONTROL_3, 4, 0xA9, 0x51, 0x2C, 0x02,
+	ILI9488_CMD_DISPLAY_ON, DISP_PANEL_DELAY, 100 / 5,
+	DISP_PANEL_END,
+};
+
+static const disp_panel_t ili9488_panel = {
+	.name = "ILI9488",
+	.init = ili_init_cmds,
+	.reset_low_ms = 100,
+	.reset_high_ms = 100,
+	.madctl = {0x48, 0x88, 0x28, 0xE8},
+	.invert = DISP_PANEL_INVERT_IN_INIT,
+	.convert = ili9488_convert,
+};
 
 /**********************
  *      MACROS
@@ -50,181 +66,34 @@ static void ili9488_send_color(void * data, uint16_t length);
 /**********************
  *   GLOBAL FUNCTIONS
  **********************/
-// From github.com/jeremyjh/ESP32_TFT_library 
-// From github.com/mvturnho/ILI9488-lvgl-ESP32-WROVER-B
 void ili9488_init(void)
 {
-	lcd_init_cmd_t ili_init_cmds[]={
-                {ILI9488_CMD_SLEEP_OUT, {0x00}, 0x80},
-		{ILI9488_CMD_POSITIVE_GAMMA_CORRECTION, {0x00, 0x03, 0x09, 0x08, 0x16, 0x0A, 0x3F, 0x78, 0x4C, 0x09, 0x0A, 0x08, 0x16, 0x1A, 0x0F}, 15},
-		{ILI9488_CMD_NEGATIVE_GAMMA_CORRECTION, {0x00, 0x16, 0x19, 0x03, 0x0F, 0x05, 0x32, 0x45, 0x46, 0x04, 0x0E, 0x0D, 0x35, 0x37, 0x0F}, 15},
-		{ILI9488_CMD_POWER_CONTROL_1, {0x17, 0x15}, 2},
-		{ILI9488_CMD_POWER_CONTROL_2, {0x41}, 1},
-		{ILI9488_CMD_VCOM_CONTROL_1, {0x00, 0x12, 0x80}, 3},
-		{ILI9488_CMD_MEMORY_ACCESS_CONTROL, {(0x20 | 0x08)}, 1},
-		{ILI9488_CMD_COLMOD_PIXEL_FORMAT_SET, {0x66}, 1},
-		{ILI9488_CMD_INTERFACE_MODE_CONTROL, {0x00}, 1},
-		{ILI9488_CMD_FRAME_RATE_CONTROL_NORMAL, {0xA0}, 1},
-		{ILI9488_CMD_DISPLAY_INVERSION_CONTROL, {0x02}, 1},
-		{ILI9488_CMD_DISPLAY_FUNCTION_CONTROL, {0x02, 0x02}, 2},
-		{ILI9488_CMD_SET_IMAGE_FUNCTION, {0x00}, 1},
-		{ILI9488_CMD_WRITE_CTRL_DISPLAY, {0x28}, 1},
-		{ILI9488_CMD_WRITE_DISPLAY_BRIGHTNESS, {0x7F}, 1},
-		{ILI9488_CMD_ADJUST_CONTROL_3, {0xA9, 0x51, 0x2C, 0x02}, 4},
-		{ILI9488_CMD_DISPLAY_ON, {0x00}, 0x80},
-		{0, {0}, 0xff},
-	};
-
-	//Initialize non-SPI GPIOs
-	gpio_set_direction(ILI9488_DC, GPIO_MODE_OUTPUT);
-	gpio_set_direction(ILI9488_RST, GPIO_MODE_OUTPUT);
-
-#if ILI9488_ENABLE_BACKLIGHT_CONTROL
-	gpio_set_direction(ILI9488_BCKL, GPIO_MODE_OUTPUT);
-#endif
-
-	//Reset the display
-	gpio_set_level(ILI9488_RST, 0);
-	vTaskDelay(100 / portTICK_RATE_MS);
-	gpio_set_level(ILI9488_RST, 1);
-	vTaskDelay(100 / portTICK_RATE_MS);
-
-	ESP_LOGI(TAG, "ILI9488 initialization.");
-
-	// Exit sleep
-	ili9488_send_cmd(0x01);	/* Software reset */
-	vTaskDelay(100 / portTICK_RATE_MS);
-	
-	//Send all the commands
-	uint16_t cmd = 0;
-	while (ili_init_cmds[cmd].databytes!=0xff) {
-		ili9488_send_cmd(ili_init_cmds[cmd].cmd);
-		ili9488_send_data(ili_init_cmds[cmd].data, ili_init_cmds[cmd].databytes&0x1F);
-		if (ili_init_cmds[cmd].databytes & 0x80) {
-			vTaskDelay(100 / portTICK_RATE_MS);
-		}
-		cmd++;
-	}
-
-	ili9488_enable_backlight(true);
-
-        ili9488_set_orientation(CONFIG_LVGL_DISPLAY_ORIENTATION);
+	disp_panel_init(&ili9488_panel, CONFIG_LVGL_DISPLAY_ORIENTATION);
 }
 
-// Flush function based on mvturnho repo
 void ili9488_flush(lv_disp_drv_t * drv, const lv_area_t * area, lv_color_t * color_map)
 {
-    uint32_t size = lv_area_get_width(area) * lv_area_get_height(area);
-
-    lv_color16_t *buffer_16bit = (lv_color16_t *) color_map;
-    uint8_t *mybuf;
-    do {
-        mybuf = (uint8_t *) heap_caps_malloc(3 * size * sizeof(uint8_t), MALLOC_CAP_DMA);
-        if (mybuf == NULL)  ESP_LOGW(TAG, "Could not allocate enough DMA memory!");
-    } while (mybuf == NULL);
-
-    uint32_t LD = 0;
-    uint32_t j = 0;
-
-    for (uint32_t i = 0; i < size; i++) {
-        LD = buffer_16bit[i].full;
-        mybuf[j] = (uint8_t) ((LD & 0xF800) >> 8);
-        j++;
-        mybuf[j] = (uint8_t) ((LD & 0x07E0) >> 3);
-        j++;
-        mybuf[j] = (uint8_t) ((LD & 0x001F) << 3);
-        j++;
-    }
-
-	/* Column addresses  */
-	uint8_t xb[] = {
-	    (uint8_t) (area->x1 >> 8) & 0xFF,
-	    (uint8_t) (area->x1) & 0xFF,
-	    (uint8_t) (area->x2 >> 8) & 0xFF,
-	    (uint8_t) (area->x2) & 0xFF,
-	};
-	
-	/* Page addresses  */
-	uint8_t yb[] = {
-	    (uint8_t) (area->y1 >> 8) & 0xFF,
-	    (uint8_t) (area->y1) & 0xFF,
-	    (uint8_t) (area->y2 >> 8) & 0xFF,
-	    (uint8_t) (area->y2) & 0xFF,
-	};
-
-	/*Column addresses*/
-	ili9488_send_cmd(ILI9488_CMD_COLUMN_ADDRESS_SET);
-	ili9488_send_data(xb, 4);
-
-	/*Page addresses*/
-	ili9488_send_cmd(ILI9488_CMD_PAGE_ADDRESS_SET);
-	ili9488_send_data(yb, 4);
-
-	/*Memory write*/
-	ili9488_send_cmd(ILI9488_CMD_MEMORY_WRITE);
-
-	ili9488_send_color((void *) mybuf, size * 3);
-	heap_caps_free(mybuf);
+	disp_panel_flush(drv, area, color_map);
 }
 
 void ili9488_enable_backlight(bool backlight)
 {
-#if ILI9488_ENABLE_BACKLIGHT_CONTROL
-    ESP_LOGI(TAG, "%s backlight.", backlight ? "Enabling" : "Disabling");
-    uint32_t tmp = 0;
-
-#if (ILI9488_BCKL_ACTIVE_LVL==1)
-    tmp = backlight ? 1 : 0;
-#else
-    tmp = backlight ? 0 : 1;
-#endif
-
-    gpio_set_level(ILI9488_BCKL, tmp);
-#endif
+	disp_panel_enable_backlight(backlight);
 }
 
 /**********************
  *   STATIC FUNCTIONS
  **********************/
 
-
-static void ili9488_send_cmd(uint8_t cmd)
+/* RGB565 to RGB666, based on mvturnho repo */
+static void ili9488_convert(const lv_color_t *src, uint8_t *dst, uint32_t px)
 {
-    disp_wait_for_pending_transactions();
-    gpio_set_level(ILI9488_DC, 0);	 /*Command mode*/
-    disp_spi_send_data(&cmd, 1);
-}
+	const lv_color16_t *buffer_16bit = (const lv_color16_t *) src;
 
-static void ili9488_send_data(void * data, uint16_t length)
-{
-    disp_wait_for_pending_transactions();
-    gpio_set_level(ILI9488_DC, 1);	 /*Data mode*/
-    disp_spi_send_data(data, length);
-}
-
-static void ili9488_send_color(void * data, uint16_t length)
-{
-    disp_wait_for_pending_transactions();
-    gpio_set_level(ILI9488_DC, 1);   /*Data mode*/
-    disp_spi_send_colors(data, length);
-}
-
-static void ili9488_set_orientation(uint8_t orientation)
-{
-    // ESP_ASSERT(orientation < 4);
-
-    const char *orientation_str[] = {
-        "PORTRAIT", "PORTRAIT_INVERTED", "LANDSCAPE", "LANDSCAPE_INVERTED"
-    };
-
-    ESP_LOGI(TAG, "Display orientation: %s", orientation_str[orientation]);
-
-#if defined (CONFIG_LVGL_PREDEFINED_DISPLAY_NONE)
-    uint8_t data[] = {0x48, 0x88, 0x28, 0xE8};
-#endif
-
-    ESP_LOGI(TAG, "0x36 command value: 0x%02X", data[orientation]);
-
-    ili9488_send_cmd(0x36);
-    ili9488_send_data((void *) &data[orientation], 1);
+	for (uint32_t i = 0; i < px; i++) {
+		uint32_t LD = buffer_16bit[i].full;
+		*dst++ = (uint8_t) ((LD & 0xF800) >> 8);
+		*dst++ = (uint8_t) ((LD & 0x07E0) >> 3);
+		*dst++ = (uint8_t) ((LD & 0x001F) << 3);
+	}
 }
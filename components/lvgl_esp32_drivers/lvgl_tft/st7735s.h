@@ -20,7 +20,6 @@ extern "C" {
  *      DEFINES
  *********************/
 // #define DISP_BUF_SIZE   (CONFIG_LVGL_DISPLAY_WIDTH*CONFIG_LVGL_DISPLAY_HEIGHT)
-#define DISP_BUF_SIZE (LV_HOR_RES_MAX * 40)
 
 #define ST7735S_DC   CONFIG_LVGL_DISP_PIN_DC
 #define ST7735S_RST  CONFIG_LVGL_DISP_PIN_RST
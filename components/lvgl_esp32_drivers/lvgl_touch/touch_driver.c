@@ -5,7 +5,9 @@
 #include "touch_driver.h"
 #include "tp_spi.h"
 #include "tp_i2c.h"
+#include "esp_timer.h"
 
+static touch_driver_stats_t stats;
 
 void touch_driver_init(void)
 {
@@ -15,7 +17,26 @@ void touch_driver_init(void)
 bool touch_driver_read(lv_indev_drv_t *drv, lv_indev_data_t *data)
 {
     bool res = false;
+    int64_t start = esp_timer_get_time();
+    uint64_t wait_start = tp_spi_get_xchg_wait_us();
+
     res = xpt2046_read(drv, data);
+
+    uint32_t read_us = esp_timer_get_time() - start;
+    uint32_t wait_us = tp_spi_get_xchg_wait_us() - wait_start;
+    stats.reads++;
+    if (data->state == LV_INDEV_STATE_PR) {
+        stats.pressed++;
+    }
+    stats.read_us += read_us;
+    stats.wait_us += wait_us;
+    if (read_us - wait_us > stats.max_cpu_us) {
+        stats.max_cpu_us = read_us - wait_us;
+    }
     return res;
 }
 
+void touch_driver_get_stats(touch_driver_stats_t *out)
+{
+    *out = stats;
+}
@@ -34,12 +34,26 @@ extern "C" {
 *      DEFINES
 *********************/
 
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct {
+    uint32_t reads;             /* touch_driver_read() calls */
+    uint32_t pressed;           /* Reads that reported a press */
+    uint64_t read_us;           /* Time inside touch_driver_read() */
+    uint64_t wait_us;           /* Part of it blocked on SPI transfers, CPU free */
+    uint32_t max_cpu_us;        /* Longest read minus its SPI wait */
+} touch_driver_stats_t;
+
 /**********************
  * GLOBAL PROTOTYPES
  **********************/
 void touch_driver_init(void);
 bool touch_driver_read(lv_indev_drv_t *drv, lv_indev_data_t *data);
 
+/* Read statistics since boot */
+void touch_driver_get_stats(touch_driver_stats_t *stats);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
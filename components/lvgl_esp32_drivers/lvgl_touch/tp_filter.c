@@ -0,0 +1,101 @@
+/**
+ * @file tp_filter.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "tp_filter.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+uint16_t tp_filter_select(uint16_t *samples, uint8_t num, uint8_t k)
+{
+    int lo = 0;
+    int hi = num - 1;
+
+    /* Hoare's partition around the value at k; only the side holding k is
+     * partitioned again */
+    while (lo < hi) {
+        uint16_t pivot = samples[k];
+        int i = lo;
+        int j = hi;
+
+        do {
+            while (samples[i] < pivot) {
+                i++;
+            }
+            while (pivot < samples[j]) {
+                j--;
+            }
+            if (i <= j) {
+                uint16_t tmp = samples[i];
+                samples[i] = samples[j];
+                samples[j] = tmp;
+                i++;
+                j--;
+            }
+        } while (i <= j);
+
+        if (j < k) {
+            lo = i;
+        }
+        if (k < i) {
+            hi = j;
+        }
+    }
+
+    return samples[k];
+}
+
+bool tp_filter_median_mean(uint16_t *samples, uint8_t num, uint16_t spread, uint16_t *out)
+{
+    if (num == 0) {
+        return false;
+    }
+
+    uint16_t median = tp_filter_select(samples, num, num / 2);
+    uint32_t sum = 0;
+    uint8_t used = 0;
+
+    for (uint8_t i = 0; i < num; i++) {
+        uint16_t diff = samples[i] > median ? samples[i] - median : median - samples[i];
+        if (diff <= spread) {
+            sum += samples[i];
+            used++;
+        }
+    }
+
+    if (used * 2 <= num) {
+        return false;
+    }
+
+    *out = (uint16_t) ((sum + used / 2) / used);
+    return true;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
@@ -0,0 +1,54 @@
+/**
+ * @file tp_filter.h
+ *
+ * Noise filter for a burst of resistive touch ADC samples: the median
+ * (found by selection, no sort), then the mean of the samples within a
+ * spread of it. Spikes from a bouncing contact or a finger sliding off
+ * fall outside the spread and are ignored; when too few samples agree the
+ * burst is rejected. Linear in the number of samples.
+ *
+ * No LVGL or ESP-IDF dependencies, so it can be run on a host
+ * (tools/tp_filter_bench.c).
+ */
+
+#ifndef TP_FILTER_H
+#define TP_FILTER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+/* k-th smallest of num samples (quickselect), reorders the samples */
+uint16_t tp_filter_select(uint16_t *samples, uint8_t num, uint8_t k);
+
+/* Mean of the samples within spread of their median into *out. Returns
+ * false (and leaves *out alone) when half of them or fewer are within it.
+ * Reorders the samples. */
+bool tp_filter_median_mean(uint16_t *samples, uint8_t num, uint16_t spread, uint16_t *out);
+
+/**********************
+ *      MACROS
+ **********************/
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /*TP_FILTER_H*/
@@ -11,6 +11,7 @@
 #include "esp_system.h"
 #include "driver/gpio.h"
 #include "driver/spi_master.h"
+#include "esp_timer.h"
 #include <string.h>
 
 #include "../lvgl_helpers.h"
@@ -33,6 +34,7 @@ static spi_device_handle_t spi;
 /**********************
  *  STATIC VARIABLES
  **********************/
+static uint64_t xchg_wait_us;
 
 /**********************
  *      MACROS
@@ -73,10 +75,18 @@ void tp_spi_xchg(uint8_t* data_send, uint8_t* data_recv, uint8_t byte_count)
 		.tx_buffer = data_send,
 		.rx_buffer = data_recv};
 	
+	// The calling task sleeps until the transfer is done
+	int64_t start = esp_timer_get_time();
 	esp_err_t ret = spi_device_transmit(spi, &t);
+	xchg_wait_us += esp_timer_get_time() - start;
 	assert(ret == ESP_OK);
 }
 
+uint64_t tp_spi_get_xchg_wait_us(void)
+{
+	return xchg_wait_us;
+}
+
 void tp_spi_write_reg(uint8_t* data, uint8_t byte_count)
 {
 	spi_transaction_t t = {
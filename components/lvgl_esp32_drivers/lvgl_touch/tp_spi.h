@@ -30,6 +30,8 @@ extern "C" {
 void tp_spi_add_device(spi_host_device_t host);
 void tp_spi_add_device_config(spi_host_device_t host, spi_device_interface_config_t *config);
 void tp_spi_xchg(uint8_t* data_send, uint8_t* data_recv, uint8_t byte_count);
+/* Time spent in tp_spi_xchg() transactions since boot */
+uint64_t tp_spi_get_xchg_wait_us(void);
 void tp_spi_write_reg(uint8_t* data, uint8_t byte_count);
 void tp_spi_read_reg(uint8_t reg, uint8_t* data, uint8_t byte_count);
 
@@ -6,12 +6,16 @@
 /*********************
  *      INCLUDES
  *********************/
+#include <assert.h>
+
 #include "xpt2046.h"
 #include "esp_system.h"
 #include "esp_log.h"
 #include "driver/gpio.h"
 #include "tp_spi.h"
+#include "tp_filter.h"
 #include <stddef.h>
+#include "../lvgl_spi_conf.h"
 #include "../esp_idf_compat.h"
 
 /*********************
@@ -19,8 +23,22 @@
  *********************/
 #define TAG "XPT2046"
 
+#define XPT2046_IRQ		CONFIG_LVGL_TOUCH_PIN_IRQ
+
 #define CMD_X_READ  0b10010000		//0x90
 #define CMD_Y_READ  0b11010000		//0xD0
+#define CMD_ADC_ON  0b00000001		// PD0: keep the ADC on after the conversion, PENIRQ off
+
+/* Command byte, then the busy bit, 12 data bits and 3 zeros */
+#define CONV_BYTES	3
+/* Both axes, each with a first conversion that is thrown away */
+#define BURST_CONVS	(2 * (XPT2046_SAMPLES + 1))
+#define BURST_BYTES	(BURST_CONVS * CONV_BYTES)
+
+#if !CONFIG_LVGL_TOUCH_XPT2046_GPIO_SPI
+// The touch bus runs without DMA: one transaction must fit the SPI FIFO
+_Static_assert(BURST_BYTES <= 64, "XPT2046_SAMPLES too large for one SPI transaction");
+#endif
 
 /**********************
  *      TYPEDEFS
@@ -30,15 +48,17 @@
 /**********************
  *  STATIC PROTOTYPES
  **********************/
-static void xpt2046_corr(int16_t * x, int16_t * y);
-static void xpt2046_avg(int16_t * x, int16_t * y);
+static void xpt2046_xchg(const uint8_t *tx, uint8_t *rx, uint8_t len);
+static uint16_t xpt2046_conv_result(const uint8_t *conv);
+#if CONFIG_LVGL_TOUCH_XPT2046_GPIO_SPI
+static uint8_t xpt2046_gpio_xchg_byte(uint8_t data);
+#endif
 
 /**********************
  *  STATIC VARIABLES
  **********************/
-int16_t avg_buf_x[XPT2046_AVG];
-int16_t avg_buf_y[XPT2046_AVG];
-uint8_t avg_last;
+static uint8_t burst_tx[BURST_BYTES];
+static uint8_t burst_rx[BURST_BYTES];
 
 /**********************
  *      MACROS
@@ -60,26 +80,57 @@ void xpt2046_init(void)
 		.intr_type = GPIO_INTR_DISABLE,
 	};
 	esp_err_t ret = gpio_config(&irq_config);
+	assert(ret == ESP_OK);
+
+#if CONFIG_LVGL_TOUCH_XPT2046_GPIO_SPI
 	// 配置XPT2046的数据输出（MISO）引脚
 	gpio_config_t miso_config = {
-		.pin_bit_mask = BIT64(XPT2046_MISO),
+		.pin_bit_mask = BIT64(TP_SPI_MISO),
 		.mode = GPIO_MODE_INPUT,
 		.pull_up_en = GPIO_PULLUP_DISABLE,
 		.pull_down_en = GPIO_PULLDOWN_DISABLE,
 		.intr_type = GPIO_INTR_DISABLE,
 	};
 	ret = gpio_config(&miso_config);
+	assert(ret == ESP_OK);
 	// 配置其它数据脚
-	gpio_pad_select_gpio(XPT2046_MOSI);
-	gpio_set_direction(XPT2046_MOSI, GPIO_MODE_OUTPUT);// 设置GPIO为推挽输出模式
-	gpio_pad_select_gpio(XPT2046_CLK);
-	gpio_set_direction(XPT2046_CLK, GPIO_MODE_OUTPUT);// 设置GPIO为推挽输出模式
-	gpio_pad_select_gpio(XPT2046_CS);
-	gpio_set_direction(XPT2046_CS, GPIO_MODE_OUTPUT);// 设置GPIO为推挽输出模式
-	
-	ESP_LOGI(TAG,"XPT2046 Initialization");
+	gpio_pad_select_gpio(TP_SPI_MOSI);
+	gpio_set_direction(TP_SPI_MOSI, GPIO_MODE_OUTPUT);// 设置GPIO为推挽输出模式
+	gpio_pad_select_gpio(TP_SPI_CLK);
+	gpio_set_direction(TP_SPI_CLK, GPIO_MODE_OUTPUT);// 设置GPIO为推挽输出模式
+	gpio_pad_select_gpio(TP_SPI_CS);
+	gpio_set_direction(TP_SPI_CS, GPIO_MODE_OUTPUT);// 设置GPIO为推挽输出模式
+	gpio_set_level(TP_SPI_CS, 1);
+#else
+	// The bus is initialized by lvgl_driver_init. Full duplex without a
+	// command phase: a burst is one plain tx/rx exchange
+	spi_device_interface_config_t devcfg = {
+		.clock_speed_hz = SPI_TOUCH_CLOCK_SPEED_HZ,
+		.mode = SPI_TOUCH_SPI_MODE,
+		.spics_io_num = TP_SPI_CS,
+		.queue_size = 1,
+	};
+	tp_spi_add_device_config(TOUCH_SPI_HOST, &devcfg);
+#endif
 
-	assert(ret == ESP_OK);
+	/* One transaction samples both axes. All but the last conversion keep
+	 * the ADC on, so the panel drivers stay settled between conversions;
+	 * the last one powers down and enables PENIRQ again. */
+	for (uint8_t i = 0; i < BURST_CONVS; i++) {
+		uint8_t cmd = i <= XPT2046_SAMPLES ? CMD_X_READ : CMD_Y_READ;
+		if (i < BURST_CONVS - 1) {
+			cmd |= CMD_ADC_ON;
+		}
+		burst_tx[i * CONV_BYTES] = cmd;
+	}
+
+	ESP_LOGI(TAG, "XPT2046 Initialization (%s, IRQ GPIO%d)",
+#if CONFIG_LVGL_TOUCH_XPT2046_GPIO_SPI
+		"GPIO bit-bang",
+#else
+		"SPI host",
+#endif
+		XPT2046_IRQ);
 }
 
 /**
@@ -90,206 +141,89 @@ void xpt2046_init(void)
 bool xpt2046_read(lv_indev_drv_t * drv, lv_indev_data_t * data)
 {
 	static int16_t last_x = 0,last_y = 0;
-	bool valid = true;
-	int16_t x = 0,y = 0;
 	uint16_t ux = 0,uy = 0;
-	uint8_t irq = gpio_get_level(XPT2046_IRQ);
-	if (irq == 0) {
-		uint8_t data[2];
-		if(TP_Read_XY2(&ux,&uy)==1){
-			ESP_LOGI(TAG,"XPT2046 Read 原始值：x:%d   y:%d", ux, uy);
-			if(ux > 350){ux -= 350;}else{ux = 0;}
-			if(uy > 190){uy -= 190;}else{uy = 0;}
-			ux = (uint32_t)((uint32_t)ux * LV_HOR_RES) / (3870 - 350);//320   3870-350
-			uy = (uint32_t)((uint32_t)uy * LV_VER_RES) / (3870 - 190);// 240  3870-190
-			// 翻转坐标
-			//ux =  LV_HOR_RES - ux;
-			ux=ux + 20;
-			//uy =  LV_VER_RES - uy;
-			ESP_LOGI(TAG,"XPT2046 Read 坐标值：x:%d   y:%d", ux, uy);
-			x = ux;
-			y = uy;
-			last_x = ux;
-			last_y = uy;
-		}else{
-			ESP_LOGI(TAG,"XPT2046 Read Error");
-			x = last_x;
-			y = last_y;
-			avg_last = 0;
-			valid = false;
-		}
+
+	if (xpt2046_read_raw(&ux, &uy)) {
+		if(ux > XPT2046_X_MIN){ux -= XPT2046_X_MIN;}else{ux = 0;}
+		if(uy > XPT2046_Y_MIN){uy -= XPT2046_Y_MIN;}else{uy = 0;}
+		ux = (uint32_t)((uint32_t)ux * LV_HOR_RES) / (XPT2046_X_MAX - XPT2046_X_MIN);
+		uy = (uint32_t)((uint32_t)uy * LV_VER_RES) / (XPT2046_Y_MAX - XPT2046_Y_MIN);
+		ux = ux + XPT2046_X_OFFSET;
+		last_x = ux;
+		last_y = uy;
+		data->state = LV_INDEV_STATE_PR;
 	} else {
-		x = last_x;
-		y = last_y;
-		avg_last = 0;
-		valid = false;
+		data->state = LV_INDEV_STATE_REL;
 	}
-	data->point.x = x;
-	data->point.y = y;
-	data->state = valid == false ? LV_INDEV_STATE_REL : LV_INDEV_STATE_PR;
+
+	data->point.x = last_x;
+	data->point.y = last_y;
 	return false;
 }
-uint16_t TP_Read_XOY(uint8_t xy)
-{
-	uint8_t READ_TIMES = 30;//读取次数
-	uint8_t LOST_VAL = 1;//丢弃值
-	uint16_t i, j,temp,buf[READ_TIMES];
-	uint32_t sum=0;
-	for(i=0;i<READ_TIMES;i++){
-		buf[i]=xpt2046_gpio_spi_read_reg(xy);
-	}
-	for(i=0;i<READ_TIMES-1; i++){//排序
-		for(j=i+1;j<READ_TIMES;j++){
-			if(buf[i]>buf[j]){//升序排列
-				temp=buf[i];
-				buf[i]=buf[j];
-				buf[j]=temp;
-			}
-		}
-	}
-	sum=0;
-	for(i=LOST_VAL;i<READ_TIMES-LOST_VAL;i++){
-		sum+=buf[i];
-	}
-	temp = sum/(READ_TIMES-2*LOST_VAL);
-	return temp;
-}
 
-//读取x,y坐标
-//最小值不能少于100.
-//x,y:读取到的坐标值
-//返回值:0,失败;1,成功。
-uint8_t TP_Read_XY(uint16_t *x,uint16_t *y)
-{
-	uint16_t xtemp,ytemp;
-	xtemp=TP_Read_XOY(CMD_X_READ);
-	ytemp=TP_Read_XOY(CMD_Y_READ);
-	//if(xtemp<100||ytemp<100)return 0;//读数失败
-	*x=xtemp;
-	*y=ytemp;
-	return 1;//读数成功
-}
-//连续2次读取触摸屏IC,且这两次的偏差不能超过
-//ERR_RANGE,满足条件,则认为读数正确,否则读数错误
-//该函数能大大提高准确度
-//x,y:读取到的坐标值
-//返回值:0,失败;1,成功。
-#define ERR_RANGE 50 //误差范围 
-uint8_t TP_Read_XY2(uint16_t *x,uint16_t *y)
+bool xpt2046_read_raw(uint16_t *x, uint16_t *y)
 {
-	uint16_t x1,y1,x2,y2;
-	uint8_t flag;
-	flag=TP_Read_XY(&x1,&y1);
-	if(flag==0)return(0);
-	flag=TP_Read_XY(&x2,&y2);
-	if(flag==0)return(0);   
-	if(((x2<=x1&&x1<x2+ERR_RANGE)||(x1<=x2&&x2<x1+ERR_RANGE))//前后两次采样在+-50内
-	&&((y2<=y1&&y1<y2+ERR_RANGE)||(y1<=y2&&y2<y1+ERR_RANGE)))
-	{
-		*x=(x1+x2)/2;
-		*y=(y1+y2)/2;
-		return 1;
-	}else return 0;
-}
+	uint16_t xs[XPT2046_SAMPLES];
+	uint16_t ys[XPT2046_SAMPLES];
+	uint16_t fx, fy;
 
-// 向XPT2016写入一个字节
-void xpt2046_gpio_Write_Byte(uint8_t data)
-{
-	uint8_t i=0;
-	for(i=0;i<8;i++){
-		if(data&0x80){
-			gpio_set_level(XPT2046_MOSI, 1);
-		}else{
-			gpio_set_level(XPT2046_MOSI, 0);
-		}  
-		data<<=1; 
-		gpio_set_level(XPT2046_CLK, 0);
-		gpio_set_level(XPT2046_CLK, 1);
+	// PENIRQ high: not touched, leave the bus alone
+	if (gpio_get_level(XPT2046_IRQ) != 0) {
+		return false;
 	}
-}
 
-uint16_t xpt2046_gpio_spi_read_reg(uint8_t reg)
-{
-	uint8_t count=0;
-	uint16_t Data=0; 
-	gpio_set_level(XPT2046_CLK, 0);		// 先拉低时钟
-	gpio_set_level(XPT2046_MOSI, 0); 	// 拉低数据线
-	gpio_set_level(XPT2046_CS, 0); 		// 选中触摸屏IC
-
-	xpt2046_gpio_Write_Byte(reg);		// 发送命令字
+	xpt2046_xchg(burst_tx, burst_rx, BURST_BYTES);
 
-	ets_delay_us(6);					// ADS7846的转换时间最长为6us
+	for (uint8_t i = 0; i < XPT2046_SAMPLES; i++) {
+		xs[i] = xpt2046_conv_result(&burst_rx[(1 + i) * CONV_BYTES]);
+		ys[i] = xpt2046_conv_result(&burst_rx[(XPT2046_SAMPLES + 2 + i) * CONV_BYTES]);
+	}
 
-	gpio_set_level(XPT2046_CLK, 0);
-	ets_delay_us(1);
-	gpio_set_level(XPT2046_CLK, 1);			// 给1个时钟，清除BUSY
-	gpio_set_level(XPT2046_CLK, 0);
-	for(count=0;count<16;count++){			// 读出16位数据,只有高12位有效
-		Data<<=1; 	 
-		gpio_set_level(XPT2046_CLK, 0);		// 下降沿有效
-		gpio_set_level(XPT2046_CLK, 1);	
-		if(gpio_get_level(XPT2046_MISO))Data++;
+	if (!tp_filter_median_mean(xs, XPT2046_SAMPLES, XPT2046_SPREAD, &fx) ||
+	    !tp_filter_median_mean(ys, XPT2046_SAMPLES, XPT2046_SPREAD, &fy)) {
+		return false;
 	}
-	Data>>=4;								// 只有高12位有效
-	gpio_set_level(XPT2046_CS, 1);			// 释放片选
-	return(Data);
+
+	*x = fx;
+	*y = fy;
+	return true;
 }
+
 /**********************
  *   STATIC FUNCTIONS
  **********************/
-//xpt2046_corr(&x, &y);
-static void xpt2046_corr(int16_t * x, int16_t * y)
+static void xpt2046_xchg(const uint8_t *tx, uint8_t *rx, uint8_t len)
 {
-#if XPT2046_XY_SWAP != 0
-	int16_t swap_tmp;
-    swap_tmp = *x;
-    *x = *y;
-    *y = swap_tmp;
-#endif
-	if((*x) > XPT2046_X_MIN)
-		(*x) -= XPT2046_X_MIN;
-	else
-		(*x) = 0;
-
-	if((*y) > XPT2046_Y_MIN)(*y) -= XPT2046_Y_MIN;
-	else(*y) = 0;
-
-	(*x) = (uint32_t)((uint32_t)(*x) * LV_HOR_RES) / (XPT2046_X_MAX - XPT2046_X_MIN);
-	(*y) = (uint32_t)((uint32_t)(*y) * LV_VER_RES) / (XPT2046_Y_MAX - XPT2046_Y_MIN);
-
-#if XPT2046_X_INV != 0
-	(*x) =  LV_HOR_RES - (*x);
-#endif
-
-#if XPT2046_Y_INV != 0
-	(*y) =  LV_VER_RES - (*y);
+#if CONFIG_LVGL_TOUCH_XPT2046_GPIO_SPI
+	gpio_set_level(TP_SPI_CLK, 0);		// 先拉低时钟
+	gpio_set_level(TP_SPI_CS, 0); 		// 选中触摸屏IC
+	for (uint8_t i = 0; i < len; i++) {
+		rx[i] = xpt2046_gpio_xchg_byte(tx[i]);
+	}
+	gpio_set_level(TP_SPI_CLK, 0);
+	gpio_set_level(TP_SPI_CS, 1);		// 释放片选
+#else
+	tp_spi_xchg((uint8_t *) tx, rx, len);
 #endif
 }
 
-//xpt2046_avg(&x, &y);
-static void xpt2046_avg(int16_t * x, int16_t * y)
+static uint16_t xpt2046_conv_result(const uint8_t *conv)
 {
-	/*Shift out the oldest data*/
-	uint8_t i;
-	for(i = XPT2046_AVG - 1; i > 0 ; i--) {
-		avg_buf_x[i] = avg_buf_x[i - 1];
-		avg_buf_y[i] = avg_buf_y[i - 1];
-	}
-
-	/*Insert the new point*/
-	avg_buf_x[0] = *x;
-	avg_buf_y[0] = *y;
-	if(avg_last < XPT2046_AVG) avg_last++;
+	return (((uint16_t) conv[1] << 8 | conv[2]) >> 3) & 0x0FFF;
+}
 
-	/*Sum the x and y coordinates*/
-	int32_t x_sum = 0;
-	int32_t y_sum = 0;
-	for(i = 0; i < avg_last ; i++) {
-		x_sum += avg_buf_x[i];
-		y_sum += avg_buf_y[i];
+#if CONFIG_LVGL_TOUCH_XPT2046_GPIO_SPI
+// SPI mode 0: data out before the rising edge, in after it
+static uint8_t xpt2046_gpio_xchg_byte(uint8_t data)
+{
+	uint8_t in = 0;
+	for (uint8_t i = 0; i < 8; i++) {
+		gpio_set_level(TP_SPI_MOSI, (data & 0x80) ? 1 : 0);
+		data <<= 1;
+		gpio_set_level(TP_SPI_CLK, 0);
+		gpio_set_level(TP_SPI_CLK, 1);
+		in = (in << 1) | (gpio_get_level(TP_SPI_MISO) ? 1 : 0);
 	}
-
-	/*Normalize the sums*/
-	(*x) = (int32_t)x_sum / avg_last;
-	(*y) = (int32_t)y_sum / avg_last;
+	return in;
 }
+#endif
@@ -0,0 +1,134 @@
+/**
+ * @file cbor_writer.c
+ * @brief Allocation-free CBOR encoder
+ */
+
+#include "cbor_writer.h"
+#include <string.h>
+
+#define CBOR_MAJOR_UINT   0
+#define CBOR_MAJOR_NINT   1
+#define CBOR_MAJOR_BYTES  2
+#define CBOR_MAJOR_TEXT   3
+#define CBOR_MAJOR_ARRAY  4
+#define CBOR_MAJOR_MAP    5
+#define CBOR_MAJOR_TAG    6
+#define CBOR_MAJOR_SIMPLE 7
+
+#define CBOR_SIMPLE_FALSE 20
+#define CBOR_SIMPLE_TRUE  21
+
+static void put(cbor_writer_t *w, const void *data, size_t n)
+{
+    if (w->overflow) {
+        return;
+    }
+    if (n > w->cap - w->len) {
+        w->overflow = true;
+        return;
+    }
+    memcpy(w->buf + w->len, data, n);
+    w->len += n;
+}
+
+// Initial byte plus the shortest big-endian argument (0, 1, 2, 4 or 8 bytes)
+static void put_head(cbor_writer_t *w, uint8_t major, uint64_t arg)
+{
+    uint8_t head[9];
+    size_t n;
+
+    if (arg < 24) {
+        head[0] = (uint8_t)(major << 5 | arg);
+        n = 1;
+    } else if (arg <= UINT8_MAX) {
+        head[0] = (uint8_t)(major << 5 | 24);
+        n = 2;
+    } else if (arg <= UINT16_MAX) {
+        head[0] = (uint8_t)(major << 5 | 25);
+        n = 3;
+    } else if (arg <= UINT32_MAX) {
+        head[0] = (uint8_t)(major << 5 | 26);
+        n = 5;
+    } else {
+        head[0] = (uint8_t)(major << 5 | 27);
+        n = 9;
+    }
+    for (size_t i = n - 1; i > 0; i--) {
+        head[i] = (uint8_t)arg;
+        arg >>= 8;
+    }
+    put(w, head, n);
+}
+
+void cbor_writer_init(cbor_writer_t *w, uint8_t *buf, size_t cap)
+{
+    w->buf = buf;
+    w->cap = cap;
+    w->len = 0;
+    w->overflow = false;
+}
+
+size_t cbor_writer_finish(const cbor_writer_t *w)
+{
+    return w->overflow ? 0 : w->len;
+}
+
+void cbor_uint(cbor_writer_t *w, uint64_t value)
+{
+    put_head(w, CBOR_MAJOR_UINT, value);
+}
+
+void cbor_int(cbor_writer_t *w, int64_t value)
+{
+    if (value < 0) {
+        // Negative integers encode -1 - value
+        put_head(w, CBOR_MAJOR_NINT, (uint64_t)(-1 - value));
+    } else {
+        put_head(w, CBOR_MAJOR_UINT, (uint64_t)value);
+    }
+}
+
+void cbor_tag(cbor_writer_t *w, uint64_t tag)
+{
+    put_head(w, CBOR_MAJOR_TAG, tag);
+}
+
+void cbor_bool(cbor_writer_t *w, bool value)
+{
+    put_head(w, CBOR_MAJOR_SIMPLE, value ? CBOR_SIMPLE_TRUE : CBOR_SIMPLE_FALSE);
+}
+
+void cbor_text(cbor_writer_t *w, const char *s)
+{
+    size_t n = strlen(s);
+    put_head(w, CBOR_MAJOR_TEXT, n);
+    put(w, s, n);
+}
+
+void cbor_bytes(cbor_writer_t *w, const void *data, size_t len)
+{
+    put_head(w, CBOR_MAJOR_BYTES, len);
+    put(w, data, len);
+}
+
+void cbor_array(cbor_writer_t *w, size_t count)
+{
+    put_head(w, CBOR_MAJOR_ARRAY, count);
+}
+
+void cbor_map(cbor_writer_t *w, size_t count)
+{
+    put_head(w, CBOR_MAJOR_MAP, count);
+}
+
+void cbor_int16_array_begin(cbor_writer_t *w, size_t count)
+{
+    put_head(w, CBOR_MAJOR_TAG, CBOR_TAG_INT16_BE_ARRAY);
+    put_head(w, CBOR_MAJOR_BYTES, count * 2);
+}
+
+void cbor_int16_put(cbor_writer_t *w, int16_t value)
+{
+    uint8_t be[2] = {(uint8_t)((uint16_t)value >> 8), (uint8_t)value};
+    put(w, be, sizeof(be));
+}
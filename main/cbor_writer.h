@@ -0,0 +1,84 @@
+/**
+ * @file cbor_writer.h
+ * @brief Allocation-free CBOR (RFC 8949) encoder for binary MQTT payloads
+ *
+ * Companion to json_writer for links where bytes matter. Only definite-length
+ * items are produced, so the caller states element counts up front:
+ *
+ *   uint8_t buf[64];
+ *   cbor_writer_t w;
+ *   cbor_writer_init(&w, buf, sizeof(buf));
+ *   cbor_map(&w, 2);
+ *   cbor_uint(&w, 1); cbor_uint(&w, t0_ms);
+ *   cbor_uint(&w, 2); cbor_int(&w, -42);
+ *   size_t len = cbor_writer_finish(&w);    // 0 if it did not fit
+ *
+ * Integers always use the shortest encoding, which makes small values
+ * (e.g. millisecond deltas below 24) a single byte.
+ *
+ * No ESP-IDF dependencies.
+ */
+
+#ifndef CBOR_WRITER_H
+#define CBOR_WRITER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Self-describe tag (RFC 8949 3.4.6): encodes as D9 D9 F7, usable as a magic number
+#define CBOR_TAG_SELF_DESCRIBE    55799
+// Typed array of big-endian int16 in a byte string (RFC 8746)
+#define CBOR_TAG_INT16_BE_ARRAY   65
+
+/**
+ * @brief Writer state
+ */
+typedef struct {
+    uint8_t *buf;             ///< Output buffer
+    size_t cap;               ///< Buffer size
+    size_t len;               ///< Bytes written so far
+    bool overflow;            ///< Set once anything did not fit
+} cbor_writer_t;
+
+/**
+ * @brief Start writing into buf
+ */
+void cbor_writer_init(cbor_writer_t *w, uint8_t *buf, size_t cap);
+
+/**
+ * @brief Encoded length, or 0 if the output did not fit
+ */
+size_t cbor_writer_finish(const cbor_writer_t *w);
+
+void cbor_uint(cbor_writer_t *w, uint64_t value);
+void cbor_int(cbor_writer_t *w, int64_t value);
+void cbor_tag(cbor_writer_t *w, uint64_t tag);
+void cbor_bool(cbor_writer_t *w, bool value);
+void cbor_text(cbor_writer_t *w, const char *s);
+void cbor_bytes(cbor_writer_t *w, const void *data, size_t len);
+
+/**
+ * @brief Array / map header; must be followed by count items (count pairs for a map)
+ */
+void cbor_array(cbor_writer_t *w, size_t count);
+void cbor_map(cbor_writer_t *w, size_t count);
+
+/**
+ * @brief Tagged int16 typed array (tag 65) written in place, without a copy
+ *
+ * Call cbor_int16_array_begin() with the element count, then cbor_int16_put()
+ * exactly count times.
+ */
+void cbor_int16_array_begin(cbor_writer_t *w, size_t count);
+void cbor_int16_put(cbor_writer_t *w, int16_t value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CBOR_WRITER_H
@@ -4,21 +4,30 @@
  */
 
 #include "clock_component.h"
+#include "digit_sprite.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "nvs_flash.h"
 #include <string.h>
 
 #define NVS_NAMESPACE "lindi_cfg"
 #define NVS_KEY_DIGITAL_MODE "digital_mode"
 
+#define DIGITAL_GLYPHS "0123456789:-"   ///< Glyphs of the digital clock's atlas
+#define DIGITAL_CHARS  8                ///< "HH:MM:SS"
+
 static const char *TAG = "clock_component";
 
 /**
  * @brief Internal clock component structure
  */
 struct clock_handle_s {
+    lv_obj_t *parent;            ///< Parent container
     lv_obj_t *analog_gauge;      ///< Analog clock gauge widget
-    lv_obj_t *digital_label;     ///< Digital clock label widget
+    lv_img_dsc_t analog_face;    ///< Pre-rendered dial of the gauge (data NULL unless it is shown)
+    lv_obj_t *digital_clock;     ///< Digit sprite, or a label without memory for the atlas (NULL in analog mode)
+    digit_atlas_t digit_atlas;   ///< Pre-rendered digits of the sprite (NULL unless it is shown)
+    char digital_text[16];       ///< Time shown by the digital clock
     lv_obj_t *toggle_button;     ///< Mode toggle button (may be NULL)
     bool digital_mode;           ///< Current mode: true=digital, false=analog
     int x_offset;                ///< X position offset
@@ -32,6 +41,9 @@ static clock_handle_t g_clock_handle = NULL;
 static void load_digital_clock_mode(clock_handle_t handle);
 static void save_digital_clock_mode(bool enabled);
 static void toggle_button_cb(lv_obj_t *obj, lv_event_t event);
+static void digital_clock_show(clock_handle_t handle, bool show);
+static void analog_face_show(clock_handle_t handle, bool show);
+static void analog_face_render(clock_handle_t handle);
 
 /**
  * @brief Load digital clock mode setting from NVS
@@ -85,6 +97,103 @@ static void toggle_button_cb(lv_obj_t *obj, lv_event_t event)
     }
 }
 
+/**
+ * @brief Create the digital clock when entering digital mode, delete it when leaving
+ *
+ * The 48 px digit atlas takes about 23 kB of heap, so it only exists while
+ * the digital clock is shown.
+ */
+static void digital_clock_show(clock_handle_t handle, bool show)
+{
+    if (!show) {
+        if (handle->digital_clock) {
+            lv_obj_del(handle->digital_clock);
+            handle->digital_clock = NULL;
+        }
+        digit_atlas_destroy(handle->digit_atlas);
+        handle->digit_atlas = NULL;
+        return;
+    }
+    if (handle->digital_clock) {
+        return;
+    }
+
+    lv_color_t fg, bg;
+    digit_atlas_colors_of(handle->parent, &fg, &bg);
+    handle->digit_atlas = digit_atlas_create(&lv_font_montserrat_48, DIGITAL_GLYPHS, fg, bg);
+    if (handle->digit_atlas) {
+        handle->digital_clock = digit_sprite_create(handle->parent, handle->digit_atlas, DIGITAL_CHARS);
+    }
+    if (handle->digital_clock) {
+        digit_sprite_set_text(handle->digital_clock, handle->digital_text);
+    } else {
+        // No memory for the atlas: a label draws the same text, only slower
+        digit_atlas_destroy(handle->digit_atlas);
+        handle->digit_atlas = NULL;
+        handle->digital_clock = lv_label_create(handle->parent, NULL);
+        lv_label_set_text(handle->digital_clock, handle->digital_text);
+        lv_obj_set_style_local_text_font(handle->digital_clock, LV_LABEL_PART_MAIN, LV_STATE_DEFAULT, &lv_font_montserrat_48);
+    }
+
+    // Stay centred if the width changes ("--:--:--" -> "12:34:56")
+    lv_obj_set_auto_realign(handle->digital_clock, true);
+    lv_obj_align(handle->digital_clock, NULL, LV_ALIGN_CENTER, handle->x_offset, handle->y_offset);
+}
+
+/**
+ * @brief Render the gauge's dial (background, ring, ticks) into its image
+ */
+static void analog_face_render(clock_handle_t handle)
+{
+    lv_color_t fg, bg;
+    digit_atlas_colors_of(handle->parent, &fg, &bg);
+
+    int64_t start_us = esp_timer_get_time();
+    lv_gauge_render_face(handle->analog_gauge, &handle->analog_face, bg);
+    ESP_LOGI(TAG, "Dial of %dx%d rendered in %lld us", handle->analog_face.header.w,
+             handle->analog_face.header.h, esp_timer_get_time() - start_us);
+}
+
+/**
+ * @brief Draw the dial from an image in analog mode, free the image when leaving
+ *
+ * Only the needles are drawn every second; the areas they leave are copied
+ * from the image instead of drawing the ticks and the background again.
+ * The 139x139 image takes about 38 kB of heap; like the digital clock's
+ * atlas it only exists while its mode is shown.
+ */
+static void analog_face_show(clock_handle_t handle, bool show)
+{
+    if (!show) {
+        if (handle->analog_face.data) {
+            lv_gauge_set_face_img(handle->analog_gauge, NULL);
+            lv_img_cache_invalidate_src(&handle->analog_face);
+            free((void *)handle->analog_face.data);
+            handle->analog_face.data = NULL;
+        }
+        return;
+    }
+    if (handle->analog_face.data) {
+        return;
+    }
+
+    lv_img_dsc_t *face = &handle->analog_face;
+    face->header.always_zero = 0;
+    face->header.cf = LV_IMG_CF_TRUE_COLOR;
+    face->header.w = lv_obj_get_width(handle->analog_gauge);
+    face->header.h = lv_obj_get_height(handle->analog_gauge);
+    face->data_size = LV_IMG_BUF_SIZE_TRUE_COLOR(face->header.w, face->header.h);
+    face->data = (const uint8_t *)malloc(face->data_size);
+    if (!face->data) {
+        // The gauge draws its dial itself, only slower
+        ESP_LOGW(TAG, "No memory for the %u byte dial image", (unsigned)face->data_size);
+        return;
+    }
+
+    analog_face_render(handle);
+    lv_gauge_set_face_img(handle->analog_gauge, face);
+}
+
 /**
  * @brief Create and initialize clock component
  */
@@ -104,9 +213,11 @@ clock_handle_t clock_create(const clock_config_t *config)
 
     // Initialize handle
     memset(handle, 0, sizeof(struct clock_handle_s));
+    handle->parent = config->parent;
     handle->digital_mode = config->start_with_digital;
     handle->x_offset = config->x_offset;
     handle->y_offset = config->y_offset;
+    strcpy(handle->digital_text, "--:--:--");
 
     // Store global handle for callback (LVGL 7 compatibility)
     g_clock_handle = handle;
@@ -128,12 +239,6 @@ clock_handle_t clock_create(const clock_config_t *config)
         lv_obj_align(btn_label, handle->toggle_button, LV_ALIGN_OUT_RIGHT_MID, 5, 0);
     }
 
-    // Create digital clock label
-    handle->digital_label = lv_label_create(config->parent, NULL);
-    lv_label_set_text(handle->digital_label, "--:--:--");
-    lv_obj_set_style_local_text_font(handle->digital_label, LV_LABEL_PART_MAIN, LV_STATE_DEFAULT, &lv_font_montserrat_48);
-    lv_obj_align(handle->digital_label, NULL, LV_ALIGN_CENTER, config->x_offset, config->y_offset);
-
     // Create analog clock gauge
     handle->analog_gauge = lv_gauge_create(config->parent, NULL);
     lv_obj_set_size(handle->analog_gauge, 139, 139);  // 110% of base 126
@@ -160,7 +265,8 @@ clock_handle_t clock_create(const clock_config_t *config)
     lv_gauge_set_value(handle->analog_gauge, 2, 30);  // Second at 12 (with offset)
 
     // Apply initial visibility based on loaded mode
-    lv_obj_set_hidden(handle->digital_label, !handle->digital_mode);
+    digital_clock_show(handle, handle->digital_mode);
+    analog_face_show(handle, !handle->digital_mode);
     lv_obj_set_hidden(handle->analog_gauge, handle->digital_mode);
 
     ESP_LOGI(TAG, "Clock created in %s mode", handle->digital_mode ? "digital" : "analog");
@@ -176,16 +282,19 @@ void clock_update(clock_handle_t handle, struct tm *timeinfo)
         return;
     }
 
-    // Update digital clock display (24-hour format)
-    if (handle->digital_label) {
-        char time_str[16];
-        snprintf(time_str, sizeof(time_str), "%02d:%02d:%02d",
-                 timeinfo->tm_hour, timeinfo->tm_min, timeinfo->tm_sec);
-
-        // Only update if text changed to avoid unnecessary redraws
-        const char *current_text = lv_label_get_text(handle->digital_label);
-        if (strcmp(current_text, time_str) != 0) {
-            lv_label_set_text(handle->digital_label, time_str);
+    // Update digital clock display (24-hour format), kept while it is hidden
+    char time_str[16];
+    snprintf(time_str, sizeof(time_str), "%02d:%02d:%02d",
+             timeinfo->tm_hour, timeinfo->tm_min, timeinfo->tm_sec);
+
+    // Only update if text changed to avoid unnecessary redraws
+    if (strcmp(handle->digital_text, time_str) != 0) {
+        strcpy(handle->digital_text, time_str);
+        if (handle->digit_atlas) {
+            // Redraws only the digits that changed
+            digit_sprite_set_text(handle->digital_clock, time_str);
+        } else if (handle->digital_clock) {
+            lv_label_set_text(handle->digital_clock, time_str);
         }
     }
 
@@ -228,14 +337,15 @@ void clock_toggle_mode(clock_handle_t handle)
     // Save to NVS
     save_digital_clock_mode(handle->digital_mode);
 
-    // Update visibility
+    // Update visibility, freeing the images of the mode left before allocating the other's
     if (handle->digital_mode) {
-        lv_obj_set_hidden(handle->digital_label, false);
-        lv_obj_set_hidden(handle->analog_gauge, true);
+        analog_face_show(handle, false);
+        digital_clock_show(handle, true);
     } else {
-        lv_obj_set_hidden(handle->digital_label, true);
-        lv_obj_set_hidden(handle->analog_gauge, false);
+        digital_clock_show(handle, false);
+        analog_face_show(handle, true);
     }
+    lv_obj_set_hidden(handle->analog_gauge, handle->digital_mode);
 
     ESP_LOGI(TAG, "Clock mode changed to %s", handle->digital_mode ? "digital" : "analog");
 }
@@ -260,6 +370,23 @@ void clock_set_mode(clock_handle_t handle, bool digital)
     clock_toggle_mode(handle);
 }
 
+/**
+ * @brief Render the cached clock graphics in the current theme colours
+ */
+void clock_refresh_theme(clock_handle_t handle)
+{
+    if (!handle) {
+        return;
+    }
+
+    if (handle->digit_atlas) {
+        digit_sprite_update_colors(handle->digital_clock);
+    }
+    if (handle->analog_face.data) {
+        analog_face_render(handle);
+    }
+}
+
 /**
  * @brief Destroy clock component and free resources
  */
@@ -270,12 +397,11 @@ void clock_destroy(clock_handle_t handle)
     }
 
     // Delete LVGL objects (automatically handles NULL)
+    digital_clock_show(handle, false);
+    analog_face_show(handle, false);
     if (handle->analog_gauge) {
         lv_obj_del(handle->analog_gauge);
     }
-    if (handle->digital_label) {
-        lv_obj_del(handle->digital_label);
-    }
     if (handle->toggle_button) {
         lv_obj_del(handle->toggle_button);
     }
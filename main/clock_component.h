@@ -3,8 +3,10 @@
  * @brief Reusable analog/digital clock component for LVGL
  * 
  * This component provides a dual-mode clock (analog and digital) with:
- * - Beautiful analog clock with hour, minute, and second hands
- * - Large digital clock display
+ * - Beautiful analog clock with hour, minute, and second hands, drawn on a
+ *   dial rendered once into an image (lv_gauge_set_face_img)
+ * - Large digital clock display, drawn from pre-rendered digits that are
+ *   redrawn only when they change (digit_sprite.h)
  * - Toggle button to switch between modes
  * - NVS persistence of user preference
  * - External time management (caller provides time updates)
@@ -36,8 +38,9 @@ typedef struct clock_handle_s* clock_handle_t;
 /**
  * @brief Create and initialize clock component
  * 
- * Creates both analog and digital clock widgets, with one initially hidden
- * based on configuration. If show_toggle_button is true, creates a toggle
+ * Creates the analog clock widget, and the digital clock while in digital
+ * mode. The analog dial image and the digital clock's digit atlas only
+ * exist while their mode is shown. If show_toggle_button is true, creates a toggle
  * button in the top-left corner labeled "dgt clk".
  * 
  * The initial mode is loaded from NVS if available, otherwise uses
@@ -55,7 +58,7 @@ clock_handle_t clock_create(const clock_config_t *config);
  * @brief Update clock display with current time
  * 
  * Updates both analog and digital clocks (even if hidden) to show the
- * provided time. Call this function at least once per second for smooth
+ * provided time. The digital clock only redraws the digits that changed. Call this function at least once per second for smooth
  * second hand movement.
  * 
  * @param handle Clock handle
@@ -96,6 +99,17 @@ bool clock_is_digital_mode(clock_handle_t handle);
  */
 void clock_set_mode(clock_handle_t handle, bool digital);
 
+/**
+ * @brief Render the cached clock graphics in the current theme colours
+ * 
+ * The analog clock's dial and the digital clock's digits are rendered once
+ * at the theme colours. Call this after lv_theme_set_act() so they follow a
+ * theme or accent change.
+ * 
+ * @param handle Clock handle
+ */
+void clock_refresh_theme(clock_handle_t handle);
+
 /**
  * @brief Destroy clock component and free resources
  * 
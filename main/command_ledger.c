@@ -0,0 +1,174 @@
+/**
+ * @file command_ledger.c
+ * @brief Bounded record of executed MQTT command IDs
+ *
+ * The index uses linear probing with backward-shift deletion, so evicting the
+ * oldest entry leaves no tombstones and lookups stay short however many IDs
+ * have passed through the ring.
+ */
+
+#include "command_ledger.h"
+#include <string.h>
+
+#define RING_MASK   (COMMAND_LEDGER_CAPACITY - 1)
+#define INDEX_MASK  (COMMAND_LEDGER_INDEX_SIZE - 1)
+
+_Static_assert((COMMAND_LEDGER_CAPACITY & RING_MASK) == 0,
+               "COMMAND_LEDGER_CAPACITY must be a power of two");
+_Static_assert(COMMAND_LEDGER_CAPACITY % COMMAND_LEDGER_CHUNK == 0 && COMMAND_LEDGER_CHUNKS <= 32,
+               "COMMAND_LEDGER_CHUNKS must fit the dirty mask");
+_Static_assert(COMMAND_LEDGER_CAPACITY < UINT16_MAX, "index stores slot + 1 in 16 bits");
+_Static_assert(sizeof(command_ledger_entry_t) == 12, "persisted entry layout");
+
+uint64_t command_ledger_hash(const char *command_id)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (const unsigned char *p = (const unsigned char *)command_id; *p; p++) {
+        h ^= *p;
+        h *= 0x100000001b3ULL;
+    }
+    return h != 0 ? h : 1;
+}
+
+static bool entry_used(const command_ledger_entry_t *e)
+{
+    return e->hash_lo != 0 || e->hash_hi != 0;
+}
+
+static bool entry_matches(const command_ledger_entry_t *e, uint64_t hash)
+{
+    return e->hash_lo == (uint32_t)hash && e->hash_hi == (uint32_t)(hash >> 32);
+}
+
+// Home index slot: mix both halves so IDs differing only in the tail spread out
+static uint32_t home_slot(uint32_t lo, uint32_t hi)
+{
+    return (((lo ^ hi) * 0x9E3779B1u) >> 16) & INDEX_MASK;
+}
+
+// Index position holding the entry with this hash, or -1
+static int find(const command_ledger_t *l, uint64_t hash)
+{
+    uint32_t i = home_slot((uint32_t)hash, (uint32_t)(hash >> 32));
+    while (l->index[i] != 0) {
+        if (entry_matches(&l->entries[l->index[i] - 1], hash)) {
+            return (int)i;
+        }
+        i = (i + 1) & INDEX_MASK;
+    }
+    return -1;
+}
+
+static void index_insert(command_ledger_t *l, uint32_t slot)
+{
+    const command_ledger_entry_t *e = &l->entries[slot];
+    uint32_t i = home_slot(e->hash_lo, e->hash_hi);
+    while (l->index[i] != 0) {
+        i = (i + 1) & INDEX_MASK;
+    }
+    l->index[i] = (uint16_t)(slot + 1);
+}
+
+// Remove index position i and shift later members of the probe run back
+static void index_remove(command_ledger_t *l, uint32_t i)
+{
+    uint32_t j = i;
+    while (1) {
+        l->index[i] = 0;
+        while (1) {
+            j = (j + 1) & INDEX_MASK;
+            if (l->index[j] == 0) {
+                return;
+            }
+            const command_ledger_entry_t *e = &l->entries[l->index[j] - 1];
+            uint32_t home = home_slot(e->hash_lo, e->hash_hi);
+            // Move j into the hole unless its home lies cyclically in (i, j]
+            bool stays = i <= j ? (i < home && home <= j) : (i < home || home <= j);
+            if (!stays) {
+                break;
+            }
+        }
+        l->index[i] = l->index[j];
+        i = j;
+    }
+}
+
+void command_ledger_init(command_ledger_t *l, uint32_t max_age_s)
+{
+    memset(l, 0, sizeof(*l));
+    l->max_age_s = max_age_s;
+}
+
+void command_ledger_restore(command_ledger_t *l)
+{
+    memset(l->index, 0, sizeof(l->index));
+    // Slots the ring has not reached yet must be empty
+    for (uint32_t slot = 0; slot < COMMAND_LEDGER_CAPACITY; slot++) {
+        command_ledger_entry_t *e = &l->entries[slot];
+        if (!entry_used(e)) {
+            continue;
+        }
+        if (l->head < COMMAND_LEDGER_CAPACITY && slot >= l->head) {
+            memset(e, 0, sizeof(*e));
+            continue;
+        }
+        uint64_t hash = (uint64_t)e->hash_hi << 32 | e->hash_lo;
+        if (find(l, hash) >= 0) {
+            memset(e, 0, sizeof(*e));  // Duplicate from a torn write
+            continue;
+        }
+        index_insert(l, slot);
+    }
+    l->dirty = 0;
+}
+
+static bool expired(const command_ledger_t *l, const command_ledger_entry_t *e, uint32_t now)
+{
+    return l->max_age_s != 0 && e->time != 0 && now != 0 &&
+           now > e->time && now - e->time > l->max_age_s;
+}
+
+bool command_ledger_contains(const command_ledger_t *l, uint64_t hash, uint32_t now)
+{
+    int i = find(l, hash);
+    return i >= 0 && !expired(l, &l->entries[l->index[i] - 1], now);
+}
+
+void command_ledger_add(command_ledger_t *l, uint64_t hash, uint32_t now)
+{
+    int i = find(l, hash);
+    if (i >= 0) {
+        uint32_t slot = l->index[i] - 1u;
+        l->entries[slot].time = now;
+        l->dirty |= 1u << (slot / COMMAND_LEDGER_CHUNK);
+        return;
+    }
+
+    uint32_t slot = l->head & RING_MASK;
+    command_ledger_entry_t *e = &l->entries[slot];
+    if (entry_used(e)) {
+        // Ring full: forget the oldest ID
+        int old = find(l, (uint64_t)e->hash_hi << 32 | e->hash_lo);
+        if (old >= 0) {
+            index_remove(l, (uint32_t)old);
+        }
+    }
+    e->hash_lo = (uint32_t)hash;
+    e->hash_hi = (uint32_t)(hash >> 32);
+    e->time = now;
+    index_insert(l, slot);
+    l->head++;
+    l->dirty |= 1u << (slot / COMMAND_LEDGER_CHUNK);
+}
+
+uint32_t command_ledger_count(const command_ledger_t *l)
+{
+    return l->head < COMMAND_LEDGER_CAPACITY ? l->head : COMMAND_LEDGER_CAPACITY;
+}
+
+uint32_t command_ledger_take_dirty(command_ledger_t *l)
+{
+    uint32_t dirty = l->dirty;
+    l->dirty = 0;
+    return dirty;
+}
@@ -0,0 +1,103 @@
+/**
+ * @file command_ledger.h
+ * @brief Bounded record of executed MQTT command IDs (duplicate detection)
+ *
+ * Commands are delivered with QoS 1 and may arrive more than once, so every
+ * executed command_id is remembered:
+ * - IDs are stored as 64-bit FNV-1a hashes, so any ID length works
+ * - The newest COMMAND_LEDGER_CAPACITY IDs are kept in a ring; older ones are
+ *   forgotten, as are IDs older than max_age_s (when the clock is known)
+ * - Lookups go through an open-addressing hash index: O(1), no flash access
+ * - The ring is persisted by the caller in fixed chunks; the ledger only
+ *   tracks which chunks changed, so writes can be batched
+ *
+ * Not thread safe (callers lock). No ESP-IDF dependencies.
+ */
+
+#ifndef COMMAND_LEDGER_H
+#define COMMAND_LEDGER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Number of remembered IDs (power of two), 12 bytes each plus 4 bytes of index
+#ifndef COMMAND_LEDGER_CAPACITY
+#define COMMAND_LEDGER_CAPACITY     256
+#endif
+
+// Entries per persisted chunk (one NVS blob of 384 bytes)
+#define COMMAND_LEDGER_CHUNK        32
+#define COMMAND_LEDGER_CHUNKS       (COMMAND_LEDGER_CAPACITY / COMMAND_LEDGER_CHUNK)
+
+// Hash index slots (load factor <= 0.5)
+#define COMMAND_LEDGER_INDEX_SIZE   (2 * COMMAND_LEDGER_CAPACITY)
+
+/**
+ * @brief One executed command
+ */
+typedef struct {
+    uint32_t hash_lo;         ///< Low half of the ID hash (0:0 = unused slot)
+    uint32_t hash_hi;         ///< High half of the ID hash
+    uint32_t time;            ///< Unix time of execution, 0 if the clock was not set
+} command_ledger_entry_t;
+
+/**
+ * @brief Ledger state (statically allocated)
+ */
+typedef struct {
+    command_ledger_entry_t entries[COMMAND_LEDGER_CAPACITY]; ///< Ring, persisted
+    uint16_t index[COMMAND_LEDGER_INDEX_SIZE];  ///< Entry slot + 1, 0 = empty
+    uint32_t head;            ///< Entries ever added (ring write position), persisted
+    uint32_t dirty;           ///< Bit per chunk changed since the last command_ledger_take_dirty()
+    uint32_t max_age_s;       ///< Forget IDs older than this (0 = only when evicted)
+} command_ledger_t;
+
+/**
+ * @brief Hash of a command ID (never 0)
+ */
+uint64_t command_ledger_hash(const char *command_id);
+
+/**
+ * @brief Empty ledger
+ */
+void command_ledger_init(command_ledger_t *l, uint32_t max_age_s);
+
+/**
+ * @brief Rebuild the index after entries[] and head were loaded from storage
+ *
+ * Entries that do not belong to the ring position (corrupt storage) are dropped.
+ */
+void command_ledger_restore(command_ledger_t *l);
+
+/**
+ * @brief True if the ID was executed and has not expired
+ *
+ * @param now Current Unix time, 0 if unknown (no age-based expiry then)
+ */
+bool command_ledger_contains(const command_ledger_t *l, uint64_t hash, uint32_t now);
+
+/**
+ * @brief Record an executed ID (refreshes the time if already present)
+ */
+void command_ledger_add(command_ledger_t *l, uint64_t hash, uint32_t now);
+
+/**
+ * @brief Number of remembered IDs (expired ones included until overwritten)
+ */
+uint32_t command_ledger_count(const command_ledger_t *l);
+
+/**
+ * @brief Chunks changed since the last call (bit n = chunk n), clears the set
+ */
+uint32_t command_ledger_take_dirty(command_ledger_t *l);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // COMMAND_LEDGER_H
@@ -0,0 +1,333 @@
+/**
+ * @file digit_sprite.c
+ * @brief Implementation of pre-rendered digit atlases and sprites
+ */
+
+#include "digit_sprite.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define DIGIT_SPRITE_NONE   0xFF    ///< Cell without a glyph yet
+
+static const char *TAG = "digit_sprite";
+
+/**
+ * @brief Internal atlas structure
+ */
+struct digit_atlas_s {
+    const lv_font_t *font;
+    uint8_t count;                                  ///< Glyphs in the atlas
+    uint32_t letters[DIGIT_ATLAS_MAX_GLYPHS];       ///< Unicode of each glyph
+    char text[DIGIT_ATLAS_MAX_GLYPHS][5];           ///< UTF-8 of each glyph, to render it
+    lv_img_dsc_t cells[DIGIT_ATLAS_MAX_GLYPHS];     ///< Image of each glyph
+    lv_coord_t top;                                 ///< Top of the cells below the top of a line
+    lv_color_t fg;
+    lv_color_t bg;
+    uint8_t *pixels;                                ///< All cells, one after another
+    size_t size;                                    ///< Bytes of pixels
+};
+
+/**
+ * @brief Sprite data (LVGL ext attribute of the container)
+ */
+typedef struct {
+    digit_atlas_t atlas;
+    uint8_t max_chars;
+    uint8_t count;                                  ///< Cells showing a character
+    uint8_t glyph[DIGIT_SPRITE_MAX_CHARS];          ///< Atlas glyph of each cell
+    lv_obj_t *cells[DIGIT_SPRITE_MAX_CHARS];
+} digit_sprite_ext_t;
+
+// Forward declarations
+static void digit_atlas_render(digit_atlas_t atlas);
+static int digit_atlas_find(digit_atlas_t atlas, uint32_t letter);
+
+/**
+ * @brief Draw every glyph centred in its cell with the label pipeline
+ *
+ * A hidden canvas points at each cell in turn, so the glyphs are blended
+ * on the background exactly like a label draws them on screen.
+ */
+static void digit_atlas_render(digit_atlas_t atlas)
+{
+    lv_obj_t *canvas = lv_canvas_create(lv_layer_sys(), NULL);
+    lv_obj_set_hidden(canvas, true);
+
+    lv_draw_label_dsc_t dsc;
+    lv_draw_label_dsc_init(&dsc);
+    dsc.color = atlas->fg;
+    dsc.font = atlas->font;
+
+    for (int i = 0; i < atlas->count; i++) {
+        lv_img_dsc_t *cell = &atlas->cells[i];
+        lv_canvas_set_buffer(canvas, (void *)cell->data, cell->header.w, cell->header.h, LV_IMG_CF_TRUE_COLOR);
+        lv_canvas_fill_bg(canvas, atlas->bg, LV_OPA_COVER);
+        lv_canvas_draw_text(canvas, 0, -atlas->top, cell->header.w, &dsc, atlas->text[i], LV_LABEL_ALIGN_CENTER);
+        lv_img_cache_invalidate_src(cell);
+    }
+
+    lv_obj_del(canvas);
+}
+
+/**
+ * @brief Find the atlas glyph of a letter
+ */
+static int digit_atlas_find(digit_atlas_t atlas, uint32_t letter)
+{
+    for (int i = 0; i < atlas->count; i++) {
+        if (atlas->letters[i] == letter) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Render glyphs of a font into an atlas
+ */
+digit_atlas_t digit_atlas_create(const lv_font_t *font, const char *glyphs, lv_color_t fg, lv_color_t bg)
+{
+    if (!font || !glyphs) {
+        return NULL;
+    }
+
+    digit_atlas_t atlas = (digit_atlas_t)calloc(1, sizeof(struct digit_atlas_s));
+    if (!atlas) {
+        ESP_LOGE(TAG, "Failed to allocate memory");
+        return NULL;
+    }
+    atlas->font = font;
+    atlas->fg = fg;
+    atlas->bg = bg;
+
+    // Glyph widths, the widest digit, and the rows the glyphs draw on
+    lv_coord_t widths[DIGIT_ATLAS_MAX_GLYPHS];
+    lv_coord_t digit_w = 0;
+    lv_coord_t top = font->line_height;
+    lv_coord_t bottom = 0;
+    uint32_t i = 0;
+    while (glyphs[i] && atlas->count < DIGIT_ATLAS_MAX_GLYPHS) {
+        uint32_t start = i;
+        uint32_t letter = _lv_txt_encoded_next(glyphs, &i);
+        lv_font_glyph_dsc_t g;
+        if (!lv_font_get_glyph_dsc(font, &g, letter, 0) || i - start >= sizeof(atlas->text[0])) {
+            ESP_LOGW(TAG, "Glyph U+%04lX not in the font", (unsigned long)letter);
+            continue;
+        }
+
+        int n = atlas->count++;
+        atlas->letters[n] = letter;
+        memcpy(atlas->text[n], &glyphs[start], i - start);
+        widths[n] = g.adv_w;
+        if (letter >= '0' && letter <= '9' && g.adv_w > digit_w) {
+            digit_w = g.adv_w;
+        }
+        if (g.box_h > 0) {
+            lv_coord_t glyph_top = font->line_height - font->base_line - g.box_h - g.ofs_y;
+            top = LV_MATH_MIN(top, glyph_top);
+            bottom = LV_MATH_MAX(bottom, glyph_top + g.box_h);
+        }
+    }
+    if (atlas->count == 0 || bottom <= top) {
+        free(atlas);
+        return NULL;
+    }
+    top = LV_MATH_MAX(top, 0);
+    bottom = LV_MATH_MIN(bottom, font->line_height);
+    lv_coord_t cell_h = bottom - top;
+    atlas->top = top;
+
+    // Digits are as wide as the widest one, so numbers do not move
+    for (int n = 0; n < atlas->count; n++) {
+        if (atlas->letters[n] >= '0' && atlas->letters[n] <= '9') {
+            widths[n] = digit_w;
+        }
+        atlas->size += LV_IMG_BUF_SIZE_TRUE_COLOR(widths[n], cell_h);
+    }
+
+    atlas->pixels = (uint8_t *)malloc(atlas->size);
+    if (!atlas->pixels) {
+        ESP_LOGE(TAG, "Failed to allocate %u bytes for %d glyphs", (unsigned)atlas->size, atlas->count);
+        free(atlas);
+        return NULL;
+    }
+
+    uint8_t *data = atlas->pixels;
+    for (int n = 0; n < atlas->count; n++) {
+        lv_img_dsc_t *cell = &atlas->cells[n];
+        cell->header.always_zero = 0;
+        cell->header.cf = LV_IMG_CF_TRUE_COLOR;
+        cell->header.w = widths[n];
+        cell->header.h = cell_h;
+        cell->data_size = LV_IMG_BUF_SIZE_TRUE_COLOR(cell->header.w, cell->header.h);
+        cell->data = data;
+        data += cell->data_size;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    digit_atlas_render(atlas);
+    ESP_LOGI(TAG, "Atlas of %d glyphs, %d px high: %u bytes, rendered in %lld us",
+             atlas->count, cell_h, (unsigned)atlas->size, esp_timer_get_time() - start_us);
+    return atlas;
+}
+
+/**
+ * @brief Render the atlas again in other colours
+ */
+bool digit_atlas_set_colors(digit_atlas_t atlas, lv_color_t fg, lv_color_t bg)
+{
+    if (!atlas || (atlas->fg.full == fg.full && atlas->bg.full == bg.full)) {
+        return false;
+    }
+
+    atlas->fg = fg;
+    atlas->bg = bg;
+    digit_atlas_render(atlas);
+    return true;
+}
+
+/**
+ * @brief Get the text and background colours a sprite or label is drawn with
+ */
+void digit_atlas_colors_of(lv_obj_t *obj, lv_color_t *fg, lv_color_t *bg)
+{
+    *fg = lv_obj_get_style_text_color(obj, LV_OBJ_PART_MAIN);
+    *bg = LV_COLOR_BLACK;
+    for (lv_obj_t *o = obj; o; o = lv_obj_get_parent(o)) {
+        if (lv_obj_get_style_bg_opa(o, LV_OBJ_PART_MAIN) >= LV_OPA_MAX) {
+            *bg = lv_obj_get_style_bg_color(o, LV_OBJ_PART_MAIN);
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Get the bytes of pixels an atlas holds
+ */
+size_t digit_atlas_get_size(digit_atlas_t atlas)
+{
+    return atlas ? atlas->size : 0;
+}
+
+/**
+ * @brief Free an atlas
+ */
+void digit_atlas_destroy(digit_atlas_t atlas)
+{
+    if (!atlas) {
+        return;
+    }
+
+    for (int n = 0; n < atlas->count; n++) {
+        lv_img_cache_invalidate_src(&atlas->cells[n]);
+    }
+    free(atlas->pixels);
+    free(atlas);
+}
+
+/**
+ * @brief Create a digit sprite
+ */
+lv_obj_t *digit_sprite_create(lv_obj_t *parent, digit_atlas_t atlas, uint8_t max_chars)
+{
+    if (!atlas) {
+        return NULL;
+    }
+
+    lv_obj_t *sprite = lv_obj_create(parent, NULL);
+    if (!sprite) {
+        return NULL;
+    }
+    digit_sprite_ext_t *ext = lv_obj_allocate_ext_attr(sprite, sizeof(digit_sprite_ext_t));
+    if (!ext) {
+        lv_obj_del(sprite);
+        return NULL;
+    }
+    memset(ext, 0, sizeof(digit_sprite_ext_t));
+    ext->atlas = atlas;
+    ext->max_chars = LV_MATH_MIN(max_chars, DIGIT_SPRITE_MAX_CHARS);
+
+    // No background or border: the cells draw everything
+    lv_obj_clean_style_list(sprite, LV_OBJ_PART_MAIN);
+    lv_obj_set_click(sprite, false);
+    lv_obj_set_size(sprite, 0, lv_font_get_line_height(atlas->font));
+
+    for (int i = 0; i < ext->max_chars; i++) {
+        lv_obj_t *cell = lv_img_create(sprite, NULL);
+        lv_obj_clean_style_list(cell, LV_IMG_PART_MAIN);
+        lv_obj_set_hidden(cell, true);
+        lv_obj_set_y(cell, atlas->top);
+        ext->cells[i] = cell;
+        ext->glyph[i] = DIGIT_SPRITE_NONE;
+    }
+
+    return sprite;
+}
+
+/**
+ * @brief Show a string
+ */
+void digit_sprite_set_text(lv_obj_t *sprite, const char *text)
+{
+    if (!sprite || !text) {
+        return;
+    }
+
+    digit_sprite_ext_t *ext = lv_obj_get_ext_attr(sprite);
+    digit_atlas_t atlas = ext->atlas;
+    lv_coord_t x = 0;
+    uint8_t n = 0;
+    uint32_t i = 0;
+
+    while (text[i] && n < ext->max_chars) {
+        int g = digit_atlas_find(atlas, _lv_txt_encoded_next(text, &i));
+        if (g < 0) {
+            continue;
+        }
+
+        lv_obj_t *cell = ext->cells[n];
+        if (ext->glyph[n] != g) {
+            lv_img_set_src(cell, &atlas->cells[g]);
+            ext->glyph[n] = g;
+        }
+        if (lv_obj_get_x(cell) != x) {
+            lv_obj_set_x(cell, x);
+        }
+        if (lv_obj_get_hidden(cell)) {
+            lv_obj_set_hidden(cell, false);
+        }
+        x += atlas->cells[g].header.w;
+        n++;
+    }
+
+    for (int k = n; k < ext->count; k++) {
+        lv_obj_set_hidden(ext->cells[k], true);
+    }
+    ext->count = n;
+
+    if (lv_obj_get_width(sprite) != x) {
+        lv_obj_set_width(sprite, x);
+    }
+}
+
+/**
+ * @brief Render the atlas of a sprite in the sprite's current colours
+ */
+bool digit_sprite_update_colors(lv_obj_t *sprite)
+{
+    if (!sprite) {
+        return false;
+    }
+
+    digit_sprite_ext_t *ext = lv_obj_get_ext_attr(sprite);
+    lv_color_t fg, bg;
+    digit_atlas_colors_of(sprite, &fg, &bg);
+    if (!digit_atlas_set_colors(ext->atlas, fg, bg)) {
+        return false;
+    }
+
+    lv_obj_invalidate(sprite);
+    return true;
+}
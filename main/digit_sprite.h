@@ -0,0 +1,129 @@
+/**
+ * @file digit_sprite.h
+ * @brief Pre-rendered digits for numbers that change every second
+ *
+ * A label redraws its whole box on every lv_label_set_text(): LVGL blends
+ * the background and then every glyph through the text pipeline again.
+ * A digit atlas renders a small set of glyphs ("0123456789:" and the like)
+ * once, at the current theme colours, into opaque RGB565 images. A digit
+ * sprite shows a string as one lv_img per character cell using those images:
+ * - Setting a new text only touches the cells whose character changed, so
+ *   "12:34:56" -> "12:34:57" invalidates one cell
+ * - An opaque cell covers its area, so LVGL copies it to the display buffer
+ *   without drawing the background under it
+ * - Digits share the width of the widest one, so the string does not move
+ *   as they change
+ *
+ * The atlas bakes in the text and background colours; call
+ * digit_sprite_update_colors() after a theme change. One atlas can serve
+ * several sprites that use the same font on the same background.
+ */
+
+#ifndef DIGIT_SPRITE_H
+#define DIGIT_SPRITE_H
+
+#include "lvgl/lvgl.h"
+#include <stdbool.h>
+
+#define DIGIT_ATLAS_MAX_GLYPHS  16  ///< Glyphs per atlas
+#define DIGIT_SPRITE_MAX_CHARS  12  ///< Character cells per sprite
+
+/**
+ * @brief Digit atlas handle (opaque pointer)
+ */
+typedef struct digit_atlas_s* digit_atlas_t;
+
+/**
+ * @brief Render glyphs of a font into an atlas
+ *
+ * Cells are as high as the ink of the glyphs (not the whole line), and the
+ * pixels are allocated from the heap: width x height x 2 bytes per glyph.
+ *
+ * @param font Font to render, normally the one of the label it replaces
+ * @param glyphs UTF-8 string of the glyphs, e.g. "0123456789:"
+ * @param fg Text colour
+ * @param bg Background colour
+ * @return Atlas handle or NULL on error (out of memory)
+ */
+digit_atlas_t digit_atlas_create(const lv_font_t *font, const char *glyphs, lv_color_t fg, lv_color_t bg);
+
+/**
+ * @brief Render the atlas again in other colours
+ *
+ * Does nothing if the colours did not change. The caller must invalidate
+ * the sprites using the atlas (digit_sprite_update_colors() does).
+ *
+ * @param atlas Atlas handle
+ * @param fg Text colour
+ * @param bg Background colour
+ * @return true if the atlas was rendered again
+ */
+bool digit_atlas_set_colors(digit_atlas_t atlas, lv_color_t fg, lv_color_t bg);
+
+/**
+ * @brief Get the text and background colours a sprite or label is drawn with
+ *
+ * The text colour is the object's (inherited from its parents unless set);
+ * the background is the one of the nearest parent with an opaque background.
+ *
+ * @param obj LVGL object
+ * @param fg Text colour
+ * @param bg Background colour
+ */
+void digit_atlas_colors_of(lv_obj_t *obj, lv_color_t *fg, lv_color_t *bg);
+
+/**
+ * @brief Get the bytes of pixels an atlas holds
+ *
+ * @param atlas Atlas handle
+ * @return Size in bytes
+ */
+size_t digit_atlas_get_size(digit_atlas_t atlas);
+
+/**
+ * @brief Free an atlas
+ *
+ * Delete the sprites using it first.
+ *
+ * @param atlas Atlas handle
+ */
+void digit_atlas_destroy(digit_atlas_t atlas);
+
+/**
+ * @brief Create a digit sprite
+ *
+ * The sprite is a transparent container as high as a line of the atlas
+ * font, with one image per character cell. It starts empty (zero width).
+ *
+ * @param parent Parent object
+ * @param atlas Atlas to draw the characters from (must outlive the sprite)
+ * @param max_chars Character cells, up to DIGIT_SPRITE_MAX_CHARS
+ * @return Sprite object or NULL on error
+ */
+lv_obj_t *digit_sprite_create(lv_obj_t *parent, digit_atlas_t atlas, uint8_t max_chars);
+
+/**
+ * @brief Show a string
+ *
+ * Characters not in the atlas are skipped. Only cells whose character or
+ * position changed are invalidated. The sprite's width follows the text,
+ * growing to the right like a label's.
+ *
+ * @param sprite Sprite object
+ * @param text UTF-8 text
+ */
+void digit_sprite_set_text(lv_obj_t *sprite, const char *text);
+
+/**
+ * @brief Render the atlas of a sprite in the sprite's current colours
+ *
+ * Call after a theme change (lv_theme_set_act). Redraws the sprite if the
+ * colours changed; other sprites sharing the atlas must be invalidated by
+ * the caller.
+ *
+ * @param sprite Sprite object
+ * @return true if the atlas was rendered again
+ */
+bool digit_sprite_update_colors(lv_obj_t *sprite);
+
+#endif // DIGIT_SPRITE_H
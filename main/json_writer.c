@@ -0,0 +1,242 @@
+/**
+ * @file json_writer.c
+ * @brief Allocation-free streaming JSON writer
+ */
+
+#include "json_writer.h"
+#include <math.h>
+#include <string.h>
+
+static const int64_t pow10_table[] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+
+static void put(json_writer_t *w, const char *data, size_t n)
+{
+    if (w->overflow) {
+        return;
+    }
+    // Always keep one byte for the terminating NUL
+    if (w->len + n >= w->cap) {
+        w->overflow = true;
+        return;
+    }
+    memcpy(w->buf + w->len, data, n);
+    w->len += n;
+}
+
+static void put_char(json_writer_t *w, char c)
+{
+    put(w, &c, 1);
+}
+
+// Comma before every member except the first in the current container
+static void begin_value(json_writer_t *w)
+{
+    if (w->after_key) {
+        w->after_key = false;
+        return;
+    }
+    if (w->depth > 0) {
+        uint16_t bit = (uint16_t)(1u << (w->depth - 1));
+        if (w->has_items & bit) {
+            put_char(w, ',');
+        }
+        w->has_items |= bit;
+    }
+}
+
+static void put_uint(json_writer_t *w, uint64_t value, int min_digits)
+{
+    char tmp[20];
+    int n = 0;
+    do {
+        tmp[sizeof(tmp) - 1 - n] = (char)('0' + value % 10);
+        value /= 10;
+        n++;
+    } while (value != 0 || n < min_digits);
+    put(w, &tmp[sizeof(tmp) - n], (size_t)n);
+}
+
+static void put_escaped(json_writer_t *w, const char *s)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    put_char(w, '"');
+    const char *run = s;
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        put(w, run, (size_t)(s - run));
+        run = s + 1;
+        switch (c) {
+            case '"':  put(w, "\\\"", 2); break;
+            case '\\': put(w, "\\\\", 2); break;
+            case '\n': put(w, "\\n", 2); break;
+            case '\r': put(w, "\\r", 2); break;
+            case '\t': put(w, "\\t", 2); break;
+            default: {
+                char esc[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+                put(w, esc, sizeof(esc));
+                break;
+            }
+        }
+    }
+    put(w, run, (size_t)(s - run));
+    put_char(w, '"');
+}
+
+void json_writer_init(json_writer_t *w, char *buf, size_t cap)
+{
+    memset(w, 0, sizeof(*w));
+    w->buf = buf;
+    w->cap = cap;
+    if (cap == 0) {
+        w->overflow = true;
+    }
+}
+
+const char *json_writer_finish(json_writer_t *w, size_t *len)
+{
+    if (w->overflow || w->depth != 0 || w->after_key) {
+        if (len) {
+            *len = 0;
+        }
+        return NULL;
+    }
+    w->buf[w->len] = '\0';
+    if (len) {
+        *len = w->len;
+    }
+    return w->buf;
+}
+
+static void open_container(json_writer_t *w, char c)
+{
+    begin_value(w);
+    if (w->depth >= JSON_WRITER_MAX_DEPTH) {
+        w->overflow = true;
+        return;
+    }
+    put_char(w, c);
+    w->depth++;
+    w->has_items &= (uint16_t)~(1u << (w->depth - 1));
+}
+
+static void close_container(json_writer_t *w, char c)
+{
+    if (w->depth == 0) {
+        w->overflow = true;
+        return;
+    }
+    w->depth--;
+    put_char(w, c);
+}
+
+void json_obj_begin(json_writer_t *w) { open_container(w, '{'); }
+void json_obj_end(json_writer_t *w) { close_container(w, '}'); }
+void json_arr_begin(json_writer_t *w) { open_container(w, '['); }
+void json_arr_end(json_writer_t *w) { close_container(w, ']'); }
+
+void json_key(json_writer_t *w, const char *key)
+{
+    begin_value(w);
+    put_escaped(w, key);
+    put_char(w, ':');
+    w->after_key = true;
+}
+
+void json_str(json_writer_t *w, const char *value)
+{
+    begin_value(w);
+    if (value == NULL) {
+        put(w, "null", 4);
+        return;
+    }
+    put_escaped(w, value);
+}
+
+void json_int(json_writer_t *w, int64_t value)
+{
+    begin_value(w);
+    if (value < 0) {
+        put_char(w, '-');
+        put_uint(w, (uint64_t)0 - (uint64_t)value, 1);
+    } else {
+        put_uint(w, (uint64_t)value, 1);
+    }
+}
+
+void json_bool(json_writer_t *w, bool value)
+{
+    begin_value(w);
+    if (value) {
+        put(w, "true", 4);
+    } else {
+        put(w, "false", 5);
+    }
+}
+
+void json_null(json_writer_t *w)
+{
+    begin_value(w);
+    put(w, "null", 4);
+}
+
+void json_fixed(json_writer_t *w, int64_t value, uint8_t decimals)
+{
+    if (decimals == 0) {
+        json_int(w, value);
+        return;
+    }
+    if (decimals > 6) {
+        decimals = 6;
+    }
+
+    begin_value(w);
+    uint64_t magnitude = value < 0 ? (uint64_t)0 - (uint64_t)value : (uint64_t)value;
+    if (value < 0) {
+        put_char(w, '-');
+    }
+    uint64_t scale = (uint64_t)pow10_table[decimals];
+    put_uint(w, magnitude / scale, 1);
+    put_char(w, '.');
+    put_uint(w, magnitude % scale, decimals);
+}
+
+void json_float(json_writer_t *w, float value, uint8_t decimals)
+{
+    if (decimals > 6) {
+        decimals = 6;
+    }
+    // Also rejects values too large for the int64 fixed-point path
+    if (!isfinite(value) || fabsf(value) > 1e12f) {
+        json_null(w);
+        return;
+    }
+    json_fixed(w, llround((double)value * (double)pow10_table[decimals]), decimals);
+}
+
+void json_kv_str(json_writer_t *w, const char *key, const char *value)
+{
+    json_key(w, key);
+    json_str(w, value);
+}
+
+void json_kv_int(json_writer_t *w, const char *key, int64_t value)
+{
+    json_key(w, key);
+    json_int(w, value);
+}
+
+void json_kv_bool(json_writer_t *w, const char *key, bool value)
+{
+    json_key(w, key);
+    json_bool(w, value);
+}
+
+void json_kv_float(json_writer_t *w, const char *key, float value, uint8_t decimals)
+{
+    json_key(w, key);
+    json_float(w, value, decimals);
+}
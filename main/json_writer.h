@@ -0,0 +1,102 @@
+/**
+ * @file json_writer.h
+ * @brief Allocation-free streaming JSON writer for MQTT payloads
+ *
+ * Serialises straight into a caller-provided (stack or static) buffer:
+ * - No heap use, no intermediate tree
+ * - Bounds checked: on overflow the writer stops and json_writer_finish()
+ *   returns NULL, it never writes past the buffer
+ * - Integers and fixed-point floats are formatted without printf
+ *
+ * Commas between members are inserted automatically, so callers only
+ * describe the structure:
+ *
+ *   char buf[128];
+ *   json_writer_t w;
+ *   json_writer_init(&w, buf, sizeof(buf));
+ *   json_obj_begin(&w);
+ *   json_kv_str(&w, "command", "say_time");
+ *   json_kv_int(&w, "timestamp", now);
+ *   json_obj_end(&w);
+ *   const char *payload = json_writer_finish(&w, &len);
+ *
+ * No ESP-IDF dependencies.
+ */
+
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Maximum nesting depth of objects/arrays
+#define JSON_WRITER_MAX_DEPTH 16
+
+/**
+ * @brief Writer state
+ */
+typedef struct {
+    char *buf;                ///< Output buffer
+    size_t cap;               ///< Buffer size including the terminating NUL
+    size_t len;               ///< Bytes written so far
+    bool overflow;            ///< Set once anything did not fit
+    bool after_key;           ///< Next value belongs to the key just written
+    uint8_t depth;            ///< Current nesting depth
+    uint16_t has_items;       ///< Bit per depth: container already has a member
+} json_writer_t;
+
+/**
+ * @brief Start writing into buf
+ */
+void json_writer_init(json_writer_t *w, char *buf, size_t cap);
+
+/**
+ * @brief NUL-terminate the output
+ *
+ * @param w Writer
+ * @param len Optional: payload length without the NUL
+ * @return The payload, or NULL if it did not fit or nesting is unbalanced
+ */
+const char *json_writer_finish(json_writer_t *w, size_t *len);
+
+void json_obj_begin(json_writer_t *w);
+void json_obj_end(json_writer_t *w);
+void json_arr_begin(json_writer_t *w);
+void json_arr_end(json_writer_t *w);
+
+/**
+ * @brief Member name inside an object (must be followed by a value)
+ */
+void json_key(json_writer_t *w, const char *key);
+
+void json_str(json_writer_t *w, const char *value);
+void json_int(json_writer_t *w, int64_t value);
+void json_bool(json_writer_t *w, bool value);
+void json_null(json_writer_t *w);
+
+/**
+ * @brief Fixed-point number: value / 10^decimals, e.g. (1234, 3) -> 1.234
+ */
+void json_fixed(json_writer_t *w, int64_t value, uint8_t decimals);
+
+/**
+ * @brief Float rounded to a fixed number of decimals (max 6); NaN/Inf -> null
+ */
+void json_float(json_writer_t *w, float value, uint8_t decimals);
+
+// Key + value shorthands
+void json_kv_str(json_writer_t *w, const char *key, const char *value);
+void json_kv_int(json_writer_t *w, const char *key, int64_t value);
+void json_kv_bool(json_writer_t *w, const char *key, bool value);
+void json_kv_float(json_writer_t *w, const char *key, float value, uint8_t decimals);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // JSON_WRITER_H
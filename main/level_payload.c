@@ -0,0 +1,72 @@
+/**
+ * @file level_payload.c
+ * @brief Binary (CBOR) encoding of level sample batches
+ */
+
+#include "level_payload.h"
+#include <math.h>
+
+// Map keys
+#define KEY_CLIENT_ID 0
+#define KEY_T0        1
+#define KEY_DT        2
+#define KEY_PITCH     3
+#define KEY_ROLL      4
+#define KEY_LOST      5
+#define KEY_REPLAY    6
+
+int16_t level_payload_centidegrees(float degrees)
+{
+    if (!isfinite(degrees)) {
+        return LEVEL_PAYLOAD_INVALID;
+    }
+    float scaled = roundf(degrees * 100.0f);
+    if (scaled > INT16_MAX) {
+        return INT16_MAX;
+    }
+    if (scaled < -INT16_MAX) {
+        return -INT16_MAX;
+    }
+    return (int16_t)scaled;
+}
+
+void level_payload_encode_cbor(cbor_writer_t *w, const char *client_id, const int64_t *ts_us,
+                               const float *pitch, const float *roll, size_t count, uint32_t lost,
+                               int64_t epoch_offset_us, bool replay)
+{
+    cbor_tag(w, CBOR_TAG_SELF_DESCRIBE);
+    cbor_map(w, 5 + (lost > 0) + replay);
+    cbor_uint(w, KEY_CLIENT_ID);
+    cbor_text(w, client_id);
+
+    int64_t prev_ms = (ts_us[0] + epoch_offset_us) / 1000;
+    cbor_uint(w, KEY_T0);
+    cbor_int(w, prev_ms);
+    cbor_uint(w, KEY_DT);
+    cbor_array(w, count);
+    for (size_t i = 0; i < count; i++) {
+        int64_t ms = (ts_us[i] + epoch_offset_us) / 1000;
+        cbor_int(w, ms - prev_ms);
+        prev_ms = ms;
+    }
+
+    cbor_uint(w, KEY_PITCH);
+    cbor_int16_array_begin(w, count);
+    for (size_t i = 0; i < count; i++) {
+        cbor_int16_put(w, level_payload_centidegrees(pitch[i]));
+    }
+    cbor_uint(w, KEY_ROLL);
+    cbor_int16_array_begin(w, count);
+    for (size_t i = 0; i < count; i++) {
+        cbor_int16_put(w, level_payload_centidegrees(roll[i]));
+    }
+
+    if (lost > 0) {
+        cbor_uint(w, KEY_LOST);
+        cbor_uint(w, lost);
+    }
+    if (replay) {
+        cbor_uint(w, KEY_REPLAY);
+        cbor_bool(w, true);
+    }
+}
@@ -0,0 +1,57 @@
+/**
+ * @file level_payload.h
+ * @brief Binary (CBOR) encoding of level sample batches
+ *
+ * Layout of one batch (see documentation/mqtt_level_logging.md):
+ *
+ *   55799({0: client_id, 1: t0_ms, 2: [dt_ms...], 3: 65(h'pitch int16 BE'),
+ *          4: 65(h'roll int16 BE'), ?5: lost, ?6: true if replayed})
+ *
+ * Angles are centi-degrees, clamped to +-327.67; NaN/Inf become
+ * LEVEL_PAYLOAD_INVALID. tools/level_decode.py is the reference decoder.
+ *
+ * No ESP-IDF dependencies.
+ */
+
+#ifndef LEVEL_PAYLOAD_H
+#define LEVEL_PAYLOAD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "cbor_writer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Centi-degree value of a NaN/Inf angle
+#define LEVEL_PAYLOAD_INVALID INT16_MIN
+
+/**
+ * @brief Angle in centi-degrees, rounded and clamped to +-INT16_MAX
+ */
+int16_t level_payload_centidegrees(float degrees);
+
+/**
+ * @brief Encode one batch of level samples
+ *
+ * @param w Writer (check cbor_writer_finish() for overflow)
+ * @param client_id Device client ID
+ * @param ts_us Sample times (esp_timer microseconds), count entries
+ * @param pitch Pitch in degrees, count entries
+ * @param roll Roll in degrees, count entries
+ * @param count Number of samples (at least 1)
+ * @param lost Samples dropped before this batch; omitted when 0
+ * @param epoch_offset_us Added to ts_us to get Unix time
+ * @param replay Batch comes from the offline queue
+ */
+void level_payload_encode_cbor(cbor_writer_t *w, const char *client_id, const int64_t *ts_us,
+                               const float *pitch, const float *roll, size_t count, uint32_t lost,
+                               int64_t epoch_offset_us, bool replay);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LEVEL_PAYLOAD_H
@@ -36,7 +36,7 @@ DC (Data / Command)					GPIO_2
 Reset								GPIO_4
 Backlight							None
 
-Touch SPI Pin Definitions components\lvgl_esp32_drivers\lvgl_touch\xpt2046.h
+Touch SPI Pin Definitions (VSPI host, sdkconfig)
 Component config → LVGL Touch controller → Touchpanel (XPT2046) Pin Assignments
 MISO (Master In Slave Out)			GPIO_39(SENSOR_VN input only)
 MOSI (Master Out Slave In)			GPIO_32
@@ -100,8 +100,13 @@ Flash button	IO0			25		GPIO0, ADC2_CH1, TOUCH1, RTC_GPIO11, CLK_OUT1,EMAC_TX_CLK
 #include "esp_log.h"
 #include "esp_err.h"
 #include "esp_timer.h"
+#include "esp_cpu.h"
 #include "esp_wifi.h"
 #include "esp_mac.h"
+#include "esp_random.h"
+#include "esp_pm.h"
+#include "esp_sleep.h"
+#include "esp_heap_caps.h"
 #include "nvs_flash.h"
 #include "esp_sntp.h"
 #include "mqtt_client.h"
@@ -112,6 +117,7 @@ Flash button	IO0			25		GPIO0, ADC2_CH1, TOUCH1, RTC_GPIO11, CLK_OUT1,EMAC_TX_CLK
 
 #include "driver/gpio.h"
 #include "driver/i2c.h"
+#include "driver/uart.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_freertos_hooks.h"
@@ -127,8 +133,28 @@ Flash button	IO0			25		GPIO0, ADC2_CH1, TOUCH1, RTC_GPIO11, CLK_OUT1,EMAC_TX_CLK
 // Littlevgl header files
 #include "lvgl/lvgl.h"			// LVGL header file
 #include "lvgl_helpers.h"		// Helper - hardware driver related
+#include "disp_spi.h"			// Display SPI queue (flush completion, stats)
+#if CONFIG_LVGL_DISP_FLUSH_WORKER
+#include "disp_pipeline.h"		// Display buffer ring flushed by a worker task
+#endif
+#if LV_USE_GPU_ESP32_BLEND
+#include "lvgl/src/lv_gpu/lv_gpu_esp32_blend.h"	// ESP32 blend kernels (A/B in the benchmark)
+#endif
+#if CONFIG_LVGL_CODE_PLACEMENT_PROFILE
+#include "lvgl_profile.h"		// Cycles per LVGL function for the IRAM placement
+#endif
 #include "clock_component.h"		// Modular clock component
+#include "digit_sprite.h"		// Pre-rendered digits for the Level readouts
 #include "serial_menu.h"		// Serial settings menu
+#include "sensor_fusion.h"		// Gyro+accel attitude fusion
+#include "sensor_snapshot.h"		// Lock-free fused sensor state
+#include "sensor_history.h"		// Full-rate sample history for consumers
+#include "json_writer.h"			// Allocation-free JSON for MQTT payloads
+#include "cbor_writer.h"			// Compact binary level payloads
+#include "level_payload.h"			// CBOR layout of level batches
+#include "offline_queue.h"			// Store-and-forward while MQTT is down
+#include "mqtt_failover.h"			// Primary/secondary broker selection
+#include "command_ledger.h"			// Executed command IDs (duplicate detection)
 #include "wifi_credentials.h"		// WiFi credentials (local only, not in git)
 #include "mqtt_config.h"			// MQTT broker configuration (local only, not in git)
 
@@ -185,6 +211,47 @@ static char mqtt_client_id[32] = {0};  // Auto-generated from MAC address
 static TickType_t last_command_poll = 0;
 #define COMMAND_POLL_INTERVAL_MS 10000  // Poll for commands every 10 seconds
 
+// MQTT topics, built once in mqtt_init()
+#define MQTT_TOPIC_MAX 64
+static char mqtt_topic_device[MQTT_TOPIC_MAX];       // {base}/device
+static char mqtt_topic_level[MQTT_TOPIC_MAX];        // {base}/device/level
+static char mqtt_topic_timestamp[MQTT_TOPIC_MAX];    // {base}/device/timestamp
+static char mqtt_topic_command[MQTT_TOPIC_MAX];      // {base}/device/command
+static char mqtt_topic_command_ack[MQTT_TOPIC_MAX];  // {base}/device/command_ack
+static char mqtt_topic_queue[MQTT_TOPIC_MAX];        // {base}/device/queue
+static char mqtt_topic_health[MQTT_TOPIC_MAX];       // {base}/device/health
+
+// Last QoS 1 deliveries confirmed by the broker (MQTT_EVENT_PUBLISHED), newest at
+// mqtt_acked_count - 1. Lets a task check its own msg_id without a callback.
+#define MQTT_ACK_HISTORY 16
+static volatile int mqtt_acked_ids[MQTT_ACK_HISTORY];
+static volatile uint32_t mqtt_acked_count = 0;
+
+// Level telemetry batching (lindi_cfg: lvl_rate, lvl_batch, lvl_flush_ms, lvl_format)
+#define LEVEL_FORMAT_ARRAY        0     // {"samples":[{"timestamp_ms","pitch","roll"},...]}
+#define LEVEL_FORMAT_COLUMNAR     1     // {"t0","dt":[...],"pitch":[...],"roll":[...]}
+#define LEVEL_FORMAT_CBOR         2     // CBOR map, int16 centi-degree columns (see mqtt_level_logging.md)
+#define LEVEL_FORMAT_COUNT        3
+#define LEVEL_RATE_DEFAULT        50    // Samples per second taken from the sensor history
+#define LEVEL_BATCH_DEFAULT       50    // Samples per MQTT message
+#define LEVEL_FLUSH_MS_DEFAULT    1000  // Publish a partial batch after this long
+#define LEVEL_BATCH_MAX           200   // Upper limit for lvl_batch
+#define LEVEL_POLL_MS             100   // How often the history is drained
+#define LEVEL_PAYLOAD_MAX         4096  // Larger batches are split over several messages
+#define LEVEL_REPLAY_PER_SEC      5     // Offline queue replay pace (records/s, one in flight)
+#define LEVEL_REPLAY_ACK_TIMEOUT_MS 10000 // Resend a replayed record if the broker does not confirm it
+#define LEVEL_LIVE_ACK_TIMEOUT_MS 5000  // Queue a live batch the broker has not confirmed by then
+#define LEVEL_UNACKED_MAX         16    // Live batches awaiting confirmation...
+#define LEVEL_UNACKED_BYTES       6144  // ...and their offline queue records (~10 batches of 50)
+#define LEVEL_QUEUE_STATUS_MS     60000 // Offline queue status publish interval
+static uint16_t level_rate_hz = LEVEL_RATE_DEFAULT;
+static uint16_t level_batch_size = LEVEL_BATCH_DEFAULT;
+static uint16_t level_flush_ms = LEVEL_FLUSH_MS_DEFAULT;
+static uint8_t level_format = LEVEL_FORMAT_COLUMNAR;
+static bool level_queue_enabled = false;    // offline_q partition available
+// Names used in the calling-home message and by the set_level_format command
+static const char *const level_format_names[LEVEL_FORMAT_COUNT] = {"array", "columnar", "cbor"};
+
 // Language configuration
 typedef enum {
     LANG_EN = 0,
@@ -226,11 +293,48 @@ static const char *STR_NO[] = {"No", "Nee"};
 
 // MPU6050 Configuration
 #define MPU6050_ADDR         0x68      // MPU6050 I2C address (AD0=GND)
+#define MPU6050_CONFIG       0x1A      // DLPF configuration register
 #define MPU6050_PWR_MGMT_1   0x6B      // Power management register
 #define MPU6050_WHO_AM_I     0x75      // Device ID register
 #define MPU6050_ACCEL_XOUT_H 0x3B      // Accelerometer X-axis high byte
 #define MPU6050_GYRO_XOUT_H  0x43      // Gyroscope X-axis high byte
 #define MPU6050_TEMP_OUT_H   0x41      // Temperature high byte
+#define MPU6050_DLPF_44HZ    0x03      // DLPF_CFG=3: 44Hz accel / 42Hz gyro bandwidth
+#define MPU6050_SMPLRT_DIV   0x19      // Sample rate divider (rate = 1kHz / (1 + div) with DLPF on)
+#define MPU6050_FIFO_EN      0x23      // FIFO enable register
+#define MPU6050_INT_PIN_CFG  0x37      // INT pin configuration
+#define MPU6050_INT_ENABLE   0x38      // Interrupt enable register
+#define MPU6050_INT_STATUS   0x3A      // Interrupt status (cleared on read)
+#define MPU6050_USER_CTRL    0x6A      // User control (FIFO enable/reset)
+#define MPU6050_FIFO_COUNTH  0x72      // FIFO byte count high byte
+#define MPU6050_FIFO_R_W     0x74      // FIFO data port
+
+// FIFO and interrupt register values
+#define MPU6050_FIFO_EN_ALL       0xF8  // TEMP + XG + YG + ZG + ACCEL (same 14-byte layout as 0x3B-0x48)
+#define MPU6050_USER_FIFO_EN      0x40  // USER_CTRL.FIFO_EN
+#define MPU6050_USER_FIFO_RESET   0x04  // USER_CTRL.FIFO_RESET
+#define MPU6050_INT_DATA_RDY      0x01  // INT_ENABLE.DATA_RDY_EN
+#define MPU6050_INT_FIFO_OFLOW    0x10  // INT_ENABLE/INT_STATUS.FIFO_OFLOW
+#define MPU6050_INT_PULSE_HIGH    0x00  // Active high, push-pull, 50us pulse
+#define MPU6050_FIFO_SIZE         1024  // FIFO size in bytes
+#define MPU6050_FRAME_SIZE        14    // Bytes per FIFO frame
+
+// MPU6050 INT pin (push-pull output from sensor so no pull-up needed)
+// Not wired by default: the free input-only header pins are taken (IO35 is the IR receiver,
+// IO34 the light sensor, IO36/IO39 the touch controller), so the FIFO is drained on a timer.
+// Set to a free GPIO when INT is wired to get data-ready wake-ups
+#define MPU6050_INT_PIN           GPIO_NUM_NC
+
+// Sensor fusion configuration
+#define MPU6050_SAMPLE_RATE_DEFAULT  200   // Default FIFO sample rate (Hz), stored as "mpu_rate"
+#define MPU6050_SAMPLE_RATE_MIN      50    // Slowest supported rate (Hz)
+#define MPU6050_SAMPLE_RATE_MAX      1000  // Fastest rate with DLPF enabled (Hz)
+#define MPU6050_DRAIN_PERIOD_MS      10    // FIFO drained in one burst every ~10ms
+#define MPU6050_DRAIN_SLEEP_MS       100   // ...and every ~100ms while the display sleeps
+#define MPU6050_DRAIN_MAX_FRAMES     32    // Largest single FIFO burst (frames)
+#define MPU6050_BIAS_PERIOD_MS       10    // Polling period while estimating gyro bias
+#define GYRO_BIAS_SAMPLES            100   // Startup samples averaged for gyro bias (1 second)
+#define FUSION_BENCH_FRAMES          256   // Recent history samples replayed by the fusion benchmark
 
 // SD Card Configuration (VSPI SPI3_HOST)
 #define SD_CS_PIN            5         // GPIO for SD card CS
@@ -245,20 +349,26 @@ static clock_handle_t main_clock = NULL;
 // MPU6050 sensor data
 #define USE_FAKE_SENSOR_DATA 0  // Set to 1 for fake data, 0 for real MPU6050
 
-static float current_pitch = 0.0f;
-static float current_roll = 0.0f;
 static float pitch_offset = 0.0f;  // Calibration offset for pitch
 static float roll_offset = 0.0f;   // Calibration offset for roll
-static SemaphoreHandle_t mpu_mutex = NULL;
+static uint16_t mpu_sample_rate_hz = MPU6050_SAMPLE_RATE_DEFAULT;  // FIFO sample rate (from NVS)
 
 // SD card global
 static sdmmc_card_t *sd_card = NULL;
 
+// Start / Level / Info tabs
+static lv_obj_t *main_tabview = NULL;
+
 // Level menu UI objects
 static lv_obj_t *pitch_bar = NULL;
 static lv_obj_t *roll_bar = NULL;
 static lv_obj_t *pitch_label = NULL;
 static lv_obj_t *roll_label = NULL;
+// Values of the readouts drawn from pre-rendered digits (NULL: the labels
+// above show name and value, without memory for the atlas)
+static digit_atlas_t level_atlas = NULL;
+static lv_obj_t *pitch_value = NULL;
+static lv_obj_t *roll_value = NULL;
 
 // Info tab UI label objects (for dynamic language updates)
 static lv_obj_t *tz_label = NULL;
@@ -274,6 +384,7 @@ static lv_obj_t *lang_label = NULL;
 // Previous values for change detection (avoid unnecessary redraws)
 static int16_t prev_pitch_mapped = 0;
 static int16_t prev_roll_mapped = 0;
+static lv_coord_t level_readout_shift = 0;  // Keeps name and value centred under the bar
 
 //LV_IMG_DECLARE(mouse_cursor_icon);			/*Declare the image file.*/
 
@@ -282,12 +393,10 @@ static int16_t prev_roll_mapped = 0;
  *      DEFINES
  *********************/
 #define TAG "Lindi"
-#define LV_TICK_PERIOD_MS 10
 
 /**********************
  *  STATIC PROTOTYPES
  **********************/
-static void lv_tick_task(void *arg);
 void guiTask(void *pvParameter);				// GUI任务
 static void perf_monitor_toggle_cb(lv_obj_t *sw, lv_event_t e);
 static void clock_update_task(lv_task_t *task);
@@ -298,6 +407,7 @@ static void dark_theme_toggle_cb(lv_obj_t *sw, lv_event_t e);
 static void accent_color_button_cb(lv_obj_t *btn, lv_event_t e);
 static void color_picker_event_cb(lv_obj_t *msgbox, lv_event_t e);
 static void apply_accent_color(void);
+static void refresh_theme_caches(void);
 static void sensor_inversion_toggle_cb(lv_obj_t *sw, lv_event_t e);
 static void language_toggle_cb(lv_obj_t *sw, lv_event_t e);
 static void calibrate_confirm_cb(lv_obj_t *btn, lv_event_t e);
@@ -308,6 +418,8 @@ static void reset_calibration_cb(lv_obj_t *btn, lv_event_t e);
 static esp_err_t i2c_master_init(void);
 static esp_err_t mpu6050_init(void);
 static void mpu6050_read_task(void *pvParameters);
+void load_display_power_settings(void);
+void gui_display_wake(void);
 
 // WiFi event handler
 static void wifi_event_handler(void* arg, esp_event_base_t event_base,
@@ -327,12 +439,14 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
         }
         wifi_connected = false;
         strcpy(wifi_ip_addr, "Not connected");
+        mqtt_failover_set_link(false);
     } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
         ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
         snprintf(wifi_ip_addr, sizeof(wifi_ip_addr), IPSTR, IP2STR(&event->ip_info.ip));
         ESP_LOGI(TAG, "Got IP: %s", wifi_ip_addr);
         s_retry_num = 0;
         wifi_connected = true;
+        mqtt_failover_set_link(true);
         xEventGroupSetBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
     }
 }
@@ -582,6 +696,53 @@ void reset_calibration_offsets(void)
     ESP_LOGI(TAG, "Calibration offsets reset to zero");
 }
 
+// Load level telemetry batching settings from NVS (also called by the serial menu)
+void load_level_telemetry_settings(void)
+{
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs_handle);
+    if (err == ESP_OK) {
+        uint16_t value = 0;
+        uint8_t format = 0;
+        if (nvs_get_u16(nvs_handle, "lvl_rate", &value) == ESP_OK && value >= 1 && value <= MPU6050_SAMPLE_RATE_MAX) {
+            level_rate_hz = value;
+        }
+        if (nvs_get_u16(nvs_handle, "lvl_batch", &value) == ESP_OK && value >= 1 && value <= LEVEL_BATCH_MAX) {
+            level_batch_size = value;
+        }
+        if (nvs_get_u16(nvs_handle, "lvl_flush_ms", &value) == ESP_OK && value >= LEVEL_POLL_MS) {
+            level_flush_ms = value;
+        }
+        if (nvs_get_u8(nvs_handle, "lvl_format", &format) == ESP_OK && format < LEVEL_FORMAT_COUNT) {
+            level_format = format;
+        }
+        nvs_close(nvs_handle);
+    }
+    ESP_LOGI(TAG, "Level telemetry: %u Hz, %u samples/msg, flush %u ms, %s",
+             level_rate_hz, level_batch_size, level_flush_ms,
+             level_format_names[level_format]);
+}
+
+// Load MPU6050 FIFO sample rate from NVS (applied when the sensor is initialized)
+void load_mpu_sample_rate_setting(void)
+{
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs_handle);
+    if (err == ESP_OK) {
+        uint16_t rate = 0;
+        err = nvs_get_u16(nvs_handle, "mpu_rate", &rate);
+        if (err == ESP_OK) {
+            if (rate < MPU6050_SAMPLE_RATE_MIN || rate > MPU6050_SAMPLE_RATE_MAX) {
+                ESP_LOGW(TAG, "Ignoring invalid MPU6050 sample rate %u Hz", rate);
+            } else {
+                mpu_sample_rate_hz = rate;
+            }
+        }
+        nvs_close(nvs_handle);
+    }
+    ESP_LOGI(TAG, "MPU6050 sample rate: %u Hz", mpu_sample_rate_hz);
+}
+
 // Initialize SD card on VSPI bus
 static esp_err_t init_sd_card(void)
 {
@@ -763,7 +924,49 @@ static esp_err_t mpu6050_init(void)
         return err;
     }
     
-    ESP_LOGI(TAG, "MPU6050 initialized successfully");
+    // Low-pass filter the sensor before sampling at the fusion rate (anti-aliasing)
+    err = i2c_master_write_to_device(I2C_MASTER_NUM, MPU6050_ADDR,
+                                     (uint8_t[]){MPU6050_CONFIG, MPU6050_DLPF_44HZ}, 2,
+                                     1000 / portTICK_PERIOD_MS);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to configure MPU6050 DLPF: %s", esp_err_to_name(err));
+    }
+    
+    // Sample rate divider: with the DLPF enabled the internal rate is 1kHz
+    uint8_t smplrt_div = (uint8_t)(1000 / mpu_sample_rate_hz - 1);
+    mpu_sample_rate_hz = 1000 / (1 + smplrt_div);  // Actual rate after integer division
+    err = i2c_master_write_to_device(I2C_MASTER_NUM, MPU6050_ADDR,
+                                     (uint8_t[]){MPU6050_SMPLRT_DIV, smplrt_div}, 2,
+                                     1000 / portTICK_PERIOD_MS);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to set MPU6050 sample rate: %s", esp_err_to_name(err));
+        return err;
+    }
+    
+    // INT pin: active high push-pull 50us pulse on every new sample (data ready)
+    err = i2c_master_write_to_device(I2C_MASTER_NUM, MPU6050_ADDR,
+                                     (uint8_t[]){MPU6050_INT_PIN_CFG, MPU6050_INT_PULSE_HIGH}, 2,
+                                     1000 / portTICK_PERIOD_MS);
+    if (err == ESP_OK) {
+        err = i2c_master_write_to_device(I2C_MASTER_NUM, MPU6050_ADDR,
+                                         (uint8_t[]){MPU6050_INT_ENABLE, MPU6050_INT_DATA_RDY | MPU6050_INT_FIFO_OFLOW}, 2,
+                                         1000 / portTICK_PERIOD_MS);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to configure MPU6050 interrupt: %s", esp_err_to_name(err));
+        return err;
+    }
+    
+    // FIFO stays disabled until the read task starts draining it
+    err = i2c_master_write_to_device(I2C_MASTER_NUM, MPU6050_ADDR,
+                                     (uint8_t[]){MPU6050_FIFO_EN, 0x00}, 2,
+                                     1000 / portTICK_PERIOD_MS);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to configure MPU6050 FIFO: %s", esp_err_to_name(err));
+        return err;
+    }
+    
+    ESP_LOGI(TAG, "MPU6050 initialized successfully (%u Hz, div=%u)", mpu_sample_rate_hz, smplrt_div);
     vTaskDelay(100 / portTICK_PERIOD_MS);  // Give sensor time to stabilize
     
     return ESP_OK;
@@ -787,12 +990,22 @@ static void fake_sensor_task(void *pvParameters)
         float fake_pitch = 12.0f * sinf(phase);           // ±12° pitch
         float fake_roll = 10.0f * sinf(phase * 1.3f);     // ±10° roll, slightly different frequency
         
-        // Update global values with mutex
-        if (xSemaphoreTake(mpu_mutex, portMAX_DELAY)) {
-            current_pitch = fake_pitch;
-            current_roll = fake_roll;
-            xSemaphoreGive(mpu_mutex);
-        }
+        sensor_snapshot_t snap = {
+            .pitch = fake_pitch,
+            .roll = fake_roll,
+            .pitch_rate = 12.0f * cosf(phase) * phase_increment * 30.0f,
+            .roll_rate = 13.0f * cosf(phase * 1.3f) * phase_increment * 30.0f,
+            .temperature = 25.0f,
+            .timestamp_us = esp_timer_get_time(),
+        };
+        sensor_snapshot_publish(&snap);
+        
+        sensor_history_sample_t entry = {
+            .timestamp_us = snap.timestamp_us,
+            .pitch = fake_pitch,
+            .roll = fake_roll,
+        };
+        sensor_history_append(sensor_history_default(), &entry);
         
         phase += phase_increment;
         if (phase > 2.0f * M_PI) {
@@ -803,90 +1016,335 @@ static void fake_sensor_task(void *pvParameters)
     }
 }
 #else
-// Real MPU6050 sensor reading task
+// Read one 14-byte burst (accel + temp + gyro, registers 0x3B-0x48)
+static esp_err_t mpu6050_read_frame(uint8_t data[14])
+{
+    return i2c_master_write_read_device(I2C_MASTER_NUM, MPU6050_ADDR,
+                                        (uint8_t[]){MPU6050_ACCEL_XOUT_H}, 1,
+                                        data, 14,
+                                        100 / portTICK_PERIOD_MS);
+}
+
+// Average the gyro for a moment at startup to seed the fusion bias estimate
+static void mpu6050_estimate_gyro_bias(sensor_fusion_t *fusion)
+{
+    uint8_t data[14];
+    sensor_fusion_sample_t sample;
+    float sum_x = 0.0f, sum_y = 0.0f, sum_z = 0.0f;
+    int n = 0;
+
+    for (int i = 0; i < GYRO_BIAS_SAMPLES; i++) {
+        if (mpu6050_read_frame(data) == ESP_OK) {
+            sensor_fusion_sample_from_raw(data, &sample);
+            sum_x += sample.gx;
+            sum_y += sample.gy;
+            sum_z += sample.gz;
+            n++;
+        }
+        vTaskDelay(pdMS_TO_TICKS(MPU6050_BIAS_PERIOD_MS));
+    }
+
+    if (n > 0) {
+        sensor_fusion_set_gyro_bias(fusion, sum_x / n, sum_y / n, sum_z / n);
+        ESP_LOGI(TAG, "Gyro bias: X=%.2f Y=%.2f Z=%.2f °/s (%d samples)",
+                 sum_x / n, sum_y / n, sum_z / n, n);
+    }
+}
+
+// Data-ready pulses counted in the ISR; the read task is only woken once a
+// full drain batch is waiting in the FIFO
+static TaskHandle_t mpu_task_handle = NULL;
+static volatile uint32_t mpu_int_pending = 0;
+static volatile uint32_t mpu_int_batch = 1;
+static volatile uint16_t mpu_drain_period_ms = MPU6050_DRAIN_PERIOD_MS;
+
+static void IRAM_ATTR mpu6050_int_isr(void *arg)
+{
+    (void)arg;
+    BaseType_t woken = pdFALSE;
+    if (++mpu_int_pending >= mpu_int_batch) {
+        mpu_int_pending = 0;
+        vTaskNotifyGiveFromISR(mpu_task_handle, &woken);
+    }
+    if (woken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+// Time between FIFO bursts. Nothing shows the level while the display sleeps,
+// so longer bursts then leave the CPU idle long enough to light sleep. Capped
+// so a burst still fits MPU6050_DRAIN_MAX_FRAMES at the sample rate.
+static void mpu6050_set_drain_period(uint16_t period_ms)
+{
+    uint16_t max_ms = MPU6050_DRAIN_MAX_FRAMES * 1000 / mpu_sample_rate_hz;
+    if (period_ms > max_ms) {
+        period_ms = max_ms;
+    }
+    uint32_t batch = mpu_sample_rate_hz * period_ms / 1000;
+    mpu_int_batch = batch < 1 ? 1 : batch;
+    mpu_drain_period_ms = period_ms;
+}
+
+// Configure the INT GPIO; returns false when no pin is wired
+static bool mpu6050_int_init(void)
+{
+    gpio_num_t pin = MPU6050_INT_PIN;   // Not a constant: no shift warning when it is GPIO_NUM_NC
+    if (pin == GPIO_NUM_NC) {
+        return false;
+    }
+
+    gpio_config_t io_conf = {
+        .pin_bit_mask = 1ULL << pin,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_POSEDGE,
+    };
+    esp_err_t err = gpio_config(&io_conf);
+    if (err == ESP_OK) {
+        err = gpio_install_isr_service(0);
+        if (err == ESP_ERR_INVALID_STATE) {
+            err = ESP_OK;  // Already installed by another driver
+        }
+    }
+    if (err == ESP_OK) {
+        err = gpio_isr_handler_add(pin, mpu6050_int_isr, NULL);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "MPU6050 INT on GPIO%d unavailable (%s), using timed FIFO drain",
+                 pin, esp_err_to_name(err));
+        return false;
+    }
+
+    ESP_LOGI(TAG, "MPU6050 INT on GPIO%d, wake every %lu samples",
+             pin, (unsigned long)mpu_int_batch);
+    return true;
+}
+
+// Reset and enable the FIFO (also used to recover from overflow)
+static esp_err_t mpu6050_fifo_reset(void)
+{
+    esp_err_t err = i2c_master_write_to_device(I2C_MASTER_NUM, MPU6050_ADDR,
+                                               (uint8_t[]){MPU6050_USER_CTRL, MPU6050_USER_FIFO_RESET}, 2,
+                                               100 / portTICK_PERIOD_MS);
+    if (err == ESP_OK) {
+        err = i2c_master_write_to_device(I2C_MASTER_NUM, MPU6050_ADDR,
+                                         (uint8_t[]){MPU6050_FIFO_EN, MPU6050_FIFO_EN_ALL}, 2,
+                                         100 / portTICK_PERIOD_MS);
+    }
+    if (err == ESP_OK) {
+        err = i2c_master_write_to_device(I2C_MASTER_NUM, MPU6050_ADDR,
+                                         (uint8_t[]){MPU6050_USER_CTRL, MPU6050_USER_FIFO_EN}, 2,
+                                         100 / portTICK_PERIOD_MS);
+    }
+    return err;
+}
+
+// Read up to max_frames complete frames from the FIFO in a single burst.
+// Returns the number of frames read, or -1 on error / overflow (FIFO reset).
+static int mpu6050_fifo_drain(uint8_t *buf, int max_frames)
+{
+    uint8_t count_raw[2];
+    esp_err_t err = i2c_master_write_read_device(I2C_MASTER_NUM, MPU6050_ADDR,
+                                                 (uint8_t[]){MPU6050_FIFO_COUNTH}, 1,
+                                                 count_raw, 2,
+                                                 100 / portTICK_PERIOD_MS);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to read MPU6050 FIFO count: %s", esp_err_to_name(err));
+        return -1;
+    }
+
+    uint16_t count = (count_raw[0] << 8) | count_raw[1];
+    if (count >= MPU6050_FIFO_SIZE - MPU6050_FRAME_SIZE) {
+        // Overflowed (or about to): frames are no longer aligned, start over
+        ESP_LOGW(TAG, "MPU6050 FIFO overflow (%u bytes), resetting", count);
+        mpu6050_fifo_reset();
+        return -1;
+    }
+
+    int frames = count / MPU6050_FRAME_SIZE;
+    if (frames > max_frames) {
+        frames = max_frames;
+    }
+    if (frames == 0) {
+        return 0;
+    }
+
+    err = i2c_master_write_read_device(I2C_MASTER_NUM, MPU6050_ADDR,
+                                       (uint8_t[]){MPU6050_FIFO_R_W}, 1,
+                                       buf, frames * MPU6050_FRAME_SIZE,
+                                       100 / portTICK_PERIOD_MS);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to read MPU6050 FIFO: %s", esp_err_to_name(err));
+        mpu6050_fifo_reset();
+        return -1;
+    }
+    return frames;
+}
+
+// Real MPU6050 sensor reading task - drains the FIFO in bursts when the INT
+// pin signals a batch of samples and fuses every sample at the sensor rate
 static void mpu6050_read_task(void *pvParameters)
 {
     (void)pvParameters;
-    uint8_t data[14];  // Read all sensor data in one transaction
+    static uint8_t fifo_buf[MPU6050_DRAIN_MAX_FRAMES * MPU6050_FRAME_SIZE];
+    sensor_history_t *history = sensor_history_default();
+    sensor_history_sample_t entry;
+    sensor_fusion_sample_t sample;
+    sensor_fusion_t fusion;
+    
+    sensor_fusion_init(&fusion, SENSOR_FUSION_ALGORITHM);
+    ESP_LOGI(TAG, "MPU6050 read task started (%s fusion, %u Hz)",
+             sensor_fusion_algorithm_name(SENSOR_FUSION_ALGORITHM), mpu_sample_rate_hz);
     
-    ESP_LOGI(TAG, "MPU6050 read task started");
+    mpu6050_estimate_gyro_bias(&fusion);
+    
+    // Wake roughly every drain period regardless of sample rate (now that it is known)
+    mpu6050_set_drain_period(mpu_drain_period_ms);
+    mpu_task_handle = xTaskGetCurrentTaskHandle();
+    bool use_int = mpu6050_int_init();
+    
+    const float dt = 1.0f / mpu_sample_rate_hz;  // Sensor clock, not task wakeup time
+    const int64_t period_us = 1000000 / mpu_sample_rate_hz;
+    
+    if (mpu6050_fifo_reset() != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to enable MPU6050 FIFO");
+    }
     
     while (1) {
-        // Read all sensor data (accel + temp + gyro) in one burst read
-        // Registers: 0x3B-0x48 (14 bytes total)
-        esp_err_t err = i2c_master_write_read_device(I2C_MASTER_NUM, MPU6050_ADDR,
-                                                     (uint8_t[]){MPU6050_ACCEL_XOUT_H}, 1,
-                                                     data, 14,
-                                                     100 / portTICK_PERIOD_MS);
+        // Without INT (or if pulses stop) the timeout drains the FIFO anyway
+        uint16_t drain_ms = mpu_drain_period_ms;
+        TickType_t wait_ticks = pdMS_TO_TICKS(use_int ? 2 * drain_ms : drain_ms);
+        ulTaskNotifyTake(pdTRUE, wait_ticks < 1 ? 1 : wait_ticks);
         
-        if (err != ESP_OK) {
-            ESP_LOGE(TAG, "Failed to read MPU6050: %s", esp_err_to_name(err));
-            vTaskDelay(100 / portTICK_PERIOD_MS);
+        int frames = mpu6050_fifo_drain(fifo_buf, MPU6050_DRAIN_MAX_FRAMES);
+        if (frames < 0) {
+            // Restart fusion from the accelerometer after a gap
+            fusion.initialized = false;
+            vTaskDelay(pdMS_TO_TICKS(MPU6050_DRAIN_PERIOD_MS));
+            continue;
+        }
+        if (frames == 0) {
             continue;
         }
         
-        // Parse raw data from the 14-byte buffer
-        // Accel: bytes 0-5
-        int16_t accel_x_raw = (int16_t)((data[0] << 8) | data[1]);
-        int16_t accel_y_raw = (int16_t)((data[2] << 8) | data[3]);
-        int16_t accel_z_raw = (int16_t)((data[4] << 8) | data[5]);
-        
-        // Temp: bytes 6-7
-        int16_t temp_raw = (int16_t)((data[6] << 8) | data[7]);
-        
-        // Gyro: bytes 8-13
-        int16_t gyro_x_raw = (int16_t)((data[8] << 8) | data[9]);
-        int16_t gyro_y_raw = (int16_t)((data[10] << 8) | data[11]);
-        int16_t gyro_z_raw = (int16_t)((data[12] << 8) | data[13]);
-        
-        // Convert to physical units
-        float ax = accel_x_raw / 16384.0f;
-        float ay = accel_y_raw / 16384.0f;
-        float az = accel_z_raw / 16384.0f;
-        
-        // Unused variables (kept for potential future use)
-        (void)temp_raw;
-        (void)gyro_x_raw;
-        (void)gyro_y_raw;
-        (void)gyro_z_raw;
-        
-        // Output raw data stream (disabled to reduce serial spam)
-        // printf("MPU6050 RAW | AccXYZ: %6d %6d %6d | GyroXYZ: %6d %6d %6d | Temp: %6d (%.1f°C)\n",
-        //        accel_x_raw, accel_y_raw, accel_z_raw,
-        //        gyro_x_raw, gyro_y_raw, gyro_z_raw,
-        //        temp_raw, temperature);
-        
-        // Raw sensor data (no longer printed to reduce serial spam)
-        // printf("MPU6050  G  | AccXYZ: %6.2f %6.2f %6.2f | GyroXYZ: %6.1f %6.1f %6.1f\n",
-        //        ax, ay, az, gx, gy, gz);
-        
-        // Calculate angles from accelerometer (in degrees)
-        // Note: Due to physical sensor mounting orientation:
-        // - Sensor's mathematical 'pitch' axis = Physical ROLL (left/right tilt)
-        // - Sensor's mathematical 'roll' axis = Physical PITCH (forward/backward tilt)
-        float sensor_pitch_axis = -atan2(ay, sqrt(ax * ax + az * az)) * 180.0f / M_PI;
-        float sensor_roll_axis = -atan2(ax, az) * 180.0f / M_PI;
-        
-        // Map to physical orientation (sensor mounted 90° rotated)
-        float physical_pitch = sensor_roll_axis;   // Forward/backward tilt
-        float physical_roll = sensor_pitch_axis;   // Left/right tilt
-        
-        // Apply calibration offsets (subtract to zero out)
-        physical_pitch -= pitch_offset;
-        physical_roll -= roll_offset;
+        // Newest frame was sampled just now, older ones one sample period apart
+        int64_t now_us = esp_timer_get_time();
         
-        // Update global values with mutex
-        if (xSemaphoreTake(mpu_mutex, portMAX_DELAY)) {
-            current_pitch = physical_pitch;
-            current_roll = physical_roll;
-            xSemaphoreGive(mpu_mutex);
+        // Convert raw accel/gyro to g and °/s, fuse every sample and keep it in the history
+        for (int i = 0; i < frames; i++) {
+            const uint8_t *raw = &fifo_buf[i * MPU6050_FRAME_SIZE];
+            sensor_fusion_sample_from_raw(raw, &sample);
+            sensor_fusion_update(&fusion, &sample, dt);
+            
+            entry.timestamp_us = now_us - (frames - 1 - i) * period_us;
+            for (int axis = 0; axis < 3; axis++) {
+                entry.accel[axis] = (int16_t)((raw[axis * 2] << 8) | raw[axis * 2 + 1]);
+                entry.gyro[axis] = (int16_t)((raw[8 + axis * 2] << 8) | raw[8 + axis * 2 + 1]);
+            }
+            
+            // Note: Due to physical sensor mounting orientation:
+            // - Sensor's mathematical 'pitch' axis = Physical ROLL (left/right tilt)
+            // - Sensor's mathematical 'roll' axis = Physical PITCH (forward/backward tilt)
+            // Calibration offsets are subtracted to zero out
+            entry.pitch = fusion.roll - pitch_offset;    // Forward/backward tilt
+            entry.roll = fusion.pitch - roll_offset;     // Left/right tilt
+            sensor_history_append(history, &entry);
         }
         
-        vTaskDelay(100 / portTICK_PERIOD_MS);  // 100ms = 10Hz polling
+        // Die temperature from the newest frame (datasheet: raw / 340 + 36.53)
+        const uint8_t *last = &fifo_buf[(frames - 1) * MPU6050_FRAME_SIZE];
+        int16_t temp_raw = (int16_t)((last[6] << 8) | last[7]);
+        
+        sensor_snapshot_t snap = {
+            .pitch = entry.pitch,
+            .roll = entry.roll,
+            .pitch_rate = fusion.roll_rate,
+            .roll_rate = fusion.pitch_rate,
+            .temperature = temp_raw / 340.0f + 36.53f,
+            .timestamp_us = now_us,
+        };
+        sensor_snapshot_publish(&snap);
     }
 }
 #endif
 
+static uint32_t fusion_bench_cycles(void)
+{
+    return esp_cpu_get_cycle_count();
+}
+
+// Replay the most recent sensor frames through each fusion algorithm and
+// report the cost per update (called from the serial menu)
+void sensor_fusion_benchmark(void)
+{
+    sensor_snapshot_t snap;
+    if (!sensor_snapshot_read(&snap)) {
+        printf("Sensor not running - nothing to replay\n");
+        return;
+    }
+
+    sensor_fusion_sample_t *frames = malloc(sizeof(sensor_fusion_sample_t) * FUSION_BENCH_FRAMES);
+    if (!frames) {
+        printf("Not enough memory for benchmark\n");
+        return;
+    }
+
+    // Take the newest history samples (with a private cursor) and convert to physical units
+    sensor_history_t *history = sensor_history_default();
+    sensor_history_reader_t reader;
+    sensor_history_reader_init(history, &reader, true);
+    uint32_t available = sensor_history_available(history, &reader);
+    if (available > FUSION_BENCH_FRAMES) {
+        reader.next += available - FUSION_BENCH_FRAMES;
+    }
+
+    size_t count = 0;
+    sensor_history_sample_t chunk[16];
+    while (count < FUSION_BENCH_FRAMES) {
+        size_t want = FUSION_BENCH_FRAMES - count;
+        if (want > sizeof(chunk) / sizeof(chunk[0])) {
+            want = sizeof(chunk) / sizeof(chunk[0]);
+        }
+        size_t n = sensor_history_read(history, &reader, chunk, want, NULL);
+        if (n == 0) {
+            break;
+        }
+        for (size_t i = 0; i < n; i++, count++) {
+            frames[count].ax = chunk[i].accel[0] / SENSOR_FUSION_ACCEL_LSB_PER_G;
+            frames[count].ay = chunk[i].accel[1] / SENSOR_FUSION_ACCEL_LSB_PER_G;
+            frames[count].az = chunk[i].accel[2] / SENSOR_FUSION_ACCEL_LSB_PER_G;
+            frames[count].gx = chunk[i].gyro[0] / SENSOR_FUSION_GYRO_LSB_PER_DPS;
+            frames[count].gy = chunk[i].gyro[1] / SENSOR_FUSION_GYRO_LSB_PER_DPS;
+            frames[count].gz = chunk[i].gyro[2] / SENSOR_FUSION_GYRO_LSB_PER_DPS;
+        }
+    }
+
+    if (count == 0) {
+        printf("No recorded frames yet\n");
+        free(frames);
+        return;
+    }
+
+    const float dt = 1.0f / mpu_sample_rate_hz;
+    const sensor_fusion_algorithm_t algorithms[] = {SENSOR_FUSION_COMPLEMENTARY, SENSOR_FUSION_MAHONY};
+
+    printf("Replaying %u frames (active: %s)\n", (unsigned)count,
+           sensor_fusion_algorithm_name(SENSOR_FUSION_ALGORITHM));
+    for (size_t a = 0; a < sizeof(algorithms) / sizeof(algorithms[0]); a++) {
+        sensor_fusion_t final_state;
+        uint32_t cycles = sensor_fusion_replay(algorithms[a], frames, count, dt,
+                                               fusion_bench_cycles, &final_state);
+        uint32_t per_update = cycles / count;
+        printf("  %-14s %6lu cycles/update (%.1f us @ %d MHz)  final pitch=%+.2f roll=%+.2f\n",
+               sensor_fusion_algorithm_name(algorithms[a]), (unsigned long)per_update,
+               (float)per_update / CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ, CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+               final_state.pitch, final_state.roll);
+    }
+
+    free(frames);
+}
+
 // Initialize WiFi in station mode
 void wifi_init_sta(void)
 {
@@ -921,6 +1379,9 @@ void wifi_init_sta(void)
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA) );
     ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config) );
     ESP_ERROR_CHECK(esp_wifi_start() );
+    // Modem sleep between DTIM beacons: an MQTT command (wake_display) arrives
+    // within one DTIM interval of the AP, also while the CPUs light sleep
+    ESP_ERROR_CHECK(esp_wifi_set_ps(WIFI_PS_MIN_MODEM));
 
     ESP_LOGI(TAG, "WiFi init finished, waiting for connection...");
 
@@ -966,42 +1427,182 @@ void wifi_init_sta(void)
 
 #define NVS_CMD_NAMESPACE "mqtt_cmds"
 #define MAX_COMMAND_ID_LEN 32
+#define COMMAND_LEDGER_MAX_AGE_S  (30 * 24 * 3600)  // Redelivery after this long executes again
+#define COMMAND_LEDGER_FLUSH_MS   2000              // Executed IDs are written to NVS in batches
+
+// Persisted ledger chunk, NVS blob "ledger_<n>" in mqtt_cmds. The newest head
+// over all chunks restores the ring position.
+typedef struct {
+    uint32_t head;
+    command_ledger_entry_t entries[COMMAND_LEDGER_CHUNK];
+} command_ledger_chunk_t;
+
+static command_ledger_t command_ledger;
+static SemaphoreHandle_t command_ledger_mutex = NULL;
+static esp_timer_handle_t command_ledger_timer = NULL;
+static volatile bool command_ledger_flush_requested = false;  // Set by the timer, served by the MQTT log task
+
+// Unix time for the ledger, 0 while the clock is not set (no age-based expiry)
+static uint32_t command_ledger_now(void)
+{
+    return time_synced ? (uint32_t)time(NULL) : 0;
+}
 
-// Check if command_id has been executed before
-static bool is_command_executed(const char *command_id)
+// Write the chunks changed since the last flush. Blocks on the mutex and
+// flash, so it never runs in the esp_timer task.
+static void command_ledger_flush(void)
 {
+    xSemaphoreTake(command_ledger_mutex, portMAX_DELAY);
+    uint32_t dirty = command_ledger_take_dirty(&command_ledger);
+    if (dirty == 0) {
+        xSemaphoreGive(command_ledger_mutex);
+        return;
+    }
+    
     nvs_handle_t nvs_handle;
-    esp_err_t err = nvs_open(NVS_CMD_NAMESPACE, NVS_READONLY, &nvs_handle);
+    esp_err_t err = nvs_open(NVS_CMD_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (err == ESP_OK) {
+        static command_ledger_chunk_t chunk;
+        for (uint32_t n = 0; n < COMMAND_LEDGER_CHUNKS && err == ESP_OK; n++) {
+            if (!(dirty & (1u << n))) {
+                continue;
+            }
+            char key[16];
+            snprintf(key, sizeof(key), "ledger_%lu", (unsigned long)n);
+            chunk.head = command_ledger.head;
+            memcpy(chunk.entries, &command_ledger.entries[n * COMMAND_LEDGER_CHUNK], sizeof(chunk.entries));
+            err = nvs_set_blob(nvs_handle, key, &chunk, sizeof(chunk));
+        }
+        if (err == ESP_OK) {
+            err = nvs_commit(nvs_handle);
+        }
+        nvs_close(nvs_handle);
+    }
     if (err != ESP_OK) {
-        return false;  // Assume not executed if can't open NVS
+        // Try again with the next executed command
+        command_ledger.dirty |= dirty;
+        ESP_LOGE(TAG, "Failed to save command ledger: %s", esp_err_to_name(err));
+    }
+    xSemaphoreGive(command_ledger_mutex);
+}
+
+// esp_timer callback: only hand the flush to mqtt_sensor_log_task
+static void command_ledger_flush_timer(void *arg)
+{
+    (void)arg;
+    command_ledger_flush_requested = true;
+}
+
+// Load the executed-command ledger, migrating the old one-key-per-command records
+static void command_ledger_load(void)
+{
+    command_ledger_init(&command_ledger, COMMAND_LEDGER_MAX_AGE_S);
+    command_ledger_mutex = xSemaphoreCreateMutex();
+    const esp_timer_create_args_t timer_args = {
+        .callback = command_ledger_flush_timer,
+        .name = "cmd_ledger",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &command_ledger_timer));
+    
+    nvs_handle_t nvs_handle;
+    if (nvs_open(NVS_CMD_NAMESPACE, NVS_READWRITE, &nvs_handle) != ESP_OK) {
+        return;  // Nothing executed yet
+    }
+    
+    static command_ledger_chunk_t chunk;
+    uint32_t head = 0;
+    for (uint32_t n = 0; n < COMMAND_LEDGER_CHUNKS; n++) {
+        char key[16];
+        size_t len = sizeof(chunk);
+        snprintf(key, sizeof(key), "ledger_%lu", (unsigned long)n);
+        if (nvs_get_blob(nvs_handle, key, &chunk, &len) != ESP_OK || len != sizeof(chunk)) {
+            continue;
+        }
+        memcpy(&command_ledger.entries[n * COMMAND_LEDGER_CHUNK], chunk.entries, sizeof(chunk.entries));
+        if (chunk.head > head) {
+            head = chunk.head;
+        }
+    }
+    command_ledger.head = head;
+    command_ledger_restore(&command_ledger);
+    
+    // Firmware before the ledger stored each command_id as its own u32 key
+    // (execution time). Fold them in and drop the keys.
+    uint32_t legacy = 0;
+    nvs_iterator_t it = NULL;
+    esp_err_t res = nvs_entry_find(NVS_DEFAULT_PART_NAME, NVS_CMD_NAMESPACE, NVS_TYPE_U32, &it);
+    while (res == ESP_OK) {
+        nvs_entry_info_t info;
+        uint32_t executed = 0;
+        nvs_entry_info(it, &info);
+        nvs_get_u32(nvs_handle, info.key, &executed);
+        command_ledger_add(&command_ledger, command_ledger_hash(info.key), executed);
+        legacy++;
+        res = nvs_entry_next(&it);
     }
+    nvs_release_iterator(it);
     
-    uint32_t timestamp = 0;
-    err = nvs_get_u32(nvs_handle, command_id, &timestamp);
+    if (legacy > 0) {
+        nvs_erase_all(nvs_handle);
+        nvs_commit(nvs_handle);
+        command_ledger.dirty = (uint32_t)((1ull << COMMAND_LEDGER_CHUNKS) - 1);  // Rewrite every chunk
+        ESP_LOGI(TAG, "Migrated %lu executed command IDs to the command ledger", (unsigned long)legacy);
+    }
     nvs_close(nvs_handle);
     
-    return (err == ESP_OK);  // True if found
+    if (legacy > 0) {
+        command_ledger_flush();
+    }
+    ESP_LOGI(TAG, "Command ledger: %lu executed command IDs remembered",
+             (unsigned long)command_ledger_count(&command_ledger));
+}
+
+// Check if command_id has been executed before (RAM only, no flash access)
+static bool is_command_executed(const char *command_id)
+{
+    if (command_ledger_mutex == NULL) {
+        return false;
+    }
+    xSemaphoreTake(command_ledger_mutex, portMAX_DELAY);
+    bool executed = command_ledger_contains(&command_ledger, command_ledger_hash(command_id), command_ledger_now());
+    xSemaphoreGive(command_ledger_mutex);
+    return executed;
 }
 
-// Mark command as executed
+// Mark command as executed; saved to NVS within COMMAND_LEDGER_FLUSH_MS (+ LEVEL_POLL_MS)
 static void mark_command_executed(const char *command_id)
 {
-    nvs_handle_t nvs_handle;
-    esp_err_t err = nvs_open(NVS_CMD_NAMESPACE, NVS_READWRITE, &nvs_handle);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to open NVS for command tracking: %s", esp_err_to_name(err));
+    if (command_ledger_mutex == NULL) {
         return;
     }
+    xSemaphoreTake(command_ledger_mutex, portMAX_DELAY);
+    command_ledger_add(&command_ledger, command_ledger_hash(command_id), command_ledger_now());
+    xSemaphoreGive(command_ledger_mutex);
     
-    uint32_t timestamp = (uint32_t)time(NULL);
-    err = nvs_set_u32(nvs_handle, command_id, timestamp);
-    if (err == ESP_OK) {
-        nvs_commit(nvs_handle);
-        ESP_LOGI(TAG, "✓ Marked command '%s' as executed", command_id);
-    } else {
-        ESP_LOGE(TAG, "Failed to save command ID: %s", esp_err_to_name(err));
+    if (!esp_timer_is_active(command_ledger_timer)) {
+        esp_timer_start_once(command_ledger_timer, COMMAND_LEDGER_FLUSH_MS * 1000);
+    }
+    ESP_LOGI(TAG, "✓ Marked command '%s' as executed", command_id);
+}
+
+// Publish {"command_id","command","status","timestamp"} to {base}/device/command_ack
+static void publish_command_ack(const char *command_id, const char *command, const char *status, int64_t timestamp)
+{
+    char ack[160];
+    json_writer_t w;
+    json_writer_init(&w, ack, sizeof(ack));
+    json_obj_begin(&w);
+    json_kv_str(&w, "command_id", command_id);
+    json_kv_str(&w, "command", command);
+    json_kv_str(&w, "status", status);
+    json_kv_int(&w, "timestamp", timestamp);
+    json_obj_end(&w);
+    
+    const char *ack_string = json_writer_finish(&w, NULL);
+    if (ack_string) {
+        esp_mqtt_client_publish(mqtt_client, mqtt_topic_command_ack, ack_string, 0, 1, 0);
+        ESP_LOGI(TAG, "✓ Published ack to %s", mqtt_topic_command_ack);
     }
-    nvs_close(nvs_handle);
 }
 
 // Execute say_time command
@@ -1016,38 +1617,54 @@ static void execute_say_time(const char *command_id)
     strftime(datetime_str, sizeof(datetime_str), "%Y-%m-%d %H:%M:%S", &timeinfo);
     
     // Build JSON response
-    cJSON *root = cJSON_CreateObject();
-    cJSON_AddNumberToObject(root, "timestamp", (double)now);
-    cJSON_AddStringToObject(root, "datetime", datetime_str);
-    cJSON_AddStringToObject(root, "timezone", "UTC");  // TODO: Add actual timezone from config
-    cJSON_AddStringToObject(root, "source", "SNTP");
+    char payload[160];
+    json_writer_t w;
+    json_writer_init(&w, payload, sizeof(payload));
+    json_obj_begin(&w);
+    json_kv_int(&w, "timestamp", (int64_t)now);
+    json_kv_str(&w, "datetime", datetime_str);
+    json_kv_str(&w, "timezone", "UTC");  // TODO: Add actual timezone from config
+    json_kv_str(&w, "source", "SNTP");
+    json_obj_end(&w);
     
-    char *json_string = cJSON_PrintUnformatted(root);
+    const char *json_string = json_writer_finish(&w, NULL);
     if (json_string) {
-        char topic[128];
-        snprintf(topic, sizeof(topic), "%s/device/timestamp", MQTT_BASE_TOPIC);
-        esp_mqtt_client_publish(mqtt_client, topic, json_string, 0, 1, 0);
-        ESP_LOGI(TAG, "✓ Published time to %s: %s", topic, json_string);
-        free(json_string);
-    }
-    cJSON_Delete(root);
-    
-    // Send acknowledgment
-    cJSON *ack = cJSON_CreateObject();
-    cJSON_AddStringToObject(ack, "command_id", command_id);
-    cJSON_AddStringToObject(ack, "command", "say_time");
-    cJSON_AddStringToObject(ack, "status", "executed");
-    cJSON_AddNumberToObject(ack, "timestamp", (double)now);
-    
-    char *ack_string = cJSON_PrintUnformatted(ack);
-    if (ack_string) {
-        char ack_topic[128];
-        snprintf(ack_topic, sizeof(ack_topic), "%s/device/command_ack", MQTT_BASE_TOPIC);
-        esp_mqtt_client_publish(mqtt_client, ack_topic, ack_string, 0, 1, 0);
-        ESP_LOGI(TAG, "✓ Published ack to %s", ack_topic);
-        free(ack_string);
+        esp_mqtt_client_publish(mqtt_client, mqtt_topic_timestamp, json_string, 0, 1, 0);
+        ESP_LOGI(TAG, "✓ Published time to %s: %s", mqtt_topic_timestamp, json_string);
+    }
+    
+    publish_command_ack(command_id, "say_time", "executed", (int64_t)now);
+}
+
+// Switch the level payload format for this session (not saved, NVS lvl_format applies after reboot)
+// Parameters: {"format": "array" | "columnar" | "cbor"}
+static void execute_set_level_format(const char *command_id, const cJSON *parameters)
+{
+    const cJSON *format_obj = parameters ? cJSON_GetObjectItem(parameters, "format") : NULL;
+    const char *status = "rejected";
+
+    if (format_obj && cJSON_IsString(format_obj)) {
+        for (uint8_t i = 0; i < LEVEL_FORMAT_COUNT; i++) {
+            if (strcmp(format_obj->valuestring, level_format_names[i]) == 0) {
+                level_format = i;
+                status = "executed";
+                ESP_LOGI(TAG, "✓ Level format set to %s", level_format_names[i]);
+                break;
+            }
+        }
     }
-    cJSON_Delete(ack);
+    if (strcmp(status, "executed") != 0) {
+        ESP_LOGW(TAG, "❌ set_level_format: missing or unknown 'format'");
+    }
+
+    publish_command_ack(command_id, "set_level_format", status, (int64_t)time(NULL));
+}
+
+// Light the display if it is dimmed or asleep
+static void execute_wake_display(const char *command_id)
+{
+    gui_display_wake();
+    publish_command_ack(command_id, "wake_display", "executed", (int64_t)time(NULL));
 }
 
 // Process incoming command
@@ -1106,6 +1723,12 @@ static void process_command(const char *payload, int payload_len)
     if (strcmp(command, "say_time") == 0) {
         execute_say_time(command_id);
         mark_command_executed(command_id);
+    } else if (strcmp(command, "set_level_format") == 0) {
+        execute_set_level_format(command_id, cJSON_GetObjectItem(json, "parameters"));
+        mark_command_executed(command_id);
+    } else if (strcmp(command, "wake_display") == 0) {
+        execute_wake_display(command_id);
+        mark_command_executed(command_id);
     } else {
         ESP_LOGW(TAG, "❌ Unknown command '%s' - not in whitelist", command);
     }
@@ -1118,33 +1741,38 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
 {
     esp_mqtt_event_handle_t event = (esp_mqtt_event_handle_t)event_data;
     
+    // Health tracking and broker switching
+    mqtt_failover_handle_event(event);
+    
     switch ((esp_mqtt_event_id_t)event_id) {
-        case MQTT_EVENT_CONNECTED:
-            ESP_LOGI(TAG, "✅ MQTT: Connected to broker");
+        case MQTT_EVENT_CONNECTED: {
+            mqtt_failover_stats_t failover;
+            mqtt_failover_get_stats(&failover);
+            ESP_LOGI(TAG, "✅ MQTT: Connected to %s broker", mqtt_failover_name(failover.active));
             mqtt_connected = true;
             
             // Publish "calling home" message to {basetopic}/device
-            char topic[128];
             char message[128];
             uint8_t mac[6];
             esp_read_mac(mac, ESP_MAC_WIFI_STA);
             
-            snprintf(topic, sizeof(topic), "%s/device", MQTT_BASE_TOPIC);
-            snprintf(message, sizeof(message), "[%02X:%02X:%02X:%02X:%02X:%02X] calling home", 
-                     mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+            // Trailing key=value tokens advertise the level payload formats (see mqtt_level_logging.md)
+            snprintf(message, sizeof(message), "[%02X:%02X:%02X:%02X:%02X:%02X] calling home level=%s formats=%s,%s,%s", 
+                     mac[0], mac[1], mac[2], mac[3], mac[4], mac[5], level_format_names[level_format],
+                     level_format_names[LEVEL_FORMAT_ARRAY], level_format_names[LEVEL_FORMAT_COLUMNAR],
+                     level_format_names[LEVEL_FORMAT_CBOR]);
             
-            int msg_id = esp_mqtt_client_publish(mqtt_client, topic, message, 0, 1, 0);
-            ESP_LOGI(TAG, "MQTT: Published to '%s': %s (msg_id=%d)", topic, message, msg_id);
+            int msg_id = esp_mqtt_client_publish(mqtt_client, mqtt_topic_device, message, 0, 1, 0);
+            ESP_LOGI(TAG, "MQTT: Published to '%s': %s (msg_id=%d)", mqtt_topic_device, message, msg_id);
             
             // Subscribe to command topic
-            char cmd_topic[128];
-            snprintf(cmd_topic, sizeof(cmd_topic), "%s/device/command", MQTT_BASE_TOPIC);
-            msg_id = esp_mqtt_client_subscribe(mqtt_client, cmd_topic, 1);
-            ESP_LOGI(TAG, "📬 MQTT: Subscribed to '%s' (msg_id=%d)", cmd_topic, msg_id);
+            msg_id = esp_mqtt_client_subscribe(mqtt_client, mqtt_topic_command, 1);
+            ESP_LOGI(TAG, "📬 MQTT: Subscribed to '%s' (msg_id=%d)", mqtt_topic_command, msg_id);
             
             // Reset polling timer
             last_command_poll = xTaskGetTickCount();
             break;
+        }
             
         case MQTT_EVENT_DISCONNECTED:
             ESP_LOGW(TAG, "❌ MQTT: Disconnected from broker");
@@ -1161,17 +1789,16 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
             
         case MQTT_EVENT_PUBLISHED:
             ESP_LOGD(TAG, "MQTT: Published, msg_id=%d", event->msg_id);
+            mqtt_acked_ids[mqtt_acked_count % MQTT_ACK_HISTORY] = event->msg_id;
+            mqtt_acked_count++;
             break;
             
         case MQTT_EVENT_DATA:
             ESP_LOGI(TAG, "MQTT: Data received on topic '%.*s'", event->topic_len, event->topic);
             
             // Check if this is a command topic
-            char cmd_topic_check[128];
-            snprintf(cmd_topic_check, sizeof(cmd_topic_check), "%s/device/command", MQTT_BASE_TOPIC);
-            
-            if (event->topic_len == strlen(cmd_topic_check) && 
-                strncmp(event->topic, cmd_topic_check, event->topic_len) == 0) {
+            if (event->topic_len == strlen(mqtt_topic_command) && 
+                strncmp(event->topic, mqtt_topic_command, event->topic_len) == 0) {
                 // Process command
                 process_command(event->data, event->data_len);
             } else {
@@ -1199,6 +1826,13 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
 }
 
 // Initialize MQTT client
+// Called by the failover task before it restarts the client on the other broker
+static void mqtt_broker_switching(uint8_t from, uint8_t to)
+{
+    ESP_LOGW(TAG, "🔀 MQTT: Switching from %s to %s broker", mqtt_failover_name(from), mqtt_failover_name(to));
+    mqtt_connected = false;
+}
+
 static void mqtt_init(void)
 {
     // Generate client ID from MAC address if not provided
@@ -1211,35 +1845,46 @@ static void mqtt_init(void)
         strncpy(mqtt_client_id, MQTT_CLIENT_ID, sizeof(mqtt_client_id) - 1);
     }
     
+    // Build topic strings once (used by every publish)
+    snprintf(mqtt_topic_device, sizeof(mqtt_topic_device), "%s/device", MQTT_BASE_TOPIC);
+    snprintf(mqtt_topic_level, sizeof(mqtt_topic_level), "%s/device/level", MQTT_BASE_TOPIC);
+    snprintf(mqtt_topic_timestamp, sizeof(mqtt_topic_timestamp), "%s/device/timestamp", MQTT_BASE_TOPIC);
+    snprintf(mqtt_topic_command, sizeof(mqtt_topic_command), "%s/device/command", MQTT_BASE_TOPIC);
+    snprintf(mqtt_topic_command_ack, sizeof(mqtt_topic_command_ack), "%s/device/command_ack", MQTT_BASE_TOPIC);
+    snprintf(mqtt_topic_queue, sizeof(mqtt_topic_queue), "%s/device/queue", MQTT_BASE_TOPIC);
+    snprintf(mqtt_topic_health, sizeof(mqtt_topic_health), "%s/device/health", MQTT_BASE_TOPIC);
+    
+    // Brokers from the serial menu (mqtt_cfg), compile-time broker if never configured
+    const mqtt_failover_default_t fallback = {
+        .uri = MQTT_BROKER_URL,
+        .port = MQTT_BROKER_PORT,
+        .username = MQTT_USERNAME,
+        .password = MQTT_PASSWORD,
+    };
+    mqtt_failover_init(&fallback);
+    
     // Print MQTT configuration
     ESP_LOGI(TAG, "═══════════════════════════════════════════");
     ESP_LOGI(TAG, "MQTT Configuration:");
-    ESP_LOGI(TAG, "  Broker URL:  %s", MQTT_BROKER_URL);
-    ESP_LOGI(TAG, "  Broker Port: %d", MQTT_BROKER_PORT);
-    ESP_LOGI(TAG, "  Use TLS:     %s", MQTT_USE_TLS ? "Yes" : "No");
+    for (uint8_t i = MQTT_FAILOVER_PRIMARY; i <= MQTT_FAILOVER_SECONDARY; i++) {
+        const mqtt_failover_broker_t *broker = mqtt_failover_broker(i);
+        if (broker == NULL) {
+            ESP_LOGI(TAG, "  %-10s   Not configured", i == MQTT_FAILOVER_PRIMARY ? "Primary:" : "Secondary:");
+            continue;
+        }
+        ESP_LOGI(TAG, "  %-10s   %s (TLS: %s, user: %s)", i == MQTT_FAILOVER_PRIMARY ? "Primary:" : "Secondary:",
+                 broker->uri, broker->tls ? "Yes" : "No", strlen(broker->username) > 0 ? broker->username : "none");
+    }
     ESP_LOGI(TAG, "  Base Topic:  %s", MQTT_BASE_TOPIC);
     ESP_LOGI(TAG, "  Client ID:   %s", mqtt_client_id);
-    if (strlen(MQTT_USERNAME) > 0) {
-        ESP_LOGI(TAG, "  Username:    %s", MQTT_USERNAME);
-        ESP_LOGI(TAG, "  Password:    %s", "********");
-    } else {
-        ESP_LOGI(TAG, "  Auth:        None");
-    }
     ESP_LOGI(TAG, "═══════════════════════════════════════════");
     
-    // Configure MQTT client
+    // Configure MQTT client, starting on the primary broker
     esp_mqtt_client_config_t mqtt_cfg = {
-        .broker.address.uri = MQTT_BROKER_URL,
-        .broker.address.port = MQTT_BROKER_PORT,
         .credentials.client_id = mqtt_client_id,
         .broker.verification.crt_bundle_attach = esp_crt_bundle_attach,
     };
-    
-    // Add authentication if provided
-    if (strlen(MQTT_USERNAME) > 0) {
-        mqtt_cfg.credentials.username = MQTT_USERNAME;
-        mqtt_cfg.credentials.authentication.password = MQTT_PASSWORD;
-    }
+    mqtt_failover_apply(&mqtt_cfg, MQTT_FAILOVER_PRIMARY);
     
     ESP_LOGI(TAG, "🔧 MQTT: Initializing client...");
     mqtt_client = esp_mqtt_client_init(&mqtt_cfg);
@@ -1254,6 +1899,11 @@ static void mqtt_init(void)
     // Register event handler
     ESP_ERROR_CHECK(esp_mqtt_client_register_event(mqtt_client, ESP_EVENT_ANY_ID, mqtt_event_handler, NULL));
     
+    // Health checks and switching to the secondary broker (before the first connect)
+    if (mqtt_failover_start(mqtt_client, &mqtt_cfg, mqtt_topic_health, mqtt_broker_switching) != ESP_OK) {
+        ESP_LOGE(TAG, "❌ MQTT: Failover not available");
+    }
+    
     // Start MQTT client
     ESP_LOGI(TAG, "🚀 MQTT: Starting client...");
     esp_err_t err = esp_mqtt_client_start(mqtt_client);
@@ -1265,167 +1915,1839 @@ static void mqtt_init(void)
     }
 }
 
-// MQTT sensor data logging task - publishes pitch/roll every second
-static void mqtt_sensor_log_task(void *pvParameters)
+// Serialise one batch of level samples (timestamps in esp_timer microseconds) in a JSON
+// level format (LEVEL_FORMAT_COLUMNAR, otherwise the array of samples)
+static void level_encode_batch(json_writer_t *w, uint8_t format, const int64_t *ts_us, const float *pitch,
+                               const float *roll, size_t count, uint32_t lost, int64_t epoch_offset_us, bool replay)
 {
-    ESP_LOGI(TAG, "MQTT sensor logging task started");
-
-    // Wait for MQTT connection
-    vTaskDelay(pdMS_TO_TICKS(5000));  // 5 second delay to ensure MQTT is connected
-
-    while (1) {
-        // Only publish if MQTT client is connected
-        if (mqtt_client != NULL) {
-            // Get current pitch and roll with mutex
-            float pitch = 0.0f, roll = 0.0f;
-            if (xSemaphoreTake(mpu_mutex, pdMS_TO_TICKS(100))) {
-                pitch = current_pitch;
-                roll = current_roll;
-                xSemaphoreGive(mpu_mutex);
-            }
-
-            // Get current time with millisecond precision
-            struct timeval tv;
-            gettimeofday(&tv, NULL);
-
-            // Calculate milliseconds since epoch
-            uint64_t timestamp_ms = (uint64_t)tv.tv_sec * 1000ULL + (uint64_t)(tv.tv_usec / 1000);
-
-            // Create JSON message
-            cJSON *root = cJSON_CreateObject();
-            cJSON_AddStringToObject(root, "client_id", mqtt_client_id);
-            cJSON_AddNumberToObject(root, "timestamp_ms", (double)timestamp_ms);
-            cJSON_AddNumberToObject(root, "pitch", (double)pitch);
-            cJSON_AddNumberToObject(root, "roll", (double)roll);
-
-            // Convert to JSON string
-            char *json_string = cJSON_PrintUnformatted(root);
-            if (json_string) {
-                // Publish to lindi/device/level topic
-                char topic[64];
-                snprintf(topic, sizeof(topic), "%s/device/level", MQTT_BASE_TOPIC);
-
-                int msg_id = esp_mqtt_client_publish(mqtt_client, topic, json_string, 0, 0, 0);
-
-                // Log every 10th message to avoid spam (log every 10 seconds)
-                static int log_counter = 0;
-                if (++log_counter >= 10) {
-                    ESP_LOGI(TAG, "MQTT level data published (msg_id=%d): %s", msg_id, json_string);
-                    log_counter = 0;
-                }
+    json_obj_begin(w);
+    json_kv_str(w, "client_id", mqtt_client_id);
+    json_kv_int(w, "count", (int64_t)count);
+    if (lost > 0) {
+        json_kv_int(w, "lost", lost);
+    }
+    if (replay) {
+        json_kv_bool(w, "replay", true);
+    }
 
-                free(json_string);
-            }
-            cJSON_Delete(root);
+    if (format == LEVEL_FORMAT_COLUMNAR) {
+        // Base timestamp plus per-sample deltas (ms) keeps the payload small
+        int64_t prev_ms = (ts_us[0] + epoch_offset_us) / 1000;
+        json_kv_int(w, "t0", prev_ms);
+        json_key(w, "dt");
+        json_arr_begin(w);
+        for (size_t i = 0; i < count; i++) {
+            int64_t ms = (ts_us[i] + epoch_offset_us) / 1000;
+            json_int(w, ms - prev_ms);
+            prev_ms = ms;
         }
-
-        // Wait 1 second before next publish
-        vTaskDelay(pdMS_TO_TICKS(1000));
-    }
+        json_arr_end(w);
+        json_key(w, "pitch");
+        json_arr_begin(w);
+        for (size_t i = 0; i < count; i++) {
+            json_float(w, pitch[i], 3);
+        }
+        json_arr_end(w);
+        json_key(w, "roll");
+        json_arr_begin(w);
+        for (size_t i = 0; i < count; i++) {
+            json_float(w, roll[i], 3);
+        }
+        json_arr_end(w);
+    } else {
+        json_key(w, "samples");
+        json_arr_begin(w);
+        for (size_t i = 0; i < count; i++) {
+            json_obj_begin(w);
+            json_kv_int(w, "timestamp_ms", (ts_us[i] + epoch_offset_us) / 1000);
+            json_kv_float(w, "pitch", pitch[i], 3);
+            json_kv_float(w, "roll", roll[i], 3);
+            json_obj_end(w);
+        }
+        json_arr_end(w);
+    }
+    json_obj_end(w);
+}
+
+// Map esp_timer time to wall clock (NTP-synchronized system time)
+static int64_t level_epoch_offset_us(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000000LL + tv.tv_usec - esp_timer_get_time();
+}
+
+// Publish one batch of level samples, split in halves if it does not fit LEVEL_PAYLOAD_MAX.
+// QoS 1 whenever the offline queue is available, so a batch is only forgotten once the
+// broker has it (level_unacked_* for live data, level_replay_step for replayed data);
+// QoS 0 otherwise. Returns the msg_id of the last part, -1 on error.
+static int level_publish_batch(const int64_t *ts_us, const float *pitch, const float *roll,
+                               size_t count, uint32_t lost, int64_t epoch_offset_us, bool replay)
+{
+    static char payload[LEVEL_PAYLOAD_MAX];
+    const uint8_t format = level_format;   // May be changed by a command meanwhile
+    size_t len;
+
+    if (format == LEVEL_FORMAT_CBOR) {
+        cbor_writer_t cw;
+        cbor_writer_init(&cw, (uint8_t *)payload, sizeof(payload));
+        level_payload_encode_cbor(&cw, mqtt_client_id, ts_us, pitch, roll, count, lost, epoch_offset_us, replay);
+        len = cbor_writer_finish(&cw);
+    } else {
+        json_writer_t w;
+        json_writer_init(&w, payload, sizeof(payload));
+        level_encode_batch(&w, format, ts_us, pitch, roll, count, lost, epoch_offset_us, replay);
+        json_writer_finish(&w, &len);
+    }
+
+    if (len == 0) {
+        if (count > 1) {
+            size_t half = count / 2;
+            int first = level_publish_batch(ts_us, pitch, roll, half, lost, epoch_offset_us, replay);
+            int last = level_publish_batch(ts_us + half, pitch + half, roll + half, count - half, 0,
+                                           epoch_offset_us, replay);
+            return first < 0 ? -1 : last;
+        }
+        ESP_LOGE(TAG, "Level sample does not fit in %d bytes", LEVEL_PAYLOAD_MAX);
+        return -1;
+    }
+
+    int msg_id = esp_mqtt_client_publish(mqtt_client, mqtt_topic_level, payload, (int)len,
+                                         replay || level_queue_enabled ? 1 : 0, 0);
+
+    // Log every 10th message to avoid spam
+    static int log_counter = 0;
+    if (++log_counter >= 10) {
+        ESP_LOGI(TAG, "MQTT level batch published (msg_id=%d): %u samples, %u bytes, %lu lost%s",
+                 msg_id, (unsigned)count, (unsigned)len, (unsigned long)lost, replay ? ", replay" : "");
+        log_counter = 0;
+    }
+    return msg_id;
+}
+
+// Reference encoder for the benchmark: the cJSON tree the level batch used to be built with
+static cJSON *level_build_batch_cjson(const int64_t *ts_us, const float *pitch, const float *roll,
+                                      size_t count, int64_t epoch_offset_us)
+{
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "client_id", mqtt_client_id);
+    cJSON_AddNumberToObject(root, "count", count);
+    int64_t prev_ms = (ts_us[0] + epoch_offset_us) / 1000;
+    cJSON_AddNumberToObject(root, "t0", (double)prev_ms);
+    cJSON *dt = cJSON_AddArrayToObject(root, "dt");
+    cJSON *p = cJSON_AddArrayToObject(root, "pitch");
+    cJSON *r = cJSON_AddArrayToObject(root, "roll");
+    for (size_t i = 0; i < count; i++) {
+        int64_t ms = (ts_us[i] + epoch_offset_us) / 1000;
+        cJSON_AddItemToArray(dt, cJSON_CreateNumber((double)(ms - prev_ms)));
+        cJSON_AddItemToArray(p, cJSON_CreateNumber(round(pitch[i] * 1000.0) / 1000.0));
+        cJSON_AddItemToArray(r, cJSON_CreateNumber(round(roll[i] * 1000.0) / 1000.0));
+        prev_ms = ms;
+    }
+    return root;
+}
+
+// Heap blocks a cJSON tree holds: one per item, plus its copied key and string value.
+// Counted from the tree because cJSON's allocator hooks are global: swapping them would
+// also count (and reroute) the allocations of the MQTT tasks running meanwhile.
+static uint32_t cjson_tree_allocs(const cJSON *item)
+{
+    uint32_t allocs = 0;
+    for (; item; item = item->next) {
+        allocs++;
+        if (item->string && !(item->type & cJSON_StringIsConst)) {
+            allocs++;
+        }
+        if (item->valuestring) {
+            allocs++;
+        }
+        allocs += cjson_tree_allocs(item->child);
+    }
+    return allocs;
+}
+
+#define JSON_BENCH_SAMPLES     50
+#define JSON_BENCH_ITERATIONS  200
+
+// Encode the same level batch with cJSON, json_writer (columnar) and CBOR and
+// report size, throughput and heap allocations per message (called from the serial menu)
+void json_writer_benchmark(void)
+{
+    static int64_t ts_us[JSON_BENCH_SAMPLES];
+    static float pitch[JSON_BENCH_SAMPLES];
+    static float roll[JSON_BENCH_SAMPLES];
+    static char buf[LEVEL_PAYLOAD_MAX];
+
+    // Synthetic 50 Hz batch with realistic magnitudes
+    int64_t t = esp_timer_get_time();
+    for (int i = 0; i < JSON_BENCH_SAMPLES; i++) {
+        ts_us[i] = t + i * 20000;
+        pitch[i] = -12.3456f + i * 0.0173f;
+        roll[i] = 3.21f - i * 0.0291f;
+    }
+    const int64_t epoch_offset_us = level_epoch_offset_us();
+
+    // cJSON: build the tree, print it, free both
+    uint32_t cjson_allocs = 0;
+    size_t cjson_bytes = 0;
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < JSON_BENCH_ITERATIONS; i++) {
+        cJSON *root = level_build_batch_cjson(ts_us, pitch, roll, JSON_BENCH_SAMPLES, epoch_offset_us);
+        if (i == 0) {
+            cjson_allocs = cjson_tree_allocs(root) + 1;   // + the output buffer
+        }
+        char *out = cJSON_PrintUnformatted(root);
+        cJSON_Delete(root);
+        if (!out) {
+            break;
+        }
+        cjson_bytes += strlen(out);
+        cJSON_free(out);
+    }
+    int64_t cjson_us = esp_timer_get_time() - start;
+
+    // json_writer: the same payload into a static buffer
+    size_t writer_bytes = 0;
+    start = esp_timer_get_time();
+    for (int i = 0; i < JSON_BENCH_ITERATIONS; i++) {
+        json_writer_t w;
+        size_t len;
+        json_writer_init(&w, buf, sizeof(buf));
+        level_encode_batch(&w, LEVEL_FORMAT_COLUMNAR, ts_us, pitch, roll, JSON_BENCH_SAMPLES, 0,
+                           epoch_offset_us, false);
+        if (!json_writer_finish(&w, &len)) {
+            break;
+        }
+        writer_bytes += len;
+    }
+    int64_t writer_us = esp_timer_get_time() - start;
+
+    // CBOR: the binary level format, same samples
+    size_t cbor_bytes = 0;
+    start = esp_timer_get_time();
+    for (int i = 0; i < JSON_BENCH_ITERATIONS; i++) {
+        cbor_writer_t cw;
+        cbor_writer_init(&cw, (uint8_t *)buf, sizeof(buf));
+        level_payload_encode_cbor(&cw, mqtt_client_id, ts_us, pitch, roll, JSON_BENCH_SAMPLES, 0,
+                                  epoch_offset_us, false);
+        size_t len = cbor_writer_finish(&cw);
+        if (len == 0) {
+            break;
+        }
+        cbor_bytes += len;
+    }
+    int64_t cbor_us = esp_timer_get_time() - start;
+
+    if (cjson_us <= 0) cjson_us = 1;
+    if (writer_us <= 0) writer_us = 1;
+    if (cbor_us <= 0) cbor_us = 1;
+
+    printf("Level batch, %d samples, %d iterations\n", JSON_BENCH_SAMPLES, JSON_BENCH_ITERATIONS);
+    printf("  %-12s %5u bytes/msg %7.1f us/msg %8.1f KB/s %6.1f allocs/msg (+ buffer growth)\n", "cJSON",
+           (unsigned)(cjson_bytes / JSON_BENCH_ITERATIONS), (double)cjson_us / JSON_BENCH_ITERATIONS,
+           cjson_bytes * 1000000.0 / cjson_us / 1024.0, (double)cjson_allocs);
+    printf("  %-12s %5u bytes/msg %7.1f us/msg %8.1f KB/s %6.1f allocs/msg\n", "json_writer",
+           (unsigned)(writer_bytes / JSON_BENCH_ITERATIONS), (double)writer_us / JSON_BENCH_ITERATIONS,
+           writer_bytes * 1000000.0 / writer_us / 1024.0, 0.0);
+    printf("  %-12s %5u bytes/msg %7.1f us/msg %8.1f KB/s %6.1f allocs/msg\n", "cbor",
+           (unsigned)(cbor_bytes / JSON_BENCH_ITERATIONS), (double)cbor_us / JSON_BENCH_ITERATIONS,
+           cbor_bytes * 1000000.0 / cbor_us / 1024.0, 0.0);
+}
+
+// Offline queue record for one level batch: level_queue_header_t followed by
+// count level_queue_sample_t. Sample times are relative to the record timestamp,
+// which is wall-clock ms when the clock was set, otherwise esp_timer ms of the
+// boot identified by boot_id (LEVEL_QUEUE_BOOT_CLOCK).
+#define LEVEL_QUEUE_BOOT_CLOCK    0x01
+
+typedef struct {
+    uint32_t lost;
+    uint32_t boot_id;
+    uint8_t flags;
+    uint8_t reserved[3];
+} level_queue_header_t;
+
+typedef struct {
+    uint32_t offset_ms;
+    float pitch;
+    float roll;
+} level_queue_sample_t;
+
+#define LEVEL_QUEUE_RECORD_MAX (sizeof(level_queue_header_t) + LEVEL_BATCH_MAX * sizeof(level_queue_sample_t))
+_Static_assert(LEVEL_QUEUE_RECORD_MAX <= OFFLINE_QUEUE_MAX_RECORD, "level batch does not fit an offline queue record");
+
+// Record timestamps below this are esp_timer based (wall clock would be after 2001)
+#define LEVEL_QUEUE_EPOCH_MIN_MS  1000000000000LL
+
+static uint32_t level_boot_id = 0;          // Random per boot
+
+// Encode a batch as an offline queue record (LEVEL_QUEUE_RECORD_MAX bytes at most);
+// returns its length and the record timestamp
+static size_t level_queue_record(uint8_t *record, const int64_t *ts_us, const float *pitch, const float *roll,
+                                 size_t count, uint32_t lost, int64_t *base_ms_out)
+{
+    level_queue_header_t *hdr = (level_queue_header_t *)record;
+    level_queue_sample_t *samples = (level_queue_sample_t *)(record + sizeof(*hdr));
+
+    const bool wall_clock = time_synced;
+    const int64_t offset_us = wall_clock ? level_epoch_offset_us() : 0;
+    const int64_t base_ms = (ts_us[0] + offset_us) / 1000;
+
+    hdr->lost = lost;
+    hdr->boot_id = level_boot_id;
+    hdr->flags = wall_clock ? 0 : LEVEL_QUEUE_BOOT_CLOCK;
+    memset(hdr->reserved, 0, sizeof(hdr->reserved));
+    for (size_t i = 0; i < count; i++) {
+        samples[i].offset_ms = (uint32_t)((ts_us[i] + offset_us) / 1000 - base_ms);
+        samples[i].pitch = pitch[i];
+        samples[i].roll = roll[i];
+    }
+    *base_ms_out = base_ms;
+    return sizeof(*hdr) + count * sizeof(*samples);
+}
+
+static void level_queue_push(const uint8_t *record, size_t len, uint16_t count, int64_t base_ms)
+{
+    esp_err_t err = offline_queue_push(record, len, count, base_ms);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Offline queue: batch of %u samples lost (%s)", (unsigned)count, esp_err_to_name(err));
+    }
+}
+
+// Store a batch that could not be published
+static void level_queue_batch(const int64_t *ts_us, const float *pitch, const float *roll,
+                              size_t count, uint32_t lost)
+{
+    static uint8_t record[LEVEL_QUEUE_RECORD_MAX];
+    int64_t base_ms;
+    size_t len = level_queue_record(record, ts_us, pitch, roll, count, lost, &base_ms);
+    level_queue_push(record, len, (uint16_t)count, base_ms);
+}
+
+static bool mqtt_delivery_confirmed(int msg_id)
+{
+    uint32_t count = mqtt_acked_count;
+    for (uint32_t i = 0; i < MQTT_ACK_HISTORY && i < count; i++) {
+        if (mqtt_acked_ids[(count - 1 - i) % MQTT_ACK_HISTORY] == msg_id) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Live batches published while the offline queue is available, oldest first, kept
+// as queue records in level_unacked_data until MQTT_EVENT_PUBLISHED confirms them.
+// A link that drops silently is only noticed at the next keepalive; batches sent in
+// between are not confirmed and go to the offline queue instead of being lost (they
+// may then arrive twice). Only used by mqtt_sensor_log_task.
+typedef struct {
+    int msg_id;
+    int64_t sent_us;
+    int64_t base_ms;
+    uint16_t len;
+    uint16_t samples;
+} level_unacked_t;
+
+_Static_assert(LEVEL_UNACKED_BYTES >= LEVEL_QUEUE_RECORD_MAX, "LEVEL_UNACKED_BYTES below one record");
+
+static level_unacked_t level_unacked[LEVEL_UNACKED_MAX];
+static uint8_t level_unacked_data[LEVEL_UNACKED_BYTES];
+static size_t level_unacked_count = 0;
+static size_t level_unacked_used = 0;
+
+// Forget the oldest unconfirmed batch, queueing it first unless it was delivered
+static void level_unacked_pop(bool to_queue)
+{
+    const level_unacked_t *u = &level_unacked[0];
+    if (to_queue) {
+        level_queue_push(level_unacked_data, u->len, u->samples, u->base_ms);
+    }
+    level_unacked_used -= u->len;
+    memmove(level_unacked_data, level_unacked_data + u->len, level_unacked_used);
+    level_unacked_count--;
+    memmove(&level_unacked[0], &level_unacked[1], level_unacked_count * sizeof(level_unacked[0]));
+}
+
+// Drop confirmed batches and queue the ones that timed out or lost their connection.
+// Confirmations arrive in publish order, so only the oldest entries are looked at.
+static void level_unacked_step(void)
+{
+    int64_t now_us = esp_timer_get_time();
+
+    while (level_unacked_count > 0) {
+        const level_unacked_t *u = &level_unacked[0];
+        if (mqtt_delivery_confirmed(u->msg_id)) {
+            level_unacked_pop(false);
+        } else if (!mqtt_connected || now_us - u->sent_us > LEVEL_LIVE_ACK_TIMEOUT_MS * 1000LL) {
+            level_unacked_pop(true);
+        } else {
+            break;
+        }
+    }
+}
+
+// Keep a live batch that was just published as msg_id
+static void level_unacked_add(int msg_id, const int64_t *ts_us, const float *pitch, const float *roll,
+                              size_t count, uint32_t lost)
+{
+    // Full: the oldest goes to the queue early (it may still be confirmed later)
+    size_t len = sizeof(level_queue_header_t) + count * sizeof(level_queue_sample_t);
+    while (level_unacked_count == LEVEL_UNACKED_MAX || level_unacked_used + len > LEVEL_UNACKED_BYTES) {
+        level_unacked_pop(true);
+    }
+
+    level_unacked_t *u = &level_unacked[level_unacked_count++];
+    u->msg_id = msg_id;
+    u->sent_us = esp_timer_get_time();
+    u->samples = (uint16_t)count;
+    u->len = (uint16_t)level_queue_record(level_unacked_data + level_unacked_used, ts_us, pitch, roll,
+                                          count, lost, &u->base_ms);
+    level_unacked_used += u->len;
+}
+
+// Publish a finished batch, or keep it in the offline queue while MQTT is down
+static void level_flush_batch(const int64_t *ts_us, const float *pitch, const float *roll,
+                              size_t count, uint32_t lost)
+{
+    level_unacked_step();  // Earlier batches reach the queue first
+    if (mqtt_client != NULL && mqtt_connected) {
+        int msg_id = level_publish_batch(ts_us, pitch, roll, count, lost, level_epoch_offset_us(), false);
+        if (msg_id >= 0) {
+            if (level_queue_enabled) {
+                level_unacked_add(msg_id, ts_us, pitch, roll, count, lost);
+            }
+            return;
+        }
+    }
+    if (level_queue_enabled) {
+        level_queue_batch(ts_us, pitch, roll, count, lost);
+    }
+}
+
+// Replay the offline queue oldest-first: one record in flight, at most
+// LEVEL_REPLAY_PER_SEC per second, removed only after the broker confirmed it.
+// Called from mqtt_sensor_log_task after live data has been handled.
+static void level_replay_step(void)
+{
+    static uint8_t record[LEVEL_QUEUE_RECORD_MAX];
+    static int64_t ts_us[LEVEL_BATCH_MAX];
+    static float pitch[LEVEL_BATCH_MAX];
+    static float roll[LEVEL_BATCH_MAX];
+    static offline_queue_record_t inflight;
+    static bool inflight_valid = false;
+    static int inflight_msg_id = -1;
+    static int64_t inflight_sent_us = 0;
+    static int64_t next_replay_us = 0;
+
+    int64_t now_us = esp_timer_get_time();
+
+    if (!level_queue_enabled || mqtt_client == NULL || !mqtt_connected) {
+        inflight_valid = false;  // Resent after reconnecting
+        return;
+    }
+
+    if (inflight_valid) {
+        if (mqtt_delivery_confirmed(inflight_msg_id)) {
+            offline_queue_consume(&inflight);
+            inflight_valid = false;
+            next_replay_us = now_us + 1000000 / LEVEL_REPLAY_PER_SEC;
+        } else if (now_us - inflight_sent_us > LEVEL_REPLAY_ACK_TIMEOUT_MS * 1000LL) {
+            ESP_LOGW(TAG, "Offline queue: no delivery confirmation, resending");
+            inflight_valid = false;
+        } else {
+            return;
+        }
+    }
+    if (now_us < next_replay_us) {
+        return;
+    }
+
+    offline_queue_record_t rec;
+    if (offline_queue_peek(record, sizeof(record), &rec) != ESP_OK) {
+        return;
+    }
+
+    const level_queue_header_t *hdr = (const level_queue_header_t *)record;
+    const level_queue_sample_t *samples = (const level_queue_sample_t *)(record + sizeof(*hdr));
+    size_t count = rec.len >= sizeof(*hdr) ? (rec.len - sizeof(*hdr)) / sizeof(*samples) : 0;
+    if (count == 0 || count > LEVEL_BATCH_MAX || rec.len != sizeof(*hdr) + count * sizeof(*samples)) {
+        ESP_LOGW(TAG, "Offline queue: malformed record discarded");
+        offline_queue_consume(&rec);
+        return;
+    }
+
+    int64_t epoch_offset_us = 0;
+    if (hdr->flags & LEVEL_QUEUE_BOOT_CLOCK) {
+        if (hdr->boot_id != level_boot_id) {
+            // Recorded before the clock was set in an earlier boot: no usable timestamps
+            ESP_LOGW(TAG, "Offline queue: %u samples without wall-clock time discarded", (unsigned)count);
+            offline_queue_consume(&rec);
+            return;
+        }
+        if (!time_synced) {
+            return;  // Wait for SNTP, then convert with this boot's offset
+        }
+        epoch_offset_us = level_epoch_offset_us();
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        ts_us[i] = (rec.timestamp_ms + samples[i].offset_ms) * 1000;
+        pitch[i] = samples[i].pitch;
+        roll[i] = samples[i].roll;
+    }
+
+    int msg_id = level_publish_batch(ts_us, pitch, roll, count, hdr->lost, epoch_offset_us, true);
+    if (msg_id < 0) {
+        next_replay_us = now_us + 1000000;
+        return;
+    }
+    inflight = rec;
+    inflight_valid = true;
+    inflight_msg_id = msg_id;
+    inflight_sent_us = now_us;
+}
+
+// Age of the oldest queued sample, -1 if unknown (clock not set); also used by the serial menu
+int64_t level_queue_oldest_age_ms(const offline_queue_stats_t *stats)
+{
+    if (stats->records == 0) {
+        return 0;
+    }
+    int64_t age_ms;
+    if (stats->oldest_timestamp_ms < LEVEL_QUEUE_EPOCH_MIN_MS) {
+        age_ms = esp_timer_get_time() / 1000 - stats->oldest_timestamp_ms;
+    } else if (time_synced) {
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        age_ms = (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000 - stats->oldest_timestamp_ms;
+    } else {
+        return -1;
+    }
+    return age_ms >= 0 ? age_ms : -1;
+}
+
+// Publish offline queue statistics to {base}/device/queue
+static void level_publish_queue_status(void)
+{
+    offline_queue_stats_t stats;
+    offline_queue_get_stats(&stats);
+    int64_t age_ms = level_queue_oldest_age_ms(&stats);
+
+    char payload[256];
+    json_writer_t w;
+    json_writer_init(&w, payload, sizeof(payload));
+    json_obj_begin(&w);
+    json_kv_str(&w, "client_id", mqtt_client_id);
+    json_kv_int(&w, "records", stats.records);
+    json_kv_int(&w, "samples", stats.samples);
+    json_kv_int(&w, "bytes", stats.bytes_pending);
+    json_kv_int(&w, "capacity", stats.capacity_bytes);
+    json_key(&w, "oldest_age_s");
+    if (age_ms >= 0) {
+        json_int(&w, age_ms / 1000);
+    } else {
+        json_null(&w);
+    }
+    json_kv_int(&w, "dropped", stats.dropped_samples);
+    json_kv_int(&w, "replayed", stats.replayed_samples);
+    json_obj_end(&w);
+
+    size_t len;
+    if (json_writer_finish(&w, &len)) {
+        esp_mqtt_client_publish(mqtt_client, mqtt_topic_queue, payload, (int)len, 0, 0);
+    }
+}
+
+// MQTT sensor data logging task - drains the sensor history at level_rate_hz and
+// publishes level_batch_size samples per message (or whatever is there after level_flush_ms)
+static void mqtt_sensor_log_task(void *pvParameters)
+{
+    (void)pvParameters;
+    static int64_t batch_ts_us[LEVEL_BATCH_MAX];
+    static float batch_pitch[LEVEL_BATCH_MAX];
+    static float batch_roll[LEVEL_BATCH_MAX];
+    static sensor_history_sample_t chunk[16];
+    size_t batch_count = 0;
+    uint32_t batch_lost = 0;
+    int64_t next_due_us = 0;
+
+    ESP_LOGI(TAG, "MQTT sensor logging task started");
+
+    sensor_history_t *history = sensor_history_default();
+    sensor_history_reader_t reader;
+    sensor_history_reader_init(history, &reader, false);
+    int64_t batch_start_us = 0;  // When the first sample of the current batch was taken
+    int64_t last_status_us = 0;  // Last offline queue status publish
+
+    while (1) {
+        int64_t interval_us = 1000000 / level_rate_hz;
+        size_t batch_size = level_batch_size;
+
+        // Take one sample per interval from the full-rate history
+        uint32_t lost;
+        size_t n;
+        while ((n = sensor_history_read(history, &reader, chunk, sizeof(chunk) / sizeof(chunk[0]), &lost)) > 0) {
+            batch_lost += lost;
+            for (size_t i = 0; i < n; i++) {
+                if (chunk[i].timestamp_us < next_due_us) {
+                    continue;
+                }
+                next_due_us += interval_us;
+                if (next_due_us <= chunk[i].timestamp_us) {
+                    next_due_us = chunk[i].timestamp_us + interval_us;  // Fell behind (gap or rate change)
+                }
+
+                if (batch_count == 0) {
+                    batch_start_us = esp_timer_get_time();
+                }
+                batch_ts_us[batch_count] = chunk[i].timestamp_us;
+                batch_pitch[batch_count] = chunk[i].pitch;
+                batch_roll[batch_count] = chunk[i].roll;
+                batch_count++;
+
+                if (batch_count >= batch_size) {
+                    level_flush_batch(batch_ts_us, batch_pitch, batch_roll, batch_count, batch_lost);
+                    batch_count = 0;
+                    batch_lost = 0;
+                }
+            }
+        }
+
+        // Partial batch after the flush interval
+        if (batch_count > 0 && esp_timer_get_time() - batch_start_us >= (int64_t)level_flush_ms * 1000) {
+            level_flush_batch(batch_ts_us, batch_pitch, batch_roll, batch_count, batch_lost);
+            batch_count = 0;
+            batch_lost = 0;
+        }
+
+        // Confirmed or overdue live batches, then the backlog from the offline queue
+        level_unacked_step();
+        level_replay_step();
+
+        if (level_queue_enabled && mqtt_client != NULL && mqtt_connected &&
+            esp_timer_get_time() - last_status_us >= LEVEL_QUEUE_STATUS_MS * 1000LL) {
+            level_publish_queue_status();
+            last_status_us = esp_timer_get_time();
+        }
+
+        // Executed command IDs, batched by command_ledger_timer
+        if (command_ledger_flush_requested) {
+            command_ledger_flush_requested = false;
+            command_ledger_flush();
+        }
+
+        vTaskDelay(pdMS_TO_TICKS(LEVEL_POLL_MS));
+    }
+}
+
+// Main function
+void app_main() {
+	ESP_LOGI(TAG, "Starting...");
+	
+	// Initialize NVS
+	esp_err_t ret = nvs_flash_init();
+	if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+		ESP_ERROR_CHECK(nvs_flash_erase());
+		ret = nvs_flash_init();
+	}
+	ESP_ERROR_CHECK(ret);
+
+	// Initialize serial menu (press 'm' to open)
+	ESP_LOGI(TAG, "Starting serial menu...");
+	serial_menu_init();
+
+	// Load winter time setting from NVS
+	load_winter_time_setting();
+	
+	// Load dark theme setting from NVS
+	load_dark_theme_setting();
+
+	// Load accent color setting from NVS
+	load_accent_color_setting();
+
+	// Load sensor inversion setting from NVS
+	load_sensor_inversion_setting();
+	
+	// Load language setting from NVS
+	load_language_setting();
+	
+	// Load calibration offsets from NVS
+	load_calibration_offsets();
+	
+	// Load MPU6050 sample rate from NVS
+	load_mpu_sample_rate_setting();
+	
+	// Load level telemetry batching from NVS
+	load_level_telemetry_settings();
+	
+	// Load display dim/sleep timeouts from NVS
+	load_display_power_settings();
+	
+	// Initialize event loop
+	ESP_ERROR_CHECK(esp_event_loop_create_default());
+	
+	// Initialize I2C
+	ESP_LOGI(TAG, "Initializing I2C...");
+	ESP_ERROR_CHECK(i2c_master_init());
+	
+#if USE_FAKE_SENSOR_DATA
+	// Using fake sensor data for UI testing
+	ESP_LOGI(TAG, "Using FAKE sensor data (MPU6050 disabled)");
+	xTaskCreatePinnedToCore(fake_sensor_task, "fake_sensor", 2048, NULL, 5, NULL, 0);
+#else
+	// Initialize real MPU6050
+	ESP_LOGI(TAG, "Initializing MPU6050...");
+	if (mpu6050_init() == ESP_OK) {
+		// Start MPU6050 reading task - pinned to Core 0 to avoid blocking display
+		xTaskCreatePinnedToCore(mpu6050_read_task, "mpu6050_read", 4096, NULL, 5, NULL, 0);
+		ESP_LOGI(TAG, "MPU6050 task started on Core 0");
+	} else {
+		ESP_LOGW(TAG, "MPU6050 initialization failed, continuing without sensor");
+	}
+#endif
+	
+	// Offline queue for level telemetry, then start logging before WiFi so
+	// batches taken while offline are kept from boot onwards
+	level_boot_id = esp_random();
+	level_queue_enabled = offline_queue_init() == ESP_OK;
+	ESP_LOGI(TAG, "Starting MQTT sensor logging task...");
+	xTaskCreatePinnedToCore(mqtt_sensor_log_task, "mqtt_sensor_log", 4096, NULL, 5, NULL, 0);
+	
+	// Initialize WiFi with power save mode
+	ESP_LOGI(TAG, "Starting WiFi...");
+	wifi_init_sta();
+	
+	// Wait for WiFi connection before starting MQTT
+	ESP_LOGI(TAG, "Waiting for WiFi connection...");
+	xEventGroupWaitBits(s_wifi_event_group, WIFI_CONNECTED_BIT, pdFALSE, pdTRUE, portMAX_DELAY);
+	
+	// Initialize MQTT client
+	ESP_LOGI(TAG, "WiFi connected, initializing MQTT...");
+	command_ledger_load();
+	mqtt_init();
+
+	// Initialize SD card (optional - continues if card not present)
+	// TEMPORARILY DISABLED - May conflict with display SPI
+	// ESP_LOGI(TAG, "Checking for SD card...");
+	// ret = init_sd_card();
+	// if (ret == ESP_OK) {
+	// 	ESP_LOGI(TAG, "SD card is accessible and ready");
+	// } else {
+	// 	ESP_LOGW(TAG, "SD card not available (insert card and restart if needed)");
+	// }
+	
+	vTaskDelay(1000 / portTICK_PERIOD_MS);
+	// GUI task pinned to Core 1 - keeps display smooth while Core 0 handles I2C
+	xTaskCreatePinnedToCore(guiTask, "gui", 4096*2, NULL, 0, NULL, 1);
+}
+
+//Creates a semaphore to handle concurrent call to lvgl stuff
+//If you wish to call *any* lvgl function from other threads/tasks
+//you should lock on the very same semaphore, and call gui_wake() after
+//releasing it so the GUI task picks the change up before its next deadline!
+SemaphoreHandle_t xGuiSemaphore;		// 创建一个GUI信号量
+static bool perf_monitor_hidden = false;	// Flag to track if we've hidden the perf monitor
+
+// The GUI task sleeps on its task notification until the next LVGL task is
+// due (lv_task_handler's return value) or one of these events arrives
+#define GUI_WAKE_REQUEST    (1u << 0)   // Another task changed the UI (gui_wake)
+#define GUI_WAKE_TOUCH      (1u << 1)   // Touch controller pen-down IRQ
+#define GUI_WAKE_FLUSH      (1u << 2)   // Display flush finished while a refresh was pending
+#define GUI_MAX_SLEEP_MS    1000        // Upper bound when no LVGL task is scheduled
+#define GUI_TOUCH_PARK_MS   1000        // Stop polling the touch controller after this long untouched
+#define GUI_FLUSH_CORE      0           // Display flush worker runs beside the sensor tasks
+#define GUI_FLUSH_PRIO      6           // Above the sensor tasks: a late stripe stalls rendering
+
+#if CONFIG_LVGL_TOUCH_CONTROLLER_XPT2046
+// Parking the touch polling needs a real PENIRQ line. On one of the bus pins
+// (e.g. TP_CLK) the "pen down" edges only come from our own reads, so touch
+// would never resume: keep polling instead.
+#if CONFIG_LVGL_TOUCH_PIN_IRQ == CONFIG_LVGL_TOUCH_SPI_CLK || CONFIG_LVGL_TOUCH_PIN_IRQ == CONFIG_LVGL_TOUCH_SPI_MOSI || \
+    CONFIG_LVGL_TOUCH_PIN_IRQ == CONFIG_LVGL_TOUCH_SPI_MISO || CONFIG_LVGL_TOUCH_PIN_IRQ == CONFIG_LVGL_TOUCH_SPI_CS
+#warning "CONFIG_LVGL_TOUCH_PIN_IRQ is a touch SPI pin; touch is polled continuously (PENIRQ is GPIO36 on this board)"
+#else
+#define GUI_TOUCH_IRQ_PIN   CONFIG_LVGL_TOUCH_PIN_IRQ
+#endif
+#endif
+
+static TaskHandle_t gui_task_handle = NULL;
+static volatile bool gui_loop_polling = false;  // Old fixed-tick loop, kept for comparison
+static volatile bool gui_flush_wake_armed = false;
+static lv_task_t *level_task = NULL;
+static lv_indev_t *touch_indev = NULL;
+static bool touch_parked = false;
+
+// Loop statistics since the last gui_loop_report()
+typedef struct {
+    int64_t since_us;
+    uint64_t idle_us;           // Blocked waiting for a deadline or an event
+    uint64_t handler_us;        // Inside lv_task_handler
+    uint32_t wakeups;
+    uint32_t deadlines;         // Woken by the timeout (LVGL task due)
+    uint32_t requests;
+    uint32_t touches;
+    uint32_t flushes;
+    uint32_t frames;            // Refresh cycles (monitor_cb)
+    uint64_t frame_ms;          // Render + flush time of those cycles
+    uint64_t frame_px;
+    uint64_t frame_wait_us;     // Waited for the bus (or a free buffer) during those cycles
+    uint32_t max_frame_wait_us;
+} gui_loop_stats_t;
+
+static gui_loop_stats_t gui_stats;
+static portMUX_TYPE gui_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void IRAM_ATTR gui_notify_from_isr(uint32_t event)
+{
+    BaseType_t woken = pdFALSE;
+    if (gui_task_handle) {
+        xTaskNotifyFromISR(gui_task_handle, event, eSetBits, &woken);
+    }
+    if (woken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+// Wake the GUI task after changing LVGL objects from another task
+void gui_wake(void)
+{
+    if (gui_task_handle) {
+        xTaskNotify(gui_task_handle, GUI_WAKE_REQUEST, eSetBits);
+    }
+}
+
+// disp_spi: a flush was handed back to LVGL (SPI ISR)
+static void IRAM_ATTR gui_flush_done_isr(void)
+{
+    if (gui_flush_wake_armed) {
+        gui_flush_wake_armed = false;
+        gui_notify_from_isr(GUI_WAKE_FLUSH);
+    }
+}
+
+#ifdef GUI_TOUCH_IRQ_PIN
+static int64_t gui_touch_irq_us;    // Last pen-down, for the display wake latency
+
+// PENIRQ low: one-shot, re-armed when touch polling is parked again
+static void IRAM_ATTR gui_touch_isr(void *arg)
+{
+    (void)arg;
+    gpio_intr_disable(GUI_TOUCH_IRQ_PIN);
+    gui_touch_irq_us = esp_timer_get_time();
+    gui_notify_from_isr(GUI_WAKE_TOUCH);
+}
+
+static bool gui_touch_irq_init(void)
+{
+    // Level, not edge: light sleep can only wake on a level (gui_power_init)
+    esp_err_t err = gpio_set_intr_type(GUI_TOUCH_IRQ_PIN, GPIO_INTR_LOW_LEVEL);
+    if (err == ESP_OK) {
+        err = gpio_install_isr_service(0);
+        if (err == ESP_ERR_INVALID_STATE) {
+            err = ESP_OK;  // Already installed by another driver
+        }
+    }
+    if (err == ESP_OK) {
+        err = gpio_isr_handler_add(GUI_TOUCH_IRQ_PIN, gui_touch_isr, NULL);
+    }
+    if (err == ESP_OK) {
+        gpio_intr_disable(GUI_TOUCH_IRQ_PIN);  // Enabled while polling is parked
+    } else {
+        ESP_LOGW(TAG, "Touch IRQ on GPIO%d unavailable (%s), polling touch continuously",
+                 GUI_TOUCH_IRQ_PIN, esp_err_to_name(err));
+    }
+    return err == ESP_OK;
+}
+#endif
+
+// Resume the LVGL read task of the touch controller
+static void gui_touch_resume(void)
+{
+    if (!touch_parked) {
+        return;
+    }
+    touch_parked = false;
+    lv_task_set_prio(touch_indev->driver.read_task, LV_TASK_PRIO_HIGH);
+    lv_task_ready(touch_indev->driver.read_task);
+}
+
+// Stop polling the touch controller once nothing has touched the screen for a
+// while; the pen-down IRQ resumes it. Needs the read task to have seen the
+// release, so drags and throws have finished.
+static void gui_touch_park(void)
+{
+#ifdef GUI_TOUCH_IRQ_PIN
+    if (touch_parked || touch_indev == NULL ||
+        lv_disp_get_inactive_time(NULL) < GUI_TOUCH_PARK_MS ||
+        gpio_get_level(GUI_TOUCH_IRQ_PIN) == 0) {
+        return;
+    }
+    lv_task_set_prio(touch_indev->driver.read_task, LV_TASK_PRIO_OFF);
+    touch_parked = true;
+    gpio_intr_enable(GUI_TOUCH_IRQ_PIN);
+    if (gpio_get_level(GUI_TOUCH_IRQ_PIN) == 0) {
+        // Pen went down before the interrupt was armed
+        gpio_intr_disable(GUI_TOUCH_IRQ_PIN);
+        gui_touch_resume();
+    }
+#endif
+}
+
+// With the perf monitor compiled in, LVGL keeps its refresh task running every
+// LV_DISP_DEF_REFR_PERIOD. Pause it while the monitor is hidden and nothing is
+// invalid; any invalidation re-enables it (_lv_inv_area).
+static void gui_refr_park(void)
+{
+#if LV_USE_PERF_MONITOR
+    lv_disp_t *disp = lv_disp_get_default();
+    lv_obj_t *perf = lv_obj_get_child(lv_layer_sys(), NULL);
+    if (disp && disp->inv_p == 0 && perf && lv_obj_get_hidden(perf)) {
+        lv_task_set_prio(disp->refr_task, LV_TASK_PRIO_OFF);
+    }
+#endif
+}
+
+// A refresh left pending behind an in-flight flush starts as soon as the
+// flush completes instead of after the rest of the refresh period
+static uint32_t gui_flush_wake_arm(uint32_t sleep_ms)
+{
+    lv_disp_t *disp = lv_disp_get_default();
+    if (disp == NULL || disp->inv_p == 0 || !lv_disp_get_buf(disp)->flushing) {
+        return sleep_ms;
+    }
+    gui_flush_wake_armed = true;
+    if (!lv_disp_get_buf(disp)->flushing) {
+        gui_flush_wake_armed = false;  // Finished before the ISR could see the flag
+        lv_task_ready(disp->refr_task);
+        return 0;
+    }
+    return sleep_ms;
+}
+
+// Time the GUI task has spent waiting for the display so far: in wait_cb
+// for the bus, or for a free buffer when a flush worker sends the stripes
+static uint64_t gui_disp_wait_us(void)
+{
+#if CONFIG_LVGL_DISP_FLUSH_WORKER
+    disp_pipeline_stats_t p;
+    disp_pipeline_get_stats(&p);
+    return p.render_wait_us;
+#else
+    disp_spi_queue_stats_t q;
+    disp_spi_get_queue_stats(&q);
+    return q.flush_wait_us + q.blocked_us;
+#endif
+}
+
+// LVGL monitor_cb, after every refresh cycle: attribute the flush waits of
+// this cycle to the frame
+static void gui_frame_monitor_cb(lv_disp_drv_t *drv, uint32_t time_ms, uint32_t px)
+{
+    static uint64_t wait_at_last_frame;
+    (void)drv;
+
+    uint64_t wait_total = gui_disp_wait_us();
+    uint32_t wait_us = (uint32_t)(wait_total - wait_at_last_frame);
+    wait_at_last_frame = wait_total;
+
+    portENTER_CRITICAL(&gui_stats_lock);
+    gui_stats.frames++;
+    gui_stats.frame_ms += time_ms;
+    gui_stats.frame_px += px;
+    gui_stats.frame_wait_us += wait_us;
+    if (wait_us > gui_stats.max_frame_wait_us) {
+        gui_stats.max_frame_wait_us = wait_us;
+    }
+    portEXIT_CRITICAL(&gui_stats_lock);
+}
+
+// Only the Level tab needs the 10 Hz bar updates
+static void main_tabview_cb(lv_obj_t *tv, lv_event_t e)
+{
+    if (e == LV_EVENT_VALUE_CHANGED && level_task) {
+        if (lv_tabview_get_tab_act(tv) == 1) {
+            lv_task_set_prio(level_task, LV_TASK_PRIO_MID);
+            lv_task_ready(level_task);
+        } else {
+            lv_task_set_prio(level_task, LV_TASK_PRIO_OFF);
+        }
+    }
+}
+
+// Ticks to sleep for an LVGL deadline, rounded up so a due task is not
+// missed by a tick; LV_NO_TASK_READY means only events can wake us
+static TickType_t gui_sleep_ticks(uint32_t ms)
+{
+    if (ms > GUI_MAX_SLEEP_MS) {
+        ms = GUI_MAX_SLEEP_MS;
+    }
+    return (ms + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS;
+}
+
+// Use the old vTaskDelay(1) loop (serial menu, before/after comparison)
+void gui_loop_set_polling(bool polling)
+{
+    gui_loop_polling = polling;
+    gui_wake();
+}
+
+bool gui_loop_is_polling(void)
+{
+    return gui_loop_polling;
+}
+
+// Print wakeups/s and idle time since the previous call, then start a new
+// window (called from the serial menu)
+void gui_loop_report(void)
+{
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&gui_stats_lock);
+    gui_loop_stats_t s = gui_stats;
+    memset(&gui_stats, 0, sizeof(gui_stats));
+    gui_stats.since_us = now;
+    portEXIT_CRITICAL(&gui_stats_lock);
+
+    float window_s = (now - s.since_us) / 1e6f;
+    if (window_s <= 0.0f) {
+        return;
+    }
+
+    printf("  Loop:             %s\n", gui_loop_polling ?
+           "fixed tick (vTaskDelay(1) per pass)" : "event driven (sleeps until the next LVGL deadline)");
+    printf("  Window:           %.1f s\n", window_s);
+    printf("  Wakeups:          %.1f /s\n", s.wakeups / window_s);
+    printf("    deadline:       %.1f /s\n", s.deadlines / window_s);
+    printf("    touch IRQ:      %.1f /s\n", s.touches / window_s);
+    printf("    flush done:     %.1f /s\n", s.flushes / window_s);
+    printf("    UI request:     %.1f /s\n", s.requests / window_s);
+    printf("  Idle:             %.1f %%\n", 100.0f * s.idle_us / (window_s * 1e6f));
+    printf("  lv_task_handler:  %.1f %% (%.0f us per wakeup)\n",
+           100.0f * s.handler_us / (window_s * 1e6f),
+           s.wakeups ? (float)s.handler_us / s.wakeups : 0.0f);
+    printf("  Touch polling:    %s\n", touch_parked ? "parked (waiting for pen-down IRQ)" : "active");
+#if CONFIG_LVGL_TOUCH_CONTROLLER != TOUCH_CONTROLLER_NONE
+    // Cost of the indev read callback; SPI wait is time the GUI task sleeps
+    static touch_driver_stats_t touch_prev;
+    touch_driver_stats_t t;
+    touch_driver_get_stats(&t);
+    uint32_t touch_reads = t.reads - touch_prev.reads;
+    if (touch_reads > 0) {
+        uint32_t pressed = t.pressed - touch_prev.pressed;
+        uint64_t read_us = t.read_us - touch_prev.read_us;
+        uint64_t wait_us = t.wait_us - touch_prev.wait_us;
+        printf("  Touch reads:      %.1f /s, %lu pressed, %.0f us CPU per read (%.0f us SPI wait), max %lu us\n",
+               touch_reads / window_s, (unsigned long)pressed,
+               (float)(read_us - wait_us) / touch_reads, (float)wait_us / touch_reads,
+               (unsigned long)t.max_cpu_us);
+    }
+    touch_prev = t;
+#endif
+    if (s.frames > 0) {
+        printf("  Frames:           %lu (%.1f /s), %.1f ms and %llu px each\n",
+               (unsigned long)s.frames, s.frames / window_s, (float)s.frame_ms / s.frames,
+               (unsigned long long)(s.frame_px / s.frames));
+        printf("  Flush wait/frame: %.2f ms avg, %.2f ms max (task sleeps, CPU free)\n",
+               s.frame_wait_us / 1000.0f / s.frames, s.max_frame_wait_us / 1000.0f);
+    } else {
+        printf("  Frames:           0\n");
+    }
+
+    disp_spi_queue_stats_t q;
+    disp_spi_get_queue_stats(&q);
+    printf("  Display flushes:  %lu since boot, %llu ms blocked on SPI\n",
+           (unsigned long)q.flushes, (unsigned long long)(q.blocked_us / 1000));
+#if CONFIG_LVGL_DISP_FLUSH_WORKER
+    disp_pipeline_stats_t p;
+    disp_pipeline_get_stats(&p);
+    printf("  Flush worker:     %u buffers, %lu stripes, %lu render stalls, max %u queued\n",
+           p.buffers, (unsigned long)p.stripes, (unsigned long)p.render_stalls, p.max_queued);
+#endif
+}
+
+// Display benchmark ([d] serial menu): the rounded rectangle, shadow and text
+// scenes of lv_demo_benchmark, falling objects redrawn full screen as fast as
+// LVGL can for DISP_BENCH_MS. Runs in the GUI task so rendering stays on its
+// core; the serial task only requests it and waits. With the ESP32 blend
+// kernels it first times each kernel on a stripe, then renders the scene once
+// more for DISP_BENCH_C_MS with LVGL's own C blending for comparison.
+#define DISP_BENCH_MS       5000
+#if LV_USE_GPU_ESP32_BLEND
+#define DISP_BENCH_C_MS     2000
+#else
+#define DISP_BENCH_C_MS     0
+#endif
+#define DISP_BENCH_OBJ_NUM  8
+#define DISP_BENCH_TXT      "hello world\nit is a multi line text to test\nthe performance of text rendering"
+
+static volatile bool disp_bench_requested = false;
+static SemaphoreHandle_t disp_bench_done = NULL;
+
+// Same sequence on every run so results can be compared
+static int32_t disp_bench_rnd(uint32_t *seed, int32_t min, int32_t max)
+{
+    *seed = *seed * 1103515245u + 12345u;
+    return min + (int32_t)((*seed >> 8) % (uint32_t)(max - min + 1));
+}
+
+// Wait until the last stripe of the frame is on the panel
+static void gui_disp_drain(void)
+{
+#if CONFIG_LVGL_DISP_FLUSH_WORKER
+    disp_pipeline_drain();
+#else
+    lv_disp_t *disp = lv_disp_get_default();
+    while (lv_disp_get_buf(disp)->flushing) {
+        disp_driver_wait_cb(&disp->driver);
+    }
+#endif
+}
+
+#if LV_USE_GPU_ESP32_BLEND
+// One LV_HOR_RES_MAX wide stripe in internal RAM, like a draw buffer
+#define DISP_BENCH_KERNEL_LINES     16
+#define DISP_BENCH_KERNEL_ROUNDS    50
+
+typedef struct {
+    const char *name;
+    bool map;           // Blend an image map, else a fill color
+    bool mask;          // Through a mask with glyph-like edges
+    lv_opa_t opa;
+} disp_bench_kernel_t;
+
+static const disp_bench_kernel_t disp_bench_kernels[] = {
+    {"fill",          false, false, LV_OPA_COVER},
+    {"fill opa",      false, false, LV_OPA_50},
+    {"fill mask",     false, true,  LV_OPA_COVER},
+    {"fill opa mask", false, true,  LV_OPA_50},
+    {"map",           true,  false, LV_OPA_COVER},
+    {"map opa",       true,  false, LV_OPA_50},
+    {"map mask",      true,  true,  LV_OPA_COVER},
+    {"map opa mask",  true,  true,  LV_OPA_50},
+};
+
+static void disp_bench_kernel_run(const disp_bench_kernel_t *k, uint16_t *buf, const uint16_t *map,
+                                  const uint8_t *mask, uint16_t color)
+{
+    int32_t w = LV_HOR_RES_MAX;
+    int32_t h = DISP_BENCH_KERNEL_LINES;
+
+    if (k->map) {
+        if (k->mask) {
+            lv_gpu_esp32_blend_map_mask(buf, w, map, w, k->opa, mask, w, h);
+        } else if (k->opa == LV_OPA_COVER) {
+            lv_gpu_esp32_blend_copy(buf, w, map, w, w, h);
+        } else {
+            lv_gpu_esp32_blend_map_opa(buf, w, map, w, k->opa, w, h);
+        }
+    } else {
+        if (k->mask) {
+            lv_gpu_esp32_blend_fill_mask(buf, w, color, k->opa, mask, w, h);
+        } else if (k->opa == LV_OPA_COVER) {
+            lv_gpu_esp32_blend_fill(buf, w, color, w, h);
+        } else {
+            lv_gpu_esp32_blend_fill_opa(buf, w, color, k->opa, w, h);
+        }
+    }
+}
+
+// What fill_normal and map_normal in lv_draw_blend.c draw for one pixel
+static uint16_t disp_bench_kernel_expect(const disp_bench_kernel_t *k, uint16_t fg, uint16_t bg, lv_opa_t m)
+{
+    lv_color_t c1 = {.full = fg};
+    lv_color_t c2 = {.full = bg};
+    lv_opa_t opa = k->opa;
+
+    if (k->mask) {
+        if (m == LV_OPA_TRANSP) {
+            return bg;
+        }
+        if (k->opa == LV_OPA_COVER) {
+            opa = m;
+        } else if (k->map ? m >= LV_OPA_MAX : m == LV_OPA_COVER) {
+            opa = k->opa;
+        } else {
+            opa = (k->opa * m) >> 8;
+        }
+    }
+    return lv_color_mix(c1, c2, opa).full;
+}
+
+static void display_benchmark_kernels(void)
+{
+    uint32_t seed = 1;
+    const uint32_t px = LV_HOR_RES_MAX * DISP_BENCH_KERNEL_LINES;
+    uint16_t *buf = heap_caps_malloc(px * sizeof(uint16_t), MALLOC_CAP_INTERNAL);
+    uint16_t *bg = heap_caps_malloc(px * sizeof(uint16_t), MALLOC_CAP_INTERNAL);
+    uint16_t *map = heap_caps_malloc(px * sizeof(uint16_t), MALLOC_CAP_INTERNAL);
+    uint8_t *mask = heap_caps_malloc(px, MALLOC_CAP_INTERNAL);
+    uint16_t color = lv_color_hex(disp_bench_rnd(&seed, 0, 0xFFFFF0)).full;
+    bool exact = true;
+
+    if (buf == NULL || bg == NULL || map == NULL || mask == NULL) {
+        printf("  Blend kernels:    not enough internal RAM\n");
+        goto out;
+    }
+
+    // Runs of transparent and covered pixels with an anti-aliased edge between
+    for (uint32_t i = 0; i < px;) {
+        int32_t run = disp_bench_rnd(&seed, 1, 12);
+        lv_opa_t opa = disp_bench_rnd(&seed, 0, 1) ? LV_OPA_COVER : LV_OPA_TRANSP;
+        for (; run > 0 && i < px; run--) {
+            mask[i++] = opa;
+        }
+        if (i < px) {
+            mask[i++] = disp_bench_rnd(&seed, 1, 254);
+        }
+    }
+    for (uint32_t i = 0; i < px; i++) {
+        bg[i] = disp_bench_rnd(&seed, 0, 0xFFFF);
+        map[i] = disp_bench_rnd(&seed, 0, 0xFFFF);
+    }
+
+    printf("  Blend kernels (%u x %u px, IRAM, internal RAM buffer):\n",
+           (unsigned)LV_HOR_RES_MAX, (unsigned)DISP_BENCH_KERNEL_LINES);
+    for (size_t n = 0; n < sizeof(disp_bench_kernels) / sizeof(disp_bench_kernels[0]); n++) {
+        const disp_bench_kernel_t *k = &disp_bench_kernels[n];
+
+        memcpy(buf, bg, px * sizeof(uint16_t));
+        disp_bench_kernel_run(k, buf, map, mask, color);
+        for (uint32_t i = 0; i < px; i++) {
+            if (buf[i] != disp_bench_kernel_expect(k, k->map ? map[i] : color, bg[i], mask[i])) {
+                exact = false;
+                break;
+            }
+        }
+
+        int64_t t0 = esp_timer_get_time();
+        for (int r = 0; r < DISP_BENCH_KERNEL_ROUNDS; r++) {
+            disp_bench_kernel_run(k, buf, map, mask, color);
+        }
+        int64_t us = esp_timer_get_time() - t0;
+        printf("    %-14s %6.1f px/us\n", k->name, us > 0 ? (float)px * DISP_BENCH_KERNEL_ROUNDS / us : 0.0f);
+    }
+    printf("    Output matches lv_color_mix: %s\n\n", exact ? "yes" : "NO");
+
+out:
+    free(buf);
+    free(bg);
+    free(map);
+    free(mask);
+}
+#endif
+
+// Move the falling objects and redraw the screen until duration_ms is over.
+// Returns the frame count and adds the time spent in lv_refr_now to refr_us.
+static uint32_t disp_bench_frames(lv_disp_t *disp, lv_obj_t *scr, lv_obj_t **objs, const lv_coord_t *start_y,
+                                  const lv_coord_t *speed, int duration_ms, uint64_t *refr_us)
+{
+    lv_coord_t ver = lv_disp_get_ver_res(disp);
+    uint32_t frames = 0;
+    int64_t start = esp_timer_get_time();
+
+    while (esp_timer_get_time() - start < duration_ms * 1000LL) {
+        for (int i = 0; i < DISP_BENCH_OBJ_NUM; i++) {
+            lv_coord_t h = lv_obj_get_height(objs[i]);
+            lv_obj_set_y(objs[i], (start_y[i] + frames * speed[i]) % (ver + h) - h);
+        }
+        lv_obj_invalidate(scr);
+
+        int64_t t0 = esp_timer_get_time();
+        lv_refr_now(disp);
+        *refr_us += esp_timer_get_time() - t0;
+        frames++;
+    }
+    return frames;
+}
+
+static void display_benchmark_run(void)
+{
+    lv_disp_t *disp = lv_disp_get_default();
+    lv_coord_t hor = lv_disp_get_hor_res(disp);
+    lv_coord_t ver = lv_disp_get_ver_res(disp);
+    lv_obj_t *prev_scr = lv_scr_act();
+    lv_obj_t *scr = lv_obj_create(NULL, NULL);
+    lv_obj_t *objs[DISP_BENCH_OBJ_NUM];
+    lv_coord_t start_y[DISP_BENCH_OBJ_NUM];
+    lv_coord_t speed[DISP_BENCH_OBJ_NUM];
+    uint32_t seed = 1;
+
+#if LV_USE_GPU_ESP32_BLEND
+    display_benchmark_kernels();
+#endif
+    for (int i = 0; i < DISP_BENCH_OBJ_NUM; i++) {
+        lv_obj_t *obj;
+        if (i % 2 == 0) {
+            // Rounded, semi-transparent rectangle with a small shadow
+            obj = lv_obj_create(scr, NULL);
+            lv_obj_set_size(obj, disp_bench_rnd(&seed, 10, hor / 2), disp_bench_rnd(&seed, 10, hor / 2));
+            lv_obj_set_style_local_radius(obj, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, 8);
+            lv_obj_set_style_local_bg_opa(obj, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, LV_OPA_50);
+            lv_obj_set_style_local_bg_color(obj, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT,
+                                            lv_color_hex(disp_bench_rnd(&seed, 0, 0xFFFFF0)));
+            lv_obj_set_style_local_shadow_width(obj, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, 8);
+            lv_obj_set_style_local_shadow_ofs_x(obj, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, 4);
+            lv_obj_set_style_local_shadow_ofs_y(obj, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, 4);
+            lv_obj_set_style_local_shadow_color(obj, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT,
+                                                lv_color_hex(disp_bench_rnd(&seed, 0, 0xFFFFF0)));
+        } else {
+            obj = lv_label_create(scr, NULL);
+            lv_label_set_text(obj, DISP_BENCH_TXT);
+            lv_obj_set_style_local_text_color(obj, LV_LABEL_PART_MAIN, LV_STATE_DEFAULT,
+                                              lv_color_hex(disp_bench_rnd(&seed, 0, 0xFFFFF0)));
+        }
+        lv_obj_set_x(obj, disp_bench_rnd(&seed, 0, hor - lv_obj_get_width(obj)));
+        start_y[i] = disp_bench_rnd(&seed, 0, ver);
+        speed[i] = disp_bench_rnd(&seed, 2, 8);
+        objs[i] = obj;
+    }
+
+    lv_scr_load(scr);
+    lv_refr_now(disp);      // First frame (screen change) is not measured
+    gui_disp_drain();
+
+    disp_spi_queue_stats_t q0, q1;
+    disp_spi_get_queue_stats(&q0);
+    uint64_t wait0 = gui_disp_wait_us();
+    uint64_t refr_us = 0;
+    int64_t start = esp_timer_get_time();
+    uint32_t frames = disp_bench_frames(disp, scr, objs, start_y, speed, DISP_BENCH_MS, &refr_us);
+    gui_disp_drain();
+
+    int64_t wall_us = esp_timer_get_time() - start;
+    disp_spi_get_queue_stats(&q1);
+    uint64_t wait_us = gui_disp_wait_us() - wait0;
+    uint64_t bus_us = q1.flush_bus_us - q0.flush_bus_us;
+    uint64_t render_us = refr_us > wait_us ? refr_us - wait_us : 0;
+
+    // Time both were busy at once; 100 % means the bus never held up rendering
+    int64_t overlap_us = (int64_t)(render_us + bus_us) - wall_us;
+    if (overlap_us < 0) {
+        overlap_us = 0;
+    }
+    if ((uint64_t)overlap_us > bus_us) {
+        overlap_us = bus_us;
+    }
+
+#if LV_USE_GPU_ESP32_BLEND
+    // Same frames again, blended by lv_draw_blend.c's C code
+    bool kernels = lv_gpu_esp32_blend_is_enabled();
+    uint64_t c_refr_us = 0;
+    uint64_t c_wait0 = gui_disp_wait_us();
+    lv_gpu_esp32_blend_set_enabled(false);
+    uint32_t c_frames = disp_bench_frames(disp, scr, objs, start_y, speed, DISP_BENCH_C_MS, &c_refr_us);
+    gui_disp_drain();
+    lv_gpu_esp32_blend_set_enabled(kernels);
+    uint64_t c_wait_us = gui_disp_wait_us() - c_wait0;
+    uint64_t c_render_us = c_refr_us > c_wait_us ? c_refr_us - c_wait_us : 0;
+#endif
+
+    lv_scr_load(prev_scr);
+    lv_obj_del(scr);
+
+#if CONFIG_LVGL_DISP_FLUSH_WORKER
+    disp_pipeline_stats_t p;
+    disp_pipeline_get_stats(&p);
+    printf("  Buffers:          %u x %u lines, flush worker on core %d\n",
+           p.buffers, (unsigned)(p.buf_px / LV_HOR_RES_MAX), GUI_FLUSH_CORE);
+#else
+    printf("  Buffers:          2 x %u lines, flushed from the GUI task\n",
+           (unsigned)(DISP_BUF_SIZE / LV_HOR_RES_MAX));
+#endif
+    if (frames == 0 || bus_us == 0) {
+        printf("  No frames were flushed\n");
+        return;
+    }
+    printf("  Frames:           %lu in %.1f s = %.1f FPS\n",
+           (unsigned long)frames, wall_us / 1e6f, frames * 1e6f / wall_us);
+#if LV_USE_GPU_ESP32_BLEND
+    printf("  Render:           %.2f ms/frame (LVGL drawing, blend kernels %s)\n",
+           render_us / 1000.0f / frames, kernels ? "on" : "off");
+    if (c_frames > 0) {
+        printf("  Render, C blend:  %.2f ms/frame (%lu frames)\n",
+               c_render_us / 1000.0f / c_frames, (unsigned long)c_frames);
+    }
+#else
+    printf("  Render:           %.2f ms/frame (LVGL drawing)\n", render_us / 1000.0f / frames);
+#endif
+    printf("  SPI flush:        %.2f ms/frame on the bus\n", bus_us / 1000.0f / frames);
+    printf("  Waited for panel: %.2f ms/frame\n", wait_us / 1000.0f / frames);
+    printf("  Overlap:          %.0f %% of the flush time hidden behind rendering\n",
+           100.0f * overlap_us / bus_us);
+}
+
+// Serial menu: run the benchmark in the GUI task and wait for its report
+void display_benchmark(void)
+{
+    if (disp_bench_done == NULL) {
+        printf("  GUI not running\n");
+        return;
+    }
+    printf("  Drawing for %d s, results follow...\n\n", (DISP_BENCH_MS + DISP_BENCH_C_MS) / 1000);
+    xSemaphoreTake(disp_bench_done, 0);
+    disp_bench_requested = true;
+    gui_wake();
+    if (xSemaphoreTake(disp_bench_done, pdMS_TO_TICKS(DISP_BENCH_MS + DISP_BENCH_C_MS + 5000)) != pdTRUE) {
+        printf("  Benchmark did not finish\n");
+    }
+}
+
+// LVGL render profile ([k] serial menu): each tab of the UI redrawn full
+// screen for RENDER_PROFILE_SCENE_MS, with LVGL's tasks run between frames so
+// the clock and the Level bars keep moving. Prints the render time per frame
+// as "S <scene> <frames> <ms/frame>" lines; tools/lvgl_iram_place.py compares
+// two such reports, from builds with and without the IRAM placement. A
+// CONFIG_LVGL_CODE_PLACEMENT_PROFILE build also prints the cycles of every
+// LVGL function, from which the tool writes the placement (lvgl_iram.lf).
+#define RENDER_PROFILE_SCENE_MS     3000
+
+static const char *const render_profile_scenes[] = {"start", "level", "info"};
+
+static volatile bool render_profile_requested = false;
+static SemaphoreHandle_t render_profile_done = NULL;
+
+static void render_profile_run(void)
+{
+    lv_disp_t *disp = lv_disp_get_default();
+    uint16_t prev_tab = lv_tabview_get_tab_act(main_tabview);
+    size_t scenes = sizeof(render_profile_scenes) / sizeof(render_profile_scenes[0]);
+
+#if CONFIG_LVGL_CODE_PLACEMENT_PROFILE
+    printf("  LVGL code: flash, instrumented (frames are slower than in a normal build)\n");
+    bool profiling = lvgl_profile_start();
+    if (!profiling) {
+        printf("  No memory for the function counters\n");
+    }
+#elif CONFIG_LVGL_CODE_PLACEMENT_IRAM
+    printf("  LVGL code: IRAM placement (lvgl_iram.lf)\n");
+#else
+    printf("  LVGL code: flash\n");
+#endif
+    printf("  Scene     frames  render ms/frame\n");
+
+    for (size_t n = 0; n < scenes && n < lv_tabview_get_tab_count(main_tabview); n++) {
+        lv_tabview_set_tab_act(main_tabview, n, LV_ANIM_OFF);
+        lv_event_send(main_tabview, LV_EVENT_VALUE_CHANGED, NULL);
+        lv_refr_now(disp);      // Tab change is not measured
+        gui_disp_drain();
+
+        uint64_t wait0 = gui_disp_wait_us();
+        uint64_t refr_us = 0;
+        uint32_t frames = 0;
+        int64_t start = esp_timer_get_time();
+
+        while (esp_timer_get_time() - start < RENDER_PROFILE_SCENE_MS * 1000LL) {
+            lv_task_handler();
+            lv_obj_invalidate(lv_scr_act());
+
+            int64_t t0 = esp_timer_get_time();
+            lv_refr_now(disp);
+            refr_us += esp_timer_get_time() - t0;
+            frames++;
+        }
+        gui_disp_drain();
+
+        uint64_t wait_us = gui_disp_wait_us() - wait0;
+        uint64_t render_us = refr_us > wait_us ? refr_us - wait_us : 0;
+        printf("S %-8s %6lu %8.2f\n", render_profile_scenes[n], (unsigned long)frames,
+               frames ? render_us / 1000.0f / frames : 0.0f);
+    }
+
+#if CONFIG_LVGL_CODE_PLACEMENT_PROFILE
+    lvgl_profile_stop();
+    if (profiling) {
+        lvgl_profile_stats_t stats;
+        lvgl_profile_get_stats(&stats);
+        printf("  Profiled: %lu LVGL functions, %.1f Mcycles, %lu calls not counted\n",
+               (unsigned long)stats.functions, stats.cycles / 1e6f, (unsigned long)stats.dropped);
+        lvgl_profile_print();
+    }
+#endif
+
+    lv_tabview_set_tab_act(main_tabview, prev_tab, LV_ANIM_OFF);
+    lv_event_send(main_tabview, LV_EVENT_VALUE_CHANGED, NULL);
+}
+
+// Serial menu: run the render profile in the GUI task and wait for its report
+void lvgl_render_profile(void)
+{
+    if (render_profile_done == NULL || main_tabview == NULL) {
+        printf("  GUI not running\n");
+        return;
+    }
+    size_t scenes = sizeof(render_profile_scenes) / sizeof(render_profile_scenes[0]);
+    printf("  Drawing each tab for %d s, results follow...\n\n", RENDER_PROFILE_SCENE_MS / 1000);
+    xSemaphoreTake(render_profile_done, 0);
+    render_profile_requested = true;
+    gui_wake();
+    // Printing the profile takes a few seconds at 115200 baud
+    if (xSemaphoreTake(render_profile_done, pdMS_TO_TICKS(scenes * RENDER_PROFILE_SCENE_MS + 15000)) != pdTRUE) {
+        printf("  Profile did not finish\n");
+    }
+}
+
+// Display power. Without input the backlight dims after gui_dim_s and the
+// panel sleeps after gui_sleep_s (NVS "dim_s" and "sleep_s", 0 = never).
+// While the panel sleeps LVGL does not refresh and the GUI holds no power
+// management lock, so the CPUs run at GUI_PM_MIN_MHZ and light sleep when
+// the sensor, MQTT and WiFi tasks leave a long enough gap. Pen-down (touch
+// IRQ, also a light sleep wakeup source) and the MQTT "wake_display" command
+// light it again.
+#define GUI_DIM_S_DEFAULT   60
+#define GUI_SLEEP_S_DEFAULT 300
+#define GUI_DIM_PERCENT     15          // Backlight while dimmed
+#define GUI_PM_MIN_MHZ      80          // Lowest DFS step that keeps APB (LEDC, UART, I2C, SPI) at 80 MHz
+#define GUI_UART_WAKE_EDGES 3           // RX edges that end light sleep; that character is lost
+
+typedef enum {
+    GUI_POWER_ON,
+    GUI_POWER_DIM,
+    GUI_POWER_SLEEP,
+    GUI_POWER_STATES
+} gui_power_state_t;
+
+typedef enum {
+    GUI_POWER_WAKE_TOUCH,
+    GUI_POWER_WAKE_MQTT,
+    GUI_POWER_WAKE_OTHER,               // Touch seen by polling, display benchmark
+    GUI_POWER_WAKE_SOURCES
+} gui_power_wake_t;
+
+typedef struct {
+    gui_power_state_t state;            // Written by the GUI task only
+    int64_t since_us;                   // Current state entered
+    uint64_t state_us[GUI_POWER_STATES];// Time in each state before that
+    uint32_t wakes[GUI_POWER_WAKE_SOURCES];
+    uint32_t last_wake_us;              // Wake request to lit backlight
+    uint32_t max_wake_us;
+} gui_power_stats_t;
+
+static const char *const gui_power_state_names[GUI_POWER_STATES] = {"on", "dimmed", "asleep"};
+
+static uint16_t gui_dim_s = GUI_DIM_S_DEFAULT;
+static uint16_t gui_sleep_s = GUI_SLEEP_S_DEFAULT;
+static gui_power_stats_t gui_power;
+static portMUX_TYPE gui_power_lock = portMUX_INITIALIZER_UNLOCKED;
+static volatile bool gui_screen_wake_requested = false;
+static int64_t gui_screen_request_us;
+
+#if CONFIG_PM_ENABLE
+static esp_pm_lock_handle_t gui_pm_cpu_lock;      // Full clock while LVGL runs
+static esp_pm_lock_handle_t gui_pm_screen_lock;   // No light sleep while lit: LEDC and SPI DMA stop in it
+#endif
+
+// Load the display dim/sleep timeouts from NVS (also called by the serial menu)
+void load_display_power_settings(void)
+{
+    nvs_handle_t nvs_handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs_handle) == ESP_OK) {
+        uint16_t value = 0;
+        if (nvs_get_u16(nvs_handle, "dim_s", &value) == ESP_OK) {
+            gui_dim_s = value;
+        }
+        if (nvs_get_u16(nvs_handle, "sleep_s", &value) == ESP_OK) {
+            gui_sleep_s = value;
+        }
+        nvs_close(nvs_handle);
+    }
+    ESP_LOGI(TAG, "Display: dim after %u s, sleep after %u s (0 = never)", gui_dim_s, gui_sleep_s);
+    gui_wake();  // Apply the new timeouts now
 }
 
-// Main function
-void app_main() {
-	ESP_LOGI(TAG, "Starting...");
-	
-	// Initialize NVS
-	esp_err_t ret = nvs_flash_init();
-	if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
-		ESP_ERROR_CHECK(nvs_flash_erase());
-		ret = nvs_flash_init();
-	}
-	ESP_ERROR_CHECK(ret);
+// Power management and the light sleep wakeup sources, once the touch IRQ
+// is set up. The display starts lit.
+static void gui_power_init(void)
+{
+    gui_power.since_us = esp_timer_get_time();
 
-	// Initialize serial menu (press 'm' to open)
-	ESP_LOGI(TAG, "Starting serial menu...");
-	serial_menu_init();
+#if CONFIG_PM_ENABLE
+    esp_err_t err = esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "gui_render", &gui_pm_cpu_lock);
+    if (err == ESP_OK) {
+        err = esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "gui_screen", &gui_pm_screen_lock);
+    }
+    if (err == ESP_OK) {
+        err = esp_pm_lock_acquire(gui_pm_screen_lock);
+    }
+    if (err == ESP_OK) {
+        esp_pm_config_t pm_config = {
+            .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+            .min_freq_mhz = GUI_PM_MIN_MHZ,
+            .light_sleep_enable = true,
+        };
+        err = esp_pm_configure(&pm_config);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Power management not enabled: %s", esp_err_to_name(err));
+        return;
+    }
 
-	// Load winter time setting from NVS
-	load_winter_time_setting();
-	
-	// Load dark theme setting from NVS
-	load_dark_theme_setting();
+#ifdef GUI_TOUCH_IRQ_PIN
+    // Switches the pin to a low level interrupt, which the one-shot ISR handles
+    if (touch_indev) {
+        gpio_wakeup_enable(GUI_TOUCH_IRQ_PIN, GPIO_INTR_LOW_LEVEL);
+        esp_sleep_enable_gpio_wakeup();
+    }
+#endif
+    // A key on the serial console wakes too; the menu needs it pressed again
+    uart_set_wakeup_threshold(CONFIG_ESP_CONSOLE_UART_NUM, GUI_UART_WAKE_EDGES);
+    esp_sleep_enable_uart_wakeup(CONFIG_ESP_CONSOLE_UART_NUM);
 
-	// Load accent color setting from NVS
-	load_accent_color_setting();
+    ESP_LOGI(TAG, "Power management: %d-%d MHz, light sleep while the display sleeps",
+             GUI_PM_MIN_MHZ, CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ);
+#endif
+}
 
-	// Load sensor inversion setting from NVS
-	load_sensor_inversion_setting();
-	
-	// Load language setting from NVS
-	load_language_setting();
-	
-	// Load calibration offsets from NVS
-	load_calibration_offsets();
-	
-	// Initialize event loop
-	ESP_ERROR_CHECK(esp_event_loop_create_default());
-	
-	// Initialize I2C
-	ESP_LOGI(TAG, "Initializing I2C...");
-	ESP_ERROR_CHECK(i2c_master_init());
-	
-#if USE_FAKE_SENSOR_DATA
-	// Using fake sensor data for UI testing
-	ESP_LOGI(TAG, "Using FAKE sensor data (MPU6050 disabled)");
-	mpu_mutex = xSemaphoreCreateMutex();
-	xTaskCreatePinnedToCore(fake_sensor_task, "fake_sensor", 2048, NULL, 5, NULL, 0);
+// Refresh task callback while the display sleeps: _lv_inv_area() re-enables
+// the task on every invalidation, this switches it off again without drawing
+static void gui_refr_asleep(lv_task_t *task)
+{
+    lv_task_set_prio(task, LV_TASK_PRIO_OFF);
+}
+
+static void gui_power_enter(gui_power_state_t state)
+{
+    gui_power_state_t from = gui_power.state;
+    lv_disp_t *disp = lv_disp_get_default();
+
+    if (state == from) {
+        return;
+    }
+
+    if (state == GUI_POWER_SLEEP) {
+        // Dark before SLPIN, so the panel blanking is not seen
+        gui_disp_drain();
+        disp_driver_set_brightness(0);
+        disp_driver_sleep(true);
+        // Invalidated areas collect (_lv_inv_area) but are not drawn
+        lv_task_set_cb(disp->refr_task, gui_refr_asleep);
+        lv_task_set_prio(disp->refr_task, LV_TASK_PRIO_OFF);
+#if !USE_FAKE_SENSOR_DATA
+        mpu6050_set_drain_period(MPU6050_DRAIN_SLEEP_MS);
+#endif
+#if CONFIG_PM_ENABLE
+        esp_pm_lock_release(gui_pm_screen_lock);
+#endif
+    } else {
+        if (from == GUI_POWER_SLEEP) {
+#if CONFIG_PM_ENABLE
+            esp_pm_lock_acquire(gui_pm_screen_lock);
+#endif
+            disp_driver_sleep(false);
+#if !USE_FAKE_SENSOR_DATA
+            mpu6050_set_drain_period(MPU6050_DRAIN_PERIOD_MS);
+#endif
+            lv_task_set_cb(disp->refr_task, _lv_disp_refr_task);
+            lv_task_set_prio(disp->refr_task, LV_REFR_TASK_PRIO);  // gui_refr_park() decides again
+            // The panel kept its RAM: only what changed meanwhile is drawn
+            lv_refr_now(disp);
+            gui_disp_drain();
+        }
+        disp_driver_set_brightness(state == GUI_POWER_DIM ? GUI_DIM_PERCENT : 100);
+    }
+
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&gui_power_lock);
+    gui_power.state_us[from] += now - gui_power.since_us;
+    gui_power.since_us = now;
+    gui_power.state = state;
+    portEXIT_CRITICAL(&gui_power_lock);
+    ESP_LOGI(TAG, "Display %s", gui_power_state_names[state]);
+}
+
+// Light the display; request_us is when the wake was asked for (IRQ, MQTT)
+static void gui_power_wake(gui_power_wake_t source, int64_t request_us)
+{
+    bool was_asleep = gui_power.state == GUI_POWER_SLEEP;
+
+    lv_disp_trig_activity(NULL);
+    gui_power_enter(GUI_POWER_ON);
+    if (!was_asleep) {
+        return;
+    }
+
+    uint32_t wake_us = (uint32_t)(esp_timer_get_time() - request_us);
+    portENTER_CRITICAL(&gui_power_lock);
+    gui_power.wakes[source]++;
+    gui_power.last_wake_us = wake_us;
+    if (wake_us > gui_power.max_wake_us) {
+        gui_power.max_wake_us = wake_us;
+    }
+    portEXIT_CRITICAL(&gui_power_lock);
+}
+
+// After lv_task_handler: follow LVGL's inactivity time. The GUI task wakes
+// at least every GUI_MAX_SLEEP_MS, which bounds how late a timeout is seen.
+static void gui_power_update(int64_t wake_us)
+{
+    uint32_t inactive_ms = lv_disp_get_inactive_time(NULL);
+    gui_power_state_t state = GUI_POWER_ON;
+
+    if (gui_sleep_s && inactive_ms >= gui_sleep_s * 1000u) {
+        state = GUI_POWER_SLEEP;
+    } else if (gui_dim_s && inactive_ms >= gui_dim_s * 1000u) {
+        state = GUI_POWER_DIM;
+    }
+
+    if (state == GUI_POWER_ON && gui_power.state == GUI_POWER_SLEEP) {
+        gui_power_wake(GUI_POWER_WAKE_OTHER, wake_us);  // Input without the IRQ
+    } else {
+        gui_power_enter(state);
+    }
+}
+
+// Light the display from another task (MQTT "wake_display")
+void gui_display_wake(void)
+{
+    gui_screen_request_us = esp_timer_get_time();
+    gui_screen_wake_requested = true;
+    gui_wake();
+}
+
+// Serial menu: display state, time per state and wakes since boot
+void gui_power_report(void)
+{
+    portENTER_CRITICAL(&gui_power_lock);
+    gui_power_stats_t p = gui_power;
+    portEXIT_CRITICAL(&gui_power_lock);
+
+    int64_t in_state_us = esp_timer_get_time() - p.since_us;
+    p.state_us[p.state] += in_state_us;
+
+    printf("  Display:          %s for %.0f s (dim after %u s, sleep after %u s, 0 = never)\n",
+           gui_power_state_names[p.state], in_state_us / 1e6f, gui_dim_s, gui_sleep_s);
+    printf("  Since boot:       %.0f s on, %.0f s dimmed, %.0f s asleep\n",
+           p.state_us[GUI_POWER_ON] / 1e6f, p.state_us[GUI_POWER_DIM] / 1e6f,
+           p.state_us[GUI_POWER_SLEEP] / 1e6f);
+    printf("  Woken by:         %lu touch, %lu MQTT, %lu other\n",
+           (unsigned long)p.wakes[GUI_POWER_WAKE_TOUCH], (unsigned long)p.wakes[GUI_POWER_WAKE_MQTT],
+           (unsigned long)p.wakes[GUI_POWER_WAKE_OTHER]);
+    if (p.max_wake_us > 0) {
+        printf("  Wake latency:     %.1f ms last, %.1f ms max (request to lit backlight)\n",
+               p.last_wake_us / 1000.0f, p.max_wake_us / 1000.0f);
+    }
+#if CONFIG_PM_ENABLE
+    printf("  CPU clock:        %d-%d MHz, light sleep %s\n", GUI_PM_MIN_MHZ,
+           CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+           p.state == GUI_POWER_SLEEP ? "allowed" : "held off while lit");
 #else
-	// Initialize real MPU6050
-	ESP_LOGI(TAG, "Initializing MPU6050...");
-	if (mpu6050_init() == ESP_OK) {
-		// Create mutex for MPU data
-		mpu_mutex = xSemaphoreCreateMutex();
-		
-		// Start MPU6050 reading task - pinned to Core 0 to avoid blocking display
-		xTaskCreatePinnedToCore(mpu6050_read_task, "mpu6050_read", 4096, NULL, 5, NULL, 0);
-		ESP_LOGI(TAG, "MPU6050 task started on Core 0");
-	} else {
-		ESP_LOGW(TAG, "MPU6050 initialization failed, continuing without sensor");
-	}
+    printf("  CPU clock:        %d MHz fixed (CONFIG_PM_ENABLE is off)\n", CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ);
 #endif
-	
-	// Initialize WiFi with power save mode
-	ESP_LOGI(TAG, "Starting WiFi...");
-	wifi_init_sta();
-	
-	// Wait for WiFi connection before starting MQTT
-	ESP_LOGI(TAG, "Waiting for WiFi connection...");
-	xEventGroupWaitBits(s_wifi_event_group, WIFI_CONNECTED_BIT, pdFALSE, pdTRUE, portMAX_DELAY);
-	
-	// Initialize MQTT client
-	ESP_LOGI(TAG, "WiFi connected, initializing MQTT...");
-	mqtt_init();
+}
 
-	// Start MQTT sensor logging task (publishes pitch/roll every second)
-	ESP_LOGI(TAG, "Starting MQTT sensor logging task...");
-	xTaskCreatePinnedToCore(mqtt_sensor_log_task, "mqtt_sensor_log", 3072, NULL, 5, NULL, 0);
+// Display SPI clock. With CONFIG_LVGL_DISP_SPI_CLOCK_TUNE it is picked by
+// writing test patterns and reading them back (disp_driver_tune_clock), and
+// cached in NVS so a normal boot only checks the cached clock. The fastest
+// clock that passed is checked again every GUI_SPI_CHECK_MS; when it fails
+// the clock is tuned again.
+#define GUI_SPI_CHECK_MS    (10 * 60 * 1000)
 
-	// Initialize SD card (optional - continues if card not present)
-	// TEMPORARILY DISABLED - May conflict with display SPI
-	// ESP_LOGI(TAG, "Checking for SD card...");
-	// ret = init_sd_card();
-	// if (ret == ESP_OK) {
-	// 	ESP_LOGI(TAG, "SD card is accessible and ready");
-	// } else {
-	// 	ESP_LOGW(TAG, "SD card not available (insert card and restart if needed)");
-	// }
-	
-	vTaskDelay(1000 / portTICK_PERIOD_MS);
-	// GUI task pinned to Core 1 - keeps display smooth while Core 0 handles I2C
-	xTaskCreatePinnedToCore(guiTask, "gui", 4096*2, NULL, 0, NULL, 1);
+static lv_obj_t *spi_clock_label = NULL;
+
+#if CONFIG_LVGL_DISP_SPI_CLOCK_TUNE
+static disp_panel_clock_t spi_clock;
+
+static bool load_spi_clock_setting(disp_panel_clock_t *clock)
+{
+    nvs_handle_t nvs_handle;
+    uint32_t hz = 0;
+    uint32_t passed_hz = 0;
+
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs_handle) != ESP_OK) {
+        return false;
+    }
+    esp_err_t err = nvs_get_u32(nvs_handle, "spi_hz", &hz);
+    if (err == ESP_OK) {
+        err = nvs_get_u32(nvs_handle, "spi_pass_hz", &passed_hz);
+    }
+    nvs_close(nvs_handle);
+
+    // Tuned with another limit: tune again
+    if (err != ESP_OK || hz == 0 || passed_hz < hz ||
+        passed_hz > CONFIG_LVGL_DISP_SPI_CLOCK_TUNE_MAX_MHZ * 1000000u) {
+        return false;
+    }
+
+    clock->clock_hz = hz;
+    clock->passed_hz = passed_hz;
+    clock->margin_pct = 100 - (uint8_t)((uint64_t)hz * 100 / passed_hz);
+    clock->verified = true;
+    return true;
+}
+
+static void save_spi_clock_setting(const disp_panel_clock_t *clock)
+{
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (err == ESP_OK) {
+        err = nvs_set_u32(nvs_handle, "spi_hz", clock->clock_hz);
+        if (err == ESP_OK) {
+            err = nvs_set_u32(nvs_handle, "spi_pass_hz", clock->passed_hz);
+        }
+        if (err == ESP_OK) {
+            err = nvs_commit(nvs_handle);
+            if (err == ESP_OK) {
+                ESP_LOGI(TAG, "Saved display SPI clock: %d Hz", clock->clock_hz);
+            }
+        }
+        nvs_close(nvs_handle);
+    }
 }
 
-static void lv_tick_task(void *arg) {
-    (void) arg;
-    lv_tick_inc(LV_TICK_PERIOD_MS);
+// Before the first refresh, so the test rows are drawn over anyway
+static void gui_spi_clock_init(void)
+{
+    if (load_spi_clock_setting(&spi_clock) &&
+        disp_driver_check_clock(&spi_clock, DISP_PANEL_TUNE_ROWS)) {
+        ESP_LOGI(TAG, "Display SPI clock: %d Hz (cached, %d Hz passed)",
+                 spi_clock.clock_hz, spi_clock.passed_hz);
+        return;
+    }
+
+    if (disp_driver_tune_clock(&spi_clock)) {
+        save_spi_clock_setting(&spi_clock);
+    }
 }
+#endif
 
-//Creates a semaphore to handle concurrent call to lvgl stuff
-//If you wish to call *any* lvgl function from other threads/tasks
-//you should lock on the very same semaphore!
-SemaphoreHandle_t xGuiSemaphore;		// 创建一个GUI信号量
-static bool perf_monitor_hidden = false;	// Flag to track if we've hidden the perf monitor
+static void spi_clock_text(char *buf, size_t size)
+{
+#if CONFIG_LVGL_DISP_SPI_CLOCK_TUNE
+    if (spi_clock.verified) {
+        snprintf(buf, size, "Display SPI: %.1f MHz\n(%.1f MHz passed, %u%% margin)",
+                 spi_clock.clock_hz / 1e6f, spi_clock.passed_hz / 1e6f, spi_clock.margin_pct);
+        return;
+    }
+    snprintf(buf, size, "Display SPI: %.1f MHz\n(no read back)", disp_spi_get_clock_speed() / 1e6f);
+#else
+    snprintf(buf, size, "Display SPI: %.1f MHz", disp_spi_get_clock_speed() / 1e6f);
+#endif
+}
+
+#if CONFIG_LVGL_DISP_SPI_CLOCK_TUNE
+static void spi_clock_check_task(lv_task_t *task)
+{
+    (void)task;
+
+    if (gui_power.state == GUI_POWER_SLEEP) {
+        return;  // Next period; the sleeping panel would only be woken for it
+    }
+    gui_disp_drain();
+    if (!disp_driver_check_clock(&spi_clock, DISP_PANEL_CHECK_ROWS)) {
+        ESP_LOGW(TAG, "Display SPI: %d Hz failed the check, tuning again", spi_clock.passed_hz);
+        if (disp_driver_tune_clock(&spi_clock)) {
+            save_spi_clock_setting(&spi_clock);
+        }
+        if (spi_clock_label) {
+            char text[80];
+            spi_clock_text(text, sizeof(text));
+            lv_label_set_text(spi_clock_label, text);
+        }
+    }
+
+    // The test rows hold the pattern now
+    lv_area_t rows = {0, 0, LV_HOR_RES_MAX - 1, DISP_PANEL_TUNE_ROWS - 1};
+    _lv_inv_area(NULL, &rows);
+}
+#endif
 
 // Custom formatter for clock hour labels (unused - kept for reference)
 // Gauge places labels at values 0,5,10,15,20,25,30,35,40,45,50,55
@@ -1460,26 +3782,69 @@ static int16_t map_angle_to_bar(float angle)
 	return (int16_t)(sign * mapped);
 }
 
+// Show a pitch or roll angle: only the value's changed digits are redrawn
+static void level_readout_set(lv_obj_t *label, lv_obj_t *value, const char *name, float deg)
+{
+	char text[32];
+	if (value) {
+		snprintf(text, sizeof(text), "%.1f°", deg);
+		digit_sprite_set_text(value, text);
+	} else {
+		snprintf(text, sizeof(text), "%s: %.1f°", name, deg);
+		lv_label_set_text(label, text);
+	}
+}
+
+// Centre a readout (name label + digit sprite) under its bar
+static void level_readout_align(lv_obj_t *label, lv_obj_t *value, lv_obj_t *bar)
+{
+	lv_obj_align(label, bar, LV_ALIGN_OUT_BOTTOM_MID, -level_readout_shift, 3);
+	if (value) {
+		lv_obj_align(value, label, LV_ALIGN_OUT_RIGHT_MID, 4, 0);
+	}
+}
+
+// Readout names in the current language
+static void level_readout_relabel(void)
+{
+	if (!pitch_label || !roll_label) {
+		return;
+	}
+	if (!pitch_value) {
+		// Plain labels carry name and value: rewrite both on the next update
+		prev_pitch_mapped = prev_roll_mapped = INT16_MIN;
+		return;
+	}
+	char text[32];
+	snprintf(text, sizeof(text), "%s:", STR_PITCH[current_language]);
+	lv_label_set_text(pitch_label, text);
+	snprintf(text, sizeof(text), "%s:", STR_ROLL[current_language]);
+	lv_label_set_text(roll_label, text);
+
+	// The names differ in width per language, so centre both readouts again
+	// (the shift itself only depends on the value sprite)
+	level_readout_shift = (lv_obj_get_width(pitch_value) + 4) / 2;
+	level_readout_align(pitch_label, pitch_value, pitch_bar);
+	level_readout_align(roll_label, roll_value, roll_bar);
+}
+
 // Level menu update task - updates bars with logarithmic mapping
 static void level_menu_update_task(lv_task_t *task)
 {
 	(void)task;
 	
-	// Check if UI and mutex are ready
-	if (!pitch_bar || !roll_bar || !pitch_label || !roll_label || !mpu_mutex) {
+	// Check if UI is ready
+	if (!pitch_bar || !roll_bar || !pitch_label || !roll_label) {
 		return;  // Not ready yet
 	}
 	
-	float pitch, roll;
-	
-	// Get current values with mutex
-	if (xSemaphoreTake(mpu_mutex, 10 / portTICK_PERIOD_MS)) {
-		pitch = current_pitch;
-		roll = current_roll;
-		xSemaphoreGive(mpu_mutex);
-	} else {
-		return;  // Couldn't get mutex, skip this update
+	// Get current values (lock-free, never blocks the GUI)
+	sensor_snapshot_t snap;
+	if (!sensor_snapshot_read(&snap)) {
+		return;  // No sensor data yet
 	}
+	float pitch = snap.pitch;
+	float roll = snap.roll;
 	
 	// Apply sensor inversion if enabled (for backward-mounted sensor)
 	if (sensor_inverted) {
@@ -1502,9 +3867,7 @@ static void level_menu_update_task(lv_task_t *task)
 		lv_bar_set_start_value(pitch_bar, pitch_mapped - 2, LV_ANIM_OFF);
 		lv_bar_set_value(pitch_bar, pitch_mapped + 2, LV_ANIM_OFF);
 		
-		char pitch_text[32];
-		snprintf(pitch_text, sizeof(pitch_text), "%s: %.1f°", STR_PITCH[current_language], pitch);
-		lv_label_set_text(pitch_label, pitch_text);
+		level_readout_set(pitch_label, pitch_value, STR_PITCH[current_language], pitch);
 		
 		prev_pitch_mapped = pitch_mapped;
 	}
@@ -1513,9 +3876,7 @@ static void level_menu_update_task(lv_task_t *task)
 		lv_bar_set_start_value(roll_bar, roll_mapped - 2, LV_ANIM_OFF);
 		lv_bar_set_value(roll_bar, roll_mapped + 2, LV_ANIM_OFF);
 		
-		char roll_text[32];
-		snprintf(roll_text, sizeof(roll_text), "%s: %.1f°", STR_ROLL[current_language], roll);
-		lv_label_set_text(roll_label, roll_text);
+		level_readout_set(roll_label, roll_value, STR_ROLL[current_language], roll);
 		
 		prev_roll_mapped = roll_mapped;
 	}
@@ -1524,17 +3885,31 @@ static void level_menu_update_task(lv_task_t *task)
 void guiTask(void *pvParameter) {
     
     (void) pvParameter;
+    gui_task_handle = xTaskGetCurrentTaskHandle();
     xGuiSemaphore = xSemaphoreCreateMutex();    // 创建GUI信号量
     lv_init();          // 初始化LittlevGL
     lvgl_driver_init(); // 初始化液晶SPI驱动 触摸芯片SPI/IIC驱动
+#if CONFIG_LVGL_DISP_SPI_CLOCK_TUNE
+    gui_spi_clock_init();
+#endif
+
+    static lv_disp_buf_t disp_buf;
+
+    uint32_t size_in_px = DISP_BUF_SIZE;
 
+#if CONFIG_LVGL_DISP_FLUSH_WORKER
+    // Ring of CONFIG_LVGL_DISP_BUF_COUNT stripes: LVGL renders on this core
+    // while the worker sends finished stripes from the other one
+    if (disp_pipeline_init(&disp_buf, CONFIG_LVGL_DISP_BUF_COUNT, size_in_px,
+                           GUI_FLUSH_CORE, GUI_FLUSH_PRIO) == 0) {
+        ESP_LOGE(TAG, "No RAM for the display buffers, GUI not started");
+        vTaskDelete(NULL);
+    }
+#else
     static lv_color_t buf1[DISP_BUF_SIZE];
 #ifndef CONFIG_LVGL_TFT_DISPLAY_MONOCHROME
     static lv_color_t buf2[DISP_BUF_SIZE];
 #endif
-    static lv_disp_buf_t disp_buf;
-
-    uint32_t size_in_px = DISP_BUF_SIZE;
 
 #if defined CONFIG_LVGL_TFT_DISPLAY_CONTROLLER_IL3820 
     /* Actual size in pixel, not bytes and use single buffer */
@@ -1544,11 +3919,18 @@ void guiTask(void *pvParameter) {
     lv_disp_buf_init(&disp_buf, buf1, NULL, size_in_px);
 #else
     lv_disp_buf_init(&disp_buf, buf1, buf2, size_in_px);
+#endif
 #endif
 
     lv_disp_drv_t disp_drv;
     lv_disp_drv_init(&disp_drv);
+#if CONFIG_LVGL_DISP_FLUSH_WORKER
+    disp_drv.flush_cb = disp_pipeline_flush;
+#else
     disp_drv.flush_cb = disp_driver_flush;
+#endif
+    disp_drv.wait_cb = disp_driver_wait_cb;         // Sleep instead of spinning on a busy bus
+    disp_drv.monitor_cb = gui_frame_monitor_cb;     // Flush wait per frame ([g] serial menu)
 
 // 如果配置为 单色模式
 #ifdef CONFIG_LVGL_TFT_DISPLAY_MONOCHROME
@@ -1558,6 +3940,9 @@ void guiTask(void *pvParameter) {
 
     disp_drv.buffer = &disp_buf;
     lv_disp_drv_register(&disp_drv);
+    disp_spi_set_flush_done_cb(gui_flush_done_isr);
+    disp_bench_done = xSemaphoreCreateBinary();
+    render_profile_done = xSemaphoreCreateBinary();
 
 
 // 如果有配置触摸芯片，配置触摸
@@ -1566,17 +3951,18 @@ void guiTask(void *pvParameter) {
     lv_indev_drv_init(&indev_drv);
     indev_drv.read_cb = touch_driver_read;
     indev_drv.type = LV_INDEV_TYPE_POINTER;
-    lv_indev_drv_register(&indev_drv);
+    lv_indev_t *indev = lv_indev_drv_register(&indev_drv);
+#ifdef GUI_TOUCH_IRQ_PIN
+    if (gui_touch_irq_init()) {
+        touch_indev = indev;  // Polling may be parked
+    }
+#else
+    (void)indev;
 #endif
+#endif
+    gui_power_init();
 
-
-    const esp_timer_create_args_t periodic_timer_args = {
-        .callback = &lv_tick_task,
-        .name = "periodic_gui"
-    };
-    esp_timer_handle_t periodic_timer;
-    ESP_ERROR_CHECK(esp_timer_create(&periodic_timer_args, &periodic_timer));
-    ESP_ERROR_CHECK(esp_timer_start_periodic(periodic_timer, LV_TICK_PERIOD_MS * 1000));
+    // LVGL time comes from esp_timer (LV_TICK_CUSTOM), no tick timer needed
 
     // 一个标签演示
     //lv_obj_t * scr = lv_disp_get_scr_act(NULL);         // 获取当前屏幕
@@ -1595,6 +3981,8 @@ void guiTask(void *pvParameter) {
 	lv_obj_t *tab_start = lv_tabview_add_tab(tv, STR_TAB_START[current_language]);
 	lv_obj_t *tab_level = lv_tabview_add_tab(tv, STR_TAB_LEVEL[current_language]);
 	lv_obj_t *tab_info = lv_tabview_add_tab(tv, STR_TAB_INFO[current_language]);
+	lv_obj_set_event_cb(tv, main_tabview_cb);
+	main_tabview = tv;
 	
 	// Make Start and Level tabs non-scrollable
 	lv_page_set_scrl_layout(tab_start, LV_LAYOUT_OFF);
@@ -1618,7 +4006,13 @@ void guiTask(void *pvParameter) {
 	lv_task_create(clock_update_task, 1000, LV_TASK_PRIO_LOW, NULL);
 	
 	// Create Level menu update task (100ms = 10Hz, sufficient for level display)
-	lv_task_create(level_menu_update_task, 100, LV_TASK_PRIO_MID, NULL);
+	// Runs only while the Level tab is shown (main_tabview_cb)
+	level_task = lv_task_create(level_menu_update_task, 100, LV_TASK_PRIO_OFF, NULL);
+
+#if CONFIG_LVGL_DISP_SPI_CLOCK_TUNE
+	// Check the display SPI clock still reads back intact
+	lv_task_create(spi_clock_check_task, GUI_SPI_CHECK_MS, LV_TASK_PRIO_LOWEST, NULL);
+#endif
 	
 	// Add content to Level tab
 	// Create Pitch bar (vertical, centered top)
@@ -1634,12 +4028,38 @@ void guiTask(void *pvParameter) {
 	char pitch_initial[32];
 	snprintf(pitch_initial, sizeof(pitch_initial), "%s: 0°", STR_PITCH[current_language]);
 	lv_label_set_text(pitch_label, pitch_initial);
-	lv_obj_align(pitch_label, pitch_bar, LV_ALIGN_OUT_BOTTOM_MID, 0, 3);
+	
+	// Pitch and roll values from pre-rendered digits in the label's font and
+	// colours; the labels then only show the names
+	lv_color_t level_fg, level_bg;
+	digit_atlas_colors_of(pitch_label, &level_fg, &level_bg);
+	level_atlas = digit_atlas_create(lv_obj_get_style_text_font(pitch_label, LV_LABEL_PART_MAIN),
+	                                 "0123456789-.°", level_fg, level_bg);
+	if (level_atlas) {
+		pitch_value = digit_sprite_create(tab_level, level_atlas, 6);  // "-30.0°"
+		roll_value = digit_sprite_create(tab_level, level_atlas, 6);
+	}
+	level_readout_shift = 0;
+	if (pitch_value && roll_value) {
+		digit_sprite_set_text(pitch_value, "0.0°");
+		digit_sprite_set_text(roll_value, "0.0°");
+		snprintf(pitch_initial, sizeof(pitch_initial), "%s:", STR_PITCH[current_language]);
+		lv_label_set_text(pitch_label, pitch_initial);
+		level_readout_shift = (lv_obj_get_width(pitch_value) + 4) / 2;
+	} else if (level_atlas) {
+		// Out of memory: plain labels for both
+		if (pitch_value) lv_obj_del(pitch_value);
+		if (roll_value) lv_obj_del(roll_value);
+		pitch_value = roll_value = NULL;
+		digit_atlas_destroy(level_atlas);
+		level_atlas = NULL;
+	}
+	level_readout_align(pitch_label, pitch_value, pitch_bar);
 	
 	// Create Roll bar (horizontal, centered below pitch)
 	roll_bar = lv_bar_create(tab_level, NULL);
 	lv_obj_set_size(roll_bar, 120, 15);  // Horizontal: 120px wide, 15px high
-	lv_obj_align(roll_bar, pitch_label, LV_ALIGN_OUT_BOTTOM_MID, 0, 10);
+	lv_obj_align(roll_bar, pitch_label, LV_ALIGN_OUT_BOTTOM_MID, level_readout_shift, 10);
 	lv_bar_set_range(roll_bar, -30, 30);  // +/- 30 degrees max
 	lv_bar_set_start_value(roll_bar, -2, LV_ANIM_OFF);  // Thicker indicator line
 	lv_bar_set_value(roll_bar, 2, LV_ANIM_OFF);
@@ -1647,9 +4067,9 @@ void guiTask(void *pvParameter) {
 	// Roll label
 	roll_label = lv_label_create(tab_level, NULL);
 	char roll_initial[32];
-	snprintf(roll_initial, sizeof(roll_initial), "%s: 0°", STR_ROLL[current_language]);
+	snprintf(roll_initial, sizeof(roll_initial), roll_value ? "%s:" : "%s: 0°", STR_ROLL[current_language]);
 	lv_label_set_text(roll_label, roll_initial);
-	lv_obj_align(roll_label, roll_bar, LV_ALIGN_OUT_BOTTOM_MID, 0, 3);
+	level_readout_align(roll_label, roll_value, roll_bar);
 	
 	// Add Calibrate button (far left of screen, vertically centered with pitch bar)
 	lv_obj_t *btn_calibrate = lv_btn_create(tab_level, NULL);
@@ -1718,11 +4138,19 @@ void guiTask(void *pvParameter) {
 	lv_label_set_text(wifi_label, wifi_status);
 	lv_obj_align(wifi_label, label_info, LV_ALIGN_OUT_BOTTOM_MID, 0, 20);
 	
+	// Add display SPI clock (tuned rate and margin)
+	spi_clock_label = lv_label_create(tab_info, NULL);
+	char spi_status[80];
+	spi_clock_text(spi_status, sizeof(spi_status));
+	lv_label_set_text(spi_clock_label, spi_status);
+	lv_label_set_align(spi_clock_label, LV_LABEL_ALIGN_CENTER);
+	lv_obj_align(spi_clock_label, wifi_label, LV_ALIGN_OUT_BOTTOM_MID, 0, 10);
+	
 	// Add timezone selector
 	lv_obj_t *tz_cont = lv_cont_create(tab_info, NULL);
 	lv_cont_set_layout(tz_cont, LV_LAYOUT_ROW_MID);
 	lv_obj_set_width(tz_cont, lv_obj_get_width(tab_info) - 20);
-	lv_obj_align(tz_cont, wifi_label, LV_ALIGN_OUT_BOTTOM_MID, 0, 20);
+	lv_obj_align(tz_cont, spi_clock_label, LV_ALIGN_OUT_BOTTOM_MID, 0, 20);
 	
 	tz_label = lv_label_create(tz_cont, NULL);
 	lv_label_set_text(tz_label, STR_TIMEZONE[current_language]);
@@ -1844,11 +4272,63 @@ void guiTask(void *pvParameter) {
 	}
 	lv_obj_set_event_cb(lang_switch, language_toggle_cb);
 
+    uint32_t sleep_ms = 0;
+    gui_stats.since_us = esp_timer_get_time();
     while (1) {
-		vTaskDelay(1);
+        uint32_t events = 0;
+        int64_t wait_start = esp_timer_get_time();
+        if (gui_loop_polling) {
+            vTaskDelay(1);
+        } else {
+            xTaskNotifyWait(0, UINT32_MAX, &events, gui_sleep_ticks(sleep_ms));
+        }
+        int64_t wake = esp_timer_get_time();
+        gui_flush_wake_armed = false;
+
 		// 尝试锁定信号量，如果成功，请调用lvgl的东西
 		if (xSemaphoreTake(xGuiSemaphore, (TickType_t)10) == pdTRUE) {
-            lv_task_handler();
+#if CONFIG_PM_ENABLE
+            // Full clock while LVGL runs; between wakeups DFS may lower it
+            esp_pm_lock_acquire(gui_pm_cpu_lock);
+#endif
+            if (events & GUI_WAKE_TOUCH) {
+#ifdef GUI_TOUCH_IRQ_PIN
+                if (gui_power.state == GUI_POWER_SLEEP) {
+                    // The touch that lights the display presses nothing
+                    lv_indev_wait_release(touch_indev);
+                    gui_power_wake(GUI_POWER_WAKE_TOUCH, gui_touch_irq_us);
+                }
+#endif
+                gui_touch_resume();
+            }
+            if (events & GUI_WAKE_FLUSH) {
+                lv_task_ready(lv_disp_get_default()->refr_task);
+            }
+            if (gui_screen_wake_requested) {
+                gui_screen_wake_requested = false;
+                gui_power_wake(GUI_POWER_WAKE_MQTT, gui_screen_request_us);
+            }
+            if (disp_bench_requested) {
+                disp_bench_requested = false;
+                gui_power_wake(GUI_POWER_WAKE_OTHER, wake);
+                display_benchmark_run();
+                xSemaphoreGive(disp_bench_done);
+            }
+            if (render_profile_requested) {
+                render_profile_requested = false;
+                gui_power_wake(GUI_POWER_WAKE_OTHER, wake);
+                render_profile_run();
+                xSemaphoreGive(render_profile_done);
+            }
+
+            int64_t handler_start = esp_timer_get_time();
+            sleep_ms = lv_task_handler();
+            int64_t handler_us = esp_timer_get_time() - handler_start;
+
+            gui_power_update(wake);
+            gui_touch_park();
+            gui_refr_park();
+            sleep_ms = gui_flush_wake_arm(sleep_ms);
             
             // Hide performance monitor on first render (it's created by LVGL after first refresh)
             if (!perf_monitor_hidden) {
@@ -1862,8 +4342,34 @@ void guiTask(void *pvParameter) {
                 }
             }
             
+#if CONFIG_PM_ENABLE
+            esp_pm_lock_release(gui_pm_cpu_lock);
+#endif
             xSemaphoreGive(xGuiSemaphore);  // 释放信号量
+
+            portENTER_CRITICAL(&gui_stats_lock);
+            gui_stats.handler_us += handler_us;
+            portEXIT_CRITICAL(&gui_stats_lock);
+        } else {
+            sleep_ms = 1;  // Held by another task, which calls gui_wake() when done
+        }
+
+        portENTER_CRITICAL(&gui_stats_lock);
+        gui_stats.wakeups++;
+        gui_stats.idle_us += wake - wait_start;
+        if (events == 0) {
+            gui_stats.deadlines++;
+        }
+        if (events & GUI_WAKE_REQUEST) {
+            gui_stats.requests++;
+        }
+        if (events & GUI_WAKE_TOUCH) {
+            gui_stats.touches++;
+        }
+        if (events & GUI_WAKE_FLUSH) {
+            gui_stats.flushes++;
         }
+        portEXIT_CRITICAL(&gui_stats_lock);
     }
     vTaskDelete(NULL);      // 删除任务
 }
@@ -1928,6 +4434,7 @@ static void dark_theme_toggle_cb(lv_obj_t *sw, lv_event_t e)
                                                  LV_THEME_DEFAULT_FONT_SUBTITLE,
                                                  LV_THEME_DEFAULT_FONT_TITLE);
         lv_theme_set_act(th);
+        refresh_theme_caches();
         ESP_LOGI(TAG, "Theme changed to %s", dark_theme_enabled ? "dark" : "light");
     }
 }
@@ -1944,6 +4451,16 @@ static void apply_accent_color(void)
                                              LV_THEME_DEFAULT_FONT_SUBTITLE,
                                              LV_THEME_DEFAULT_FONT_TITLE);
     lv_theme_set_act(th);
+    refresh_theme_caches();
+}
+
+// Render the pre-rendered digits again in the new theme colours
+static void refresh_theme_caches(void)
+{
+    clock_refresh_theme(main_clock);
+    if (pitch_value && digit_sprite_update_colors(pitch_value)) {
+        lv_obj_invalidate(roll_value);  // Shares the atlas
+    }
 }
 
 // Callback for accent color button (shows color picker)
@@ -2103,6 +4620,7 @@ static void language_toggle_cb(lv_obj_t *sw, lv_event_t e)
         if (accent_color_label) lv_label_set_text(accent_color_label, STR_ACCENT_COLOR[current_language]);
         if (sensor_label) lv_label_set_text(sensor_label, STR_INVERT_LEVEL[current_language]);
         if (lang_label) lv_label_set_text(lang_label, STR_LANGUAGE[current_language]);
+        level_readout_relabel();
         
         // Note: Tab names require restart to update
     }
@@ -2116,11 +4634,11 @@ static void calibrate_confirm_cb(lv_obj_t *btnm, lv_event_t e)
         lv_obj_t *mbox = lv_obj_get_parent(btnm);
         
         if (btn_id == 0) {  // Yes button
-            // Perform calibration - save current sensor readings as offsets
-            if (xSemaphoreTake(mpu_mutex, 100 / portTICK_PERIOD_MS)) {
-                pitch_offset = current_pitch;
-                roll_offset = current_roll;
-                xSemaphoreGive(mpu_mutex);
+            // Perform calibration - fold the current (offset-corrected) reading into the offsets
+            sensor_snapshot_t snap;
+            if (sensor_snapshot_read(&snap)) {
+                pitch_offset += snap.pitch;
+                roll_offset += snap.roll;
                 
                 save_calibration_offsets(pitch_offset, roll_offset);
                 ESP_LOGI(TAG, "Calibrated! Offsets: pitch=%.3f° roll=%.3f°", pitch_offset, roll_offset);
@@ -0,0 +1,581 @@
+/**
+ * @file mqtt_failover.c
+ * @brief Primary/secondary MQTT broker selection with health checks
+ *
+ * All state is updated from two places: the MQTT event handler (connect,
+ * disconnect, error and PUBACK events) and the failover task, which runs the
+ * probe/switch/failback policy every MQTT_FAILOVER_TICK_MS. The mutex is never
+ * held across an esp_mqtt call: the MQTT task holds the client lock while it
+ * dispatches events, so doing so could deadlock.
+ */
+
+#include "mqtt_failover.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "lwip/sockets.h"
+#include "lwip/netdb.h"
+#include "json_writer.h"
+
+static const char *TAG = "mqtt_failover";
+
+#define NVS_MQTT                "mqtt_cfg"
+#define MQTT_FAILOVER_TICK_MS   250
+#define FAILBACK_CONFIRM_MS     2000    // Gap between consecutive primary checks
+#define RTT_SMOOTHING           4       // rtt_avg moves 1/4 towards each sample
+
+static mqtt_failover_broker_t brokers[2];
+static bool secondary_configured = false;
+
+static SemaphoreHandle_t failover_mutex = NULL;
+static esp_mqtt_client_handle_t client = NULL;
+static esp_mqtt_client_config_t base_config;
+static char health_topic[64];
+static mqtt_failover_switch_cb_t switch_cb = NULL;
+
+// Connection state (failover_mutex)
+static uint8_t active = MQTT_FAILOVER_PRIMARY;
+static bool connected = false;
+static bool link_up = true;
+static bool attempt_failed = false;     // Current connection attempt already counted
+static uint8_t failures = 0;
+static int64_t fault_ms = 0;            // First failure of the current episode (0 = healthy)
+static int64_t down_since_ms = 0;       // Not connected since (0 while connected)
+
+// Switchover in progress (switch_ms != 0 until the new broker connects)
+static int64_t switch_ms = 0;
+static int64_t episode_ms = 0;          // When the outage that caused the switch began
+
+// Health probe
+static int probe_msg_id = -1;
+static int64_t probe_sent_ms = 0;
+static int64_t next_probe_ms = 0;
+static int last_ack_id = -1;            // PUBACK that arrived before probe_msg_id was stored
+static int64_t last_ack_ms = 0;
+
+// Failback to the primary
+static bool failback_pending = false;   // Switched back, primary has not connected yet
+static int64_t next_failback_ms = 0;
+static uint32_t failback_interval_ms = MQTT_FAILOVER_FAILBACK_MS;
+static uint8_t failback_ok = 0;
+
+static mqtt_failover_stats_t stats;
+
+static int64_t now_ms(void)
+{
+    return esp_timer_get_time() / 1000;
+}
+
+static void load_broker(nvs_handle_t nvs, const char *prefix, mqtt_failover_broker_t *b,
+                        const char *def_addr, uint16_t def_port, uint8_t def_tls)
+{
+    char key[16];
+    size_t len;
+    uint8_t tls = def_tls;
+
+    snprintf(key, sizeof(key), "%s_addr", prefix);
+    len = sizeof(b->address);
+    if (nvs == 0 || nvs_get_str(nvs, key, b->address, &len) != ESP_OK) {
+        snprintf(b->address, sizeof(b->address), "%s", def_addr);
+    }
+    snprintf(key, sizeof(key), "%s_port", prefix);
+    if (nvs == 0 || nvs_get_u16(nvs, key, &b->port) != ESP_OK) {
+        b->port = def_port;
+    }
+    snprintf(key, sizeof(key), "%s_tls", prefix);
+    if (nvs != 0) {
+        nvs_get_u8(nvs, key, &tls);
+    }
+    b->tls = tls != 0;
+    snprintf(key, sizeof(key), "%s_user", prefix);
+    len = sizeof(b->username);
+    if (nvs == 0 || nvs_get_str(nvs, key, b->username, &len) != ESP_OK) {
+        b->username[0] = '\0';
+    }
+    snprintf(key, sizeof(key), "%s_pass", prefix);
+    len = sizeof(b->password);
+    if (nvs == 0 || nvs_get_str(nvs, key, b->password, &len) != ESP_OK) {
+        b->password[0] = '\0';
+    }
+}
+
+static void build_uri(mqtt_failover_broker_t *b)
+{
+    if (strstr(b->address, "://") != NULL) {
+        snprintf(b->uri, sizeof(b->uri), "%s", b->address);
+        b->tls = strncmp(b->address, "mqtts://", 8) == 0 || strncmp(b->address, "wss://", 6) == 0;
+    } else {
+        snprintf(b->uri, sizeof(b->uri), "%s://%s:%u", b->tls ? "mqtts" : "mqtt", b->address, b->port);
+    }
+}
+
+esp_err_t mqtt_failover_init(const mqtt_failover_default_t *fallback)
+{
+    nvs_handle_t nvs = 0;
+    if (nvs_open(NVS_MQTT, NVS_READONLY, &nvs) != ESP_OK) {
+        nvs = 0;  // Never configured: compile-time primary only
+    }
+
+    char addr[sizeof(brokers[0].address)];
+    size_t len = sizeof(addr);
+    if (nvs != 0 && nvs_get_str(nvs, "mqtt1_addr", addr, &len) == ESP_OK && addr[0] != '\0') {
+        load_broker(nvs, "mqtt1", &brokers[MQTT_FAILOVER_PRIMARY], "", 8883, 1);
+    } else if (fallback != NULL) {
+        mqtt_failover_broker_t *b = &brokers[MQTT_FAILOVER_PRIMARY];
+        snprintf(b->address, sizeof(b->address), "%s", fallback->uri);
+        b->port = fallback->port;
+        snprintf(b->username, sizeof(b->username), "%s", fallback->username ? fallback->username : "");
+        snprintf(b->password, sizeof(b->password), "%s", fallback->password ? fallback->password : "");
+    } else {
+        if (nvs != 0) {
+            nvs_close(nvs);
+        }
+        return ESP_ERR_NOT_FOUND;
+    }
+    build_uri(&brokers[MQTT_FAILOVER_PRIMARY]);
+
+    load_broker(nvs, "mqtt2", &brokers[MQTT_FAILOVER_SECONDARY], "", 1883, 0);
+    secondary_configured = brokers[MQTT_FAILOVER_SECONDARY].address[0] != '\0';
+    if (secondary_configured) {
+        build_uri(&brokers[MQTT_FAILOVER_SECONDARY]);
+    }
+
+    if (nvs != 0) {
+        nvs_close(nvs);
+    }
+
+    ESP_LOGI(TAG, "Primary:   %s", brokers[MQTT_FAILOVER_PRIMARY].uri);
+    ESP_LOGI(TAG, "Secondary: %s", secondary_configured ? brokers[MQTT_FAILOVER_SECONDARY].uri : "(not configured)");
+    return ESP_OK;
+}
+
+const mqtt_failover_broker_t *mqtt_failover_broker(uint8_t index)
+{
+    if (index > MQTT_FAILOVER_SECONDARY ||
+        (index == MQTT_FAILOVER_SECONDARY && !secondary_configured)) {
+        return NULL;
+    }
+    return &brokers[index];
+}
+
+const char *mqtt_failover_name(uint8_t index)
+{
+    return index == MQTT_FAILOVER_PRIMARY ? "primary" : "secondary";
+}
+
+void mqtt_failover_apply(esp_mqtt_client_config_t *cfg, uint8_t index)
+{
+    const mqtt_failover_broker_t *b = &brokers[index];
+
+    cfg->broker.address.uri = b->uri;
+    cfg->broker.address.port = b->port;
+    // esp_mqtt_set_config() keeps the previous string when given NULL, so an
+    // empty string is used to clear credentials when switching brokers
+    cfg->credentials.username = b->username;
+    cfg->credentials.authentication.password = b->password;
+    cfg->session.keepalive = MQTT_FAILOVER_KEEPALIVE_S;
+    cfg->network.timeout_ms = MQTT_FAILOVER_NETWORK_TIMEOUT_MS;
+    cfg->network.reconnect_timeout_ms = MQTT_FAILOVER_RECONNECT_MS;
+}
+
+// One connect error, disconnect or lost probe (failover_mutex held)
+static void note_failure(int64_t now, const char *why)
+{
+    if (!link_up) {
+        return;
+    }
+    if (fault_ms == 0) {
+        fault_ms = now;
+    }
+    if (failures < UINT8_MAX) {
+        failures++;
+    }
+    ESP_LOGW(TAG, "%s broker: %s (%u/%u)", mqtt_failover_name(active), why,
+             failures, MQTT_FAILOVER_MAX_FAILURES);
+}
+
+static void on_connected(int64_t now)
+{
+    connected = true;
+    attempt_failed = false;
+    failures = 0;
+    down_since_ms = 0;
+    probe_msg_id = -1;
+    next_probe_ms = now + MQTT_FAILOVER_PROBE_TIMEOUT_MS;  // First RTT soon after connecting
+    stats.rtt_max_ms = 0;
+
+    if (switch_ms != 0) {
+        stats.last_switch_ms = (uint32_t)(now - switch_ms);
+        stats.last_outage_ms = (uint32_t)(now - episode_ms);
+        if (stats.last_outage_ms > stats.max_outage_ms) {
+            stats.max_outage_ms = stats.last_outage_ms;
+        }
+        ESP_LOGI(TAG, "Switched to %s broker: outage %lu ms (detect %lu ms, connect %lu ms)",
+                 mqtt_failover_name(active), (unsigned long)stats.last_outage_ms,
+                 (unsigned long)stats.last_detect_ms, (unsigned long)stats.last_switch_ms);
+        switch_ms = 0;
+    }
+    fault_ms = 0;
+
+    if (active == MQTT_FAILOVER_PRIMARY) {
+        failback_pending = false;
+        failback_interval_ms = MQTT_FAILOVER_FAILBACK_MS;
+    }
+}
+
+// PUBACK for the outstanding probe (failover_mutex held)
+static void probe_acked(int64_t now)
+{
+    uint32_t rtt = (uint32_t)(now - probe_sent_ms);
+
+    stats.rtt_ms = rtt;
+    stats.rtt_avg_ms = stats.rtt_avg_ms == 0 ? rtt
+                     : stats.rtt_avg_ms + ((int32_t)rtt - (int32_t)stats.rtt_avg_ms) / RTT_SMOOTHING;
+    if (rtt > stats.rtt_max_ms) {
+        stats.rtt_max_ms = rtt;
+    }
+    probe_msg_id = -1;
+    failures = 0;
+    fault_ms = 0;
+}
+
+void mqtt_failover_handle_event(esp_mqtt_event_handle_t event)
+{
+    if (failover_mutex == NULL) {
+        return;
+    }
+    int64_t now = now_ms();
+
+    xSemaphoreTake(failover_mutex, portMAX_DELAY);
+    switch ((esp_mqtt_event_id_t)event->event_id) {
+        case MQTT_EVENT_BEFORE_CONNECT:
+            attempt_failed = false;
+            if (down_since_ms == 0) {
+                down_since_ms = now;
+            }
+            break;
+
+        case MQTT_EVENT_CONNECTED:
+            on_connected(now);
+            break;
+
+        case MQTT_EVENT_DISCONNECTED:
+        case MQTT_EVENT_ERROR:
+            if (connected) {
+                connected = false;
+                down_since_ms = now;
+            }
+            // The client reports a failed attempt as error + disconnect; count it once
+            if (!attempt_failed) {
+                attempt_failed = true;
+                note_failure(now, event->event_id == MQTT_EVENT_ERROR ? "connection error" : "disconnected");
+            }
+            break;
+
+        case MQTT_EVENT_PUBLISHED:
+            if (event->msg_id == probe_msg_id) {
+                probe_acked(now);
+            } else {
+                last_ack_id = event->msg_id;
+                last_ack_ms = now;
+            }
+            break;
+
+        default:
+            break;
+    }
+    xSemaphoreGive(failover_mutex);
+}
+
+void mqtt_failover_set_link(bool up)
+{
+    if (failover_mutex == NULL) {
+        link_up = up;
+        return;
+    }
+    xSemaphoreTake(failover_mutex, portMAX_DELAY);
+    if (up != link_up) {
+        link_up = up;
+        // Broker failures during a WiFi outage say nothing about the broker
+        failures = 0;
+        fault_ms = 0;
+        down_since_ms = (up && !connected) ? now_ms() : 0;
+    }
+    xSemaphoreGive(failover_mutex);
+}
+
+void mqtt_failover_get_stats(mqtt_failover_stats_t *out)
+{
+    if (failover_mutex == NULL) {
+        memset(out, 0, sizeof(*out));
+        out->secondary_configured = secondary_configured;
+        return;
+    }
+    xSemaphoreTake(failover_mutex, portMAX_DELAY);
+    *out = stats;
+    out->active = active;
+    out->connected = connected;
+    out->failures = failures;
+    out->secondary_configured = secondary_configured;
+    xSemaphoreGive(failover_mutex);
+}
+
+// Host name part of a broker address or URI
+static void broker_host(const mqtt_failover_broker_t *b, char *host, size_t size)
+{
+    const char *start = strstr(b->address, "://");
+    start = start ? start + 3 : b->address;
+    size_t n = strcspn(start, ":/");
+    if (n >= size) {
+        n = size - 1;
+    }
+    memcpy(host, start, n);
+    host[n] = '\0';
+}
+
+// Port from a URI address ("mqtt://host:1884"), otherwise the configured port
+static uint16_t broker_port(const mqtt_failover_broker_t *b)
+{
+    const char *start = strstr(b->address, "://");
+    if (start != NULL) {
+        const char *colon = strchr(start + 3, ':');
+        if (colon != NULL) {
+            return (uint16_t)atoi(colon + 1);
+        }
+    }
+    return b->port;
+}
+
+// Cheap reachability check of a broker without disturbing the active connection
+static bool tcp_reachable(const mqtt_failover_broker_t *b)
+{
+    char host[sizeof(b->address)];
+    char port[8];
+    struct addrinfo hints = { .ai_family = AF_INET, .ai_socktype = SOCK_STREAM };
+    struct addrinfo *res = NULL;
+
+    broker_host(b, host, sizeof(host));
+    snprintf(port, sizeof(port), "%u", broker_port(b));
+    if (getaddrinfo(host, port, &hints, &res) != 0 || res == NULL) {
+        return false;
+    }
+
+    bool ok = false;
+    int sock = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    if (sock >= 0) {
+        fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+        if (connect(sock, res->ai_addr, res->ai_addrlen) == 0) {
+            ok = true;
+        } else if (errno == EINPROGRESS) {
+            fd_set wfds;
+            FD_ZERO(&wfds);
+            FD_SET(sock, &wfds);
+            struct timeval tv = {
+                .tv_sec = MQTT_FAILOVER_NETWORK_TIMEOUT_MS / 1000,
+                .tv_usec = (MQTT_FAILOVER_NETWORK_TIMEOUT_MS % 1000) * 1000,
+            };
+            if (select(sock + 1, NULL, &wfds, NULL, &tv) > 0) {
+                int err = 0;
+                socklen_t len = sizeof(err);
+                ok = getsockopt(sock, SOL_SOCKET, SO_ERROR, &err, &len) == 0 && err == 0;
+            }
+        }
+        close(sock);
+    }
+    freeaddrinfo(res);
+    return ok;
+}
+
+// Stop the client and restart it on the other broker (failover_mutex not held)
+static void switch_broker(uint8_t to, bool failback)
+{
+    int64_t now = now_ms();
+    uint8_t from;
+
+    xSemaphoreTake(failover_mutex, portMAX_DELAY);
+    from = active;
+    if (failback) {
+        episode_ms = now;
+        stats.last_detect_ms = 0;
+        stats.failbacks++;
+        failback_pending = true;
+    } else {
+        episode_ms = fault_ms != 0 ? fault_ms : (down_since_ms != 0 ? down_since_ms : now);
+        stats.last_detect_ms = (uint32_t)(now - episode_ms);
+        if (failback_pending) {
+            // The primary we failed back to did not come up: wait longer next time
+            failback_pending = false;
+            stats.failed_failbacks++;
+            failback_interval_ms = failback_interval_ms * 2 > MQTT_FAILOVER_FAILBACK_MAX_MS
+                                 ? MQTT_FAILOVER_FAILBACK_MAX_MS : failback_interval_ms * 2;
+        }
+    }
+    active = to;
+    switch_ms = now;
+    connected = false;
+    failures = 0;
+    fault_ms = 0;
+    down_since_ms = now;
+    attempt_failed = true;      // Absorb late errors of the old connection
+    probe_msg_id = -1;
+    failback_ok = 0;
+    next_failback_ms = now + failback_interval_ms;
+    stats.switches++;
+    xSemaphoreGive(failover_mutex);
+
+    if (failback) {
+        ESP_LOGI(TAG, "Primary broker reachable again, failing back");
+    } else {
+        ESP_LOGW(TAG, "%s broker unhealthy for %lu ms, switching to %s",
+                 mqtt_failover_name(from), (unsigned long)stats.last_detect_ms, mqtt_failover_name(to));
+    }
+
+    if (switch_cb != NULL) {
+        switch_cb(from, to);
+    }
+
+    esp_mqtt_client_config_t cfg = base_config;
+    mqtt_failover_apply(&cfg, to);
+
+    esp_mqtt_client_stop(client);
+    esp_err_t err = esp_mqtt_set_config(client, &cfg);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to configure %s broker: %s", mqtt_failover_name(to), esp_err_to_name(err));
+    }
+    err = esp_mqtt_client_start(client);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to restart client: %s", esp_err_to_name(err));
+    }
+}
+
+static void send_probe(void)
+{
+    char buf[256];
+    json_writer_t w;
+    size_t len;
+    mqtt_failover_stats_t s;
+
+    mqtt_failover_get_stats(&s);
+    json_writer_init(&w, buf, sizeof(buf));
+    json_obj_begin(&w);
+    json_kv_str(&w, "broker", mqtt_failover_name(s.active));
+    json_kv_int(&w, "rtt_ms", s.rtt_ms);
+    json_kv_int(&w, "rtt_avg_ms", s.rtt_avg_ms);
+    json_kv_int(&w, "switches", s.switches);
+    json_kv_int(&w, "failbacks", s.failbacks);
+    json_kv_int(&w, "probe_timeouts", s.probe_timeouts);
+    json_kv_int(&w, "last_outage_ms", s.last_outage_ms);
+    json_kv_int(&w, "max_outage_ms", s.max_outage_ms);
+    json_obj_end(&w);
+    const char *payload = json_writer_finish(&w, &len);
+    if (payload == NULL) {
+        return;
+    }
+
+    int64_t sent = now_ms();
+    int msg_id = esp_mqtt_client_publish(client, health_topic, payload, (int)len, 1, 0);
+
+    xSemaphoreTake(failover_mutex, portMAX_DELAY);
+    next_probe_ms = sent + MQTT_FAILOVER_PROBE_MS;
+    if (msg_id > 0 && connected) {
+        probe_msg_id = msg_id;
+        probe_sent_ms = sent;
+        if (last_ack_id == msg_id) {
+            // Local brokers can acknowledge before publish() returns
+            probe_acked(last_ack_ms);
+        }
+    }
+    xSemaphoreGive(failover_mutex);
+}
+
+static void failover_task(void *arg)
+{
+    (void)arg;
+
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(MQTT_FAILOVER_TICK_MS));
+
+        int64_t now = now_ms();
+        bool do_probe = false;
+        bool check_primary = false;
+        bool do_switch = false;
+
+        xSemaphoreTake(failover_mutex, portMAX_DELAY);
+        if (link_up && switch_ms == 0) {
+            if (connected) {
+                if (probe_msg_id >= 0 && now - probe_sent_ms >= MQTT_FAILOVER_PROBE_TIMEOUT_MS) {
+                    stats.probe_timeouts++;
+                    probe_msg_id = -1;
+                    next_probe_ms = now;  // Re-probe right away
+                    note_failure(now, "probe timeout");
+                }
+                do_probe = probe_msg_id < 0 && now >= next_probe_ms;
+            }
+            do_switch = failures >= MQTT_FAILOVER_MAX_FAILURES ||
+                        (!connected && down_since_ms != 0 && now - down_since_ms >= MQTT_FAILOVER_DOWN_MS);
+            if (!secondary_configured) {
+                do_switch = false;
+            } else if (!do_switch && active == MQTT_FAILOVER_SECONDARY && now >= next_failback_ms) {
+                check_primary = true;
+            }
+        } else if (switch_ms != 0 && !connected && now - switch_ms >= MQTT_FAILOVER_DOWN_MS &&
+                   link_up && secondary_configured) {
+            // The broker we switched to does not come up either: keep alternating
+            do_switch = true;
+        }
+        uint8_t other = active == MQTT_FAILOVER_PRIMARY ? MQTT_FAILOVER_SECONDARY : MQTT_FAILOVER_PRIMARY;
+        xSemaphoreGive(failover_mutex);
+
+        if (do_switch) {
+            switch_broker(other, false);
+        } else if (check_primary) {
+            bool ok = tcp_reachable(&brokers[MQTT_FAILOVER_PRIMARY]);
+            bool failback = false;
+
+            xSemaphoreTake(failover_mutex, portMAX_DELAY);
+            if (active == MQTT_FAILOVER_SECONDARY && switch_ms == 0) {
+                failback_ok = ok ? failback_ok + 1 : 0;
+                failback = failback_ok >= MQTT_FAILOVER_FAILBACK_PROBES;
+                next_failback_ms = now_ms() + (ok ? FAILBACK_CONFIRM_MS : failback_interval_ms);
+            }
+            xSemaphoreGive(failover_mutex);
+
+            if (failback) {
+                switch_broker(MQTT_FAILOVER_PRIMARY, true);
+            }
+        } else if (do_probe) {
+            send_probe();
+        }
+    }
+}
+
+esp_err_t mqtt_failover_start(esp_mqtt_client_handle_t mqtt_client, const esp_mqtt_client_config_t *base_cfg,
+                              const char *topic, mqtt_failover_switch_cb_t on_switch)
+{
+    if (failover_mutex != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    failover_mutex = xSemaphoreCreateMutex();
+    if (failover_mutex == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    client = mqtt_client;
+    base_config = *base_cfg;
+    snprintf(health_topic, sizeof(health_topic), "%s", topic);
+    switch_cb = on_switch;
+    active = MQTT_FAILOVER_PRIMARY;
+    down_since_ms = now_ms();
+
+    if (xTaskCreate(failover_task, "mqtt_failover", 4096, NULL, 5, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create failover task");
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
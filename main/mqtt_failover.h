@@ -0,0 +1,156 @@
+/**
+ * @file mqtt_failover.h
+ * @brief Primary/secondary MQTT broker selection with health checks
+ *
+ * Loads both brokers configured in the serial menu (NVS namespace
+ * "mqtt_cfg", keys mqtt1_* and mqtt2_*) and keeps the single esp_mqtt client
+ * pointed at a healthy one:
+ * - The active broker is health-checked with a QoS 1 probe on
+ *   {base}/device/health; the PUBACK round trip is the keepalive RTT
+ * - Consecutive connect errors, disconnects and probe timeouts count as
+ *   failures; after MQTT_FAILOVER_MAX_FAILURES, or when the broker has been
+ *   unreachable for MQTT_FAILOVER_DOWN_MS, the client switches to the other
+ *   broker
+ * - While on the secondary, the primary is checked with a plain TCP connect
+ *   and the client fails back once it answers MQTT_FAILOVER_FAILBACK_PROBES
+ *   times in a row (the check interval backs off after a failed failback)
+ *
+ * Every switchover is timed from the first failure to MQTT_EVENT_CONNECTED on
+ * the new broker (see mqtt_failover_stats_t). Without a secondary broker the
+ * health checks still run but the client simply keeps retrying the primary.
+ */
+
+#ifndef MQTT_FAILOVER_H
+#define MQTT_FAILOVER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "mqtt_client.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MQTT_FAILOVER_PRIMARY        0
+#define MQTT_FAILOVER_SECONDARY      1
+
+// Client timing, short enough that a dead broker is noticed in seconds
+#define MQTT_FAILOVER_NETWORK_TIMEOUT_MS  4000   // TCP/TLS connect and read timeout
+#define MQTT_FAILOVER_RECONNECT_MS        1000   // esp_mqtt retry interval
+#define MQTT_FAILOVER_KEEPALIVE_S         10     // MQTT keepalive
+
+// Health check and switch policy
+#define MQTT_FAILOVER_PROBE_MS            5000   // Probe interval while healthy
+#define MQTT_FAILOVER_PROBE_TIMEOUT_MS    2500   // Probe without PUBACK counts as a failure
+#define MQTT_FAILOVER_MAX_FAILURES        3      // Consecutive failures before switching
+#define MQTT_FAILOVER_DOWN_MS             8000   // Switch if not connected for this long
+#define MQTT_FAILOVER_FAILBACK_MS         30000  // First primary check after switching away
+#define MQTT_FAILOVER_FAILBACK_MAX_MS     300000 // Back-off limit after failed failbacks
+#define MQTT_FAILOVER_FAILBACK_PROBES     2      // Successful TCP checks needed to fail back
+
+/**
+ * @brief Broker settings as stored by the serial menu
+ */
+typedef struct {
+    char address[128];        ///< Host name or IP (a full mqtt:// URI is accepted too)
+    uint16_t port;
+    bool tls;
+    char username[64];
+    char password[128];
+    char uri[160];            ///< Built from address/port/tls
+} mqtt_failover_broker_t;
+
+/**
+ * @brief Compile-time broker used when the primary is not in NVS
+ */
+typedef struct {
+    const char *uri;
+    uint16_t port;
+    const char *username;
+    const char *password;
+} mqtt_failover_default_t;
+
+/**
+ * @brief Failover statistics (times in ms, 0 if not measured yet)
+ */
+typedef struct {
+    uint8_t active;           ///< MQTT_FAILOVER_PRIMARY or MQTT_FAILOVER_SECONDARY
+    bool connected;
+    bool secondary_configured;
+    uint32_t switches;        ///< Switches to the other broker (failbacks included)
+    uint32_t failbacks;       ///< Switches back to the primary
+    uint32_t failed_failbacks;///< Failbacks the primary did not survive
+    uint8_t failures;         ///< Current consecutive failure count
+    uint32_t rtt_ms;          ///< Last probe round trip
+    uint32_t rtt_avg_ms;      ///< Smoothed probe round trip
+    uint32_t rtt_max_ms;      ///< Worst probe round trip on the current connection
+    uint32_t probe_timeouts;  ///< Probes that were never acknowledged
+    uint32_t last_detect_ms;  ///< First failure -> switch decision
+    uint32_t last_switch_ms;  ///< Switch decision -> connected to the new broker
+    uint32_t last_outage_ms;  ///< First failure -> connected to the new broker
+    uint32_t max_outage_ms;   ///< Worst outage of any switchover since boot
+} mqtt_failover_stats_t;
+
+/**
+ * @brief Called by the failover task right before it stops the client to
+ *        switch brokers (the client may not report a disconnect for that)
+ */
+typedef void (*mqtt_failover_switch_cb_t)(uint8_t from, uint8_t to);
+
+/**
+ * @brief Load both brokers from NVS
+ *
+ * @param fallback Used for the primary when mqtt1_addr was never configured
+ */
+esp_err_t mqtt_failover_init(const mqtt_failover_default_t *fallback);
+
+/**
+ * @brief Settings of a broker loaded by mqtt_failover_init()
+ */
+const mqtt_failover_broker_t *mqtt_failover_broker(uint8_t index);
+
+/**
+ * @brief Point cfg at the given broker (address, credentials, timeouts)
+ *
+ * Strings are referenced, not copied; they stay valid for the lifetime of
+ * the firmware.
+ */
+void mqtt_failover_apply(esp_mqtt_client_config_t *cfg, uint8_t index);
+
+/**
+ * @brief Start supervising a client
+ *
+ * Call after esp_mqtt_client_init() and before esp_mqtt_client_start() so
+ * the first connection attempt is already tracked.
+ *
+ * @param client Client created from a config passed through mqtt_failover_apply()
+ * @param base_cfg Config the client was created with (copied)
+ * @param health_topic Topic for the QoS 1 health probe
+ * @param on_switch Optional switch notification
+ */
+esp_err_t mqtt_failover_start(esp_mqtt_client_handle_t client, const esp_mqtt_client_config_t *base_cfg,
+                              const char *health_topic, mqtt_failover_switch_cb_t on_switch);
+
+/**
+ * @brief Feed client events (call from the MQTT event handler)
+ */
+void mqtt_failover_handle_event(esp_mqtt_event_handle_t event);
+
+/**
+ * @brief Tell the failover whether WiFi is up (no switching without a link)
+ */
+void mqtt_failover_set_link(bool up);
+
+void mqtt_failover_get_stats(mqtt_failover_stats_t *stats);
+
+/**
+ * @brief "primary" or "secondary"
+ */
+const char *mqtt_failover_name(uint8_t index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MQTT_FAILOVER_H
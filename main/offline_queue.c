@@ -0,0 +1,435 @@
+/**
+ * @file offline_queue.c
+ * @brief Append-only segment ring in a raw flash partition
+ *
+ * Segment layout (one flash sector):
+ *   segment_header_t | record_header_t payload (padded to 4) | ... | erased
+ *
+ * Segments are used in ring order with an increasing sequence number, so the
+ * newest segment is the one with the highest sequence and the oldest data
+ * follows it in the ring. Records are consumed strictly in order.
+ */
+
+#include "offline_queue.h"
+#include <string.h>
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+static const char *TAG = "offline_q";
+
+#define SEGMENT_MAGIC     0x3151544C   // "LTQ1"
+#define RECORD_ERASED     0xFFFF       // len of a header that was never written
+#define RECORD_PENDING    0xFFFFFFFF
+#define RECORD_CONSUMED   0x00000000
+
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;
+    uint32_t reserved[2];
+} segment_header_t;
+
+typedef struct {
+    uint16_t len;
+    uint16_t samples;
+    uint32_t state;           // Cleared to RECORD_CONSUMED after replay
+    int64_t timestamp_ms;
+    uint32_t crc;             // Over len, samples, timestamp_ms and the payload
+    uint16_t len_inv;         // ~len, written last: a torn header does not match
+    uint16_t reserved;
+} record_header_t;
+
+_Static_assert(sizeof(segment_header_t) == 16, "segment header size");
+_Static_assert(sizeof(record_header_t) == 24, "record header size");
+_Static_assert(OFFLINE_QUEUE_MAX_RECORD ==
+               OFFLINE_QUEUE_SEGMENT_SIZE - sizeof(segment_header_t) - sizeof(record_header_t),
+               "OFFLINE_QUEUE_MAX_RECORD out of date");
+
+#define ALIGN4(x)         (((x) + 3u) & ~3u)
+#define RECORD_SIZE(len)  (sizeof(record_header_t) + ALIGN4(len))
+
+static const esp_partition_t *partition = NULL;
+static SemaphoreHandle_t queue_mutex = NULL;
+static uint32_t segment_count = 0;
+
+// Write position
+static bool head_valid = false;
+static uint32_t head_segment = 0;
+static uint32_t head_offset = 0;
+static uint32_t head_seq = 0;
+
+// Oldest waiting record (valid while pending_records > 0)
+static uint32_t tail_segment = 0;
+static uint32_t tail_offset = 0;
+static int64_t tail_timestamp_ms = 0;
+static uint32_t generation = 0;
+
+static uint32_t pending_records = 0;
+static uint32_t pending_samples = 0;
+static uint32_t pending_bytes = 0;
+static uint32_t dropped_samples = 0;
+static uint32_t replayed_samples = 0;
+
+static size_t segment_address(uint32_t segment)
+{
+    return (size_t)segment * OFFLINE_QUEUE_SEGMENT_SIZE;
+}
+
+static uint32_t record_crc(const record_header_t *hdr, const void *payload)
+{
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *)&hdr->len, sizeof(hdr->len));
+    crc = esp_rom_crc32_le(crc, (const uint8_t *)&hdr->samples, sizeof(hdr->samples));
+    crc = esp_rom_crc32_le(crc, (const uint8_t *)&hdr->timestamp_ms, sizeof(hdr->timestamp_ms));
+    return esp_rom_crc32_le(crc, payload, hdr->len);
+}
+
+static bool read_segment_header(uint32_t segment, segment_header_t *hdr)
+{
+    return esp_partition_read(partition, segment_address(segment), hdr, sizeof(*hdr)) == ESP_OK &&
+           hdr->magic == SEGMENT_MAGIC;
+}
+
+// Header of the record at offset, false at the end of the written part of the segment
+static bool read_record_header(uint32_t segment, uint32_t offset, record_header_t *hdr)
+{
+    if (offset + sizeof(record_header_t) > OFFLINE_QUEUE_SEGMENT_SIZE) {
+        return false;
+    }
+    if (esp_partition_read(partition, segment_address(segment) + offset, hdr, sizeof(*hdr)) != ESP_OK) {
+        return false;
+    }
+    return hdr->len != RECORD_ERASED && hdr->len_inv == (uint16_t)~hdr->len &&
+           hdr->len <= OFFLINE_QUEUE_MAX_RECORD &&
+           offset + RECORD_SIZE(hdr->len) <= OFFLINE_QUEUE_SEGMENT_SIZE;
+}
+
+static void set_tail(uint32_t segment, uint32_t offset, const record_header_t *hdr)
+{
+    tail_segment = segment;
+    tail_offset = offset;
+    tail_timestamp_ms = hdr->timestamp_ms;
+}
+
+// Move the tail past the record at (tail_segment, tail_offset) of the given size
+static void advance_tail(uint32_t record_size)
+{
+    record_header_t hdr;
+
+    if (pending_records == 0) {
+        tail_timestamp_ms = 0;
+        return;
+    }
+    uint32_t offset = tail_offset + record_size;
+    if (read_record_header(tail_segment, offset, &hdr)) {
+        set_tail(tail_segment, offset, &hdr);
+        return;
+    }
+    // Next segment with records, up to the write position (a power loss can leave a
+    // segment without records or with an unreadable header in between)
+    segment_header_t seg;
+    uint32_t segment = tail_segment;
+    while (segment != head_segment) {
+        segment = (segment + 1) % segment_count;
+        if (read_segment_header(segment, &seg) && read_record_header(segment, sizeof(seg), &hdr)) {
+            set_tail(segment, sizeof(seg), &hdr);
+            return;
+        }
+    }
+    ESP_LOGE(TAG, "Queue inconsistent, %lu records unreachable", (unsigned long)pending_records);
+    dropped_samples += pending_samples;
+    pending_records = pending_samples = pending_bytes = 0;
+    tail_timestamp_ms = 0;
+}
+
+// The ring is full: give up the segment holding the oldest records
+static void drop_tail_segment(void)
+{
+    record_header_t hdr;
+    uint32_t segment = tail_segment;
+    uint32_t dropped = 0;
+
+    while (pending_records > 0 && tail_segment == segment &&
+           read_record_header(tail_segment, tail_offset, &hdr)) {
+        pending_records--;
+        pending_samples -= hdr.samples;
+        pending_bytes -= RECORD_SIZE(hdr.len);
+        dropped += hdr.samples;
+        advance_tail(RECORD_SIZE(hdr.len));
+    }
+    dropped_samples += dropped;
+    generation++;
+    ESP_LOGW(TAG, "Queue full, dropped %lu oldest samples", (unsigned long)dropped);
+}
+
+static esp_err_t start_segment(void)
+{
+    uint32_t segment = head_valid ? (head_segment + 1) % segment_count : 0;
+
+    if (pending_records > 0 && segment == tail_segment) {
+        drop_tail_segment();
+    }
+
+    esp_err_t err = esp_partition_erase_range(partition, segment_address(segment), OFFLINE_QUEUE_SEGMENT_SIZE);
+    if (err != ESP_OK) {
+        return err;
+    }
+    segment_header_t hdr = {
+        .magic = SEGMENT_MAGIC,
+        .seq = head_seq + 1,
+        .reserved = {0xFFFFFFFF, 0xFFFFFFFF},
+    };
+    err = esp_partition_write(partition, segment_address(segment), &hdr, sizeof(hdr));
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    head_valid = true;
+    head_segment = segment;
+    head_offset = sizeof(segment_header_t);
+    head_seq = hdr.seq;
+    return ESP_OK;
+}
+
+// Rebuild the RAM state from the segment and record headers
+static void recover(void)
+{
+    segment_header_t seg;
+    record_header_t hdr;
+    bool found = false;
+    uint32_t newest = 0;
+
+    for (uint32_t i = 0; i < segment_count; i++) {
+        if (read_segment_header(i, &seg) && (!found || (int32_t)(seg.seq - head_seq) > 0)) {
+            found = true;
+            newest = i;
+            head_seq = seg.seq;
+        }
+    }
+    if (!found) {
+        return;
+    }
+
+    // Walk from the oldest segment (the one after the newest) to the newest
+    for (uint32_t k = 1; k <= segment_count; k++) {
+        uint32_t segment = (newest + k) % segment_count;
+        if (!read_segment_header(segment, &seg)) {
+            continue;
+        }
+        uint32_t offset = sizeof(segment_header_t);
+        while (read_record_header(segment, offset, &hdr)) {
+            if (hdr.state == RECORD_PENDING) {
+                if (pending_records == 0) {
+                    set_tail(segment, offset, &hdr);
+                }
+                pending_records++;
+                pending_samples += hdr.samples;
+                pending_bytes += RECORD_SIZE(hdr.len);
+            } else if (pending_records > 0) {
+                // Consumption is in order, a consumed record after a pending one is not expected
+                ESP_LOGW(TAG, "Consumed record after pending data in segment %lu", (unsigned long)segment);
+            }
+            offset += RECORD_SIZE(hdr.len);
+        }
+    }
+
+    // The end of the newest segment may hold a partly written record: continue in a fresh one
+    head_valid = true;
+    head_segment = newest;
+    head_offset = OFFLINE_QUEUE_SEGMENT_SIZE;
+}
+
+esp_err_t offline_queue_init(void)
+{
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, OFFLINE_QUEUE_PARTITION_SUBTYPE,
+                                         OFFLINE_QUEUE_PARTITION_LABEL);
+    if (partition == NULL) {
+        ESP_LOGW(TAG, "No '%s' partition, offline queue disabled", OFFLINE_QUEUE_PARTITION_LABEL);
+        return ESP_ERR_NOT_FOUND;
+    }
+    segment_count = partition->size / OFFLINE_QUEUE_SEGMENT_SIZE;
+    if (segment_count < 2) {
+        partition = NULL;
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    queue_mutex = xSemaphoreCreateMutex();
+    if (queue_mutex == NULL) {
+        partition = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    recover();
+    ESP_LOGI(TAG, "Offline queue: %lu segments, %lu records (%lu samples) waiting",
+             (unsigned long)segment_count, (unsigned long)pending_records, (unsigned long)pending_samples);
+    return ESP_OK;
+}
+
+esp_err_t offline_queue_push(const void *data, size_t len, uint16_t samples, int64_t timestamp_ms)
+{
+    if (partition == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (len == 0 || len > OFFLINE_QUEUE_MAX_RECORD) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    xSemaphoreTake(queue_mutex, portMAX_DELAY);
+
+    esp_err_t err = ESP_OK;
+    if (!head_valid || head_offset + RECORD_SIZE(len) > OFFLINE_QUEUE_SEGMENT_SIZE) {
+        err = start_segment();
+    }
+
+    record_header_t hdr = {
+        .len = (uint16_t)len,
+        .samples = samples,
+        .state = RECORD_PENDING,
+        .timestamp_ms = timestamp_ms,
+        .len_inv = (uint16_t)~len,
+        .reserved = 0xFFFF,
+    };
+    hdr.crc = record_crc(&hdr, data);
+
+    // Payload first: a header only exists once its payload is complete
+    size_t address = segment_address(head_segment) + head_offset;
+    if (err == ESP_OK) {
+        err = esp_partition_write(partition, address + sizeof(hdr), data, len);
+    }
+    if (err == ESP_OK) {
+        err = esp_partition_write(partition, address, &hdr, sizeof(hdr));
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Write failed: %s", esp_err_to_name(err));
+        head_offset = OFFLINE_QUEUE_SEGMENT_SIZE;  // Do not reuse a partly written segment
+        xSemaphoreGive(queue_mutex);
+        return err;
+    }
+
+    if (pending_records == 0) {
+        set_tail(head_segment, head_offset, &hdr);
+    }
+    pending_records++;
+    pending_samples += samples;
+    pending_bytes += RECORD_SIZE(len);
+    head_offset += RECORD_SIZE(len);
+
+    xSemaphoreGive(queue_mutex);
+    return ESP_OK;
+}
+
+esp_err_t offline_queue_peek(void *out, size_t max, offline_queue_record_t *record)
+{
+    if (partition == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(queue_mutex, portMAX_DELAY);
+
+    esp_err_t err = ESP_ERR_NOT_FOUND;
+    record_header_t hdr;
+    while (pending_records > 0 && read_record_header(tail_segment, tail_offset, &hdr)) {
+        if (hdr.len > max) {
+            err = ESP_ERR_INVALID_SIZE;
+            break;
+        }
+        size_t address = segment_address(tail_segment) + tail_offset;
+        err = esp_partition_read(partition, address + sizeof(hdr), out, hdr.len);
+        if (err != ESP_OK) {
+            break;
+        }
+        if (record_crc(&hdr, out) == hdr.crc) {
+            record->segment = tail_segment;
+            record->offset = tail_offset;
+            record->generation = generation;
+            record->len = hdr.len;
+            record->samples = hdr.samples;
+            record->timestamp_ms = hdr.timestamp_ms;
+            break;
+        }
+
+        // Torn or corrupted record: skip it
+        ESP_LOGW(TAG, "CRC mismatch in segment %lu, record skipped", (unsigned long)tail_segment);
+        uint32_t state = RECORD_CONSUMED;
+        esp_partition_write(partition, address + offsetof(record_header_t, state), &state, sizeof(state));
+        pending_records--;
+        pending_samples -= hdr.samples;
+        pending_bytes -= RECORD_SIZE(hdr.len);
+        dropped_samples += hdr.samples;
+        generation++;
+        advance_tail(RECORD_SIZE(hdr.len));
+        err = ESP_ERR_NOT_FOUND;
+    }
+
+    xSemaphoreGive(queue_mutex);
+    return err;
+}
+
+esp_err_t offline_queue_consume(const offline_queue_record_t *record)
+{
+    if (partition == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(queue_mutex, portMAX_DELAY);
+
+    if (pending_records == 0 || record->generation != generation ||
+        record->segment != tail_segment || record->offset != tail_offset) {
+        xSemaphoreGive(queue_mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint32_t state = RECORD_CONSUMED;
+    size_t address = segment_address(tail_segment) + tail_offset + offsetof(record_header_t, state);
+    esp_err_t err = esp_partition_write(partition, address, &state, sizeof(state));
+    if (err == ESP_OK) {
+        pending_records--;
+        pending_samples -= record->samples;
+        pending_bytes -= RECORD_SIZE(record->len);
+        replayed_samples += record->samples;
+        advance_tail(RECORD_SIZE(record->len));
+    }
+
+    xSemaphoreGive(queue_mutex);
+    return err;
+}
+
+esp_err_t offline_queue_clear(void)
+{
+    if (partition == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(queue_mutex, portMAX_DELAY);
+
+    esp_err_t err = esp_partition_erase_range(partition, 0, segment_address(segment_count));
+    dropped_samples += pending_samples;
+    pending_records = pending_samples = pending_bytes = 0;
+    tail_timestamp_ms = 0;
+    head_valid = false;
+    head_seq = 0;
+    generation++;
+
+    xSemaphoreGive(queue_mutex);
+    return err;
+}
+
+void offline_queue_get_stats(offline_queue_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    if (partition == NULL) {
+        return;
+    }
+
+    xSemaphoreTake(queue_mutex, portMAX_DELAY);
+    stats->available = true;
+    stats->records = pending_records;
+    stats->samples = pending_samples;
+    stats->bytes_pending = pending_bytes;
+    stats->capacity_bytes = segment_count * (OFFLINE_QUEUE_SEGMENT_SIZE - sizeof(segment_header_t));
+    stats->oldest_timestamp_ms = pending_records > 0 ? tail_timestamp_ms : 0;
+    stats->dropped_samples = dropped_samples;
+    stats->replayed_samples = replayed_samples;
+    xSemaphoreGive(queue_mutex);
+}
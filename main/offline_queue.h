@@ -0,0 +1,108 @@
+/**
+ * @file offline_queue.h
+ * @brief Persistent store-and-forward queue for telemetry in a raw flash partition
+ *
+ * Records that cannot be published (MQTT/WiFi down) are appended to the
+ * "offline_q" data partition and replayed oldest-first after reconnecting:
+ * - The partition is a ring of 4KB segments (one flash sector each), written
+ *   append-only; a segment is only erased when the ring wraps around to it
+ * - A replayed record is marked consumed in place (bits cleared, no erase),
+ *   so after a reboot replay resumes where it stopped
+ * - When the ring is full the oldest segment is dropped (counted in the stats)
+ * - Every record carries a CRC; a torn record (power loss) is skipped
+ *
+ * Records are opaque to the queue; the caller supplies a sample count and the
+ * timestamp of the oldest sample for the statistics. Thread safe.
+ */
+
+#ifndef OFFLINE_QUEUE_H
+#define OFFLINE_QUEUE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OFFLINE_QUEUE_PARTITION_LABEL    "offline_q"
+#define OFFLINE_QUEUE_PARTITION_SUBTYPE  0x40
+#define OFFLINE_QUEUE_SEGMENT_SIZE       4096
+
+// Largest record payload (one record never spans two segments)
+#define OFFLINE_QUEUE_MAX_RECORD         (OFFLINE_QUEUE_SEGMENT_SIZE - 16 - 24)
+
+/**
+ * @brief Handle of the record returned by offline_queue_peek()
+ */
+typedef struct {
+    uint32_t segment;         ///< Segment index
+    uint32_t offset;          ///< Offset of the record header in the segment
+    uint32_t generation;      ///< Invalidates handles after drops/clear
+    size_t len;               ///< Payload length
+    uint16_t samples;         ///< Sample count given to offline_queue_push()
+    int64_t timestamp_ms;     ///< Timestamp given to offline_queue_push()
+} offline_queue_record_t;
+
+/**
+ * @brief Queue statistics
+ */
+typedef struct {
+    bool available;           ///< Partition found and initialised
+    uint32_t records;         ///< Records waiting for replay
+    uint32_t samples;         ///< Samples waiting for replay
+    uint32_t bytes_pending;   ///< Flash bytes used by waiting records
+    uint32_t capacity_bytes;  ///< Usable flash bytes
+    int64_t oldest_timestamp_ms; ///< Timestamp of the oldest waiting record (0 if empty)
+    uint32_t dropped_samples; ///< Samples lost since boot (ring full or corrupt record)
+    uint32_t replayed_samples;///< Samples replayed since boot
+} offline_queue_stats_t;
+
+/**
+ * @brief Find the partition and recover the queue state from flash
+ *
+ * @return ESP_OK, or ESP_ERR_NOT_FOUND if the partition table has no offline_q
+ */
+esp_err_t offline_queue_init(void);
+
+/**
+ * @brief Append a record
+ *
+ * @param data Payload
+ * @param len Payload length (max OFFLINE_QUEUE_MAX_RECORD)
+ * @param samples Number of samples in the payload (statistics only)
+ * @param timestamp_ms Timestamp of the oldest sample (statistics only)
+ */
+esp_err_t offline_queue_push(const void *data, size_t len, uint16_t samples, int64_t timestamp_ms);
+
+/**
+ * @brief Copy the oldest waiting record without removing it
+ *
+ * @param out Destination for the payload
+ * @param max Capacity of out
+ * @param record Filled with the record handle, pass to offline_queue_consume()
+ * @return ESP_OK, ESP_ERR_NOT_FOUND if the queue is empty
+ */
+esp_err_t offline_queue_peek(void *out, size_t max, offline_queue_record_t *record);
+
+/**
+ * @brief Remove the record returned by the last offline_queue_peek()
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_STATE if it is no longer the oldest record
+ */
+esp_err_t offline_queue_consume(const offline_queue_record_t *record);
+
+/**
+ * @brief Discard everything (erases the whole partition)
+ */
+esp_err_t offline_queue_clear(void);
+
+void offline_queue_get_stats(offline_queue_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OFFLINE_QUEUE_H
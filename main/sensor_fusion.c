@@ -0,0 +1,247 @@
+/**
+ * @file sensor_fusion.c
+ * @brief Complementary and Mahony attitude filters for the MPU6050
+ *
+ * Kept free of ESP-IDF headers so it builds on the host as well.
+ */
+
+#include "sensor_fusion.h"
+#include <math.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define RAD_TO_DEG (180.0f / (float)M_PI)
+#define DEG_TO_RAD ((float)M_PI / 180.0f)
+
+// Complementary filter tuning
+#define COMP_TAU_S              1.0f    // Crossover time constant: gyro below, accel above
+#define COMP_BIAS_GAIN          0.1f    // Bias tracking gain (1/s²)
+
+// Mahony filter tuning (gains on the half-error, as in the reference implementation)
+#define MAHONY_TWO_KP           1.0f
+#define MAHONY_TWO_KI           0.05f
+
+// Accelerometer is only trusted when |a| is close to 1g (rejects bumps and braking)
+#define ACCEL_TRUST_MIN_G       0.85f
+#define ACCEL_TRUST_MAX_G       1.15f
+
+// Largest plausible gap between samples; longer gaps re-seed from the accelerometer
+#define MAX_DT_S                0.5f
+
+static float wrap_180(float angle)
+{
+    while (angle > 180.0f) angle -= 360.0f;
+    while (angle < -180.0f) angle += 360.0f;
+    return angle;
+}
+
+static bool accel_trusted(const sensor_fusion_sample_t *s, float *norm)
+{
+    float n = sqrtf(s->ax * s->ax + s->ay * s->ay + s->az * s->az);
+    *norm = n;
+    return (n > ACCEL_TRUST_MIN_G && n < ACCEL_TRUST_MAX_G);
+}
+
+static void accel_angles(const sensor_fusion_sample_t *s, float *pitch, float *roll)
+{
+    *pitch = -atan2f(s->ay, sqrtf(s->ax * s->ax + s->az * s->az)) * RAD_TO_DEG;
+    *roll = -atan2f(s->ax, s->az) * RAD_TO_DEG;
+}
+
+static void seed_from_accel(sensor_fusion_t *f, const sensor_fusion_sample_t *s)
+{
+    accel_angles(s, &f->pitch, &f->roll);
+    f->pitch_rate = 0.0f;
+    f->roll_rate = 0.0f;
+
+    // Aerospace roll (phi, about X) and pitch (theta, about Y), yaw = 0
+    float phi = atan2f(s->ay, s->az);
+    float theta = atan2f(-s->ax, sqrtf(s->ay * s->ay + s->az * s->az));
+    float cphi = cosf(phi * 0.5f), sphi = sinf(phi * 0.5f);
+    float cth = cosf(theta * 0.5f), sth = sinf(theta * 0.5f);
+    f->q0 = cphi * cth;
+    f->q1 = sphi * cth;
+    f->q2 = cphi * sth;
+    f->q3 = -sphi * sth;
+
+    f->initialized = true;
+}
+
+static void update_complementary(sensor_fusion_t *f, const sensor_fusion_sample_t *s, float dt)
+{
+    f->pitch_rate = -(s->gx - f->bias_x);
+    f->roll_rate = s->gy - f->bias_y;
+
+    float pitch = f->pitch + f->pitch_rate * dt;
+    float roll = wrap_180(f->roll + f->roll_rate * dt);
+
+    float norm;
+    if (accel_trusted(s, &norm)) {
+        float acc_pitch, acc_roll;
+        accel_angles(s, &acc_pitch, &acc_roll);
+
+        float alpha = COMP_TAU_S / (COMP_TAU_S + dt);
+        float err_pitch = acc_pitch - pitch;
+        float err_roll = wrap_180(acc_roll - roll);
+
+        pitch += (1.0f - alpha) * err_pitch;
+        roll = wrap_180(roll + (1.0f - alpha) * err_roll);
+
+        // Persistent error means the gyro integrates a bias: pull it out
+        f->bias_x += COMP_BIAS_GAIN * err_pitch * dt;
+        f->bias_y -= COMP_BIAS_GAIN * err_roll * dt;
+    }
+
+    f->pitch = pitch;
+    f->roll = roll;
+}
+
+static void update_mahony(sensor_fusion_t *f, const sensor_fusion_sample_t *s, float dt)
+{
+    float gx = s->gx * DEG_TO_RAD;
+    float gy = s->gy * DEG_TO_RAD;
+    float gz = s->gz * DEG_TO_RAD;
+    float q0 = f->q0, q1 = f->q1, q2 = f->q2, q3 = f->q3;
+
+    float norm;
+    if (accel_trusted(s, &norm)) {
+        float ax = s->ax / norm;
+        float ay = s->ay / norm;
+        float az = s->az / norm;
+
+        // Estimated direction of gravity (half vector)
+        float halfvx = q1 * q3 - q0 * q2;
+        float halfvy = q0 * q1 + q2 * q3;
+        float halfvz = q0 * q0 - 0.5f + q3 * q3;
+
+        // Error is the cross product between measured and estimated gravity
+        float halfex = ay * halfvz - az * halfvy;
+        float halfey = az * halfvx - ax * halfvz;
+        float halfez = ax * halfvy - ay * halfvx;
+
+        f->ix += MAHONY_TWO_KI * halfex * dt;
+        f->iy += MAHONY_TWO_KI * halfey * dt;
+        f->iz += MAHONY_TWO_KI * halfez * dt;
+
+        gx += MAHONY_TWO_KP * halfex;
+        gy += MAHONY_TWO_KP * halfey;
+        gz += MAHONY_TWO_KP * halfez;
+    }
+
+    gx += f->ix;
+    gy += f->iy;
+    gz += f->iz;
+
+    // Integrate rate of change of quaternion
+    float half_dt = 0.5f * dt;
+    gx *= half_dt;
+    gy *= half_dt;
+    gz *= half_dt;
+    float qa = q0, qb = q1, qc = q2;
+    q0 += (-qb * gx - qc * gy - q3 * gz);
+    q1 += (qa * gx + qc * gz - q3 * gy);
+    q2 += (qa * gy - qb * gz + q3 * gx);
+    q3 += (qa * gz + qb * gy - qc * gx);
+
+    float recip = 1.0f / sqrtf(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+    f->q0 = q0 * recip;
+    f->q1 = q1 * recip;
+    f->q2 = q2 * recip;
+    f->q3 = q3 * recip;
+
+    // Express the result with the same formulas as the accelerometer angles
+    sensor_fusion_sample_t g = {
+        .ax = 2.0f * (f->q1 * f->q3 - f->q0 * f->q2),
+        .ay = 2.0f * (f->q0 * f->q1 + f->q2 * f->q3),
+        .az = f->q0 * f->q0 - f->q1 * f->q1 - f->q2 * f->q2 + f->q3 * f->q3,
+    };
+    accel_angles(&g, &f->pitch, &f->roll);
+
+    f->pitch_rate = -(s->gx + f->ix * RAD_TO_DEG);
+    f->roll_rate = s->gy + f->iy * RAD_TO_DEG;
+}
+
+void sensor_fusion_init(sensor_fusion_t *f, sensor_fusion_algorithm_t algorithm)
+{
+    memset(f, 0, sizeof(*f));
+    f->algorithm = algorithm;
+    f->q0 = 1.0f;
+}
+
+void sensor_fusion_set_gyro_bias(sensor_fusion_t *f, float bx, float by, float bz)
+{
+    f->bias_x = bx;
+    f->bias_y = by;
+
+    // Mahony adds the integral term to the gyro, so it holds the negated bias
+    f->ix = -bx * DEG_TO_RAD;
+    f->iy = -by * DEG_TO_RAD;
+    f->iz = -bz * DEG_TO_RAD;
+}
+
+void sensor_fusion_sample_from_raw(const uint8_t raw[14], sensor_fusion_sample_t *out)
+{
+    int16_t accel_x = (int16_t)((raw[0] << 8) | raw[1]);
+    int16_t accel_y = (int16_t)((raw[2] << 8) | raw[3]);
+    int16_t accel_z = (int16_t)((raw[4] << 8) | raw[5]);
+    // raw[6..7] is temperature
+    int16_t gyro_x = (int16_t)((raw[8] << 8) | raw[9]);
+    int16_t gyro_y = (int16_t)((raw[10] << 8) | raw[11]);
+    int16_t gyro_z = (int16_t)((raw[12] << 8) | raw[13]);
+
+    out->ax = accel_x / SENSOR_FUSION_ACCEL_LSB_PER_G;
+    out->ay = accel_y / SENSOR_FUSION_ACCEL_LSB_PER_G;
+    out->az = accel_z / SENSOR_FUSION_ACCEL_LSB_PER_G;
+    out->gx = gyro_x / SENSOR_FUSION_GYRO_LSB_PER_DPS;
+    out->gy = gyro_y / SENSOR_FUSION_GYRO_LSB_PER_DPS;
+    out->gz = gyro_z / SENSOR_FUSION_GYRO_LSB_PER_DPS;
+}
+
+void sensor_fusion_update(sensor_fusion_t *f, const sensor_fusion_sample_t *s, float dt)
+{
+    if (!f->initialized || dt <= 0.0f || dt > MAX_DT_S) {
+        seed_from_accel(f, s);
+        return;
+    }
+
+    if (f->algorithm == SENSOR_FUSION_MAHONY) {
+        update_mahony(f, s, dt);
+    } else {
+        update_complementary(f, s, dt);
+    }
+}
+
+const char *sensor_fusion_algorithm_name(sensor_fusion_algorithm_t algorithm)
+{
+    switch (algorithm) {
+        case SENSOR_FUSION_COMPLEMENTARY:
+            return "complementary";
+        case SENSOR_FUSION_MAHONY:
+            return "mahony";
+        default:
+            return "unknown";
+    }
+}
+
+uint32_t sensor_fusion_replay(sensor_fusion_algorithm_t algorithm,
+                              const sensor_fusion_sample_t *frames, size_t count, float dt,
+                              uint32_t (*cycle_counter)(void), sensor_fusion_t *out_final)
+{
+    sensor_fusion_t f;
+    sensor_fusion_init(&f, algorithm);
+
+    uint32_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t start = cycle_counter();
+        sensor_fusion_update(&f, &frames[i], dt);
+        total += cycle_counter() - start;
+    }
+
+    if (out_final) {
+        *out_final = f;
+    }
+    return total;
+}
@@ -0,0 +1,144 @@
+/**
+ * @file sensor_fusion.h
+ * @brief Gyro + accelerometer attitude fusion for the level display
+ *
+ * Combines the MPU6050 gyroscope rates with the accelerometer gravity
+ * vector to produce smooth, low-latency pitch/roll angles:
+ * - Complementary filter with gyro bias tracking (default)
+ * - Mahony filter (quaternion, PI feedback on the gravity error)
+ *
+ * The module has no ESP-IDF dependencies so it can be compiled and
+ * exercised on a host machine. The algorithm used by the firmware is
+ * selected at build time with SENSOR_FUSION_ALGORITHM.
+ */
+
+#ifndef SENSOR_FUSION_H
+#define SENSOR_FUSION_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Available fusion algorithms
+ */
+typedef enum {
+    SENSOR_FUSION_COMPLEMENTARY = 0,   ///< Per-axis complementary filter with bias estimate
+    SENSOR_FUSION_MAHONY = 1,          ///< Quaternion Mahony filter
+} sensor_fusion_algorithm_t;
+
+// Build-time algorithm selection (override with -DSENSOR_FUSION_ALGORITHM=1)
+#ifndef SENSOR_FUSION_ALGORITHM
+#define SENSOR_FUSION_ALGORITHM SENSOR_FUSION_COMPLEMENTARY
+#endif
+
+// Raw MPU6050 scale factors for the default ranges (±2g, ±250°/s)
+#define SENSOR_FUSION_ACCEL_LSB_PER_G    16384.0f
+#define SENSOR_FUSION_GYRO_LSB_PER_DPS   131.0f
+
+/**
+ * @brief One sensor frame in physical units
+ */
+typedef struct {
+    float ax, ay, az;   ///< Acceleration in g
+    float gx, gy, gz;   ///< Angular rate in °/s
+} sensor_fusion_sample_t;
+
+/**
+ * @brief Filter state
+ *
+ * Angles use the same sensor-frame convention as the previous
+ * accelerometer-only code in main.c:
+ *   pitch = -atan2(ay, sqrt(ax² + az²))   (rotation about X, rate = -gx)
+ *   roll  = -atan2(ax, az)                (rotation about Y, rate = +gy)
+ * so existing calibration offsets and axis mapping remain valid.
+ */
+typedef struct {
+    sensor_fusion_algorithm_t algorithm;
+    bool initialized;         ///< First sample seeds the state from the accelerometer
+    float pitch;              ///< Fused sensor-frame pitch (degrees)
+    float roll;               ///< Fused sensor-frame roll (degrees)
+    float pitch_rate;         ///< Bias-corrected pitch rate (°/s)
+    float roll_rate;          ///< Bias-corrected roll rate (°/s)
+
+    // Complementary filter
+    float bias_x;             ///< Gyro X bias estimate (°/s)
+    float bias_y;             ///< Gyro Y bias estimate (°/s)
+
+    // Mahony filter
+    float q0, q1, q2, q3;     ///< Orientation quaternion
+    float ix, iy, iz;         ///< Integral feedback (rad/s)
+} sensor_fusion_t;
+
+/**
+ * @brief Reset the filter
+ *
+ * @param f Filter state
+ * @param algorithm Algorithm to run (normally SENSOR_FUSION_ALGORITHM)
+ */
+void sensor_fusion_init(sensor_fusion_t *f, sensor_fusion_algorithm_t algorithm);
+
+/**
+ * @brief Seed the gyro bias estimate
+ *
+ * The filters track bias on their own, but that takes tens of seconds.
+ * Seeding with a short stationary average at startup removes the
+ * initial drift.
+ *
+ * @param f Filter state
+ * @param bx Gyro X bias (°/s)
+ * @param by Gyro Y bias (°/s)
+ * @param bz Gyro Z bias (°/s)
+ */
+void sensor_fusion_set_gyro_bias(sensor_fusion_t *f, float bx, float by, float bz);
+
+/**
+ * @brief Convert a raw 14-byte MPU6050 burst (ACCEL_XOUT_H..GYRO_ZOUT_L)
+ *
+ * @param raw 14 bytes as read from register 0x3B
+ * @param out Sample in physical units
+ */
+void sensor_fusion_sample_from_raw(const uint8_t raw[14], sensor_fusion_sample_t *out);
+
+/**
+ * @brief Feed one sample into the filter
+ *
+ * @param f Filter state
+ * @param s Sample in physical units
+ * @param dt Time since the previous sample in seconds
+ */
+void sensor_fusion_update(sensor_fusion_t *f, const sensor_fusion_sample_t *s, float dt);
+
+/**
+ * @brief Human readable algorithm name
+ */
+const char *sensor_fusion_algorithm_name(sensor_fusion_algorithm_t algorithm);
+
+/**
+ * @brief Replay recorded frames through a fresh filter
+ *
+ * Used by the benchmark to measure cost per update. The cycle counter is
+ * supplied by the caller (esp_cpu_get_cycle_count() on target, a
+ * clock-based counter on host) to keep this module platform independent.
+ *
+ * @param algorithm Algorithm to run
+ * @param frames Recorded samples
+ * @param count Number of samples
+ * @param dt Sample period in seconds
+ * @param cycle_counter Returns a free-running cycle count
+ * @param out_final Optional final filter state (for sanity checks)
+ * @return Total cycles spent in sensor_fusion_update()
+ */
+uint32_t sensor_fusion_replay(sensor_fusion_algorithm_t algorithm,
+                              const sensor_fusion_sample_t *frames, size_t count, float dt,
+                              uint32_t (*cycle_counter)(void), sensor_fusion_t *out_final);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SENSOR_FUSION_H
@@ -0,0 +1,103 @@
+/**
+ * @file sensor_history.c
+ * @brief Single-writer, multi-reader sensor history ring
+ */
+
+#include "sensor_history.h"
+#include <string.h>
+
+#define HISTORY_MASK (SENSOR_HISTORY_CAPACITY - 1)
+
+_Static_assert((SENSOR_HISTORY_CAPACITY & HISTORY_MASK) == 0,
+               "SENSOR_HISTORY_CAPACITY must be a power of two");
+
+static sensor_history_t default_history;
+
+sensor_history_t *sensor_history_default(void)
+{
+    return &default_history;
+}
+
+void sensor_history_append(sensor_history_t *h, const sensor_history_sample_t *sample)
+{
+    unsigned n = atomic_load_explicit(&h->head, memory_order_relaxed);
+    sensor_history_slot_t *slot = &h->slots[n & HISTORY_MASK];
+
+    // Odd sequence marks the slot as being rewritten
+    atomic_store_explicit(&slot->seq, 2u * n + 1u, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    memcpy(&slot->sample, sample, sizeof(*sample));
+    atomic_store_explicit(&slot->seq, 2u * n + 2u, memory_order_release);
+
+    atomic_store_explicit(&h->head, n + 1u, memory_order_release);
+}
+
+void sensor_history_reader_init(sensor_history_t *h, sensor_history_reader_t *r, bool from_oldest)
+{
+    unsigned head = atomic_load_explicit(&h->head, memory_order_acquire);
+
+    r->next = head;
+    if (from_oldest) {
+        r->next = head > SENSOR_HISTORY_CAPACITY ? head - SENSOR_HISTORY_CAPACITY : 0;
+    }
+    r->overruns = 0;
+    r->lost = 0;
+}
+
+uint32_t sensor_history_available(sensor_history_t *h, const sensor_history_reader_t *r)
+{
+    return atomic_load_explicit(&h->head, memory_order_acquire) - r->next;
+}
+
+// Skip to the oldest sample that is safe to read, counting what was missed
+static uint32_t resync(sensor_history_reader_t *r, unsigned head)
+{
+    // Leave one slot of margin: the writer may already be rewriting head - CAPACITY
+    uint32_t oldest = head - SENSOR_HISTORY_CAPACITY + 1u;
+    uint32_t missed = oldest - r->next;
+
+    r->next = oldest;
+    r->overruns++;
+    r->lost += missed;
+    return missed;
+}
+
+size_t sensor_history_read(sensor_history_t *h, sensor_history_reader_t *r,
+                           sensor_history_sample_t *out, size_t max, uint32_t *lost)
+{
+    uint32_t skipped = 0;
+    size_t count = 0;
+
+    while (count < max) {
+        unsigned head = atomic_load_explicit(&h->head, memory_order_acquire);
+        if (r->next == head) {
+            break;  // Caught up
+        }
+        if (head - r->next >= SENSOR_HISTORY_CAPACITY) {
+            skipped += resync(r, head);
+            continue;
+        }
+
+        sensor_history_slot_t *slot = &h->slots[r->next & HISTORY_MASK];
+        unsigned expected = 2u * r->next + 2u;
+
+        unsigned seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        memcpy(&out[count], &slot->sample, sizeof(out[count]));
+        atomic_thread_fence(memory_order_acquire);
+        unsigned seq_after = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+
+        if (seq != expected || seq_after != expected) {
+            // Writer lapped us during the copy
+            skipped += resync(r, atomic_load_explicit(&h->head, memory_order_acquire));
+            continue;
+        }
+
+        r->next++;
+        count++;
+    }
+
+    if (lost) {
+        *lost = skipped;
+    }
+    return count;
+}
@@ -0,0 +1,114 @@
+/**
+ * @file sensor_history.h
+ * @brief Timestamped multi-reader history of full-rate sensor samples
+ *
+ * Fixed-size ring buffer that the MPU6050 task appends every FIFO sample
+ * to. Any number of consumers (MQTT publisher, SD logger, charts,
+ * statistics) keep their own read cursor and walk the history at their own
+ * pace:
+ * - The writer never waits for readers; a slow reader is told how many
+ *   samples it missed (overrun) and resumes at the oldest sample still held
+ * - Readers never block and never return a half-written sample (each slot
+ *   carries its own sequence number, checked before and after the copy)
+ *
+ * Single writer only. Pure C11 (stdatomic), no ESP-IDF dependencies.
+ */
+
+#ifndef SENSOR_HISTORY_H
+#define SENSOR_HISTORY_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Number of samples kept (power of two). 512 samples = 2.5s at 200 Hz, 16KB
+#ifndef SENSOR_HISTORY_CAPACITY
+#define SENSOR_HISTORY_CAPACITY 512
+#endif
+
+/**
+ * @brief One sensor sample
+ */
+typedef struct {
+    int64_t timestamp_us;     ///< esp_timer time the sample was taken
+    int16_t accel[3];         ///< Raw accelerometer X/Y/Z (LSB)
+    int16_t gyro[3];          ///< Raw gyroscope X/Y/Z (LSB)
+    float pitch;              ///< Fused physical pitch, offsets applied (degrees)
+    float roll;               ///< Fused physical roll, offsets applied (degrees)
+} sensor_history_sample_t;
+
+/**
+ * @brief Ring slot
+ */
+typedef struct {
+    atomic_uint seq;          ///< 2n+1 while sample n is written, 2n+2 when complete
+    sensor_history_sample_t sample;
+} sensor_history_slot_t;
+
+/**
+ * @brief History ring (statically allocated, zero-initialised is valid)
+ */
+typedef struct {
+    sensor_history_slot_t slots[SENSOR_HISTORY_CAPACITY];
+    atomic_uint head;         ///< Total number of samples appended
+} sensor_history_t;
+
+/**
+ * @brief Per-consumer read cursor
+ */
+typedef struct {
+    uint32_t next;            ///< Index of the next sample to read
+    uint32_t overruns;        ///< Number of times the reader fell behind
+    uint32_t lost;            ///< Total samples missed because of overruns
+} sensor_history_reader_t;
+
+/**
+ * @brief History shared by the firmware (written by the MPU6050 task)
+ */
+sensor_history_t *sensor_history_default(void);
+
+/**
+ * @brief Append a sample (single writer only, never blocks)
+ */
+void sensor_history_append(sensor_history_t *h, const sensor_history_sample_t *sample);
+
+/**
+ * @brief Attach a reader
+ *
+ * @param h History
+ * @param r Reader cursor
+ * @param from_oldest true to start at the oldest sample still held,
+ *                    false to receive only samples appended from now on
+ */
+void sensor_history_reader_init(sensor_history_t *h, sensor_history_reader_t *r, bool from_oldest);
+
+/**
+ * @brief Number of samples waiting for this reader (may exceed the capacity
+ *        if the reader has already been overrun)
+ */
+uint32_t sensor_history_available(sensor_history_t *h, const sensor_history_reader_t *r);
+
+/**
+ * @brief Copy up to max samples and advance the cursor
+ *
+ * @param h History
+ * @param r Reader cursor
+ * @param out Destination for samples, oldest first
+ * @param max Capacity of out
+ * @param lost Optional: samples skipped by this call because the writer
+ *             overtook the reader (0 if none)
+ * @return Number of samples copied
+ */
+size_t sensor_history_read(sensor_history_t *h, sensor_history_reader_t *r,
+                           sensor_history_sample_t *out, size_t max, uint32_t *lost);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SENSOR_HISTORY_H
@@ -0,0 +1,47 @@
+/**
+ * @file sensor_snapshot.c
+ * @brief Seqlock latch for the fused sensor state
+ */
+
+#include "sensor_snapshot.h"
+#include <stdatomic.h>
+#include <string.h>
+
+// copies[seq & 1] is stable while the writer updates the other copy
+static sensor_snapshot_t copies[2];
+static atomic_uint latch_seq = 0;
+static uint32_t publish_count = 0;   // Only touched by the writer
+
+void sensor_snapshot_publish(const sensor_snapshot_t *state)
+{
+    sensor_snapshot_t next = *state;
+    next.seq = ++publish_count;
+    if (next.seq == 0) {
+        next.seq = ++publish_count;  // 0 is reserved for "no data"
+    }
+
+    unsigned seq = atomic_load_explicit(&latch_seq, memory_order_relaxed);
+
+    // Odd: readers move to copies[1] while copies[0] is rewritten
+    atomic_store_explicit(&latch_seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    memcpy(&copies[0], &next, sizeof(next));
+
+    // Even: readers move back to copies[0] while copies[1] catches up
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&latch_seq, seq + 2, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    memcpy(&copies[1], &next, sizeof(next));
+}
+
+bool sensor_snapshot_read(sensor_snapshot_t *out)
+{
+    unsigned seq;
+    do {
+        seq = atomic_load_explicit(&latch_seq, memory_order_acquire);
+        memcpy(out, &copies[seq & 1], sizeof(*out));
+        atomic_thread_fence(memory_order_acquire);
+    } while (seq != atomic_load_explicit(&latch_seq, memory_order_relaxed));
+
+    return out->seq != 0;
+}
@@ -0,0 +1,64 @@
+/**
+ * @file sensor_snapshot.h
+ * @brief Lock-free snapshot of the fused sensor state
+ *
+ * The MPU6050 task is the only writer; the GUI, MQTT and serial menu read
+ * from either core. Readers never block and always get a consistent copy of
+ * the most recently published state (no torn pitch/roll pairs, no skipped
+ * updates because a mutex was busy).
+ *
+ * Implemented as a seqlock "latch": two copies of the state and a sequence
+ * counter. The writer updates one copy while readers use the other, so a
+ * reader only retries if the writer completes an update on the other core
+ * during its copy - it never waits for a preempted writer.
+ *
+ * Pure C11 (stdatomic), no ESP-IDF dependencies.
+ */
+
+#ifndef SENSOR_SNAPSHOT_H
+#define SENSOR_SNAPSHOT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Fused sensor state as shown to the user
+ *
+ * Angles are in the physical (mounting-corrected) frame with the
+ * calibration offsets already applied, exactly as the Level tab shows them
+ * before the optional sensor inversion.
+ */
+typedef struct {
+    float pitch;              ///< Forward/backward tilt (degrees)
+    float roll;               ///< Left/right tilt (degrees)
+    float pitch_rate;         ///< Pitch rate (°/s)
+    float roll_rate;          ///< Roll rate (°/s)
+    float temperature;        ///< MPU6050 die temperature (°C)
+    int64_t timestamp_us;     ///< esp_timer time of the newest sample in the update
+    uint32_t seq;             ///< Update counter, set by sensor_snapshot_publish() (0 = no data yet)
+} sensor_snapshot_t;
+
+/**
+ * @brief Publish a new state (single writer only)
+ *
+ * @param state New state; the seq field is ignored and assigned internally
+ */
+void sensor_snapshot_publish(const sensor_snapshot_t *state);
+
+/**
+ * @brief Copy the latest state without blocking
+ *
+ * @param out Receives the state
+ * @return true if at least one state has been published
+ */
+bool sensor_snapshot_read(sensor_snapshot_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SENSOR_SNAPSHOT_H
@@ -4,6 +4,10 @@
  */
 
 #include "serial_menu.h"
+#include "sensor_snapshot.h"
+#include "sensor_history.h"
+#include "offline_queue.h"
+#include "mqtt_failover.h"
 #include "esp_log.h"
 #include "esp_system.h"
 #include "freertos/FreeRTOS.h"
@@ -24,6 +28,33 @@ static const char *TAG = "SerialMenu";
 // External function from main.c to reload calibration offsets
 extern void load_calibration_offsets(void);
 
+// External function from main.c to reload level telemetry batching settings
+extern void load_level_telemetry_settings(void);
+
+// External function from main.c to benchmark the sensor fusion filters
+extern void sensor_fusion_benchmark(void);
+
+// External function from main.c to benchmark the MQTT JSON encoder
+extern void json_writer_benchmark(void);
+
+// External function from main.c: age of the oldest sample in the offline queue (-1 if unknown)
+extern int64_t level_queue_oldest_age_ms(const offline_queue_stats_t *stats);
+
+// External functions from main.c: GUI loop wakeups/idle time and loop mode
+extern void gui_loop_report(void);
+extern void gui_loop_set_polling(bool polling);
+extern bool gui_loop_is_polling(void);
+
+// External function from main.c to benchmark the display render/flush pipeline
+extern void display_benchmark(void);
+
+// External function from main.c: render time per tab and cycles per LVGL function
+extern void lvgl_render_profile(void);
+
+// External functions from main.c: display dim/sleep state and timeouts
+extern void gui_power_report(void);
+extern void load_display_power_settings(void);
+
 // Task handle
 static TaskHandle_t menu_task_handle = NULL;
 
@@ -38,11 +69,21 @@ static void configure_wifi(void);
 static void configure_timesource(void);
 static void configure_mqtt_primary(void);
 static void configure_mqtt_secondary(void);
+static void configure_level_telemetry(void);
 static void configure_timezone(void);
 static void configure_language(void);
 static void configure_theme(void);
 static void configure_level_offsets(void);
+static void configure_sensor_rate(void);
 static void show_sensor_data(void);
+static void run_fusion_benchmark(void);
+static void run_json_benchmark(void);
+static void show_offline_queue(void);
+static void show_mqtt_failover(void);
+static void show_gui_loop(void);
+static void run_display_benchmark(void);
+static void run_render_profile(void);
+static void configure_display_power(void);
 static void factory_reset(void);
 
 // Forward declarations - Helpers
@@ -148,12 +189,22 @@ static void display_main_menu(void)
     printf("  MQTT CONFIGURATION\n");
     printf("  [7] Configure Primary MQTT Server\n");
     printf("  [8] Configure Secondary MQTT Server\n");
+    printf("  [l] Level Telemetry Batching\n");
+    printf("  [j] Payload Encoder Benchmark\n");
+    printf("  [o] Offline Queue Status\n");
+    printf("  [h] Broker Health / Failover Status\n");
     printf("\n");
     printf("  LEVEL CALIBRATION\n");
     printf("  [9] Configure Level Offsets\n");
+    printf("  [a] Sensor Sample Rate\n");
     printf("  [s] Show Live Sensor Data\n");
+    printf("  [b] Sensor Fusion Benchmark\n");
     printf("\n");
     printf("  SYSTEM\n");
+    printf("  [g] GUI Loop Wakeups / Idle\n");
+    printf("  [d] Display Pipeline Benchmark\n");
+    printf("  [k] LVGL Render Profile (IRAM placement)\n");
+    printf("  [p] Display Power (dim / sleep)\n");
     printf("  [f] Factory Reset\n");
     printf("  [r] Reboot Device\n");
     printf("  [q] Exit Menu\n");
@@ -194,10 +245,50 @@ static void handle_menu_input(char input)
         case '9':
             configure_level_offsets();
             break;
+        case 'l':
+        case 'L':
+            configure_level_telemetry();
+            break;
+        case 'j':
+        case 'J':
+            run_json_benchmark();
+            break;
+        case 'o':
+        case 'O':
+            show_offline_queue();
+            break;
+        case 'h':
+        case 'H':
+            show_mqtt_failover();
+            break;
+        case 'a':
+        case 'A':
+            configure_sensor_rate();
+            break;
         case 's':
         case 'S':
             show_sensor_data();
             break;
+        case 'b':
+        case 'B':
+            run_fusion_benchmark();
+            break;
+        case 'g':
+        case 'G':
+            show_gui_loop();
+            break;
+        case 'd':
+        case 'D':
+            run_display_benchmark();
+            break;
+        case 'k':
+        case 'K':
+            run_render_profile();
+            break;
+        case 'p':
+        case 'P':
+            configure_display_power();
+            break;
         case 'f':
         case 'F':
             factory_reset();
@@ -327,6 +418,22 @@ static void print_current_settings(void)
 
     printf("\n");
 
+    // === LEVEL TELEMETRY ===
+    printf("LEVEL TELEMETRY (MQTT):\n");
+
+    uint16_t lvl_rate = 50, lvl_batch = 50, lvl_flush_ms = 1000;
+    uint8_t lvl_format = 1;
+    nvs_get_u16_default(NVS_LINDI, "lvl_rate", &lvl_rate, 50);
+    nvs_get_u16_default(NVS_LINDI, "lvl_batch", &lvl_batch, 50);
+    nvs_get_u16_default(NVS_LINDI, "lvl_flush_ms", &lvl_flush_ms, 1000);
+    nvs_get_u8_default(NVS_LINDI, "lvl_format", &lvl_format, 1);
+    printf("  Sample Rate:  %u Hz\n", lvl_rate);
+    printf("  Batch Size:   %u samples\n", lvl_batch);
+    printf("  Flush After:  %u ms\n", lvl_flush_ms);
+    printf("  Format:       %s\n", lvl_format == 2 ? "CBOR" : lvl_format ? "Columnar" : "Array");
+
+    printf("\n");
+
     // === LEVEL OFFSETS ===
     printf("LEVEL CALIBRATION OFFSETS:\n");
 
@@ -346,6 +453,10 @@ static void print_current_settings(void)
     nvs_get_u8_default(NVS_LINDI, "invert_level", &invert_level, 0);
     printf("  Invert Level: %s\n", invert_level ? "Yes" : "No");
 
+    uint16_t mpu_rate = 200;
+    nvs_get_u16_default(NVS_LINDI, "mpu_rate", &mpu_rate, 200);
+    printf("  Sample Rate:  %u Hz\n", mpu_rate);
+
     printf("\n");
     printf("════════════════════════════════════════════════════════\n");
     printf("\nPress any key to return to menu...");
@@ -627,6 +738,51 @@ static void configure_theme(void)
     printf("\n");
 }
 
+static void configure_level_telemetry(void)
+{
+    printf("════════════════════════════════════════════════════════\n");
+    printf("  Level Telemetry Batching\n");
+    printf("════════════════════════════════════════════════════════\n");
+    printf("\n");
+
+    uint16_t rate = 50, batch = 50, flush_ms = 1000;
+    uint8_t format = 1;
+    nvs_get_u16_default(NVS_LINDI, "lvl_rate", &rate, 50);
+    nvs_get_u16_default(NVS_LINDI, "lvl_batch", &batch, 50);
+    nvs_get_u16_default(NVS_LINDI, "lvl_flush_ms", &flush_ms, 1000);
+    nvs_get_u8_default(NVS_LINDI, "lvl_format", &format, 1);
+
+    printf("Level samples are collected at the sample rate and published\n");
+    printf("to <base>/device/level in batches. A message is sent when the\n");
+    printf("batch is full or the flush time has passed, whichever is first.\n");
+    printf("\n");
+
+    rate = (uint16_t)read_int("Sample rate (Hz)", 1, 1000, rate);
+    batch = (uint16_t)read_int("Batch size (samples/message)", 1, 200, batch);
+    flush_ms = (uint16_t)read_int("Flush after (ms)", 100, 60000, flush_ms);
+
+    printf("\nMessage format:\n");
+    printf("  [0] Array    - one object per sample\n");
+    printf("  [1] Columnar - base timestamp + delta/pitch/roll arrays (smaller)\n");
+    printf("  [2] CBOR     - binary columnar, int16 centi-degrees (smallest)\n");
+    format = (uint8_t)read_int("Format", 0, 2, format);
+
+    nvs_set_u16_safe(NVS_LINDI, "lvl_rate", rate);
+    nvs_set_u16_safe(NVS_LINDI, "lvl_batch", batch);
+    nvs_set_u16_safe(NVS_LINDI, "lvl_flush_ms", flush_ms);
+    nvs_set_u8_safe(NVS_LINDI, "lvl_format", format);
+    load_level_telemetry_settings();  // Apply to the running MQTT task
+
+    printf("\n✓ Level telemetry: %u Hz, %u samples/message, flush %u ms, %s\n",
+           rate, batch, flush_ms, format == 2 ? "cbor" : format ? "columnar" : "array");
+    printf("  Changes applied immediately.\n");
+
+    printf("\nPress any key to continue...");
+    fflush(stdout);
+    read_char_timeout(3000);
+    printf("\n");
+}
+
 static void configure_level_offsets(void)
 {
     printf("════════════════════════════════════════════════════════\n");
@@ -718,6 +874,35 @@ static void configure_level_offsets(void)
     printf("\n");
 }
 
+static void configure_sensor_rate(void)
+{
+    printf("════════════════════════════════════════════════════════\n");
+    printf("  MPU6050 Sample Rate\n");
+    printf("════════════════════════════════════════════════════════\n");
+    printf("\n");
+
+    uint16_t current_rate = 200;
+    nvs_get_u16_default(NVS_LINDI, "mpu_rate", &current_rate, 200);
+    printf("Current sample rate: %u Hz\n", current_rate);
+    printf("\n");
+    printf("Samples are buffered in the sensor FIFO and read in bursts,\n");
+    printf("so higher rates cost little extra CPU time.\n");
+    printf("Rate is rounded to 1000/N Hz (e.g. 1000, 500, 333, 250, 200).\n");
+    printf("\n");
+
+    int rate = read_int("Sample rate (Hz)", 50, 1000, current_rate);
+    rate = 1000 / (1000 / rate);  // Round to what the divider can produce
+
+    nvs_set_u16_safe(NVS_LINDI, "mpu_rate", (uint16_t)rate);
+    printf("\n✓ Sample rate set to %d Hz\n", rate);
+    printf("  Restart device to apply.\n");
+
+    printf("\nPress any key to continue...");
+    fflush(stdout);
+    read_char_timeout(3000);
+    printf("\n");
+}
+
 static void show_sensor_data(void)
 {
     printf("════════════════════════════════════════════════════════\n");
@@ -727,24 +912,159 @@ static void show_sensor_data(void)
     printf("Displaying live sensor data for 10 seconds...\n");
     printf("Press any key to return to menu.\n");
     printf("\n");
-    printf("  Pitch    Roll     Temp\n");
-    printf("  ------   ------   ------\n");
+    printf("  Pitch    Roll     Temp     Samples/s  Pitch p-p  Roll p-p  Lost\n");
+    printf("  ------   ------   ------   ---------  ---------  --------  ----\n");
 
-    // TODO: Integrate with actual MPU6050 reading
-    // For now, show placeholder
-    for (int i = 0; i < 10; i++) {
-        printf("\r  %+6.2f°  %+6.2f°  %.1f°C   ",
-               0.0f, 0.0f, 25.0f);  // Placeholder values
-        fflush(stdout);
+    sensor_snapshot_t snap;
+    if (!sensor_snapshot_read(&snap)) {
+        printf("  No sensor data (MPU6050 not running)\n");
+    }
+
+    // Own history cursor: every sample of the last second goes into the statistics
+    sensor_history_t *history = sensor_history_default();
+    sensor_history_reader_t reader;
+    sensor_history_reader_init(history, &reader, false);
+    sensor_history_sample_t chunk[16];
 
-        // Check for keypress (use read_char_timeout with 1s timeout)
+    for (int i = 0; i < 10; i++) {
+        // Collect one second of samples (any key returns to the menu)
         char c = read_char_timeout(1000);
         if (c != 0) {
             break;
         }
+
+        uint32_t samples = 0;
+        float pitch_min = 0.0f, pitch_max = 0.0f, roll_min = 0.0f, roll_max = 0.0f;
+        size_t n;
+        while ((n = sensor_history_read(history, &reader, chunk, sizeof(chunk) / sizeof(chunk[0]), NULL)) > 0) {
+            for (size_t k = 0; k < n; k++, samples++) {
+                if (samples == 0 || chunk[k].pitch < pitch_min) pitch_min = chunk[k].pitch;
+                if (samples == 0 || chunk[k].pitch > pitch_max) pitch_max = chunk[k].pitch;
+                if (samples == 0 || chunk[k].roll < roll_min) roll_min = chunk[k].roll;
+                if (samples == 0 || chunk[k].roll > roll_max) roll_max = chunk[k].roll;
+            }
+        }
+
+        sensor_snapshot_read(&snap);
+        printf("\r  %+6.2f°  %+6.2f°  %5.1f°C  %9lu  %8.3f°  %7.3f°  %4lu   ",
+               snap.pitch, snap.roll, snap.temperature, (unsigned long)samples,
+               pitch_max - pitch_min, roll_max - roll_min, (unsigned long)reader.lost);
+        fflush(stdout);
     }
 
-    printf("\n\n(Feature pending MPU6050 integration)\n");
+    printf("\n");
+    printf("\nPress any key to continue...");
+    fflush(stdout);
+    read_char_timeout(3000);
+    printf("\n");
+}
+
+static void run_fusion_benchmark(void)
+{
+    printf("════════════════════════════════════════════════════════\n");
+    printf("  Sensor Fusion Benchmark\n");
+    printf("════════════════════════════════════════════════════════\n");
+    printf("\n");
+
+    sensor_fusion_benchmark();
+
+    printf("\nPress any key to continue...");
+    fflush(stdout);
+    read_char_timeout(10000);
+    printf("\n");
+}
+
+static void run_json_benchmark(void)
+{
+    printf("════════════════════════════════════════════════════════\n");
+    printf("  Payload Encoder Benchmark (cJSON / json_writer / CBOR)\n");
+    printf("════════════════════════════════════════════════════════\n");
+    printf("\n");
+
+    json_writer_benchmark();
+
+    printf("\nPress any key to continue...");
+    fflush(stdout);
+    read_char_timeout(10000);
+    printf("\n");
+}
+
+static void show_gui_loop(void)
+{
+    printf("════════════════════════════════════════════════════════\n");
+    printf("  GUI Loop (since the previous report)\n");
+    printf("════════════════════════════════════════════════════════\n");
+    printf("\n");
+
+    gui_loop_report();
+
+    printf("\n");
+    bool polling = read_bool("Use the fixed-tick loop (for comparison)", gui_loop_is_polling());
+    gui_loop_set_polling(polling);
+    printf("Loop mode: %s. Open this menu again later for the new numbers.\n",
+           polling ? "fixed tick" : "event driven");
+}
+
+static void run_display_benchmark(void)
+{
+    printf("════════════════════════════════════════════════════════\n");
+    printf("  Display Pipeline Benchmark (render / SPI flush)\n");
+    printf("════════════════════════════════════════════════════════\n");
+    printf("\n");
+
+    display_benchmark();
+
+    printf("\nPress any key to continue...");
+    fflush(stdout);
+    read_char_timeout(10000);
+    printf("\n");
+}
+
+static void run_render_profile(void)
+{
+    printf("════════════════════════════════════════════════════════\n");
+    printf("  LVGL Render Profile (render time per tab)\n");
+    printf("════════════════════════════════════════════════════════\n");
+    printf("\n");
+
+    lvgl_render_profile();
+
+    printf("\nSave this output for tools/lvgl_iram_place.py\n");
+    printf("Press any key to continue...");
+    fflush(stdout);
+    read_char_timeout(10000);
+    printf("\n");
+}
+
+static void configure_display_power(void)
+{
+    printf("════════════════════════════════════════════════════════\n");
+    printf("  Display Power\n");
+    printf("════════════════════════════════════════════════════════\n");
+    printf("\n");
+
+    gui_power_report();
+
+    uint16_t dim_s = 60, sleep_s = 300;
+    nvs_get_u16_default(NVS_LINDI, "dim_s", &dim_s, 60);
+    nvs_get_u16_default(NVS_LINDI, "sleep_s", &sleep_s, 300);
+
+    printf("\n");
+    printf("Without touch input the backlight dims, then the panel sleeps\n");
+    printf("and the CPU may light sleep. Touch or the MQTT wake_display\n");
+    printf("command lights it again. 0 = never.\n");
+    printf("\n");
+
+    dim_s = (uint16_t)read_int("Dim after (s)", 0, 3600, dim_s);
+    sleep_s = (uint16_t)read_int("Sleep after (s)", 0, 3600, sleep_s);
+
+    nvs_set_u16_safe(NVS_LINDI, "dim_s", dim_s);
+    nvs_set_u16_safe(NVS_LINDI, "sleep_s", sleep_s);
+    load_display_power_settings();  // Apply to the running GUI task
+
+    printf("\n✓ Display: dim after %u s, sleep after %u s\n", dim_s, sleep_s);
+    printf("  Changes applied immediately.\n");
+
     printf("\nPress any key to continue...");
     fflush(stdout);
     read_char_timeout(3000);
@@ -1048,3 +1368,91 @@ static esp_err_t nvs_set_u16_safe(const char *ns, const char *key, uint16_t valu
     nvs_close(handle);
     return err;
 }
+
+static void show_offline_queue(void)
+{
+    printf("════════════════════════════════════════════════════════\n");
+    printf("  Offline Queue (store-and-forward level telemetry)\n");
+    printf("════════════════════════════════════════════════════════\n");
+    printf("\n");
+
+    offline_queue_stats_t stats;
+    offline_queue_get_stats(&stats);
+    if (!stats.available) {
+        printf("Offline queue not available (no 'offline_q' partition)\n");
+    } else {
+        int64_t age_ms = level_queue_oldest_age_ms(&stats);
+        printf("  Records waiting:  %lu\n", (unsigned long)stats.records);
+        printf("  Samples waiting:  %lu\n", (unsigned long)stats.samples);
+        printf("  Bytes pending:    %lu / %lu (%.1f%%)\n", (unsigned long)stats.bytes_pending,
+               (unsigned long)stats.capacity_bytes, 100.0f * stats.bytes_pending / stats.capacity_bytes);
+        if (stats.records == 0) {
+            printf("  Oldest sample:    -\n");
+        } else if (age_ms < 0) {
+            printf("  Oldest sample:    unknown age (clock not set)\n");
+        } else {
+            printf("  Oldest sample:    %lld s old\n", (long long)(age_ms / 1000));
+        }
+        printf("  Replayed:         %lu samples since boot\n", (unsigned long)stats.replayed_samples);
+        printf("  Dropped:          %lu samples since boot (queue full or corrupt)\n",
+               (unsigned long)stats.dropped_samples);
+        printf("\n");
+        printf("Type 'CLEAR' to discard all queued data, Enter to go back: ");
+        fflush(stdout);
+
+        char buf[16];
+        read_line(buf, sizeof(buf));
+        if (strcmp(buf, "CLEAR") == 0) {
+            esp_err_t err = offline_queue_clear();
+            if (err == ESP_OK) {
+                printf("\n✓ Offline queue cleared\n");
+            } else {
+                printf("\n✗ Failed to clear: %s\n", esp_err_to_name(err));
+            }
+        }
+    }
+
+    printf("\nPress any key to continue...");
+    fflush(stdout);
+    read_char_timeout(3000);
+    printf("\n");
+}
+
+static void show_mqtt_failover(void)
+{
+    printf("════════════════════════════════════════════════════════\n");
+    printf("  MQTT Broker Health / Failover\n");
+    printf("════════════════════════════════════════════════════════\n");
+    printf("\n");
+
+    mqtt_failover_stats_t stats;
+    mqtt_failover_get_stats(&stats);
+
+    const mqtt_failover_broker_t *primary = mqtt_failover_broker(MQTT_FAILOVER_PRIMARY);
+    const mqtt_failover_broker_t *secondary = mqtt_failover_broker(MQTT_FAILOVER_SECONDARY);
+    printf("  Primary:          %s\n", primary ? primary->uri : "-");
+    printf("  Secondary:        %s\n", secondary ? secondary->uri : "Not configured (no failover)");
+    printf("  Active:           %s (%s)\n", mqtt_failover_name(stats.active),
+           stats.connected ? "connected" : "not connected");
+    printf("  Failures:         %u / %u before switching\n", stats.failures, MQTT_FAILOVER_MAX_FAILURES);
+    printf("\n");
+    printf("  Probe RTT:        %lu ms (avg %lu ms, max %lu ms)\n", (unsigned long)stats.rtt_ms,
+           (unsigned long)stats.rtt_avg_ms, (unsigned long)stats.rtt_max_ms);
+    printf("  Probe timeouts:   %lu\n", (unsigned long)stats.probe_timeouts);
+    printf("\n");
+    printf("  Switches:         %lu (failbacks %lu, failed failbacks %lu)\n", (unsigned long)stats.switches,
+           (unsigned long)stats.failbacks, (unsigned long)stats.failed_failbacks);
+    if (stats.switches == 0) {
+        printf("  Last switchover:  -\n");
+    } else {
+        printf("  Last switchover:  %lu ms outage (detect %lu ms, connect %lu ms)\n",
+               (unsigned long)stats.last_outage_ms, (unsigned long)stats.last_detect_ms,
+               (unsigned long)stats.last_switch_ms);
+        printf("  Worst outage:     %lu ms\n", (unsigned long)stats.max_outage_ms);
+    }
+
+    printf("\nPress any key to continue...");
+    fflush(stdout);
+    read_char_timeout(10000);
+    printf("\n");
+}
@@ -0,0 +1,434 @@
+/*
+ * Host self-check and benchmark for components/lvgl/lvgl/src/lv_gpu/lv_gpu_esp32_blend.c
+ *
+ * The references below are `fill_normal` and `map_normal` of lv_draw_blend.c
+ * without screen transparency, with `lv_color_mix`, `lv_color_premult` and
+ * `lv_color_mix_premult` for a 16 bit, byte swapped `lv_color_t`. The kernels
+ * are called the way those two functions call them. The check compares:
+ *   - every red, green and blue pair at every opacity
+ *   - random areas with every alignment of buffer, map and width, random
+ *     masks (runs of 0 and 255 with edges in between) and opacities; the
+ *     whole buffer is compared, so a write outside the area fails too
+ * and then times both on this host. The ESP32 numbers come from [d] in the
+ * serial menu; the ones here only show the relative cost.
+ *
+ * Build and run:
+ *     gcc -O2 -Icomponents/lvgl/lvgl/src/lv_gpu tools/blend_kernel_check.c \
+ *         components/lvgl/lvgl/src/lv_gpu/lv_gpu_esp32_blend.c -o blend_kernel_check
+ *     ./blend_kernel_check
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "lv_gpu_esp32_blend.h"
+
+#define BUF_W           320
+#define BUF_H           40
+#define ROUNDS          200000
+#define BENCH_PX        (20 * 1000 * 1000)
+
+#define LV_OPA_TRANSP   0
+#define LV_OPA_COVER    255
+#define LV_OPA_MAX      250
+#define LV_COLOR_MIX_ROUND_OFS 128
+#define LV_MATH_UDIV255(x) ((uint32_t)((uint32_t) (x) * 0x8081) >> 0x17)
+
+typedef uint8_t lv_opa_t;
+
+/* lv_color16_t with LV_COLOR_16_SWAP 1 */
+typedef union {
+    struct {
+        uint16_t green_h : 3;
+        uint16_t red : 5;
+        uint16_t blue : 5;
+        uint16_t green_l : 3;
+    } ch;
+    uint16_t full;
+} lv_color_t;
+
+#define GET_R(c)    (c).ch.red
+#define GET_G(c)    (((c).ch.green_h << 3) + (c).ch.green_l)
+#define GET_B(c)    (c).ch.blue
+#define SET_R(c, v) (c).ch.red = (uint8_t)(v) & 0x1FU
+#define SET_G(c, v) {(c).ch.green_h = (uint8_t)(((v) >> 3) & 0x7); (c).ch.green_l = (uint8_t)((v) & 0x7);}
+#define SET_B(c, v) (c).ch.blue = (uint8_t)(v) & 0x1FU
+
+typedef enum {
+    FILL_NORMAL,
+    MAP_NORMAL,
+} blend_op_t;
+
+typedef struct {
+    blend_op_t op;
+    int32_t buf_w;              // Pixels per buffer line
+    int32_t ofs;                // First pixel of the area in the buffer
+    int32_t w;
+    int32_t h;
+    lv_color_t color;           // FILL_NORMAL
+    const lv_color_t *map;      // MAP_NORMAL, same width as the buffer
+    lv_opa_t opa;
+    const lv_opa_t *mask;       // NULL: LV_DRAW_MASK_RES_FULL_COVER
+} blend_t;
+
+static uint32_t rng = 2463534242u;
+
+static lv_color_t buf_ref[BUF_W * BUF_H + 2];
+static lv_color_t buf_kern[BUF_W * BUF_H + 2];
+static lv_color_t map_buf[BUF_W * BUF_H + 2];
+static lv_opa_t mask_buf[BUF_W * BUF_H + 4];
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint32_t xorshift(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static lv_color_t lv_color_mix(lv_color_t c1, lv_color_t c2, uint8_t mix)
+{
+    lv_color_t ret;
+    SET_R(ret, LV_MATH_UDIV255((uint16_t) GET_R(c1) * mix + GET_R(c2) * (255 - mix) + LV_COLOR_MIX_ROUND_OFS));
+    SET_G(ret, LV_MATH_UDIV255((uint16_t) GET_G(c1) * mix + GET_G(c2) * (255 - mix) + LV_COLOR_MIX_ROUND_OFS));
+    SET_B(ret, LV_MATH_UDIV255((uint16_t) GET_B(c1) * mix + GET_B(c2) * (255 - mix) + LV_COLOR_MIX_ROUND_OFS));
+    return ret;
+}
+
+static void lv_color_premult(lv_color_t c, uint8_t mix, uint16_t *out)
+{
+    out[0] = (uint16_t) GET_R(c) * mix;
+    out[1] = (uint16_t) GET_G(c) * mix;
+    out[2] = (uint16_t) GET_B(c) * mix;
+}
+
+static lv_color_t lv_color_mix_premult(uint16_t *premult_c1, lv_color_t c2, uint8_t mix)
+{
+    lv_color_t ret;
+    SET_R(ret, LV_MATH_UDIV255((uint16_t) premult_c1[0] + GET_R(c2) * mix + LV_COLOR_MIX_ROUND_OFS));
+    SET_G(ret, LV_MATH_UDIV255((uint16_t) premult_c1[1] + GET_G(c2) * mix + LV_COLOR_MIX_ROUND_OFS));
+    SET_B(ret, LV_MATH_UDIV255((uint16_t) premult_c1[2] + GET_B(c2) * mix + LV_COLOR_MIX_ROUND_OFS));
+    return ret;
+}
+
+/* fill_normal: the software paths, one pixel at a time */
+static void ref_fill_normal(lv_color_t *disp_buf_first, int32_t disp_w, int32_t w, int32_t h,
+                            lv_color_t color, lv_opa_t opa, const lv_opa_t *mask)
+{
+    if (mask == NULL) {
+        if (opa > LV_OPA_MAX) {
+            for (int32_t y = 0; y < h; y++) {
+                for (int32_t x = 0; x < w; x++) {
+                    disp_buf_first[x] = color;
+                }
+                disp_buf_first += disp_w;
+            }
+            return;
+        }
+        lv_color_t last_dest_color = {.full = 0};
+        lv_color_t last_res_color = lv_color_mix(color, last_dest_color, opa);
+        uint16_t color_premult[3];
+        lv_color_premult(color, opa, color_premult);
+        lv_opa_t opa_inv = 255 - opa;
+        for (int32_t y = 0; y < h; y++) {
+            for (int32_t x = 0; x < w; x++) {
+                if (last_dest_color.full != disp_buf_first[x].full) {
+                    last_dest_color = disp_buf_first[x];
+                    last_res_color = lv_color_mix_premult(color_premult, disp_buf_first[x], opa_inv);
+                }
+                disp_buf_first[x] = last_res_color;
+            }
+            disp_buf_first += disp_w;
+        }
+        return;
+    }
+
+    if (opa > LV_OPA_MAX) {
+        for (int32_t y = 0; y < h; y++) {
+            for (int32_t x = 0; x < w; x++) {
+                if (mask[x]) {
+                    if (mask[x] == LV_OPA_COVER) disp_buf_first[x] = color;
+                    else disp_buf_first[x] = lv_color_mix(color, disp_buf_first[x], mask[x]);
+                }
+            }
+            disp_buf_first += disp_w;
+            mask += w;
+        }
+        return;
+    }
+
+    lv_color_t last_dest_color = disp_buf_first[0];
+    lv_color_t last_res_color = disp_buf_first[0];
+    lv_opa_t last_mask = LV_OPA_TRANSP;
+    lv_opa_t opa_tmp = LV_OPA_TRANSP;
+    for (int32_t y = 0; y < h; y++) {
+        for (int32_t x = 0; x < w; x++) {
+            if (mask[x]) {
+                if (mask[x] != last_mask) opa_tmp = mask[x] == LV_OPA_COVER ? opa :
+                                                        (uint32_t)((uint32_t)(mask[x]) * opa) >> 8;
+                if (mask[x] != last_mask || last_dest_color.full != disp_buf_first[x].full) {
+                    if (opa_tmp == LV_OPA_COVER) last_res_color = color;
+                    else last_res_color = lv_color_mix(color, disp_buf_first[x], opa_tmp);
+                    last_mask = mask[x];
+                    last_dest_color.full = disp_buf_first[x].full;
+                }
+                disp_buf_first[x] = last_res_color;
+            }
+        }
+        disp_buf_first += disp_w;
+        mask += w;
+    }
+}
+
+/* map_normal: the software paths, one pixel at a time */
+static void ref_map_normal(lv_color_t *disp_buf_first, int32_t disp_w, int32_t w, int32_t h,
+                           const lv_color_t *map_buf_first, int32_t map_w, lv_opa_t opa, const lv_opa_t *mask)
+{
+    for (int32_t y = 0; y < h; y++) {
+        for (int32_t x = 0; x < w; x++) {
+            if (mask == NULL) {
+                if (opa > LV_OPA_MAX) disp_buf_first[x] = map_buf_first[x];
+                else disp_buf_first[x] = lv_color_mix(map_buf_first[x], disp_buf_first[x], opa);
+            } else if (opa > LV_OPA_MAX) {
+                if (mask[x]) {
+                    if (mask[x] == LV_OPA_COVER) disp_buf_first[x] = map_buf_first[x];
+                    else disp_buf_first[x] = lv_color_mix(map_buf_first[x], disp_buf_first[x], mask[x]);
+                }
+            } else if (mask[x]) {
+                lv_opa_t opa_tmp = mask[x] >= LV_OPA_MAX ? opa : ((opa * mask[x]) >> 8);
+                disp_buf_first[x] = lv_color_mix(map_buf_first[x], disp_buf_first[x], opa_tmp);
+            }
+        }
+        disp_buf_first += disp_w;
+        map_buf_first += map_w;
+        if (mask) {
+            mask += w;
+        }
+    }
+}
+
+/* The LV_USE_GPU_ESP32_BLEND branches of fill_normal and map_normal */
+static void kern_fill_normal(lv_color_t *disp_buf_first, int32_t disp_w, int32_t w, int32_t h,
+                             lv_color_t color, lv_opa_t opa, const lv_opa_t *mask)
+{
+    uint16_t *buf = &disp_buf_first->full;
+    if (mask == NULL) {
+        if (opa > LV_OPA_MAX) lv_gpu_esp32_blend_fill(buf, disp_w, color.full, w, h);
+        else lv_gpu_esp32_blend_fill_opa(buf, disp_w, color.full, opa, w, h);
+    } else {
+        lv_gpu_esp32_blend_fill_mask(buf, disp_w, color.full, opa > LV_OPA_MAX ? LV_OPA_COVER : opa, mask, w, h);
+    }
+}
+
+static void kern_map_normal(lv_color_t *disp_buf_first, int32_t disp_w, int32_t w, int32_t h,
+                            const lv_color_t *map_buf_first, int32_t map_w, lv_opa_t opa, const lv_opa_t *mask)
+{
+    uint16_t *buf = &disp_buf_first->full;
+    const uint16_t *map = &map_buf_first->full;
+    if (mask == NULL) {
+        if (opa > LV_OPA_MAX) lv_gpu_esp32_blend_copy(buf, disp_w, map, map_w, w, h);
+        else lv_gpu_esp32_blend_map_opa(buf, disp_w, map, map_w, opa, w, h);
+    } else {
+        lv_gpu_esp32_blend_map_mask(buf, disp_w, map, map_w, opa > LV_OPA_MAX ? LV_OPA_COVER : opa, mask, w, h);
+    }
+}
+
+static void run_blend(const blend_t *b, lv_color_t *buf, int kernel)
+{
+    lv_color_t *first = buf + b->ofs;
+    const lv_color_t *map = b->map + b->ofs;
+
+    if (b->op == FILL_NORMAL) {
+        (kernel ? kern_fill_normal : ref_fill_normal)(first, b->buf_w, b->w, b->h, b->color, b->opa, b->mask);
+    } else {
+        (kernel ? kern_map_normal : ref_map_normal)(first, b->buf_w, b->w, b->h, map, b->buf_w, b->opa, b->mask);
+    }
+}
+
+static const char *blend_name(const blend_t *b)
+{
+    static char name[40];
+    snprintf(name, sizeof(name), "%s%s%s", b->op == FILL_NORMAL ? "fill" : "map",
+             b->opa > LV_OPA_MAX ? "" : " opa", b->mask ? " mask" : "");
+    return name;
+}
+
+/* A color with red a & 31, green a, blue a * 7 & 31: a and b in 0..63 give
+ * every pair of every channel */
+static lv_color_t pair_color(int a)
+{
+    lv_color_t c;
+    SET_R(c, a & 31);
+    SET_G(c, a);
+    SET_B(c, (a * 7) & 31);
+    return c;
+}
+
+static int check_all_pairs(void)
+{
+    lv_color_t dst[64];
+    lv_color_t exp[64];
+    lv_color_t src[64];
+    lv_opa_t mask[64];
+
+    for (int i = 0; i < 64; i++) {
+        src[i] = pair_color(i);
+    }
+    for (int mix = 0; mix <= 255; mix++) {
+        memset(mask, mix, sizeof(mask));
+        for (int bg = 0; bg < 64; bg++) {
+            // Map over one background: lv_color_mix with every foreground
+            for (int i = 0; i < 64; i++) {
+                dst[i] = exp[i] = pair_color(bg);
+            }
+            if (mix < LV_OPA_COVER) {
+                lv_gpu_esp32_blend_map_opa(&dst[0].full, 64, &src[0].full, 64, mix, 64, 1);
+            } else {
+                lv_gpu_esp32_blend_map_mask(&dst[0].full, 64, &src[0].full, 64, LV_OPA_COVER, mask, 64, 1);
+            }
+            for (int i = 0; i < 64; i++) {
+                exp[i] = lv_color_mix(src[i], exp[i], mix);
+            }
+            if (memcmp(dst, exp, sizeof(dst)) != 0) {
+                printf("FAIL: map, mix %d, background %d\n", mix, bg);
+                return 0;
+            }
+
+            // Fill one color over every background: lv_color_mix_premult
+            if (mix >= LV_OPA_COVER) {
+                continue;
+            }
+            memcpy(dst, src, sizeof(dst));
+            memcpy(exp, src, sizeof(exp));
+            kern_fill_normal(dst, 64, 64, 1, pair_color(bg), mix, NULL);
+            ref_fill_normal(exp, 64, 64, 1, pair_color(bg), mix, NULL);
+            if (memcmp(dst, exp, sizeof(dst)) != 0) {
+                printf("FAIL: fill, opa %d, color %d\n", mix, bg);
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+static void random_mask(lv_opa_t *mask, int32_t len)
+{
+    // Runs of 0 and 255 like a glyph or a rounded corner, edges in between
+    int32_t i = 0;
+    while (i < len) {
+        int32_t run = 1 + xorshift() % 12;
+        uint32_t kind = xorshift() % 4;
+        for (; run > 0 && i < len; run--, i++) {
+            mask[i] = kind == 0 ? 0 : kind == 1 ? 255 : xorshift() % 256;
+        }
+    }
+}
+
+static void random_blend(blend_t *b)
+{
+    static const lv_opa_t opas[] = {255, 254, 251, 250, 249, 128, 5, 0};
+
+    b->op = xorshift() % 2 ? FILL_NORMAL : MAP_NORMAL;
+    b->w = 1 + xorshift() % 40;
+    b->h = 1 + xorshift() % 4;
+    b->buf_w = b->w + xorshift() % 5;
+    b->ofs = xorshift() % 4;
+    b->color.full = xorshift();
+    b->map = map_buf + xorshift() % 2;  // Both halfword alignments of the map
+    b->opa = xorshift() % 2 ? opas[xorshift() % 8] : xorshift() % 256;
+    b->mask = NULL;
+    if (xorshift() % 3) {
+        random_mask(mask_buf, b->w * b->h);
+        b->mask = mask_buf + xorshift() % 4;    // Any alignment of the mask
+        memmove((void *)b->mask, mask_buf, b->w * b->h);
+    }
+}
+
+static int check_random(void)
+{
+    for (int round = 0; round < ROUNDS; round++) {
+        blend_t b;
+        random_blend(&b);
+
+        int32_t len = b.ofs + b.buf_w * b.h + 1;
+        for (int32_t i = 0; i < len; i++) {
+            // A plain background in half the rounds: the fill caches it
+            buf_ref[i].full = round % 2 ? 0x1234 : xorshift();
+            map_buf[i].full = xorshift();
+        }
+        map_buf[len].full = xorshift();
+        memcpy(buf_kern, buf_ref, len * sizeof(lv_color_t));
+
+        run_blend(&b, buf_ref, 0);
+        run_blend(&b, buf_kern, 1);
+        if (memcmp(buf_ref, buf_kern, len * sizeof(lv_color_t)) != 0) {
+            printf("FAIL: %s, %dx%d in %d at +%d, opa %d\n", blend_name(&b), (int)b.w, (int)b.h,
+                   (int)b.buf_w, (int)b.ofs, b.opa);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* One full width stripe of each operation, as a screen refresh draws it */
+static void bench(blend_op_t op, lv_opa_t opa, int masked)
+{
+    blend_t b = {
+        .op = op,
+        .buf_w = BUF_W,
+        .ofs = 0,
+        .w = BUF_W,
+        .h = BUF_H,
+        .color.full = 0xE0F8,
+        .map = map_buf,
+        .opa = opa,
+        .mask = masked ? mask_buf : NULL,
+    };
+    double t[2];
+
+    random_mask(mask_buf, BUF_W * BUF_H);
+    for (int32_t i = 0; i < BUF_W * BUF_H; i++) {
+        map_buf[i].full = xorshift();
+    }
+    for (int kernel = 0; kernel < 2; kernel++) {
+        lv_color_t *buf = kernel ? buf_kern : buf_ref;
+        int32_t rounds = BENCH_PX / (BUF_W * BUF_H);
+        for (int32_t i = 0; i < BUF_W * BUF_H; i++) {
+            buf[i].full = 0xFFFF;   // A plain background
+        }
+        double start = now_s();
+        for (int32_t r = 0; r < rounds; r++) {
+            run_blend(&b, buf, kernel);
+        }
+        t[kernel] = now_s() - start;
+    }
+    printf("  %-14s %10.0f %10.0f %8.1fx\n", blend_name(&b),
+           BENCH_PX / t[0] / 1e6, BENCH_PX / t[1] / 1e6, t[0] / t[1]);
+}
+
+int main(void)
+{
+    int failed = !check_all_pairs() || !check_random();
+
+    printf("Bit-exact against fill_normal / map_normal: %s\n\n", failed ? "no" : "yes");
+    printf("  %-14s %10s %10s %9s\n", "px/us (host)", "C", "kernel", "speedup");
+    bench(FILL_NORMAL, LV_OPA_COVER, 0);
+    bench(FILL_NORMAL, 128, 0);
+    bench(FILL_NORMAL, LV_OPA_COVER, 1);
+    bench(FILL_NORMAL, 128, 1);
+    bench(MAP_NORMAL, LV_OPA_COVER, 0);
+    bench(MAP_NORMAL, 128, 0);
+    bench(MAP_NORMAL, LV_OPA_COVER, 1);
+    bench(MAP_NORMAL, 128, 1);
+
+    printf("\n%s\n", failed ? "FAILED" : "OK");
+    return failed;
+}
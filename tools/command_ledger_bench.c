@@ -0,0 +1,161 @@
+/*
+ * Host benchmark and self-check for main/command_ledger.c
+ *
+ * Feeds 100k synthetic command IDs through the ledger and reports the cost
+ * of duplicate checks, hash index behaviour, false positives and how many
+ * NVS chunk writes batching saves.
+ *
+ * Build and run:
+ *     gcc -O2 -Imain tools/command_ledger_bench.c main/command_ledger.c -o ledger_bench
+ *     ./ledger_bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "command_ledger.h"
+
+#define IDS             100000
+#define FLUSH_MS        2000        // Matches COMMAND_LEDGER_FLUSH_MS in main.c
+#define DAY_S           86400u
+
+static command_ledger_t ledger;
+static char ids[IDS][40];
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Mix of the ID styles seen in practice: sequence numbers and UUIDs
+static void make_ids(void)
+{
+    srand(1);
+    for (int i = 0; i < IDS; i++) {
+        if (i % 2 == 0) {
+            snprintf(ids[i], sizeof(ids[i]), "cmd-2025-12-28-%06d", i);
+        } else {
+            snprintf(ids[i], sizeof(ids[i]), "%08x-%04x-4%03x-a%03x-%08x%04x",
+                     rand(), rand() & 0xffff, rand() & 0xfff, rand() & 0xfff, rand(), rand() & 0xffff);
+        }
+    }
+}
+
+static void probe_stats(double *avg, int *max)
+{
+    long total = 0;
+    int worst = 0, used = 0;
+    for (int i = 0; i < COMMAND_LEDGER_INDEX_SIZE; i++) {
+        if (ledger.index[i] == 0) {
+            continue;
+        }
+        const command_ledger_entry_t *e = &ledger.entries[ledger.index[i] - 1];
+        uint32_t home = (((e->hash_lo ^ e->hash_hi) * 0x9E3779B1u) >> 16) & (COMMAND_LEDGER_INDEX_SIZE - 1);
+        int dist = (i - (int)home + COMMAND_LEDGER_INDEX_SIZE) % COMMAND_LEDGER_INDEX_SIZE + 1;
+        total += dist;
+        worst = dist > worst ? dist : worst;
+        used++;
+    }
+    *avg = used ? (double)total / used : 0;
+    *max = worst;
+}
+
+int main(void)
+{
+    int failures = 0;
+    make_ids();
+    command_ledger_init(&ledger, 30 * DAY_S);
+
+    // 1. Execute every ID once: duplicate check + add, as process_command() does
+    double t0 = now_s();
+    int false_dups = 0;
+    for (int i = 0; i < IDS; i++) {
+        uint64_t h = command_ledger_hash(ids[i]);
+        if (command_ledger_contains(&ledger, h, 1767000000u)) {
+            false_dups++;
+        }
+        command_ledger_add(&ledger, h, 1767000000u);
+    }
+    double t_exec = now_s() - t0;
+
+    // 2. Redeliver the IDs still in the ring: all must be caught
+    t0 = now_s();
+    int caught = 0;
+    for (int i = IDS - COMMAND_LEDGER_CAPACITY; i < IDS; i++) {
+        caught += command_ledger_contains(&ledger, command_ledger_hash(ids[i]), 1767000100u);
+    }
+    double t_hit = now_s() - t0;
+
+    // 3. Redeliver all 100k: only the newest CAPACITY are remembered
+    t0 = now_s();
+    int remembered = 0;
+    for (int i = 0; i < IDS; i++) {
+        remembered += command_ledger_contains(&ledger, command_ledger_hash(ids[i]), 1767000100u);
+    }
+    double t_all = now_s() - t0;
+
+    double avg_probe;
+    int max_probe;
+    probe_stats(&avg_probe, &max_probe);
+
+    // 4. Age expiry: 31 days later nothing is a duplicate any more
+    int after_expiry = 0;
+    for (int i = IDS - COMMAND_LEDGER_CAPACITY; i < IDS; i++) {
+        after_expiry += command_ledger_contains(&ledger, command_ledger_hash(ids[i]), 1767000000u + 31 * DAY_S);
+    }
+
+    // 5. Persist/restore round trip (what the NVS chunks hold)
+    static command_ledger_t copy;
+    command_ledger_init(&copy, 30 * DAY_S);
+    memcpy(copy.entries, ledger.entries, sizeof(copy.entries));
+    copy.head = ledger.head;
+    command_ledger_restore(&copy);
+    int restored = 0;
+    for (int i = IDS - COMMAND_LEDGER_CAPACITY; i < IDS; i++) {
+        restored += command_ledger_contains(&copy, command_ledger_hash(ids[i]), 1767000100u);
+    }
+
+    // 6. Flash writes: one NVS key per command before, dirty chunks per flush now
+    long chunk_writes_steady = 0, chunk_writes_burst = 0;
+    command_ledger_init(&ledger, 0);
+    command_ledger_take_dirty(&ledger);
+    long next_flush = FLUSH_MS;
+    for (long t_ms = 0, i = 0; i < IDS; i++, t_ms += 1000) {   // Steady: one command per second
+        if (t_ms >= next_flush) {
+            chunk_writes_steady += __builtin_popcount(command_ledger_take_dirty(&ledger));
+            next_flush = t_ms + FLUSH_MS;
+        }
+        command_ledger_add(&ledger, command_ledger_hash(ids[i]), 0);
+    }
+    command_ledger_init(&ledger, 0);
+    for (int burst = 0; burst < IDS / 100; burst++) {             // Bursts of 100 within one flush window
+        for (int i = 0; i < 100; i++) {
+            command_ledger_add(&ledger, command_ledger_hash(ids[burst * 100 + i]), 0);
+        }
+        chunk_writes_burst += __builtin_popcount(command_ledger_take_dirty(&ledger));
+    }
+
+    printf("Command ledger: %d IDs, capacity %d, %zu bytes RAM\n", IDS, COMMAND_LEDGER_CAPACITY, sizeof(ledger));
+    printf("  execute (check+add):  %7.1f ns/command\n", t_exec * 1e9 / IDS);
+    printf("  duplicate check hit:  %7.1f ns\n", t_hit * 1e9 / COMMAND_LEDGER_CAPACITY);
+    printf("  check, mostly misses: %7.1f ns\n", t_all * 1e9 / IDS);
+    printf("  index probe length:   avg %.2f, max %d\n", avg_probe, max_probe);
+    printf("  false duplicates:     %d of %d new IDs\n", false_dups, IDS);
+    printf("  redeliveries caught:  %d of %d in ring\n", caught, COMMAND_LEDGER_CAPACITY);
+    printf("  remembered of 100k:   %d (ring keeps the newest %d)\n", remembered, COMMAND_LEDGER_CAPACITY);
+    printf("  after 31 days:        %d still duplicates (max age 30 days)\n", after_expiry);
+    printf("  after restore:        %d of %d caught\n", restored, COMMAND_LEDGER_CAPACITY);
+    printf("  NVS writes, 1 cmd/s:  %ld chunk writes vs %d per-command keys\n", chunk_writes_steady, IDS);
+    printf("  NVS writes, bursts:   %ld chunk writes vs %d per-command keys\n", chunk_writes_burst, IDS);
+
+    failures += false_dups != 0;
+    failures += caught != COMMAND_LEDGER_CAPACITY;
+    failures += remembered != COMMAND_LEDGER_CAPACITY;
+    failures += after_expiry != 0;
+    failures += restored != COMMAND_LEDGER_CAPACITY;
+    printf("%s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
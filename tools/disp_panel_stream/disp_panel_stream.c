@@ -0,0 +1,172 @@
+/*
+ * Records what a panel driver puts on the display bus, for
+ * disp_panel_stream.sh to compare the table-driven drivers on disp_panel.c
+ * with the per-driver code they replaced
+ *
+ * Built once per driver, controller, orientation and inversion, against
+ * either the driver source in the tree or its version from before
+ * disp_panel.c. disp_spi and the ESP-IDF calls are replaced by a recorder
+ * that prints one line per event:
+ *     spi dc=<level> <bytes, or length and hash of pixel data> [poll|queue]
+ *     delay <ticks>
+ *     gpio <pin>=<level>          (RST, backlight; DC is folded into spi)
+ * for init, five flushes, backlight off/on and, on the HX8357, the four
+ * rotations. The script compares the spi and delay lines exactly and shows
+ * the GPIO and poll/queue differences.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sdkconfig.h"
+#include "disp_spi.h"
+#include "driver/gpio.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "../lvgl_helpers.h"
+
+#define HEX_MAX     16      // Longer transfers are printed as length and hash
+
+#define PANEL_FN(name)          PANEL_FN_(PANEL, name)
+#define PANEL_FN_(panel, name)  PANEL_FN__(panel, name)
+#define PANEL_FN__(panel, name) panel##_##name
+
+static int dc_level = -1;
+static int64_t now_us;
+
+static uint32_t hash_bytes(const uint8_t *data, size_t len)
+{
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ data[i]) * 16777619u;
+    }
+    return h;
+}
+
+// ---- Recorder in place of disp_spi.c ----
+
+void disp_spi_transaction(const uint8_t *data, size_t length, disp_spi_send_flag_t flags,
+                          disp_spi_read_data *out, uint64_t addr)
+{
+    (void)out;
+    (void)addr;
+    if (length == 0) {
+        return;
+    }
+    if (flags & DISP_SPI_DC_CMD) {
+        dc_level = 0;
+    } else if (flags & DISP_SPI_DC_DATA) {
+        dc_level = 1;
+    }
+
+    printf("spi dc=%d", dc_level);
+    if (length <= HEX_MAX) {
+        for (size_t i = 0; i < length; i++) {
+            printf(" %02x", data[i]);
+        }
+    } else {
+        printf(" len=%zu fnv=%08x", length, hash_bytes(data, length));
+    }
+    printf(" [%s]\n", (flags & (DISP_SPI_SEND_POLLING | DISP_SPI_SEND_SYNCHRONOUS)) ? "poll" : "queue");
+}
+
+void disp_wait_for_pending_transactions(void)
+{
+}
+
+void disp_spi_change_device_speed(int clock_speed_hz)
+{
+    (void)clock_speed_hz;
+}
+
+int disp_spi_get_clock_speed(void)
+{
+    return 40 * 1000 * 1000;
+}
+
+void disp_spi_read_cmd(uint8_t cmd, uint8_t *data, size_t length)
+{
+    (void)cmd;
+    memset(data, 0, length);
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio, uint32_t level)
+{
+    if (gpio == CONFIG_LVGL_DISP_PIN_DC) {
+        dc_level = (int)level;
+    } else {
+        printf("gpio %d=%u\n", gpio, (unsigned)level);
+    }
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_direction(gpio_num_t gpio, gpio_mode_t mode)
+{
+    (void)gpio;
+    (void)mode;
+    return ESP_OK;
+}
+
+esp_err_t gpio_config(const gpio_config_t *config)
+{
+    (void)config;
+    return ESP_OK;
+}
+
+void vTaskDelay(const TickType_t ticks)
+{
+    printf("delay %u\n", (unsigned)ticks);
+    now_us += (int64_t)ticks * 1000000 / configTICK_RATE_HZ;
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return now_us;
+}
+
+// ---- The calls LVGL and the app make ----
+
+static void flush(lv_coord_t x1, lv_coord_t y1, lv_coord_t x2, lv_coord_t y2)
+{
+    static lv_color_t pixels[DISP_BUF_SIZE];
+    static uint32_t seed = 0x2545F491;
+    lv_disp_drv_t drv = {0};
+    lv_area_t area = {x1, y1, x2, y2};
+    uint32_t count = (uint32_t)lv_area_get_width(&area) * lv_area_get_height(&area);
+
+    for (uint32_t i = 0; i < count; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        pixels[i].full = (uint16_t)seed;
+    }
+    printf("# flush %d,%d %d,%d\n", x1, y1, x2, y2);
+    PANEL_FN(flush)(&drv, &area, pixels);
+}
+
+int main(void)
+{
+    printf("# init\n");
+    PANEL_FN(init)();
+
+    flush(0, 0, LV_HOR_RES_MAX - 1, 9);
+    flush(10, 20, 49, 59);
+    flush(LV_HOR_RES_MAX - 1, LV_VER_RES_MAX - 1, LV_HOR_RES_MAX - 1, LV_VER_RES_MAX - 1);
+    flush(0, LV_VER_RES_MAX - CONFIG_LVGL_DISP_BUF_LINES, LV_HOR_RES_MAX - 1, LV_VER_RES_MAX - 1);
+    flush(100, 5, 163, 36);
+
+#if !defined(CONFIG_LVGL_TFT_DISPLAY_CONTROLLER_ST7735S)
+    printf("# backlight\n");
+    PANEL_FN(enable_backlight)(false);
+    PANEL_FN(enable_backlight)(true);
+#endif
+
+#if defined(CONFIG_LVGL_TFT_DISPLAY_CONTROLLER_HX8357)
+    for (uint8_t r = 0; r < 4; r++) {
+        printf("# rotation %u\n", r);
+        hx8357_set_rotation(r);
+    }
+#endif
+    return 0;
+}
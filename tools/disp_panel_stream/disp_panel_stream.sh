@@ -0,0 +1,143 @@
+#!/usr/bin/env bash
+#
+# Compare what the SPI panel drivers put on the bus before and after they
+# moved onto the shared table-driven layer (lvgl_tft/disp_panel.c).
+#
+# Every driver is built twice against the recorder in disp_panel_stream.c:
+# once from the tree, once from OLD_REV (the commit before disp_panel.c).
+# This is repeated for all four orientations, with and without colour
+# inversion. Both builds run init, five flushes and backlight off/on (and
+# the HX8357 rotations). The command/parameter bytes, the DC level of each
+# transfer, the pixel data (hashed) and the delays must be identical. GPIO
+# writes (reset, backlight) and polled vs queued transfers are expected to
+# differ and are listed instead.
+#
+# One known difference is accepted and counted: the old ILI9481/ILI9488
+# flush passed the RGB666 length as uint16_t, so a flush of more than 64 KB
+# (a 64 line buffer in landscape on a 480 pixel wide panel) only sent the
+# length modulo 65536 and left the rest of the window unwritten.
+#
+# ili9341_sleep_in/out are not compared: they were changed on purpose
+# later, to drop a stray parameter byte and respect the 120 ms SLPIN/SLPOUT
+# spacing.
+#
+# Needs gcc and git. Run from anywhere in the repository:
+#     tools/disp_panel_stream/disp_panel_stream.sh
+# Set KEEP=1 to keep the recorded streams (their directory is printed).
+
+set -euo pipefail
+
+OLD_REV=${OLD_REV:-fac026f4ac5110d7b883da708c237f0cd2e5299d}
+# Driver and the resolution of the panels it is used with: windows beyond
+# it are not meaningful (the old ST7735S driver added its offset to the
+# low address byte only)
+DRIVERS="ili9341:320x240 ili9481:480x320 ili9486:480x320 ili9488:480x320 st7789:240x240 st7735s:160x80 hx8357:480x320"
+
+root=$(git -C "$(dirname "$0")" rev-parse --show-toplevel)
+tft=components/lvgl_esp32_drivers/lvgl_tft
+work=$(mktemp -d)
+if [ "${KEEP:-0}" = 1 ]; then
+    echo "Streams in $work"
+else
+    trap 'rm -rf "$work"' EXIT
+fi
+cd "$root"
+
+# The recorder replaces disp_spi.c and the ESP-IDF calls
+build() {    # name controller resolution orientation invert output sources...
+    local name=$1 controller=$2 resolution=$3 orientation=$4 invert=$5 out=$6
+    shift 6
+    gcc -O1 -w -DPANEL="$name" -DCONFIG_LVGL_TFT_DISPLAY_CONTROLLER_"$controller"=1 \
+        -DWIDTH="${resolution%x*}" -DHEIGHT="${resolution#*x}" \
+        -DORIENTATION="$orientation" -DINVERT="$invert" \
+        -include tools/disp_panel_stream/sdkconfig.h \
+        -Itools/disp_panel_stream -Itools/idf_shim -I"$tft" \
+        -Icomponents/lvgl_esp32_drivers -Icomponents/lvgl_esp32_drivers/lvgl_touch \
+        tools/disp_panel_stream/disp_panel_stream.c "$@" -o "$out"
+}
+
+# Bus bytes, DC and delays only (the old drivers also print log lines)
+bus() {
+    grep -E '^(spi|delay) ' "$1" | sed 's/ \[[a-z]*\]$//'
+}
+
+# Compare two bus streams line by line; prints the differences except the
+# known uint16_t truncation, and "truncated <n>" when it saw it
+compare() {    # old new
+    awk '
+        NR == FNR { old[FNR] = $0; n_old = FNR; next }
+        {
+            n_new = FNR
+            if (old[FNR] == $0) next
+            split(old[FNR], o, "[ =]")
+            split($0, w, "[ =]")
+            if (o[1] == "spi" && w[1] == "spi" && o[4] == "len" && w[4] == "len" &&
+                w[5] > 65535 && o[5] == w[5] % 65536) { truncated++; next }
+            printf "    line %d\n    < %s\n    > %s\n", FNR, old[FNR], $0
+        }
+        END {
+            if (n_old != n_new) printf "    %d lines before, %d after\n", n_old, n_new
+            if (truncated) printf "truncated %d\n", truncated
+        }' <(bus "$1") <(bus "$2")
+}
+
+transfers() {    # section mode file
+    awk -v section="$1" -v mode="[$2]" '
+        /^# / { in_section = index($0, "# " section) == 1 }
+        in_section && $NF == mode { n++ }
+        END { print n + 0 }' "$3"
+}
+
+failed=0
+for driver in $DRIVERS; do
+    name=${driver%:*}
+    resolution=${driver#*:}
+    controller=$(echo "$name" | tr a-z A-Z)
+    git show "$OLD_REV:$tft/$name.c" > "$work/$name.old.c"
+
+    result=identical
+    truncated=0
+    for orientation in 0 1 2 3; do
+        for invert in 0 1; do
+            tag=$name.o$orientation.i$invert
+            build "$name" "$controller" "$resolution" "$orientation" "$invert" "$work/$tag.old" \
+                "$work/$name.old.c"
+            build "$name" "$controller" "$resolution" "$orientation" "$invert" "$work/$tag.new" \
+                "$tft/$name.c" "$tft/disp_panel.c"
+            "$work/$tag.old" > "$work/$tag.old.txt"
+            "$work/$tag.new" > "$work/$tag.new.txt"
+
+            compare "$work/$tag.old.txt" "$work/$tag.new.txt" > "$work/$tag.diff"
+            truncated=$((truncated + $(awk '$1 == "truncated" { n += $2 } END { print n + 0 }' "$work/$tag.diff")))
+            if grep -qv '^truncated' "$work/$tag.diff"; then
+                result=DIFFERENT
+                failed=1
+                echo "$name, orientation $orientation, invert $invert: bus streams differ"
+                grep -v '^truncated' "$work/$tag.diff" | head -20
+            fi
+        done
+    done
+
+    # Per driver, on the orientation this project uses (landscape inverted)
+    tag=$name.o3.i0
+    printf '%-8s %4d transfers, %s; flush: %d polled/%d queued -> %d/%d\n' "$name" \
+        "$(bus "$work/$tag.new.txt" | grep -c '^spi')" "$result" \
+        "$(transfers flush poll "$work/$tag.old.txt")" "$(transfers flush queue "$work/$tag.old.txt")" \
+        "$(transfers flush poll "$work/$tag.new.txt")" "$(transfers flush queue "$work/$tag.new.txt")"
+    if [ $truncated != 0 ]; then
+        echo "         $truncated flushes over 64 KB were truncated by the old driver"
+    fi
+    if ! diff <(grep -E '^(#|gpio)' "$work/$tag.old.txt") <(grep -E '^(#|gpio)' "$work/$tag.new.txt") \
+            > "$work/$tag.gpio.diff"; then
+        echo "         GPIO differs (old <, new >):"
+        grep '^[<>]' "$work/$tag.gpio.diff" | sed 's/^/           /'
+    fi
+done
+
+echo
+if [ $failed = 0 ]; then
+    echo "OK: bus streams match for all drivers, orientations and inversion settings"
+else
+    echo "FAILED"
+fi
+exit $failed
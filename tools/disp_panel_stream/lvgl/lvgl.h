@@ -0,0 +1,61 @@
+/*
+ * The few LVGL types the panel drivers use, so they build on the host
+ * without lv_conf.h. Layout as in LVGL v7 with LV_COLOR_DEPTH 16.
+ */
+#ifndef LVGL_H
+#define LVGL_H
+
+#include <stdint.h>
+#include "sdkconfig.h"
+
+#define LVGL_VERSION_MAJOR 7
+
+#if defined(CONFIG_LVGL_DISPLAY_ORIENTATION_PORTRAIT) || defined(CONFIG_LVGL_DISPLAY_ORIENTATION_PORTRAIT_INVERTED)
+#define LV_HOR_RES_MAX (CONFIG_LVGL_DISPLAY_HEIGHT)
+#define LV_VER_RES_MAX (CONFIG_LVGL_DISPLAY_WIDTH)
+#else
+#define LV_HOR_RES_MAX (CONFIG_LVGL_DISPLAY_WIDTH)
+#define LV_VER_RES_MAX (CONFIG_LVGL_DISPLAY_HEIGHT)
+#endif
+
+typedef int16_t lv_coord_t;
+typedef uint8_t lv_opa_t;
+
+typedef union {
+    struct {
+        uint16_t blue : 5;
+        uint16_t green : 6;
+        uint16_t red : 5;
+    } ch;
+    uint16_t full;
+} lv_color16_t;
+
+typedef lv_color16_t lv_color_t;
+
+typedef struct {
+    lv_coord_t x1;
+    lv_coord_t y1;
+    lv_coord_t x2;
+    lv_coord_t y2;
+} lv_area_t;
+
+typedef struct _disp_drv_t {
+    void *user_data;
+} lv_disp_drv_t;
+
+// Declared by disp_driver.h and touch_driver.h, not used
+typedef struct _disp_t lv_disp_t;
+typedef struct _lv_indev_drv_t lv_indev_drv_t;
+typedef struct _lv_indev_data_t lv_indev_data_t;
+
+static inline lv_coord_t lv_area_get_width(const lv_area_t *area)
+{
+    return (lv_coord_t)(area->x2 - area->x1 + 1);
+}
+
+static inline lv_coord_t lv_area_get_height(const lv_area_t *area)
+{
+    return (lv_coord_t)(area->y2 - area->y1 + 1);
+}
+
+#endif /*LVGL_H*/
@@ -0,0 +1,48 @@
+/*
+ * Configuration the panel drivers are built with by disp_panel_stream.sh.
+ * The script selects the controller, its resolution (WIDTH, HEIGHT), the
+ * orientation (ORIENTATION=0..3) and colour inversion (INVERT=0/1) on the
+ * command line.
+ */
+#pragma once
+
+#define CONFIG_LVGL_TFT_DISPLAY_PROTOCOL_SPI    1
+#define CONFIG_LVGL_PREDEFINED_DISPLAY_NONE     1
+#define CONFIG_LVGL_PREDEFINED_PINS_NONE        1
+#define CONFIG_LVGL_TOUCH_CONTROLLER_NONE       1
+#define CONFIG_LVGL_DISPLAY_WIDTH               WIDTH
+#define CONFIG_LVGL_DISPLAY_HEIGHT              HEIGHT
+#define CONFIG_LVGL_DISP_BUF_LINES              64
+#define CONFIG_LVGL_DISP_SPI_MOSI               13
+#define CONFIG_LVGL_DISP_SPI_CLK                14
+#define CONFIG_LVGL_DISPLAY_USE_SPI_CS          1
+#define CONFIG_LVGL_DISP_SPI_CS                 15
+#define CONFIG_LVGL_DISPLAY_USE_DC              1
+#define CONFIG_LVGL_DISP_PIN_DC                 2
+#define CONFIG_LVGL_DISP_PIN_RST                4
+#define CONFIG_LVGL_DISP_PIN_BUSY               35
+#define CONFIG_LVGL_ENABLE_BACKLIGHT_CONTROL    1
+#define CONFIG_LVGL_BACKLIGHT_ACTIVE_LVL        1
+#define CONFIG_LVGL_DISP_PIN_BCKL               21
+#define CONFIG_LVGL_AXP192_PIN_SDA              21
+#define CONFIG_LVGL_AXP192_PIN_SCL              22
+#define CONFIG_FREERTOS_HZ                      100
+
+// The old drivers had no PWM backlight: compare the GPIO one
+#undef CONFIG_LVGL_BACKLIGHT_PWM
+
+#define CONFIG_LVGL_DISPLAY_ORIENTATION ORIENTATION
+#if ORIENTATION == 0
+#define CONFIG_LVGL_DISPLAY_ORIENTATION_PORTRAIT 1
+#elif ORIENTATION == 1
+#define CONFIG_LVGL_DISPLAY_ORIENTATION_PORTRAIT_INVERTED 1
+#elif ORIENTATION == 2
+#define CONFIG_LVGL_DISPLAY_ORIENTATION_LANDSCAPE 1
+#else
+#define CONFIG_LVGL_DISPLAY_ORIENTATION_LANDSCAPE_INVERTED 1
+#endif
+
+#if INVERT
+#define CONFIG_LVGL_INVERT_COLORS               1
+#define CONFIG_LVGL_INVERT_DISPLAY              1
+#endif
@@ -0,0 +1,611 @@
+/*
+ * Host test for the queued transaction ring in
+ * components/lvgl_esp32_drivers/lvgl_tft/disp_spi.c on a mock SPI master
+ *
+ * The mock stands in for the ESP-IDF driver: transactions queue in a FIFO
+ * of queue_size, the "hardware" starts and finishes them in order at random
+ * moments (pre callback, bytes on the wire, post callback, as from the ISR)
+ * and results are handed back in order. A random mix of what the panel
+ * drivers do is sent through disp_spi: queued command/window/pixel
+ * sequences with DC carried by the transaction, the older wait + gpio +
+ * polling pattern (and pixels queued after setting DC by hand), RAMRD style
+ * reads with CS held, bus acquisition and clock changes. Phases of a slow
+ * bus keep the ring full. For every transfer on the wire the test checks that:
+ *   - transfers go out in call order with the bytes the caller passed
+ *   - DC is at the level the caller asked for when the transfer starts
+ *   - CS is only held between transfers inside an acquired bus
+ *   - the driver never owns more than queue_size transactions, a ring slot
+ *     is not rewritten while the driver owns it, and a polling transfer or
+ *     device removal never overtakes queued work
+ *   - every flush is handed back to LVGL once, after its last byte
+ * and that the queue statistics agree with what the mock saw. It also runs
+ * a caller that drives DC without waiting for queued pixels first, and
+ * expects the DC check to catch it.
+ *
+ * disp_spi.c is compiled into this file, after minimal LVGL stand-ins.
+ *
+ * Build and run:
+ *     gcc -O2 -Itools/idf_shim -Icomponents/lvgl -Icomponents/lvgl_esp32_drivers/lvgl_tft \
+ *         tools/disp_spi_mock.c -o disp_spi_mock
+ *     ./disp_spi_mock [operations per run] [runs]
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The panel configuration the ring is built for
+#define CONFIG_LVGL_DISP_SPI_MOSI               13
+#define CONFIG_LVGL_DISP_SPI_CLK                14
+#define CONFIG_LVGL_DISPLAY_USE_SPI_CS          1
+#define CONFIG_LVGL_DISP_SPI_CS                 15
+#define CONFIG_LVGL_DISPLAY_USE_DC              1
+#define CONFIG_LVGL_DISP_PIN_DC                 2
+#define CONFIG_LVGL_DISP_SPI_TRANS_QUEUE_DEPTH  8
+#define CONFIG_LVGL_TOUCH_CONTROLLER_NONE       1
+#define CONFIG_LVGL_TFT_DISPLAY_CONTROLLER_ILI9341 1
+
+// LVGL and the panel drivers are not needed: skip their headers
+#define LVGL_H
+#define LVGL_HELPERS_H
+#define DISP_DRIVER_H
+#define LVGL_VERSION_MAJOR 7
+
+typedef struct {
+    int flushing;
+} lv_disp_drv_t;
+
+typedef struct {
+    lv_disp_drv_t driver;
+} lv_disp_t;
+
+static lv_disp_t mock_disp;
+static unsigned flush_ready_calls;
+
+static lv_disp_t *_lv_refr_get_disp_refreshing(void)
+{
+    return &mock_disp;
+}
+
+static void lv_disp_flush_ready(lv_disp_drv_t *drv)
+{
+    drv->flushing = 0;
+    flush_ready_calls++;
+}
+
+#include "disp_spi.c"
+
+#define DEFAULT_OPERATIONS  200000
+#define DEFAULT_RUNS        4
+#define HW_QUEUE_MAX        64
+#define EXPECT_MAX          4096
+#define ARENA_SIZE          (64 * 1024)
+
+// ---- Mock SPI master ----
+
+struct spi_device_t {
+    spi_device_interface_config_t cfg;
+};
+
+typedef struct {
+    spi_transaction_t *trans;
+    spi_transaction_ext_t snapshot;     // Descriptor as queued: must not change while the driver owns it
+} hw_entry_t;
+
+// What the caller asked for, in call order
+typedef struct {
+    uint32_t hash;
+    size_t len;
+    bool rx;
+    int dc;                 // Level DC must have when the transfer starts
+    bool flush;
+} expect_t;
+
+static struct spi_device_t device;
+static bool device_added;
+static bool bus_acquired;
+static hw_entry_t hw_pending[HW_QUEUE_MAX];     // Queued, not on the wire yet
+static unsigned hw_pending_count;
+static hw_entry_t hw_done[HW_QUEUE_MAX];        // Finished, result not collected
+static unsigned hw_done_count;
+static unsigned hw_max_owned;
+static bool in_isr;
+static int dc_level = -1;
+static bool cs_active;
+static bool cs_kept;                            // Previous transfer ended with CS held
+static int64_t now_us;
+static unsigned hw_speed;                       // Chance in 100 that the bus makes progress per call
+
+static expect_t expected[EXPECT_MAX];
+static unsigned expect_head, expect_tail;
+static int model_dc = -1;                       // DC as the caller's calls leave it, in call order
+static unsigned wire_transfers, wire_flushes, queued_calls, flush_calls;
+
+static unsigned failures;
+static char failure[256];
+
+static uint32_t rng_state;
+
+static uint32_t rng(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static void fail(const char *what)
+{
+    if (failures++ == 0) {
+        snprintf(failure, sizeof(failure), "%s (transfer %u on the wire)", what, wire_transfers);
+    }
+}
+
+static uint32_t hash_bytes(const uint8_t *data, size_t len)
+{
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ data[i]) * 16777619u;
+    }
+    return h;
+}
+
+static const uint8_t *tx_bytes(const spi_transaction_t *t)
+{
+    return (t->flags & SPI_TRANS_USE_TXDATA) ? t->tx_data : t->tx_buffer;
+}
+
+// One transfer from start to end, as the hardware and the ISR see it
+static void hw_run(spi_transaction_t *t, const spi_transaction_ext_t *snapshot)
+{
+    if (snapshot && memcmp(t, snapshot, sizeof(*snapshot)) != 0) {
+        fail("ring slot rewritten while the driver owned it");
+    }
+    if (cs_kept && !bus_acquired) {
+        fail("CS held across transfers outside an acquired bus");
+    }
+    cs_active = true;
+    in_isr = true;
+    if (device.cfg.pre_cb) {
+        device.cfg.pre_cb(t);
+    }
+
+    if (expect_tail == expect_head) {
+        fail("transfer on the wire nobody sent");
+    } else {
+        const expect_t *e = &expected[expect_tail++ % EXPECT_MAX];
+        bool rx = t->rx_buffer != NULL && !(t->flags & SPI_TRANS_USE_RXDATA) && t->rxlength;
+        size_t len = (rx ? t->rxlength : t->length) / 8;
+        if (len != e->len || rx != e->rx) {
+            fail("transfer out of call order");
+        } else if (!rx && hash_bytes(tx_bytes(t), len) != e->hash) {
+            fail("bytes on the wire differ from the ones passed");
+        }
+        if (dc_level != e->dc) {
+            fail("DC at the wrong level when the transfer started");
+        }
+        if (rx) {
+            for (size_t i = 0; i < len; i++) {
+                ((uint8_t *)t->rx_buffer)[i] = (uint8_t)(0xA5 ^ i);
+            }
+        }
+        now_us += 1 + (int64_t)len * 8 * 1000000 / device.cfg.clock_speed_hz;
+        wire_transfers++;
+        if (e->flush) {
+            wire_flushes++;
+        }
+    }
+
+    if (device.cfg.post_cb) {
+        device.cfg.post_cb(t);
+    }
+    in_isr = false;
+    if (flush_ready_calls != wire_flushes) {
+        fail("flush not handed back to LVGL exactly once after its last byte");
+    }
+    cs_kept = (t->flags & SPI_TRANS_CS_KEEP_ACTIVE) != 0;
+    cs_active = cs_kept;
+}
+
+static void hw_complete_one(void)
+{
+    hw_entry_t e = hw_pending[0];
+    hw_pending_count--;
+    memmove(&hw_pending[0], &hw_pending[1], hw_pending_count * sizeof(hw_pending[0]));
+    hw_run(e.trans, &e.snapshot);
+    hw_done[hw_done_count++] = e;
+}
+
+// The bus runs on its own: finish some of the queued transfers
+static void hw_progress(void)
+{
+    while (hw_pending_count > 0 && rng() % 100 < hw_speed) {
+        hw_complete_one();
+    }
+}
+
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t *cfg,
+                             spi_device_handle_t *handle)
+{
+    (void)host;
+    if (device_added) {
+        fail("device added twice");
+    }
+    if (cfg->queue_size < 1 || cfg->queue_size > HW_QUEUE_MAX) {
+        fail("bad queue_size");
+    }
+    device.cfg = *cfg;
+    device_added = true;
+    *handle = &device;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_remove_device(spi_device_handle_t handle)
+{
+    if (handle != &device || !device_added) {
+        fail("removing a device that is not there");
+    }
+    if (hw_pending_count + hw_done_count > 0) {
+        fail("device removed with transactions outstanding");
+    }
+    if (bus_acquired) {
+        fail("device removed while it holds the bus");
+    }
+    device_added = false;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t *trans, TickType_t ticks)
+{
+    (void)ticks;
+    hw_progress();
+    if (handle != &device || !device_added) {
+        fail("queue on a removed device");
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (hw_pending_count + hw_done_count >= (unsigned)device.cfg.queue_size) {
+        fail("more transactions handed to the driver than its queue_size");
+        return ESP_ERR_TIMEOUT;
+    }
+    hw_entry_t *e = &hw_pending[hw_pending_count++];
+    e->trans = trans;
+    memcpy(&e->snapshot, trans, sizeof(e->snapshot));
+    unsigned owned = hw_pending_count + hw_done_count;
+    hw_max_owned = owned > hw_max_owned ? owned : hw_max_owned;
+    hw_progress();
+    return ESP_OK;
+}
+
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t **trans, TickType_t ticks)
+{
+    (void)handle;
+    hw_progress();
+    if (hw_done_count == 0 && ticks != 0) {
+        if (hw_pending_count == 0) {
+            fail("waiting for a result with nothing queued (would block forever)");
+            return ESP_ERR_TIMEOUT;
+        }
+        hw_complete_one();
+    }
+    if (hw_done_count == 0) {
+        return ESP_ERR_TIMEOUT;
+    }
+    hw_entry_t e = hw_done[0];
+    hw_done_count--;
+    memmove(&hw_done[0], &hw_done[1], hw_done_count * sizeof(hw_done[0]));
+    if (memcmp(e.trans, &e.snapshot, sizeof(e.snapshot)) != 0) {
+        fail("ring slot rewritten while the driver owned it");
+    }
+    *trans = e.trans;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_polling_transmit(spi_device_handle_t handle, spi_transaction_t *trans)
+{
+    (void)handle;
+    hw_progress();
+    if (hw_pending_count > 0) {
+        fail("polling transfer while queued transfers are pending");
+        while (hw_pending_count > 0) {
+            hw_complete_one();
+        }
+    }
+    if ((trans->flags & SPI_TRANS_CS_KEEP_ACTIVE) && !bus_acquired) {
+        fail("SPI_TRANS_CS_KEEP_ACTIVE without the bus acquired");
+    }
+    hw_run(trans, NULL);
+    return ESP_OK;
+}
+
+esp_err_t spi_device_transmit(spi_device_handle_t handle, spi_transaction_t *trans)
+{
+    return spi_device_polling_transmit(handle, trans);
+}
+
+esp_err_t spi_device_acquire_bus(spi_device_handle_t handle, TickType_t wait)
+{
+    (void)handle;
+    (void)wait;
+    if (bus_acquired) {
+        fail("bus acquired twice");
+    }
+    bus_acquired = true;
+    return ESP_OK;
+}
+
+void spi_device_release_bus(spi_device_handle_t handle)
+{
+    (void)handle;
+    bus_acquired = false;
+    cs_kept = false;
+    cs_active = false;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio, uint32_t level)
+{
+    if (!in_isr) {
+        hw_progress();
+    }
+    if (gpio == DISP_SPI_DC) {
+        dc_level = (int)level;
+    }
+    return ESP_OK;
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return ++now_us;
+}
+
+// ---- Caller side: what the panel drivers do ----
+
+static uint8_t arena[ARENA_SIZE];
+static size_t arena_used;
+
+// Buffer for a transfer that reads from memory until it completes; reused
+// only after everything queued has finished, as LVGL does with its buffers
+static uint8_t *arena_alloc(size_t len)
+{
+    if (arena_used + len > ARENA_SIZE) {
+        disp_wait_for_pending_transactions();
+        arena_used = 0;
+    }
+    uint8_t *p = &arena[arena_used];
+    arena_used += len;
+    for (size_t i = 0; i < len; i++) {
+        p[i] = (uint8_t)rng();
+    }
+    return p;
+}
+
+static void expect(const uint8_t *data, size_t len, bool rx, int dc_flag, bool flush)
+{
+    if (dc_flag >= 0) {
+        model_dc = dc_flag;
+    }
+    expected[expect_head++ % EXPECT_MAX] = (expect_t) {
+        .hash = rx ? 0 : hash_bytes(data, len), .len = len, .rx = rx, .dc = model_dc, .flush = flush,
+    };
+    if (expect_head - expect_tail > EXPECT_MAX) {
+        fail("test: expectation ring overflow");
+    }
+}
+
+static void queue_cmd(uint8_t cmd)
+{
+    expect(&cmd, 1, false, 0, false);
+    disp_spi_queue_cmd(cmd);
+    queued_calls++;
+}
+
+// Short parameters are copied into the descriptor: clobber them after the call
+static void queue_params(void)
+{
+    uint8_t params[4];
+    size_t len = 1 + rng() % 4;
+    for (size_t i = 0; i < len; i++) {
+        params[i] = (uint8_t)rng();
+    }
+    expect(params, len, false, 1, false);
+    disp_spi_queue_data(params, len);
+    memset(params, 0xEE, sizeof(params));
+    queued_calls++;
+}
+
+static void queue_long_data(void)
+{
+    size_t len = 5 + rng() % 600;
+    uint8_t *data = arena_alloc(len);
+    expect(data, len, false, 1, false);
+    disp_spi_queue_data(data, len);
+    queued_calls++;
+}
+
+// disp_panel.c: CASET, RASET, RAMWR and the pixels, all queued with DC in the transaction
+static void queue_window_flush(void)
+{
+    queue_cmd(0x2A);
+    queue_params();
+    queue_cmd(0x2B);
+    queue_params();
+    queue_cmd(0x2C);
+    size_t len = 2 * (1 + rng() % 4000);
+    uint8_t *pixels = arena_alloc(len);
+    expect(pixels, len, false, 1, true);
+    mock_disp.driver.flushing = 1;
+    disp_spi_transaction(pixels, len, DISP_SPI_SEND_QUEUED | DISP_SPI_SIGNAL_FLUSH | DISP_SPI_DC_DATA, NULL, 0);
+    queued_calls++;
+    flush_calls++;
+}
+
+// Older drivers (sh1107, il3820): wait, set DC by hand, polling transfer
+static void legacy_send(bool cmd, bool skip_wait)
+{
+    uint8_t byte = (uint8_t)rng();
+    size_t len = cmd ? 1 : 1 + rng() % 64;
+    uint8_t *data = cmd ? &byte : arena_alloc(len);
+
+    if (!skip_wait) {
+        disp_wait_for_pending_transactions();
+    }
+    gpio_set_level(DISP_SPI_DC, cmd ? 0 : 1);
+    model_dc = cmd ? 0 : 1;
+    expect(data, len, false, -1, false);
+    disp_spi_send_data(data, len);
+}
+
+// sh1107/il3820 flush: the queued pixels rely on the DC level set by hand
+static void legacy_colors(void)
+{
+    size_t len = 1 + rng() % 1024;
+    uint8_t *pixels = arena_alloc(len);
+
+    disp_wait_for_pending_transactions();
+    gpio_set_level(DISP_SPI_DC, 1);
+    model_dc = 1;
+    expect(pixels, len, false, -1, true);
+    mock_disp.driver.flushing = 1;
+    disp_spi_send_colors(pixels, len);
+    queued_calls++;
+    flush_calls++;
+}
+
+static void read_cmd(void)
+{
+    uint8_t buf[16];
+    uint8_t cmd = 0x2E;
+    size_t len = 1 + rng() % sizeof(buf);
+
+    expect(&cmd, 1, false, 0, false);
+    expect(NULL, len, true, 1, false);
+    disp_spi_read_cmd(cmd, buf, len);
+    for (size_t i = 0; i < len; i++) {
+        if (buf[i] != (uint8_t)(0xA5 ^ i)) {
+            fail("read data not returned to the caller");
+            break;
+        }
+    }
+    if (cs_active) {
+        fail("CS still held after the read");
+    }
+}
+
+// EVE style: several polling transfers with the bus held
+static void acquired_burst(void)
+{
+    disp_spi_acquire();
+    for (unsigned n = 1 + rng() % 3; n > 0; n--) {
+        size_t len = 1 + rng() % 8;
+        uint8_t *data = arena_alloc(len);
+        expect(data, len, false, -1, false);
+        disp_spi_send_data(data, len);
+    }
+    disp_spi_release();
+}
+
+static void reset_mock(uint32_t seed)
+{
+    memset(&device, 0, sizeof(device));
+    device_added = bus_acquired = in_isr = cs_active = cs_kept = false;
+    hw_pending_count = hw_done_count = hw_max_owned = 0;
+    dc_level = model_dc = -1;
+    now_us = 0;
+    expect_head = expect_tail = 0;
+    wire_transfers = wire_flushes = queued_calls = flush_calls = 0;
+    flush_ready_calls = 0;
+    failures = 0;
+    arena_used = 0;
+    rng_state = seed * 2654435761u | 1u;
+    // disp_spi.c state carries over between runs; start from an idle bus
+    memset(&queue_stats, 0, sizeof(queue_stats));
+    blocked_at_last_flush = 0;
+}
+
+// Returns the number of failures
+static unsigned run(uint32_t seed, unsigned operations, bool buggy_caller)
+{
+    reset_mock(seed);
+    disp_spi_add_device(VSPI_HOST);
+
+    for (unsigned i = 0; i < operations && failures == 0; i++) {
+        // Phases of a slow bus (ring fills up) and a fast one
+        hw_speed = (i / 2000) % 2 ? 70 : 3;
+        uint32_t op = rng() % 100;
+        if (op < 40) {
+            queue_window_flush();
+        } else if (op < 50) {
+            legacy_colors();
+        } else if (op < 60) {
+            queue_cmd((uint8_t)rng());
+            queue_long_data();
+        } else if (op < 68) {
+            queue_cmd((uint8_t)rng());
+            queue_params();
+        } else if (op < 78) {
+            legacy_send(true, buggy_caller);
+        } else if (op < 86) {
+            legacy_send(false, false);
+        } else if (op < 90) {
+            read_cmd();
+        } else if (op < 94) {
+            acquired_burst();
+        } else if (op < 96) {
+            disp_spi_change_device_speed(rng() % 2 ? 40000000 : 26666666);
+        } else if (op < 98) {
+            disp_spi_wait_flush();
+        } else {
+            disp_wait_for_pending_transactions();
+            if (hw_pending_count + hw_done_count != 0) {
+                fail("transactions outstanding after disp_wait_for_pending_transactions()");
+            }
+        }
+    }
+
+    disp_wait_for_pending_transactions();
+    disp_spi_queue_stats_t stats;
+    disp_spi_get_queue_stats(&stats);
+    if (failures == 0) {
+        if (expect_head != expect_tail) {
+            fail("transfers never reached the wire");
+        } else if (stats.queued != queued_calls || stats.flushes != flush_calls) {
+            fail("queue statistics disagree with the calls made");
+        } else if (stats.in_flight != 0 || stats.max_in_flight > stats.depth || hw_max_owned > stats.depth) {
+            fail("ring occupancy above its depth");
+        } else if (stats.max_in_flight != hw_max_owned) {
+            fail("max_in_flight disagrees with the mock");
+        } else if (stats.ring_full_waits == 0) {
+            fail("slow bus never filled the ring");
+        }
+    }
+    disp_spi_remove_device();
+
+    if (!buggy_caller) {
+        printf("run %u: %u transfers (%u flushes), ring %u/%u at most, %lu ring-full waits: %s\n", seed,
+               wire_transfers, wire_flushes, stats.max_in_flight, stats.depth,
+               (unsigned long)stats.ring_full_waits, failures ? failure : "OK");
+    }
+    return failures;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned operations = argc > 1 ? (unsigned)strtoul(argv[1], NULL, 0) : DEFAULT_OPERATIONS;
+    unsigned runs = argc > 2 ? (unsigned)strtoul(argv[2], NULL, 0) : DEFAULT_RUNS;
+    unsigned failed = 0;
+
+    for (unsigned r = 1; r <= runs; r++) {
+        failed += run(r, operations, false) != 0;
+    }
+
+    // A caller that sets DC without waiting for queued pixels must be caught
+    if (run(1, operations, true) == 0) {
+        printf("self-check: a caller skipping disp_wait_for_pending_transactions() went unnoticed\n");
+        failed++;
+    } else {
+        printf("self-check: caller skipping the wait caught: %s\n", failure);
+    }
+
+    printf("\n%s\n", failed ? "FAILED" : "OK");
+    return failed ? 1 : 0;
+}
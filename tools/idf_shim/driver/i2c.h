@@ -0,0 +1,88 @@
+/*
+ * Host stand-in for ESP-IDF's legacy driver/i2c.h: enough to build the
+ * panel drivers that talk to a power chip, every call succeeds and does
+ * nothing
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "driver/gpio.h"
+#include "freertos/FreeRTOS.h"
+
+typedef int i2c_port_t;
+typedef void *i2c_cmd_handle_t;
+
+#define I2C_NUM_0           0
+#define I2C_MASTER_WRITE    0
+#define I2C_MASTER_READ     1
+
+typedef enum { I2C_MODE_SLAVE = 0, I2C_MODE_MASTER = 1 } i2c_mode_t;
+
+typedef struct {
+    i2c_mode_t mode;
+    int sda_io_num;
+    int scl_io_num;
+    bool sda_pullup_en;
+    bool scl_pullup_en;
+    struct {
+        uint32_t clk_speed;
+    } master;
+    uint32_t clk_flags;
+} i2c_config_t;
+
+static inline esp_err_t i2c_param_config(i2c_port_t port, const i2c_config_t *conf)
+{
+    (void)port;
+    (void)conf;
+    return ESP_OK;
+}
+
+static inline esp_err_t i2c_driver_install(i2c_port_t port, i2c_mode_t mode, size_t rx, size_t tx, int flags)
+{
+    (void)port;
+    (void)mode;
+    (void)rx;
+    (void)tx;
+    (void)flags;
+    return ESP_OK;
+}
+
+static inline i2c_cmd_handle_t i2c_cmd_link_create(void)
+{
+    return (i2c_cmd_handle_t)1;
+}
+
+static inline void i2c_cmd_link_delete(i2c_cmd_handle_t cmd)
+{
+    (void)cmd;
+}
+
+static inline esp_err_t i2c_master_start(i2c_cmd_handle_t cmd)
+{
+    (void)cmd;
+    return ESP_OK;
+}
+
+static inline esp_err_t i2c_master_stop(i2c_cmd_handle_t cmd)
+{
+    (void)cmd;
+    return ESP_OK;
+}
+
+static inline esp_err_t i2c_master_write_byte(i2c_cmd_handle_t cmd, uint8_t data, bool ack_en)
+{
+    (void)cmd;
+    (void)data;
+    (void)ack_en;
+    return ESP_OK;
+}
+
+static inline esp_err_t i2c_master_cmd_begin(i2c_port_t port, i2c_cmd_handle_t cmd, TickType_t ticks)
+{
+    (void)port;
+    (void)cmd;
+    (void)ticks;
+    return ESP_OK;
+}
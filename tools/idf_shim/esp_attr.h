@@ -0,0 +1,7 @@
+/*
+ * Host stand-in for ESP-IDF's esp_attr.h: placement attributes do nothing
+ */
+#pragma once
+
+#define IRAM_ATTR
+#define DRAM_ATTR
@@ -0,0 +1,20 @@
+/*
+ * Host stand-in for ESP-IDF's esp_log.h: warnings and errors go to stderr
+ * when built with -DIDF_SHIM_LOG=1, everything else is dropped
+ */
+#pragma once
+
+#include <stdio.h>
+
+#ifndef IDF_SHIM_LOG
+#define IDF_SHIM_LOG 0
+#endif
+
+#define IDF_SHIM_PRINT(level, tag, fmt, ...) \
+    do { if (IDF_SHIM_LOG) fprintf(stderr, level " (%s) " fmt "\n", tag, ##__VA_ARGS__); } while (0)
+
+#define ESP_LOGE(tag, fmt, ...) IDF_SHIM_PRINT("E", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) IDF_SHIM_PRINT("W", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) do { (void)(tag); } while (0)
+#define ESP_LOGD(tag, fmt, ...) do { (void)(tag); } while (0)
+#define ESP_LOGV(tag, fmt, ...) do { (void)(tag); } while (0)
@@ -0,0 +1,19 @@
+/*
+ * Host stand-in for ESP-IDF's esp_rom_crc.h (CRC-32/ISO-HDLC, like the ROM)
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+static inline uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len)
+{
+    crc = ~crc;
+    while (len--) {
+        crc ^= *buf++;
+        for (int k = 0; k < 8; k++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
@@ -0,0 +1,11 @@
+/*
+ * Host stand-in for ESP-IDF's esp_rom_gpio.h
+ */
+#pragma once
+
+#include <stdint.h>
+
+static inline void esp_rom_gpio_pad_select_gpio(uint32_t gpio_num)
+{
+    (void)gpio_num;
+}
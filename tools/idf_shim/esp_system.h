@@ -0,0 +1,8 @@
+/*
+ * Host stand-in for ESP-IDF's esp_system.h
+ */
+#pragma once
+
+#include <assert.h>
+#include "esp_attr.h"
+#include "esp_err.h"
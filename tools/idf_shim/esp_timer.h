@@ -0,0 +1,8 @@
+/*
+ * Host stand-in for ESP-IDF's esp_timer.h. The test provides the clock.
+ */
+#pragma once
+
+#include <stdint.h>
+
+int64_t esp_timer_get_time(void);
@@ -0,0 +1,20 @@
+/*
+ * Host stand-in for FreeRTOS.h, enough for the tests in tools/ (single threaded)
+ */
+#pragma once
+
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+
+#define pdTRUE          1
+#define pdFALSE         0
+#define portMAX_DELAY   ((TickType_t)0xFFFFFFFFu)
+
+#ifndef configTICK_RATE_HZ
+#define configTICK_RATE_HZ      100
+#endif
+#define portTICK_PERIOD_MS      ((TickType_t)1000 / configTICK_RATE_HZ)
+#define portTICK_RATE_MS        portTICK_PERIOD_MS
+#define pdMS_TO_TICKS(ms)       ((TickType_t)((uint64_t)(ms) * configTICK_RATE_HZ / 1000))
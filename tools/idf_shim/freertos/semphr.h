@@ -0,0 +1,63 @@
+/*
+ * Host stand-in for FreeRTOS semphr.h. The tests in tools/ are single
+ * threaded, so nothing ever blocks: a take without a token fails at once.
+ */
+#pragma once
+
+#include "FreeRTOS.h"
+
+typedef struct {
+    int count;
+    int max;
+} idf_shim_semaphore_t;
+
+typedef idf_shim_semaphore_t *SemaphoreHandle_t;
+
+static inline SemaphoreHandle_t idf_shim_semaphore_create(int count, int max)
+{
+    static idf_shim_semaphore_t pool[8];
+    static int used;
+    if (used == 8) {
+        return 0;
+    }
+    pool[used].count = count;
+    pool[used].max = max;
+    return &pool[used++];
+}
+
+static inline SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return idf_shim_semaphore_create(1, 1);
+}
+
+static inline SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return idf_shim_semaphore_create(0, 1);
+}
+
+static inline BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t ticks)
+{
+    (void)ticks;
+    if (s->count == 0) {
+        return pdFALSE;
+    }
+    s->count--;
+    return pdTRUE;
+}
+
+static inline BaseType_t xSemaphoreGive(SemaphoreHandle_t s)
+{
+    if (s->count == s->max) {
+        return pdFALSE;
+    }
+    s->count++;
+    return pdTRUE;
+}
+
+static inline BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t s, BaseType_t *woken)
+{
+    if (woken) {
+        *woken = pdFALSE;
+    }
+    return xSemaphoreGive(s);
+}
@@ -0,0 +1,10 @@
+/*
+ * Host stand-in for FreeRTOS task.h. The test provides vTaskDelay.
+ */
+#pragma once
+
+#include "FreeRTOS.h"
+
+#define portYIELD_FROM_ISR()    do { } while (0)
+
+void vTaskDelay(const TickType_t ticks);
@@ -0,0 +1,203 @@
+/*
+ * Host benchmark: cJSON vs main/json_writer.c for level batches
+ *
+ * Encodes the same level batch as the firmware's [j] menu entry with a cJSON
+ * tree and with the allocation-free writer (columnar and array formats), and
+ * prints bytes, time, throughput and heap allocations per message for a few
+ * batch sizes. The encoders mirror level_build_batch_cjson() and
+ * level_encode_batch() in main/main.c.
+ *
+ * cJSON allocations are counted with cJSON_InitHooks(), which is fine in this
+ * single-threaded program (on the device the hooks are global and shared with
+ * the MQTT and HTTP code, so the firmware counts the tree instead). Custom
+ * hooks make cJSON_Print() grow its buffer with malloc+copy instead of
+ * realloc, so the cJSON time is slightly pessimistic.
+ *
+ * Build and run (cJSON is the copy bundled with ESP-IDF):
+ *     gcc -O2 -Imain -I$IDF_PATH/components/json/cJSON tools/json_writer_bench.c main/json_writer.c \
+ *         $IDF_PATH/components/json/cJSON/cJSON.c -lm -o json_writer_bench
+ *     ./json_writer_bench [iterations]
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "cJSON.h"
+#include "json_writer.h"
+
+#define DEFAULT_ITERATIONS 2000
+#define MAX_SAMPLES        200
+#define PAYLOAD_MAX        16384    // The firmware splits batches at 4096 bytes, the bench does not
+#define CLIENT_ID          "lindi-0123456789ab"
+#define EPOCH_OFFSET_US    1760000000000000LL
+
+static unsigned long allocs;
+
+static void *counting_malloc(size_t size)
+{
+    allocs++;
+    return malloc(size);
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static cJSON *build_cjson(const int64_t *ts_us, const float *pitch, const float *roll, size_t count)
+{
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "client_id", CLIENT_ID);
+    cJSON_AddNumberToObject(root, "count", count);
+    int64_t prev_ms = (ts_us[0] + EPOCH_OFFSET_US) / 1000;
+    cJSON_AddNumberToObject(root, "t0", (double)prev_ms);
+    cJSON *dt = cJSON_AddArrayToObject(root, "dt");
+    cJSON *p = cJSON_AddArrayToObject(root, "pitch");
+    cJSON *r = cJSON_AddArrayToObject(root, "roll");
+    for (size_t i = 0; i < count; i++) {
+        int64_t ms = (ts_us[i] + EPOCH_OFFSET_US) / 1000;
+        cJSON_AddItemToArray(dt, cJSON_CreateNumber((double)(ms - prev_ms)));
+        cJSON_AddItemToArray(p, cJSON_CreateNumber(round(pitch[i] * 1000.0) / 1000.0));
+        cJSON_AddItemToArray(r, cJSON_CreateNumber(round(roll[i] * 1000.0) / 1000.0));
+        prev_ms = ms;
+    }
+    return root;
+}
+
+static void encode_columnar(json_writer_t *w, const int64_t *ts_us, const float *pitch, const float *roll,
+                            size_t count)
+{
+    json_obj_begin(w);
+    json_kv_str(w, "client_id", CLIENT_ID);
+    json_kv_int(w, "count", (int64_t)count);
+    int64_t prev_ms = (ts_us[0] + EPOCH_OFFSET_US) / 1000;
+    json_kv_int(w, "t0", prev_ms);
+    json_key(w, "dt");
+    json_arr_begin(w);
+    for (size_t i = 0; i < count; i++) {
+        int64_t ms = (ts_us[i] + EPOCH_OFFSET_US) / 1000;
+        json_int(w, ms - prev_ms);
+        prev_ms = ms;
+    }
+    json_arr_end(w);
+    json_key(w, "pitch");
+    json_arr_begin(w);
+    for (size_t i = 0; i < count; i++) {
+        json_float(w, pitch[i], 3);
+    }
+    json_arr_end(w);
+    json_key(w, "roll");
+    json_arr_begin(w);
+    for (size_t i = 0; i < count; i++) {
+        json_float(w, roll[i], 3);
+    }
+    json_arr_end(w);
+    json_obj_end(w);
+}
+
+static void encode_array(json_writer_t *w, const int64_t *ts_us, const float *pitch, const float *roll,
+                         size_t count)
+{
+    json_obj_begin(w);
+    json_kv_str(w, "client_id", CLIENT_ID);
+    json_kv_int(w, "count", (int64_t)count);
+    json_key(w, "samples");
+    json_arr_begin(w);
+    for (size_t i = 0; i < count; i++) {
+        json_obj_begin(w);
+        json_kv_int(w, "timestamp_ms", (ts_us[i] + EPOCH_OFFSET_US) / 1000);
+        json_kv_float(w, "pitch", pitch[i], 3);
+        json_kv_float(w, "roll", roll[i], 3);
+        json_obj_end(w);
+    }
+    json_arr_end(w);
+    json_obj_end(w);
+}
+
+static void report(const char *name, size_t bytes, double seconds, int iterations, double allocs_per_msg)
+{
+    printf("  %-20s %6zu B  %8.2f us/msg  %7.2f MB/s  %7.1f allocs/msg\n", name, bytes,
+           seconds / iterations * 1e6, bytes * (double)iterations / seconds / 1e6, allocs_per_msg);
+}
+
+static int bench(size_t count, int iterations)
+{
+    static int64_t ts_us[MAX_SAMPLES];
+    static float pitch[MAX_SAMPLES], roll[MAX_SAMPLES];
+    static char buf[PAYLOAD_MAX];
+    size_t cjson_len = 0, len = 0;
+    json_writer_t w;
+    int failures = 0;
+
+    // Same synthetic 50 Hz batch as the firmware bench
+    for (size_t i = 0; i < count; i++) {
+        ts_us[i] = (int64_t)i * 20000;
+        pitch[i] = -12.3456f + i * 0.0173f;
+        roll[i] = 3.21f - i * 0.0291f;
+    }
+    printf("%zu samples, %d iterations\n", count, iterations);
+
+    allocs = 0;
+    double t0 = now_s();
+    for (int i = 0; i < iterations; i++) {
+        cJSON *root = build_cjson(ts_us, pitch, roll, count);
+        char *json = cJSON_PrintUnformatted(root);
+        cjson_len = strlen(json);
+        cJSON_free(json);
+        cJSON_Delete(root);
+    }
+    report("cJSON (columnar)", cjson_len, now_s() - t0, iterations, (double)allocs / iterations);
+
+    // The writer must produce the same document as cJSON, apart from number formatting
+    json_writer_init(&w, buf, sizeof(buf));
+    encode_columnar(&w, ts_us, pitch, roll, count);
+    cJSON *parsed = json_writer_finish(&w, NULL) ? cJSON_Parse(buf) : NULL;
+    if (!parsed || cJSON_GetArraySize(cJSON_GetObjectItem(parsed, "pitch")) != (int)count) {
+        printf("  json_writer output does not parse as a %zu sample batch\n", count);
+        failures++;
+    }
+    cJSON_Delete(parsed);
+
+    allocs = 0;
+    t0 = now_s();
+    for (int i = 0; i < iterations; i++) {
+        json_writer_init(&w, buf, sizeof(buf));
+        encode_columnar(&w, ts_us, pitch, roll, count);
+        json_writer_finish(&w, &len);
+    }
+    report("json_writer columnar", len, now_s() - t0, iterations, (double)allocs / iterations);
+    failures += allocs != 0;
+
+    t0 = now_s();
+    for (int i = 0; i < iterations; i++) {
+        json_writer_init(&w, buf, sizeof(buf));
+        encode_array(&w, ts_us, pitch, roll, count);
+        json_writer_finish(&w, &len);
+    }
+    report("json_writer array", len, now_s() - t0, iterations, (double)allocs / iterations);
+    failures += allocs != 0;
+    return failures;
+}
+
+int main(int argc, char **argv)
+{
+    static const size_t sizes[] = {10, 50, MAX_SAMPLES};
+    int iterations = argc > 1 ? atoi(argv[1]) : DEFAULT_ITERATIONS;
+    cJSON_Hooks hooks = {.malloc_fn = counting_malloc, .free_fn = free};
+    int failures = 0;
+
+    if (iterations < 1) {
+        iterations = DEFAULT_ITERATIONS;
+    }
+    cJSON_InitHooks(&hooks);
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        failures += bench(sizes[i], iterations);
+        printf("\n");
+    }
+    printf("%s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
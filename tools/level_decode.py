@@ -0,0 +1,163 @@
+#!/usr/bin/env python3
+"""
+Reference decoder for Lindi level telemetry (<base>/device/level).
+
+Handles all three payload formats and yields (timestamp_ms, pitch, roll)
+in degrees:
+  - JSON array     {"samples": [{"timestamp_ms", "pitch", "roll"}, ...]}
+  - JSON columnar  {"t0", "dt": [...], "pitch": [...], "roll": [...]}
+  - CBOR           55799({0: client_id, 1: t0, 2: [dt...],
+                          3: 65(h'int16 BE centi-degrees'), 4: 65(...), ?5: lost,
+                          ?6: replay})
+
+Payloads starting with the CBOR self-describe tag (D9 D9 F7) are binary,
+everything else is JSON. No third-party packages required.
+
+Usage:
+    mosquitto_sub -t 'lindi/device/level' -F '%x' | python3 tools/level_decode.py --hex
+    python3 tools/level_decode.py payload.bin
+"""
+
+import json
+import struct
+import sys
+
+CBOR_MAGIC = b"\xd9\xd9\xf7"
+TAG_SELF_DESCRIBE = 55799
+TAG_INT16_BE_ARRAY = 65
+INVALID_CENTIDEG = -32768
+
+KEY_CLIENT_ID, KEY_T0, KEY_DT, KEY_PITCH, KEY_ROLL, KEY_LOST, KEY_REPLAY = range(7)
+
+
+class Tagged:
+    def __init__(self, tag, value):
+        self.tag = tag
+        self.value = value
+
+
+def _cbor_item(data, pos):
+    """Decode one definite-length CBOR item; returns (value, next_pos)"""
+    initial = data[pos]
+    major, info = initial >> 5, initial & 0x1F
+    pos += 1
+    if info < 24:
+        arg = info
+    elif info in (24, 25, 26, 27):
+        size = 1 << (info - 24)
+        arg = int.from_bytes(data[pos:pos + size], "big")
+        pos += size
+    else:
+        raise ValueError(f"unsupported CBOR additional info {info} at {pos - 1}")
+
+    if major == 0:
+        return arg, pos
+    if major == 1:
+        return -1 - arg, pos
+    if major in (2, 3):
+        raw = bytes(data[pos:pos + arg])
+        if len(raw) != arg:
+            raise ValueError("truncated CBOR string")
+        return (raw if major == 2 else raw.decode("utf-8")), pos + arg
+    if major == 4:
+        items = []
+        for _ in range(arg):
+            item, pos = _cbor_item(data, pos)
+            items.append(item)
+        return items, pos
+    if major == 5:
+        result = {}
+        for _ in range(arg):
+            key, pos = _cbor_item(data, pos)
+            result[key], pos = _cbor_item(data, pos)
+        return result, pos
+    if major == 6:
+        value, pos = _cbor_item(data, pos)
+        return Tagged(arg, value), pos
+    if major == 7 and info in (20, 21):
+        return info == 21, pos
+    raise ValueError(f"unsupported CBOR major type {major}")
+
+
+def _int16_column(item):
+    if not isinstance(item, Tagged) or item.tag != TAG_INT16_BE_ARRAY:
+        raise ValueError("expected tag 65 int16 typed array")
+    values = struct.unpack(f">{len(item.value) // 2}h", item.value)
+    return [None if v == INVALID_CENTIDEG else v / 100.0 for v in values]
+
+
+def decode_cbor(payload):
+    """Decode a CBOR level payload into a dict with client_id, lost, replay and samples"""
+    item, end = _cbor_item(payload, 0)
+    if end != len(payload):
+        raise ValueError("trailing bytes after CBOR item")
+    if not isinstance(item, Tagged) or item.tag != TAG_SELF_DESCRIBE:
+        raise ValueError("missing self-describe tag")
+    m = item.value
+
+    t = m[KEY_T0]
+    times = []
+    for i, dt in enumerate(m[KEY_DT]):
+        t = t if i == 0 else t + dt
+        times.append(t)
+    pitch = _int16_column(m[KEY_PITCH])
+    roll = _int16_column(m[KEY_ROLL])
+    if not (len(times) == len(pitch) == len(roll)):
+        raise ValueError("column lengths differ")
+
+    return {
+        "client_id": m.get(KEY_CLIENT_ID),
+        "lost": m.get(KEY_LOST, 0),
+        "replay": m.get(KEY_REPLAY, False),
+        "samples": list(zip(times, pitch, roll)),
+    }
+
+
+def decode_json(payload):
+    data = json.loads(payload)
+    if "samples" in data:
+        samples = [(s["timestamp_ms"], s["pitch"], s["roll"]) for s in data["samples"]]
+    else:
+        samples = []
+        t = data["t0"]
+        for i, (dt, pitch, roll) in enumerate(zip(data["dt"], data["pitch"], data["roll"])):
+            t = t if i == 0 else t + dt
+            samples.append((t, pitch, roll))
+    return {
+        "client_id": data.get("client_id"),
+        "lost": data.get("lost", 0),
+        "replay": data.get("replay", False),
+        "samples": samples,
+    }
+
+
+def decode(payload):
+    """Decode any level payload (bytes) into a dict with client_id, lost, replay and samples"""
+    if payload.startswith(CBOR_MAGIC):
+        return decode_cbor(payload)
+    return decode_json(payload.decode("utf-8"))
+
+
+def main(argv):
+    hex_input = "--hex" in argv
+    paths = [a for a in argv[1:] if a != "--hex"]
+
+    if paths:
+        payloads = [open(p, "rb").read() for p in paths]
+    elif hex_input:
+        payloads = (bytes.fromhex(line.strip()) for line in sys.stdin if line.strip())
+    else:
+        payloads = [sys.stdin.buffer.read()]
+
+    for payload in payloads:
+        msg = decode(payload)
+        replay = " (replayed from offline queue)" if msg["replay"] else ""
+        print(f"# {msg['client_id']}: {len(msg['samples'])} samples, {len(payload)} bytes, {msg['lost']} lost{replay}")
+        for t, pitch, roll in msg["samples"]:
+            pitch = "invalid" if pitch is None else f"{pitch:.2f}"
+            roll = "invalid" if roll is None else f"{roll:.2f}"
+            print(f"{t}: pitch={pitch} roll={roll}")
+
+
+if __name__ == "__main__":
+    main(sys.argv)
@@ -0,0 +1,257 @@
+/*
+ * Host round-trip test for the CBOR level payload
+ *
+ * Encodes level batches with the firmware encoder (main/level_payload.c on
+ * main/cbor_writer.c), decodes them with the reference decoder
+ * tools/level_decode.py and compares the result with the input:
+ *   - timestamps must match (ts_us + epoch offset) / 1000 exactly
+ *   - angles must be within 0.005 degrees (centi-degree rounding)
+ *   - NaN/Inf must come back as invalid, angles beyond the int16 range
+ *     clamped to +-327.67
+ *   - client_id, sample count, lost and replay must survive
+ * Cases cover single samples, batches long enough for 2-byte CBOR lengths,
+ * large timestamp gaps and large lost counts.
+ *
+ * Build and run from the repository root (needs python3):
+ *     gcc -O2 -Imain tools/level_payload_roundtrip.c main/level_payload.c main/cbor_writer.c -lm \
+ *         -o level_payload_roundtrip
+ *     ./level_payload_roundtrip [path/to/level_decode.py]
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "level_payload.h"
+
+#define MAX_SAMPLES     600
+#define PAYLOAD_MAX     4096        // LEVEL_PAYLOAD_MAX in main.c
+#define CLIENT_ID       "lindi-a1b2c3d4e5f6"
+#define EPOCH_OFFSET_US 1760000000123456LL
+#define TOLERANCE       0.005
+#define MAX_ANGLE       327.67
+
+typedef struct {
+    const char *name;
+    size_t count;
+    uint32_t lost;
+    bool replay;
+    int64_t ts_us[MAX_SAMPLES];
+    float pitch[MAX_SAMPLES];
+    float roll[MAX_SAMPLES];
+    char path[64];
+} test_case_t;
+
+static test_case_t cases[8];
+static size_t case_count;
+
+static test_case_t *add_case(const char *name, size_t count, uint32_t lost, bool replay)
+{
+    test_case_t *c = &cases[case_count++];
+    c->name = name;
+    c->count = count;
+    c->lost = lost;
+    c->replay = replay;
+    return c;
+}
+
+static void make_cases(void)
+{
+    test_case_t *c = add_case("single sample", 1, 0, false);
+    c->ts_us[0] = 987654321;
+    c->pitch[0] = 1.234f;
+    c->roll[0] = -0.567f;
+
+    // 50 Hz with jitter and sub-millisecond times, so truncation to ms matters
+    c = add_case("batch of 50, lost, replay", 50, 3, true);
+    for (size_t i = 0; i < c->count; i++) {
+        c->ts_us[i] = 5000000 + (int64_t)i * 20000 + (int64_t)(i * 7919 % 1999);
+        c->pitch[i] = -12.3456f + 0.0173f * i;
+        c->roll[i] = 3.21f - 0.0291f * i;
+    }
+
+    c = add_case("NaN and Inf", 4, 0, false);
+    for (size_t i = 0; i < c->count; i++) {
+        c->ts_us[i] = 100000 + (int64_t)i * 10000;
+    }
+    c->pitch[0] = NAN;
+    c->roll[0] = 0.0f;
+    c->pitch[1] = 0.004f;
+    c->roll[1] = INFINITY;
+    c->pitch[2] = -INFINITY;
+    c->roll[2] = -0.004f;
+    c->pitch[3] = NAN;
+    c->roll[3] = NAN;
+
+    c = add_case("out of range", 6, 0, false);
+    const float extremes[6] = {400.0f, -400.0f, 327.67f, -327.67f, 327.674f, -1e9f};
+    for (size_t i = 0; i < c->count; i++) {
+        c->ts_us[i] = (int64_t)i * 20000;
+        c->pitch[i] = extremes[i];
+        c->roll[i] = -extremes[i];
+    }
+
+    // Gaps beyond 16 and 32 bit milliseconds, lost count beyond 16 bits
+    c = add_case("large gaps and lost", 3, 70000, false);
+    c->ts_us[0] = 0;
+    c->ts_us[1] = 70000LL * 1000;
+    c->ts_us[2] = 70000LL * 1000 + 5000000000LL * 1000;
+    for (size_t i = 0; i < c->count; i++) {
+        c->pitch[i] = 45.0f * i;
+        c->roll[i] = -90.0f + 0.001f * i;
+    }
+
+    // More than 255 samples: 2-byte array and byte string lengths
+    c = add_case("batch of 600", MAX_SAMPLES, 1, false);
+    for (size_t i = 0; i < c->count; i++) {
+        c->ts_us[i] = 3600000000LL + (int64_t)i * 5000;
+        c->pitch[i] = 30.0f * sinf(i * 0.01f);
+        c->roll[i] = -179.99f + 0.6f * i;
+    }
+}
+
+// Expected decoded angle; returns false for an invalid (NaN/Inf) input
+static bool expected_angle(float in, double *out)
+{
+    if (!isfinite(in)) {
+        return false;
+    }
+    *out = in > MAX_ANGLE ? MAX_ANGLE : in < -MAX_ANGLE ? -MAX_ANGLE : in;
+    return true;
+}
+
+static int check_angle(const test_case_t *c, size_t i, const char *what, float in, const char *decoded)
+{
+    double want;
+    if (!expected_angle(in, &want)) {
+        if (strcmp(decoded, "invalid") != 0) {
+            printf("  %s: sample %zu %s: expected invalid, got %s\n", c->name, i, what, decoded);
+            return 1;
+        }
+        return 0;
+    }
+    char *end;
+    double got = strtod(decoded, &end);
+    // 1e-6 absorbs the float representation of the input
+    if (end == decoded || fabs(got - want) > TOLERANCE + 1e-6) {
+        printf("  %s: sample %zu %s: sent %.4f, decoded %s\n", c->name, i, what, in, decoded);
+        return 1;
+    }
+    return 0;
+}
+
+static int write_payloads(const char *dir)
+{
+    static uint8_t buf[PAYLOAD_MAX];
+
+    for (size_t n = 0; n < case_count; n++) {
+        test_case_t *c = &cases[n];
+        cbor_writer_t w;
+        cbor_writer_init(&w, buf, sizeof(buf));
+        level_payload_encode_cbor(&w, CLIENT_ID, c->ts_us, c->pitch, c->roll, c->count, c->lost,
+                                  EPOCH_OFFSET_US, c->replay);
+        size_t len = cbor_writer_finish(&w);
+        if (len == 0) {
+            printf("%s: does not fit in %d bytes\n", c->name, PAYLOAD_MAX);
+            return -1;
+        }
+        snprintf(c->path, sizeof(c->path), "%s/case%zu.cbor", dir, n);
+        FILE *f = fopen(c->path, "wb");
+        if (!f || fwrite(buf, 1, len, f) != len) {
+            printf("Cannot write %s\n", c->path);
+            if (f) {
+                fclose(f);
+            }
+            return -1;
+        }
+        fclose(f);
+        printf("  %-28s %3zu samples  %4zu bytes\n", c->name, c->count, len);
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    const char *decoder = argc > 1 ? argv[1] : "tools/level_decode.py";
+    char dir[] = "/tmp/level_payload_XXXXXX";
+    char cmd[1024], line[256];
+    int failures = 0;
+
+    if (!mkdtemp(dir)) {
+        perror("mkdtemp");
+        return 1;
+    }
+    make_cases();
+    printf("Encoded:\n");
+    if (write_payloads(dir) != 0) {
+        return 1;
+    }
+
+    int n = snprintf(cmd, sizeof(cmd), "python3 %s", decoder);
+    for (size_t i = 0; i < case_count; i++) {
+        n += snprintf(cmd + n, sizeof(cmd) - n, " %s", cases[i].path);
+    }
+    FILE *p = popen(cmd, "r");
+    if (!p) {
+        perror("popen");
+        return 1;
+    }
+
+    // One "# client: N samples, B bytes, L lost[ (replayed...)]" line per payload, then one line per sample
+    printf("Decoded with %s:\n", decoder);
+    for (size_t k = 0; k < case_count; k++) {
+        const test_case_t *c = &cases[k];
+        char client_id[64];
+        size_t count, bytes;
+        unsigned long lost;
+        int case_failures = 0;
+
+        if (!fgets(line, sizeof(line), p) ||
+            sscanf(line, "# %63[^:]: %zu samples, %zu bytes, %lu lost", client_id, &count, &bytes, &lost) != 4) {
+            printf("  %s: no header from the decoder\n", c->name);
+            failures++;
+            break;
+        }
+        bool replay = strstr(line, "replayed") != NULL;
+        if (strcmp(client_id, CLIENT_ID) != 0 || count != c->count || lost != c->lost || replay != c->replay) {
+            printf("  %s: header mismatch: %s", c->name, line);
+            case_failures++;
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            long long t;
+            char pitch[32], roll[32];
+            if (!fgets(line, sizeof(line), p) || sscanf(line, "%lld: pitch=%31s roll=%31s", &t, pitch, roll) != 3) {
+                printf("  %s: sample %zu missing\n", c->name, i);
+                case_failures++;
+                break;
+            }
+            if (i >= c->count) {
+                continue;
+            }
+            long long want = (c->ts_us[i] + EPOCH_OFFSET_US) / 1000;
+            if (t != want) {
+                printf("  %s: sample %zu time %lld, expected %lld\n", c->name, i, t, want);
+                case_failures++;
+            }
+            case_failures += check_angle(c, i, "pitch", c->pitch[i], pitch);
+            case_failures += check_angle(c, i, "roll", c->roll[i], roll);
+        }
+        printf("  %-28s %s\n", c->name, case_failures ? "FAILED" : "ok");
+        failures += case_failures;
+    }
+
+    int status = pclose(p);
+    if (status != 0) {
+        printf("Decoder exited with status %d\n", status);
+        failures++;
+    }
+    for (size_t i = 0; i < case_count; i++) {
+        remove(cases[i].path);
+    }
+    rmdir(dir);
+
+    printf("\n%s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
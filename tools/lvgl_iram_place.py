@@ -0,0 +1,226 @@
+#!/usr/bin/env python3
+"""
+IRAM placement for LVGL from a cycle profile (serial menu [k]).
+
+place: reads the "P <address> <calls> <cycles>" lines of a
+CONFIG_LVGL_CODE_PLACEMENT_PROFILE build and that build's linker map, and
+fills an IRAM budget with the LVGL functions that spent the most cycles per
+byte of code. It writes them to components/lvgl/lvgl_iram.lf, which the
+lvgl component links when CONFIG_LVGL_CODE_PLACEMENT_IRAM is set.
+Instrumentation makes functions larger and keeps some that would be
+inlined, so pass the map of a normal (flash) build as --flash-map for the
+sizes; functions missing from it are inlined there and left out.
+
+compare: reads the "S <scene> <frames> <ms/frame>" lines of two [k]
+reports, one from a flash build and one with the placement, and prints the
+render time per frame of each scene side by side.
+
+No third-party packages required.
+
+Usage:
+    python3 tools/lvgl_iram_place.py place profile.log --map build/lindi.map \\
+        [--flash-map flash.map] [--budget 16384] [--out components/lvgl/lvgl_iram.lf]
+    python3 tools/lvgl_iram_place.py compare flash.log iram.log
+"""
+
+import argparse
+import os
+import re
+import sys
+
+ARCHIVE = "liblvgl.a"
+DEFAULT_BUDGET = 16384          # LVGL's own LV_ATTRIBUTE_FAST_MEM set needs 15-20 kB
+DEFAULT_OUT = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                           "..", "components", "lvgl", "lvgl_iram.lf")
+# Code the cache maps from flash (ESP32 IROM)
+FLASH_TEXT = (0x400C2000, 0x40C00000)
+
+PROFILE_RE = re.compile(r"^P 0x([0-9a-fA-F]+) (\d+) (\d+)\s*$")
+SCENE_RE = re.compile(r"^S (\S+)\s+(\d+)\s+([\d.]+)\s*$")
+CODE_RE = re.compile(r"^\s*LVGL code: (.*?)\s*$")
+SECTION_RE = re.compile(r"^ \.(text|literal)\.(\S+)(?:\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(\S+))?\s*$")
+PLACE_RE = re.compile(r"^\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(\S+)\s*$")
+OBJECT_RE = re.compile(r"(?:^|/)" + re.escape(ARCHIVE) + r"\(([^)]+?)(?:\.c)?\.o(?:bj)?\)$")
+
+
+def read_map(path):
+    """Functions of liblvgl.a in a GNU ld map: {(object, name): [address, bytes]}.
+    The address is that of .text.<name>; bytes counts .text and .literal."""
+    funcs = {}
+    with open(path, errors="replace") as f:
+        lines = iter(f)
+        for line in lines:
+            if line.startswith("Linker script and memory map"):
+                break
+        pending = None
+        for line in lines:
+            if pending:
+                kind, name = pending
+                pending = None
+                m = PLACE_RE.match(line)
+                if m:
+                    add_section(funcs, kind, name, int(m.group(1), 16), int(m.group(2), 16), m.group(3))
+                    continue
+            m = SECTION_RE.match(line)
+            if not m:
+                continue
+            if m.group(3) is None:
+                pending = (m.group(1), m.group(2))       # Long name: address on the next line
+            else:
+                add_section(funcs, m.group(1), m.group(2), int(m.group(3), 16), int(m.group(4), 16), m.group(5))
+    return funcs
+
+
+def add_section(funcs, kind, name, address, size, source):
+    m = OBJECT_RE.search(source)
+    if not m or size == 0:
+        return
+    entry = funcs.setdefault((m.group(1), name), [None, 0])
+    entry[1] += size
+    if kind == "text":
+        entry[0] = address
+
+
+def read_profile(path):
+    """{address: (calls, cycles)} from the P lines of a [k] report"""
+    profile = {}
+    with open(path, errors="replace") as f:
+        for line in f:
+            m = PROFILE_RE.match(line.strip())
+            if m:
+                profile[int(m.group(1), 16)] = (int(m.group(2)), int(m.group(3)))
+    return profile
+
+
+def read_scenes(path):
+    """(LVGL code line, [(scene, frames, ms/frame)]) of a [k] report"""
+    code = "?"
+    scenes = []
+    with open(path, errors="replace") as f:
+        for line in f:
+            m = CODE_RE.match(line)
+            if m:
+                code = m.group(1)
+            m = SCENE_RE.match(line.strip())
+            if m:
+                scenes.append((m.group(1), int(m.group(2)), float(m.group(3))))
+    return code, scenes
+
+
+def place(args):
+    profile = read_profile(args.log)
+    if not profile:
+        sys.exit("%s: no 'P <address> <calls> <cycles>' lines (build with "
+                 "CONFIG_LVGL_CODE_PLACEMENT_PROFILE and run serial menu [k])" % args.log)
+    funcs = read_map(args.map)
+    sizes = read_map(args.flash_map) if args.flash_map else funcs
+    by_address = {entry[0]: key for key, entry in funcs.items() if entry[0] is not None}
+
+    total_cycles = sum(cycles for _, cycles in profile.values())
+    candidates = []
+    unknown = inlined = in_iram = 0
+    for address, (calls, cycles) in profile.items():
+        key = by_address.get(address)
+        if key is None:
+            unknown += 1
+            continue
+        if not FLASH_TEXT[0] <= address < FLASH_TEXT[1]:
+            in_iram += 1                                # IRAM_ATTR already
+            continue
+        if key not in sizes or sizes[key][0] is None:
+            inlined += 1
+            continue
+        candidates.append((cycles / sizes[key][1], key, sizes[key][1], calls, cycles))
+
+    # Greedy knapsack: most cycles per byte first, skipping what does not fit
+    candidates.sort(key=lambda c: (-c[0], c[1]))
+    chosen = []
+    used = 0
+    for c in candidates:
+        if used + c[2] <= args.budget and c[4] > 0:
+            chosen.append(c)
+            used += c[2]
+    placed_cycles = sum(c[4] for c in chosen)
+
+    print("%-36s %-16s %6s %9s %7s" % ("function", "object", "bytes", "calls", "% cyc"))
+    for _, (obj, name), size, calls, cycles in chosen:
+        print("%-36s %-16s %6d %9d %6.2f%%" % (name, obj, size, calls, 100.0 * cycles / total_cycles))
+    print()
+    print("%d functions, %d of %d bytes, %.1f%% of the profiled LVGL cycles"
+          % (len(chosen), used, args.budget, 100.0 * placed_cycles / total_cycles))
+    if unknown or inlined or in_iram:
+        print("Left out: %d not in the map, %d inlined in the flash build, %d already in IRAM"
+              % (unknown, inlined, in_iram))
+
+    with open(args.out, "w") as f:
+        f.write("# LVGL functions placed in IRAM with CONFIG_LVGL_CODE_PLACEMENT_IRAM.\n")
+        f.write("#\n")
+        f.write("# Generated by tools/lvgl_iram_place.py from %s:\n" % os.path.basename(args.log))
+        f.write("# %d functions, %d of %d bytes, %.1f%% of the profiled LVGL cycles.\n"
+                % (len(chosen), used, args.budget, 100.0 * placed_cycles / total_cycles))
+        f.write("[mapping:lvgl_iram]\n")
+        f.write("archive: %s\n" % ARCHIVE)
+        f.write("entries:\n")
+        f.write("    if LVGL_CODE_PLACEMENT_IRAM = y:\n")
+        for _, (obj, name), _, _, _ in sorted(chosen, key=lambda c: c[1]):
+            f.write("        %s:%s (noflash)\n" % (obj, name))
+        if not chosen:
+            f.write("        * (default)\n")
+        f.write("    else:\n")
+        f.write("        * (default)\n")
+    print("Wrote %s" % os.path.normpath(args.out))
+
+
+def compare(args):
+    code_a, scenes_a = read_scenes(args.without)
+    code_b, scenes_b = read_scenes(args.with_)
+    if not scenes_a or not scenes_b:
+        sys.exit("No 'S <scene> <frames> <ms/frame>' lines in %s"
+                 % (args.without if not scenes_a else args.with_))
+    b = {name: (frames, ms) for name, frames, ms in scenes_b}
+
+    print("without: %s" % code_a)
+    print("with:    %s" % code_b)
+    if "instrumented" in code_a or "instrumented" in code_b:
+        print("Note: an instrumented build draws slower; compare two builds without profiling")
+    print()
+    print("%-10s %10s %10s %8s" % ("ms/frame", "without", "with", "change"))
+    sum_a = sum_b = frames_a = frames_b = 0
+    for name, frames, ms in scenes_a:
+        if name not in b:
+            continue
+        ms_b = b[name][1]
+        print("%-10s %10.2f %10.2f %7.1f%%" % (name, ms, ms_b, 100.0 * (ms_b - ms) / ms if ms else 0.0))
+        sum_a += ms * frames
+        frames_a += frames
+        sum_b += ms_b * b[name][0]
+        frames_b += b[name][0]
+    if frames_a and frames_b:
+        all_a = sum_a / frames_a
+        all_b = sum_b / frames_b
+        print("%-10s %10.2f %10.2f %7.1f%%" % ("all", all_a, all_b, 100.0 * (all_b - all_a) / all_a if all_a else 0.0))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="IRAM placement for LVGL from a [k] profile")
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    p = sub.add_parser("place", help="write lvgl_iram.lf from a profile")
+    p.add_argument("log", help="serial output of [k] on a profiling build")
+    p.add_argument("--map", required=True, help="linker map of the profiling build")
+    p.add_argument("--flash-map", help="linker map of a normal build, for the sizes")
+    p.add_argument("--budget", type=int, default=DEFAULT_BUDGET, help="IRAM bytes (default %(default)d)")
+    p.add_argument("--out", default=DEFAULT_OUT, help="fragment to write (default components/lvgl/lvgl_iram.lf)")
+    p.set_defaults(func=place)
+
+    c = sub.add_parser("compare", help="frame times of two [k] reports")
+    c.add_argument("without", help="[k] output of a flash build")
+    c.add_argument("with_", metavar="with", help="[k] output of an IRAM placement build")
+    c.set_defaults(func=compare)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,447 @@
+/*
+ * Host test for main/offline_queue.c on an emulated NOR flash partition
+ *
+ * The partition lives in shared memory and every boot of the "device" is a
+ * forked child, so a reboot loses all RAM state, as on the ESP32. Children
+ * push and replay (peek + consume) records with random sizes, reboot cleanly
+ * now and then, and lose power in the middle of a flash write or erase: the
+ * interrupted operation programs a random subset of its bits, then the child
+ * exits on the spot. The test checks that:
+ *   - replay returns records oldest first and intact (payload, samples and
+ *     timestamp as pushed)
+ *   - nothing is lost except a push cut short by a power loss, and nothing
+ *     comes back after its consume returned (a consume cut short may repeat)
+ *   - the queue only ever programs 1 bits to 0 between erases (NOR rule)
+ *   - erases are spread evenly over the segments
+ * A last phase without power loss overfills the ring and checks that exactly
+ * the oldest records were dropped and counted.
+ *
+ * Build and run:
+ *     gcc -O2 -Itools/idf_shim -Imain tools/offline_queue_sim.c main/offline_queue.c -o offline_queue_sim
+ *     ./offline_queue_sim [operations per seed] [seeds]
+ * Add -DIDF_SHIM_LOG=1 to see the queue's warnings.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "esp_partition.h"
+#include "offline_queue.h"
+
+#define SEGMENTS            32          // 128 KB partition, so the ring wraps often
+#define PARTITION_SIZE      (SEGMENTS * OFFLINE_QUEUE_SEGMENT_SIZE)
+#define DEFAULT_OPERATIONS  200000
+#define DEFAULT_SEEDS       3
+#define MAX_DEPTH_BYTES     (PARTITION_SIZE / 2)   // Keep the power loss phase clear of ring-full drops
+#define MAX_INTERRUPTED     4096
+#define NONE                0xFFFFFFFFu
+
+// Survives reboots: the flash and the test's record of what was pushed and replayed
+typedef struct {
+    uint8_t flash[PARTITION_SIZE];
+    uint32_t erases[SEGMENTS];      // Excluding retries
+    uint32_t erase_retries;         // Same segment erased again after a power loss
+    uint32_t last_erased;
+    uint64_t nor_violations;
+    uint64_t operations;
+    uint32_t boots;
+    uint32_t power_losses;
+    uint32_t next_id;               // Next record to push
+    uint32_t last_consumed;         // Newest record whose consume returned (NONE before the first)
+    uint32_t pushing;               // Push in progress, NONE otherwise
+    uint32_t consuming;             // Consume in progress, NONE otherwise
+    uint32_t may_repeat;            // Interrupted consume: this record may be replayed again
+    uint32_t interrupted[MAX_INTERRUPTED];  // Pushes cut short: may be missing
+    uint32_t interrupted_count;
+    uint64_t depth_bytes;           // Approximate payload bytes waiting
+    uint32_t failures;
+    char failure[256];
+} sim_state_t;
+
+static sim_state_t *sim;
+static esp_partition_t partition = {
+    .type = ESP_PARTITION_TYPE_DATA,
+    .subtype = OFFLINE_QUEUE_PARTITION_SUBTYPE,
+    .size = PARTITION_SIZE,
+    .label = OFFLINE_QUEUE_PARTITION_LABEL,
+};
+static long power_loss_countdown = -1;  // Flash writes/erases until the power fails, -1 = never
+
+static uint32_t rng_state;
+
+static uint32_t rng(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static uint32_t hash32(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352d;
+    x ^= x >> 15;
+    x *= 0x846ca68b;
+    x ^= x >> 16;
+    return x;
+}
+
+// Everything about a record follows from its id
+static size_t record_len(uint32_t id)
+{
+    uint32_t h = hash32(id);
+    return h % 8 == 0 ? 1 + h / 8 % OFFLINE_QUEUE_MAX_RECORD : 1 + h / 8 % 700;
+}
+
+static void record_fill(uint32_t id, uint8_t *out, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        out[i] = (uint8_t)hash32(id * 4099u + (uint32_t)i);
+    }
+}
+
+static void fail(const char *what, uint32_t id)
+{
+    if (sim->failures++ == 0) {
+        snprintf(sim->failure, sizeof(sim->failure), "%s (record %u, boot %u)", what, id, sim->boots);
+    }
+}
+
+// ---- Flash emulation ----
+
+// Power fails during this operation: bits end up partly programmed, then the device is gone
+static bool power_fails(void)
+{
+    if (power_loss_countdown < 0 || power_loss_countdown-- > 0) {
+        return false;
+    }
+    sim->power_losses++;
+    return true;
+}
+
+const esp_partition_t *esp_partition_find_first(int type, int subtype, const char *label)
+{
+    return type == partition.type && subtype == partition.subtype && strcmp(label, partition.label) == 0
+               ? &partition : NULL;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *p, size_t offset, void *dst, size_t size)
+{
+    if (p != &partition || offset + size > PARTITION_SIZE) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(dst, &sim->flash[offset], size);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *p, size_t offset, const void *src, size_t size)
+{
+    const uint8_t *data = src;
+    if (p != &partition || offset + size > PARTITION_SIZE) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    bool lost = power_fails();
+    for (size_t i = 0; i < size; i++) {
+        uint8_t *cell = &sim->flash[offset + i];
+        if (data[i] & ~*cell) {
+            sim->nor_violations++;  // NOR can only clear bits
+        }
+        // Interrupted: only some of the bits to clear get there
+        uint8_t program = lost ? (uint8_t)(data[i] | rng()) : data[i];
+        *cell &= program;
+    }
+    if (lost) {
+        _exit(0);
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *p, size_t offset, size_t size)
+{
+    if (p != &partition || offset % OFFLINE_QUEUE_SEGMENT_SIZE || size % OFFLINE_QUEUE_SEGMENT_SIZE ||
+        offset + size > PARTITION_SIZE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    bool lost = power_fails();
+    for (size_t s = offset; s < offset + size; s += OFFLINE_QUEUE_SEGMENT_SIZE) {
+        uint32_t segment = s / OFFLINE_QUEUE_SEGMENT_SIZE;
+        if (size == OFFLINE_QUEUE_SEGMENT_SIZE && segment == sim->last_erased) {
+            sim->erase_retries++;   // Erase or segment header cut short last time
+        } else {
+            sim->erases[segment]++;
+        }
+        sim->last_erased = size == OFFLINE_QUEUE_SEGMENT_SIZE ? segment : NONE;
+        for (size_t i = 0; i < OFFLINE_QUEUE_SEGMENT_SIZE; i++) {
+            sim->flash[s + i] = lost ? (uint8_t)(sim->flash[s + i] | rng()) : 0xFF;
+        }
+    }
+    if (lost) {
+        _exit(0);
+    }
+    return ESP_OK;
+}
+
+// ---- Device side ----
+
+static bool was_interrupted(uint32_t id)
+{
+    for (uint32_t i = 0; i < sim->interrupted_count; i++) {
+        if (sim->interrupted[i] == id) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void do_push(void)
+{
+    static uint8_t payload[OFFLINE_QUEUE_MAX_RECORD];
+    uint32_t id = sim->next_id;
+    size_t len = record_len(id);
+
+    record_fill(id, payload, len);
+    sim->pushing = id;
+    esp_err_t err = offline_queue_push(payload, len, (uint16_t)(1 + id % 7), id);
+    sim->pushing = NONE;
+    sim->next_id++;
+    if (err != ESP_OK) {
+        fail("push failed", id);
+        return;
+    }
+    sim->depth_bytes += len;
+}
+
+// Replay one record; false if the queue is empty
+static bool do_replay(void)
+{
+    static uint8_t payload[OFFLINE_QUEUE_MAX_RECORD];
+    static uint8_t expected[OFFLINE_QUEUE_MAX_RECORD];
+    offline_queue_record_t rec;
+
+    if (offline_queue_peek(payload, sizeof(payload), &rec) != ESP_OK) {
+        return false;
+    }
+    uint32_t id = (uint32_t)rec.timestamp_ms;
+    record_fill(id, expected, record_len(id));
+    if (rec.len != record_len(id) || rec.samples != 1 + id % 7 || memcmp(payload, expected, rec.len) != 0) {
+        fail("replayed record corrupted", id);
+    }
+
+    // Oldest first: everything between the last consumed record and this one was lost
+    uint32_t first = sim->last_consumed == NONE ? 0 : sim->last_consumed + 1;
+    bool repeat = id == sim->may_repeat;
+    sim->may_repeat = NONE;
+    if (repeat) {
+        // The consume before the power loss did not stick
+    } else if (sim->last_consumed != NONE && id <= sim->last_consumed) {
+        fail("record replayed again after its consume returned", id);
+    } else {
+        for (uint32_t missing = first; missing < id; missing++) {
+            if (!was_interrupted(missing)) {
+                fail("record lost", missing);
+                break;
+            }
+        }
+    }
+
+    sim->consuming = id;
+    if (offline_queue_consume(&rec) != ESP_OK) {
+        fail("consume failed", id);
+    }
+    sim->consuming = NONE;
+    if (sim->last_consumed == NONE || id > sim->last_consumed) {
+        sim->last_consumed = id;
+    }
+    sim->depth_bytes = sim->depth_bytes > rec.len ? sim->depth_bytes - rec.len : 0;
+    return true;
+}
+
+// One boot: recover, then run operations until a clean reboot or the power fails
+static void device_boot(uint64_t operations_total)
+{
+    if (offline_queue_init() != ESP_OK) {
+        fail("init failed", 0);
+        _exit(0);
+    }
+    uint32_t ops_this_boot = 1 + rng() % 60;
+    while (ops_this_boot-- > 0 && sim->operations < operations_total && sim->failures == 0) {
+        sim->operations++;
+        bool push = sim->depth_bytes < MAX_DEPTH_BYTES && rng() % 100 < 55;
+        if (push || !do_replay()) {
+            do_push();
+        }
+    }
+    _exit(0);
+}
+
+// ---- Test driver ----
+
+static void boot_once(uint64_t operations_total, bool allow_power_loss)
+{
+    // What the previous boot left half done
+    if (sim->pushing != NONE) {
+        if (sim->interrupted_count < MAX_INTERRUPTED) {
+            sim->interrupted[sim->interrupted_count++] = sim->pushing;
+        }
+        sim->next_id = sim->pushing + 1;
+        sim->pushing = NONE;
+    }
+    if (sim->consuming != NONE) {
+        // The consume may or may not have reached flash: the record is either next or gone
+        sim->may_repeat = sim->consuming;
+        sim->last_consumed = sim->consuming;
+        sim->consuming = NONE;
+    }
+    sim->boots++;
+
+    rng_state = hash32(sim->boots * 7919u + (uint32_t)sim->operations) | 1u;
+    power_loss_countdown = allow_power_loss && rng() % 3 == 0 ? (long)(rng() % 200) : -1;
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        device_boot(operations_total);
+    }
+    int status;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status)) {
+        fail("device crashed", 0);
+    }
+}
+
+// Replay everything in one boot without power loss
+static void drain(void)
+{
+    pid_t pid = fork();
+    if (pid == 0) {
+        power_loss_countdown = -1;
+        if (offline_queue_init() != ESP_OK) {
+            fail("init failed", 0);
+        }
+        while (sim->failures == 0 && do_replay()) {
+            sim->operations++;
+        }
+        _exit(0);
+    }
+    waitpid(pid, NULL, 0);
+}
+
+// Overfill the ring in one boot and check the drop accounting
+static void overflow_check(void)
+{
+    pid_t pid = fork();
+    if (pid == 0) {
+        power_loss_countdown = -1;
+        offline_queue_init();
+        offline_queue_clear();
+        sim->last_consumed = NONE;
+        sim->may_repeat = NONE;
+        sim->depth_bytes = 0;
+
+        uint32_t first = sim->next_id;
+        uint64_t pushed_samples = 0;
+        while (sim->next_id - first < 3 * SEGMENTS * 8) {   // ~3 times the ring
+            pushed_samples += 1 + sim->next_id % 7;
+            do_push();
+        }
+        offline_queue_stats_t stats;
+        offline_queue_get_stats(&stats);
+
+        uint64_t replayed_samples = 0;
+        offline_queue_record_t rec;
+        static uint8_t payload[OFFLINE_QUEUE_MAX_RECORD];
+        uint32_t expect = NONE;
+        while (offline_queue_peek(payload, sizeof(payload), &rec) == ESP_OK) {
+            uint32_t id = (uint32_t)rec.timestamp_ms;
+            if (expect != NONE && id != expect) {
+                fail("overflow: replay not contiguous", id);
+            }
+            expect = id + 1;
+            replayed_samples += rec.samples;
+            offline_queue_consume(&rec);
+        }
+        if (expect != sim->next_id) {
+            fail("overflow: newest records missing", expect);
+        }
+        if (stats.dropped_samples + replayed_samples != pushed_samples) {
+            fail("overflow: dropped + replayed != pushed", 0);
+        }
+        printf("  overflow: %u records pushed into a %u KB ring, %lu samples dropped, %llu replayed\n",
+               sim->next_id - first, PARTITION_SIZE / 1024, (unsigned long)stats.dropped_samples,
+               (unsigned long long)replayed_samples);
+        fflush(stdout);
+        _exit(0);
+    }
+    waitpid(pid, NULL, 0);
+}
+
+static int run(uint32_t seed, uint64_t operations)
+{
+    memset(sim, 0, sizeof(*sim));
+    memset(sim->flash, 0xFF, sizeof(sim->flash));
+    sim->last_consumed = sim->pushing = sim->consuming = sim->may_repeat = sim->last_erased = NONE;
+    sim->boots = seed * 1000003u;
+
+    uint32_t first_boot = sim->boots;
+    while (sim->operations < operations && sim->failures == 0) {
+        boot_once(operations, true);
+    }
+    drain();
+    if (sim->failures == 0) {
+        // Every record pushed without interruption came back
+        uint32_t newest = sim->next_id - 1;
+        while (newest != NONE && was_interrupted(newest)) {
+            newest--;
+        }
+        if (sim->last_consumed != newest) {
+            fail("records missing at the end", sim->last_consumed);
+        }
+    }
+
+    uint32_t min_erase = UINT32_MAX, max_erase = 0;
+    for (int s = 0; s < SEGMENTS; s++) {
+        min_erase = sim->erases[s] < min_erase ? sim->erases[s] : min_erase;
+        max_erase = sim->erases[s] > max_erase ? sim->erases[s] : max_erase;
+    }
+    printf("seed %u: %llu operations, %u records, %u boots, %u power losses (%u pushes cut short)\n", seed,
+           (unsigned long long)sim->operations, sim->next_id, sim->boots - first_boot, sim->power_losses,
+           sim->interrupted_count);
+    printf("  erases per segment %u..%u (+%u retried after a power loss), NOR violations %llu\n", min_erase,
+           max_erase, sim->erase_retries, (unsigned long long)sim->nor_violations);
+    if (sim->nor_violations) {
+        fail("a programmed bit was set back to 1", 0);
+    }
+    if (max_erase - min_erase > 2) {
+        fail("uneven wear", 0);
+    }
+    if (sim->failures == 0) {
+        overflow_check();
+    }
+    if (sim->failures) {
+        printf("  FAILED: %s\n", sim->failure);
+    }
+    return sim->failures != 0;
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t operations = argc > 1 ? strtoull(argv[1], NULL, 0) : DEFAULT_OPERATIONS;
+    uint32_t seeds = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 0) : DEFAULT_SEEDS;
+    int failures = 0;
+
+    sim = mmap(NULL, sizeof(*sim), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (sim == MAP_FAILED) {
+        perror("mmap");
+        return 1;
+    }
+    setvbuf(stdout, NULL, _IOLBF, 0);   // Forked children must not inherit pending output
+    for (uint32_t seed = 1; seed <= seeds; seed++) {
+        failures += run(seed, operations);
+    }
+    printf("\n%s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
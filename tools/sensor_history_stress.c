@@ -0,0 +1,220 @@
+/*
+ * Host stress test for main/sensor_history.c
+ *
+ * One producer thread appends samples while three consumer threads read
+ * them with their own cursors; one consumer is deliberately slow and gets
+ * overrun. Every field of sample n is derived from n, so a consumer can
+ * tell whether a sample was torn (fields from two different writes), came
+ * out of order, or was skipped without being reported as lost:
+ *   - each sample must be self-consistent
+ *   - within a read call, the gaps between consecutive samples must add
+ *     up to the `lost` that call reported
+ *   - once the producer stops and a consumer has drained the ring,
+ *     got + lost must equal the samples written
+ * The run is repeated with the producer unthrottled and paced (~200 kHz for
+ * 1M samples). Paced, the slow consumer falls behind all the time and the
+ * fast ones only when the host deschedules them (more often with few cores).
+ *
+ * Build and run:
+ *     gcc -O2 -pthread -Imain tools/sensor_history_stress.c main/sensor_history.c -o sensor_history_stress
+ *     ./sensor_history_stress [samples]
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "sensor_history.h"
+
+#define DEFAULT_SAMPLES 20000000u
+#define READERS         3
+#define READ_MAX        64          // Samples per read call
+#define SLOW_MAX        16          // The slow reader takes fewer...
+#define SLOW_SLEEP_NS   100000      // ...and sleeps between calls
+#define PACE_BATCH      64          // Paced producer: samples per 320us
+#define PACE_NS         320000
+#define PACED_SAMPLES   1000000u    // ~5 s
+
+typedef struct {
+    int slow;
+    sensor_history_reader_t reader;   // Attached before the producer starts, so it begins at sample 0
+    uint64_t got;
+    uint64_t lost;
+    uint64_t calls;
+    uint64_t torn;
+    uint64_t order;             // Out of order samples, or gaps not reported as lost
+    uint32_t overruns;
+    double seconds;
+} reader_result_t;
+
+static sensor_history_t history;
+static atomic_uint producer_done;
+static uint32_t samples_total;     // Of the current run
+static int paced;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void sleep_ns(long ns)
+{
+    struct timespec ts = {0, ns};
+    nanosleep(&ts, NULL);
+}
+
+// Every field is a function of n (exactly representable as float below 2^24)
+static void make_sample(uint32_t n, sensor_history_sample_t *s)
+{
+    s->timestamp_us = (int64_t)n * 5000;
+    for (int i = 0; i < 3; i++) {
+        s->accel[i] = (int16_t)(n * 3u + (uint32_t)i);
+        s->gyro[i] = (int16_t)(n * 7u + (uint32_t)i);
+    }
+    s->pitch = (float)(n & 0xFFFFFu);
+    s->roll = -(float)(n & 0xFFFFFu);
+}
+
+static int sample_ok(const sensor_history_sample_t *s, uint32_t *n)
+{
+    sensor_history_sample_t ref;
+    *n = (uint32_t)(s->timestamp_us / 5000);
+    make_sample(*n, &ref);
+    return s->timestamp_us % 5000 == 0 && memcmp(s->accel, ref.accel, sizeof(ref.accel)) == 0 &&
+           memcmp(s->gyro, ref.gyro, sizeof(ref.gyro)) == 0 && s->pitch == ref.pitch && s->roll == ref.roll;
+}
+
+static void *producer(void *arg)
+{
+    (void)arg;
+    sensor_history_sample_t s;
+    double next = now_s();
+
+    for (uint32_t n = 0; n < samples_total; n++) {
+        make_sample(n, &s);
+        sensor_history_append(&history, &s);
+        if (paced && n % PACE_BATCH == PACE_BATCH - 1) {
+            next += PACE_NS * 1e-9;
+            while (now_s() < next) {
+                sleep_ns(50000);
+            }
+        }
+    }
+    atomic_store(&producer_done, 1);
+    return NULL;
+}
+
+static void *consumer(void *arg)
+{
+    reader_result_t *res = arg;
+    sensor_history_reader_t *r = &res->reader;
+    sensor_history_sample_t out[READ_MAX];
+    size_t max = res->slow ? SLOW_MAX : READ_MAX;
+    int64_t prev = -1;          // Index of the last sample read
+    uint64_t pending = 0;       // Lost samples not yet seen as a gap
+    double t0 = now_s();
+
+    for (;;) {
+        int done = atomic_load(&producer_done);
+        uint32_t lost;
+        size_t got = sensor_history_read(&history, r, out, max, &lost);
+        res->calls++;
+
+        uint64_t gaps = 0;
+        for (size_t i = 0; i < got; i++) {
+            uint32_t n;
+            if (!sample_ok(&out[i], &n)) {
+                res->torn++;
+                continue;
+            }
+            if ((int64_t)n <= prev) {
+                res->order++;
+            } else {
+                gaps += (uint64_t)(n - prev - 1);
+            }
+            prev = n;
+        }
+        // A call that returns nothing may still report samples it skipped
+        pending += lost;
+        if (got > 0) {
+            if (gaps != pending) {
+                res->order++;
+            }
+            pending = 0;
+        }
+        res->got += got;
+        res->lost += lost;
+
+        if (got == 0) {
+            if (done && sensor_history_available(&history, r) == 0) {
+                break;
+            }
+            sleep_ns(1000);
+        } else if (res->slow) {
+            sleep_ns(SLOW_SLEEP_NS);
+        }
+    }
+    if (prev + 1 != (int64_t)(res->got + res->lost)) {
+        res->order++;
+    }
+    res->overruns = r->overruns;
+    res->seconds = now_s() - t0;
+    return NULL;
+}
+
+static int run(uint32_t samples, int pace)
+{
+    pthread_t prod, cons[READERS];
+    reader_result_t res[READERS];
+    int failures = 0;
+
+    memset(&history, 0, sizeof(history));
+    atomic_store(&producer_done, 0);
+    paced = pace;
+    samples_total = samples;
+
+    memset(res, 0, sizeof(res));
+    for (int i = 0; i < READERS; i++) {
+        res[i].slow = (i == READERS - 1);
+        sensor_history_reader_init(&history, &res[i].reader, true);
+        pthread_create(&cons[i], NULL, consumer, &res[i]);
+    }
+    double t0 = now_s();
+    pthread_create(&prod, NULL, producer, NULL);
+    pthread_join(prod, NULL);
+    double write_s = now_s() - t0;
+    for (int i = 0; i < READERS; i++) {
+        pthread_join(cons[i], NULL);
+    }
+
+    printf("%s producer: %u samples in %.2f s, %.1f M appends/s\n", pace ? "Paced" : "Unthrottled",
+           samples_total, write_s, samples_total / write_s / 1e6);
+    printf("  %-6s %10s %10s %9s %9s %6s %6s %s\n", "reader", "got", "lost", "overruns", "M/s", "torn",
+           "order", "got+lost");
+    for (int i = 0; i < READERS; i++) {
+        int sum_ok = res[i].got + res[i].lost == samples_total;
+        int bad = res[i].torn || res[i].order || !sum_ok;
+        printf("  %-6s %10llu %10llu %9u %9.2f %6llu %6llu %s\n", res[i].slow ? "slow" : "fast",
+               (unsigned long long)res[i].got, (unsigned long long)res[i].lost, res[i].overruns,
+               res[i].got / res[i].seconds / 1e6, (unsigned long long)res[i].torn,
+               (unsigned long long)res[i].order, sum_ok ? "= written" : "MISMATCH");
+        failures += bad;
+    }
+    return failures;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t samples = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 0) : DEFAULT_SAMPLES;
+    printf("Capacity %d samples, %d readers (one slow)\n\n", SENSOR_HISTORY_CAPACITY, READERS);
+
+    int failures = run(samples, 0);
+    printf("\n");
+    failures += run(samples < PACED_SAMPLES ? samples : PACED_SAMPLES, 1);
+
+    printf("\n%s\n", failures ? "FAILED: torn, reordered or unaccounted samples" : "OK");
+    return failures ? 1 : 0;
+}
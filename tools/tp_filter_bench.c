@@ -0,0 +1,214 @@
+/*
+ * Host benchmark and self-check for components/lvgl_esp32_drivers/lvgl_touch/tp_filter.c
+ *
+ * Simulates XPT2046 conversions of a held finger (Gaussian noise plus
+ * occasional spikes from a bouncing contact) and compares, per indev read:
+ *   - the old driver: TP_Read_XY2, 4 bursts of 30 conversions, each bubble
+ *     sorted and trimmed by one, and the two XY pairs within 50 counts
+ *   - the new one: 7 conversions per axis after a discarded one, median by
+ *     selection and the mean of those within XPT2046_SPREAD of it
+ * It reports filter time on this host, position error, rejected reads and
+ * the estimated bus and CPU time on the ESP32.
+ *
+ * Build and run:
+ *     gcc -O2 -Icomponents/lvgl_esp32_drivers/lvgl_touch tools/tp_filter_bench.c \
+ *         components/lvgl_esp32_drivers/lvgl_touch/tp_filter.c -lm -o tp_filter_bench
+ *     ./tp_filter_bench
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "tp_filter.h"
+
+#define READS           100000
+#define NOISE           8.0         // Raw counts, 1 sigma
+#define SPIKE_PCT       3           // Conversions that catch a bounce
+#define SAMPLES         7           // XPT2046_SAMPLES in xpt2046.h
+#define SPREAD          50          // XPT2046_SPREAD in xpt2046.h
+
+/* ESP32 estimates: the old bit-bang loop toggled ~60 GPIO calls and waited
+ * 7 us per conversion; the SPI host clocks 24 bits at 2 MHz */
+#define BITBANG_CONV_US 20.0
+#define SPI_HZ          2000000
+#define SPI_SETUP_US    15.0        // spi_device_transmit() queue, ISR and wakeup
+
+static uint32_t rng = 2463534242u;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint32_t xorshift(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static double gauss(void)
+{
+    double u1 = (xorshift() + 1.0) / 4294967297.0;
+    double u2 = (xorshift() + 1.0) / 4294967297.0;
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+/* One 12-bit conversion of a finger at raw position pos */
+static uint16_t convert(double pos)
+{
+    double v = pos + NOISE * gauss();
+    if (xorshift() % 100 < SPIKE_PCT) {
+        v += (xorshift() % 2 ? 1 : -1) * (200.0 + xorshift() % 1500);
+    }
+    if (v < 0) {
+        v = 0;
+    }
+    if (v > 4095) {
+        v = 4095;
+    }
+    return (uint16_t) v;
+}
+
+/* The old TP_Read_XOY on 30 conversions */
+static uint16_t old_xoy(uint16_t *buf)
+{
+    uint32_t sum = 0;
+
+    for (int i = 0; i < 29; i++) {
+        for (int j = i + 1; j < 30; j++) {
+            if (buf[i] > buf[j]) {
+                uint16_t tmp = buf[i];
+                buf[i] = buf[j];
+                buf[j] = tmp;
+            }
+        }
+    }
+    for (int i = 1; i < 29; i++) {
+        sum += buf[i];
+    }
+    return sum / 28;
+}
+
+/* The old TP_Read_XY2: X, Y, X, Y bursts of 30 */
+static int old_filter(uint16_t *conv, uint16_t *x, uint16_t *y)
+{
+    uint16_t x1 = old_xoy(&conv[0]);
+    uint16_t y1 = old_xoy(&conv[30]);
+    uint16_t x2 = old_xoy(&conv[60]);
+    uint16_t y2 = old_xoy(&conv[90]);
+
+    if (abs(x1 - x2) < 50 && abs(y1 - y2) < 50) {
+        *x = (x1 + x2) / 2;
+        *y = (y1 + y2) / 2;
+        return 1;
+    }
+    return 0;
+}
+
+static void old_convert(double px, double py, uint16_t *conv)
+{
+    for (int i = 0; i < 120; i++) {
+        conv[i] = convert((i / 30) % 2 ? py : px);
+    }
+}
+
+/* xpt2046_read_raw: X and Y bursts, each after a discarded conversion */
+static int new_filter(uint16_t *conv, uint16_t *x, uint16_t *y)
+{
+    return tp_filter_median_mean(&conv[1], SAMPLES, SPREAD, x) &&
+           tp_filter_median_mean(&conv[SAMPLES + 2], SAMPLES, SPREAD, y);
+}
+
+static void new_convert(double px, double py, uint16_t *conv)
+{
+    for (int i = 0; i < 2 * (SAMPLES + 1); i++) {
+        conv[i] = convert(i <= SAMPLES ? px : py);
+    }
+}
+
+static int check_select(void)
+{
+    for (int n = 1; n <= 31; n++) {
+        for (int round = 0; round < 200; round++) {
+            uint16_t a[31];
+            uint16_t sorted[31];
+            for (int i = 0; i < n; i++) {
+                a[i] = xorshift() % (round % 2 ? 8 : 4096);  // With and without duplicates
+            }
+            memcpy(sorted, a, sizeof(a));
+            for (int i = 0; i < n - 1; i++) {
+                for (int j = i + 1; j < n; j++) {
+                    if (sorted[i] > sorted[j]) {
+                        uint16_t tmp = sorted[i];
+                        sorted[i] = sorted[j];
+                        sorted[j] = tmp;
+                    }
+                }
+            }
+            for (int k = 0; k < n; k++) {
+                uint16_t b[31];
+                memcpy(b, a, sizeof(a));
+                if (tp_filter_select(b, n, k) != sorted[k]) {
+                    printf("FAIL: select k=%d of %d\n", k, n);
+                    return 0;
+                }
+            }
+        }
+    }
+    return 1;
+}
+
+static void run(const char *name, void (*conv_fn)(double, double, uint16_t *),
+                int (*filter)(uint16_t *, uint16_t *, uint16_t *),
+                int convs, double bus_us, double cpu_us)
+{
+    uint16_t conv[120];
+    double err2 = 0;
+    double t = 0;
+    uint32_t rejected = 0;
+
+    for (int i = 0; i < READS; i++) {
+        double px = 300 + xorshift() % 3500;
+        double py = 300 + xorshift() % 3500;
+        uint16_t x, y;
+
+        conv_fn(px, py, conv);
+        double start = now_s();
+        int ok = filter(conv, &x, &y);
+        t += now_s() - start;
+
+        if (!ok) {
+            rejected++;
+            continue;
+        }
+        err2 += (x - px) * (x - px) + (y - py) * (y - py);
+    }
+
+    uint32_t used = READS - rejected;
+    printf("  %-12s %6d %9.2f %9.1f %10.0f %9.0f %9.0f\n", name, convs,
+           used ? sqrt(err2 / used) : 0.0, 100.0 * rejected / READS,
+           t * 1e9 / READS, bus_us, cpu_us);
+}
+
+int main(void)
+{
+    int failed = !check_select();
+    double spi_bus_us = 2 * (SAMPLES + 1) * 24 * 1e6 / SPI_HZ;
+
+    printf("%d reads, noise %.0f counts, %d%% spikes\n\n", READS, NOISE, SPIKE_PCT);
+    printf("  %-12s %6s %9s %9s %10s %9s %9s\n", "per read", "convs", "rms err",
+           "reject %", "filter ns", "bus us", "CPU us");
+    /* Old: the CPU drives the bus itself. New: the task sleeps during the
+     * transfer; the CPU only sets it up and filters. */
+    run("bit-bang", old_convert, old_filter, 120, 120 * BITBANG_CONV_US, 120 * BITBANG_CONV_US);
+    run("SPI host", new_convert, new_filter, 2 * (SAMPLES + 1), spi_bus_us, SPI_SETUP_US);
+
+    printf("\n%s\n", failed ? "FAILED" : "OK");
+    return failed;
+}